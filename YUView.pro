@@ -1,9 +1,11 @@
 TEMPLATE = subdirs
-SUBDIRS = YUViewLib YUViewApp YUViewUnitTest
+SUBDIRS = YUViewLib YUViewApp YUViewUnitTest YUViewBenchmark
 
 YUViewApp.subdir = YUViewApp
 YUViewLib.subdir = YUViewLib
 YUViewUnitTest.subdir = YUViewUnitTest
+YUViewBenchmark.subdir = YUViewBenchmark
 
 YUViewApp.depends = YUViewLib
 YUViewUnitTest.depends = YUViewLib
+YUViewBenchmark.depends = YUViewLib
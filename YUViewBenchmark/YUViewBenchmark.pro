@@ -0,0 +1,20 @@
+QT += gui opengl xml concurrent network charts
+
+TARGET = YUViewBenchmark
+TEMPLATE = app
+CONFIG += c++11 console
+CONFIG -= debug_and_release
+CONFIG -= app_bundle
+
+SOURCES += $$files(src/*.cpp, false)
+HEADERS += $$files(src/*.h, false)
+
+INCLUDEPATH += $$top_srcdir/YUViewLib/src
+LIBS += -L$$top_builddir/YUViewLib -lYUViewLib
+
+win32 {
+    PRE_TARGETDEPS += $$top_builddir/YUViewLib/YUViewLib.lib
+    DEFINES += NOMINMAX
+} else {
+    PRE_TARGETDEPS += $$top_builddir/YUViewLib/libYUViewLib.a
+}
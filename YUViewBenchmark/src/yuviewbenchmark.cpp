@@ -0,0 +1,484 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* A non-interactive benchmark for the performance critical parts of YUView. All inputs are synthetic
+ * so that the results are reproducible on any machine. The results are written as JSON (to stdout or
+ * to the file given with --output) so that they can be compared between builds.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+#include "common/typedef.h"
+#include "parser/parserAnnexBAVC.h"
+#include "parser/parserAnnexBHEVC.h"
+#include "parser/parserAV1OBU.h"
+#include "parser/parserAVFormat.h"
+#include "playlistitem/playlistItemStatisticsCSVFile.h"
+#include "video/videoHandlerYUV.h"
+
+using namespace YUV_Internals;
+
+namespace
+{
+
+// Deterministic pseudo random numbers so that all runs work on the same data
+class syntheticRandom
+{
+public:
+  unsigned int next() { state = state * 1664525u + 1013904223u; return state >> 8; }
+private:
+  unsigned int state {12345};
+};
+
+// Run the function nrRuns times (after one untimed warm up run) and create a JSON entry with the
+// throughput. bytesPerRun is the amount of input data that one run processes.
+QJsonObject timeRuns(const QString &group, const QString &name, int nrRuns, int64_t bytesPerRun, const std::function<bool(int)> &run)
+{
+  QJsonObject result;
+  result["group"] = group;
+  result["name"] = name;
+
+  if (!run(0))
+  {
+    result["skipped"] = true;
+    return result;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  for (int i = 0; i < nrRuns; i++)
+    run(i);
+  const double seconds = double(timer.nsecsElapsed()) / 1e9;
+
+  result["runs"] = nrRuns;
+  result["seconds"] = seconds;
+  result["framesPerSecond"] = (seconds > 0) ? nrRuns / seconds : 0.0;
+  result["megabytesPerSecond"] = (seconds > 0) ? double(bytesPerRun) * nrRuns / seconds / 1e6 : 0.0;
+
+  std::cerr << qPrintable(group) << " - " << qPrintable(name) << ": " << result["framesPerSecond"].toDouble() << " fps, " << result["megabytesPerSecond"].toDouble() << " MB/s\n";
+  return result;
+}
+
+// Fill a buffer with random samples of the given bit depth. Samples with more than 8 bit are stored as
+// 16 bit little endian values (this is also the layout of packed formats without byte packing).
+QByteArray createSyntheticSamples(int64_t nrBytes, int bitsPerSample)
+{
+  QByteArray data;
+  data.resize(int(nrBytes));
+  unsigned char *dst = (unsigned char*)data.data();
+  syntheticRandom rand;
+  if (bitsPerSample > 8)
+  {
+    const unsigned int mask = (1u << bitsPerSample) - 1;
+    for (int64_t i = 0; i + 1 < nrBytes; i += 2)
+    {
+      const unsigned int val = rand.next() & mask;
+      dst[i] = val & 0xff;
+      dst[i+1] = (val >> 8) & 0xff;
+    }
+  }
+  else
+  {
+    for (int64_t i = 0; i < nrBytes; i++)
+      dst[i] = rand.next() & 0xff;
+  }
+  return data;
+}
+
+// Connect the raw data request of the handler so that it is always answered with the given data
+void provideRawData(videoHandlerYUV &handler, const QByteArray &data)
+{
+  QObject::connect(&handler, &videoHandler::signalRequestRawData, &handler, [&handler, data](int frameIdx, bool caching) {
+    Q_UNUSED(caching);
+    handler.rawData = data;
+    handler.rawData_frameIdx = frameIdx;
+  }, Qt::DirectConnection);
+}
+
+QList<yuvPixelFormat> getBenchmarkFormats()
+{
+  QList<yuvPixelFormat> formats;
+  const int bitDepths[] = {8, 10, 12, 16};
+  const YUVSubsamplingType subsamplings[] = {YUV_444, YUV_422, YUV_420, YUV_440, YUV_410, YUV_411, YUV_400};
+  for (int bitDepth : bitDepths)
+  {
+    for (YUVSubsamplingType subsampling : subsamplings)
+      formats.append(yuvPixelFormat(subsampling, bitDepth, Order_YUV));
+
+    yuvPixelFormat nv12(YUV_420, bitDepth, Order_YUV);
+    nv12.uvInterleaved = true;
+    formats.append(nv12);
+
+    formats.append(yuvPixelFormat(YUV_444, bitDepth, Packing_YUV, false));
+    formats.append(yuvPixelFormat(YUV_444, bitDepth, Packing_AYUV, false));
+    formats.append(yuvPixelFormat(YUV_422, bitDepth, Packing_UYVY, false));
+    formats.append(yuvPixelFormat(YUV_422, bitDepth, Packing_YUYV, false));
+    if (bitDepth == 10)
+      formats.append(yuvPixelFormat(YUV_422, bitDepth, Packing_V210, false));
+  }
+  return formats;
+}
+
+void benchmarkYUVConversion(const QSize &frameSize, int nrFrames, QJsonArray &results)
+{
+  for (const yuvPixelFormat &format : getBenchmarkFormats())
+  {
+    if (!format.isValid())
+      continue;
+
+    QList<OutputMode> outputModes = QList<OutputMode>() << Output8Bit;
+    if (format.bitsPerSample > 8 && format.planar)
+      outputModes << Output16Bit;
+
+    for (OutputMode mode : outputModes)
+    {
+      videoHandlerYUV handler;
+      handler.setFrameSize(frameSize);
+      handler.setYUVPixelFormat(format);
+      handler.setOutputMode(mode);
+
+      const int64_t bytesPerFrame = format.bytesPerFrame(frameSize);
+      provideRawData(handler, createSyntheticSamples(bytesPerFrame, format.bitsPerSample));
+
+      const QString name = format.getName() + ((mode == Output16Bit) ? " to RGB64" : " to RGB32");
+      // Test mode converts the frame without putting it into the cache
+      results.append(timeRuns("convertYUVToRGB", name, nrFrames, bytesPerFrame, [&handler](int frameIdx) {
+        handler.cacheFrame(frameIdx, true);
+        return true;
+      }));
+    }
+  }
+}
+
+void benchmarkDifference(const QSize &frameSize, int nrFrames, QJsonArray &results)
+{
+  struct differenceCase
+  {
+    QString name;
+    yuvPixelFormat format[2];
+  };
+  const QList<differenceCase> cases = QList<differenceCase>()
+    << differenceCase {"YUV 4:2:0 8-bit", {yuvPixelFormat(YUV_420, 8), yuvPixelFormat(YUV_420, 8)}}
+    << differenceCase {"YUV 4:2:0 10-bit", {yuvPixelFormat(YUV_420, 10), yuvPixelFormat(YUV_420, 10)}}
+    << differenceCase {"YUV 4:2:0 8-bit vs 10-bit", {yuvPixelFormat(YUV_420, 8), yuvPixelFormat(YUV_420, 10)}}
+    << differenceCase {"RGB (4:2:0 vs 4:4:4 8-bit)", {yuvPixelFormat(YUV_420, 8), yuvPixelFormat(YUV_444, 8)}};
+
+  for (const differenceCase &c : cases)
+  {
+    videoHandlerYUV handler[2];
+    int64_t bytesPerFrame = 0;
+    for (int i = 0; i < 2; i++)
+    {
+      handler[i].setFrameSize(frameSize);
+      handler[i].setYUVPixelFormat(c.format[i]);
+      bytesPerFrame += c.format[i].bytesPerFrame(frameSize);
+      provideRawData(handler[i], createSyntheticSamples(c.format[i].bytesPerFrame(frameSize), c.format[i].bitsPerSample));
+    }
+
+    results.append(timeRuns("calculateDifference", c.name, nrFrames, bytesPerFrame, [&handler](int frameIdx) {
+      Q_UNUSED(frameIdx);
+      QList<infoItem> differenceInfoList;
+      return !handler[0].calculateDifference(&handler[1], 0, 0, differenceInfoList, 1, false).isNull();
+    }));
+  }
+}
+
+// Write a statistics file with one block value type (16x16 blocks) and one vector type (8x8 blocks)
+bool writeSyntheticStatisticsFile(const QString &fileName, const QSize &frameSize, int nrFrames)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return false;
+
+  QTextStream out(&file);
+  out << "%;syntax-version;v1.22\n";
+  out << "%;seq-specs;benchmark;0;" << frameSize.width() << ";" << frameSize.height() << ";50\n";
+  out << "%;type;0;Value;map\n";
+  out << "%;defaultRange;0;255;jet\n";
+  out << "%;type;1;Motion Vector;vector\n";
+  out << "%;vectorColor;255;0;0;255\n";
+  out << "%;scaleFactor;4\n";
+
+  syntheticRandom rand;
+  for (int poc = 0; poc < nrFrames; poc++)
+  {
+    for (int y = 0; y < frameSize.height(); y += 16)
+      for (int x = 0; x < frameSize.width(); x += 16)
+        out << poc << ";" << x << ";" << y << ";16;16;0;" << (rand.next() % 256) << "\n";
+    for (int y = 0; y < frameSize.height(); y += 8)
+      for (int x = 0; x < frameSize.width(); x += 8)
+        out << poc << ";" << x << ";" << y << ";8;8;1;" << int(rand.next() % 129) - 64 << ";" << int(rand.next() % 129) - 64 << "\n";
+  }
+  return true;
+}
+
+void benchmarkStatistics(const QString &tempPath, const QSize &frameSize, int nrFrames, QJsonArray &results)
+{
+  const QString fileName = tempPath + "/benchmark.csv";
+  if (!writeSyntheticStatisticsFile(fileName, frameSize, nrFrames))
+    return;
+  const int64_t fileSize = QFileInfo(fileName).size();
+
+  results.append(timeRuns("statistics", "CSV file parsing", 1, fileSize, [&fileName](int) {
+    playlistItemStatisticsCSVFile item(fileName);
+    item.waitForBackgroundParsing();
+    return true;
+  }));
+
+  playlistItemStatisticsCSVFile item(fileName);
+  item.waitForBackgroundParsing();
+  statisticHandler *handler = item.getStatisticsHandler();
+  for (const StatisticsType &type : handler->getStatisticsTypeList())
+    handler->getStatisticsType(type.typeID)->render = true;
+
+  const int64_t bytesPerFrame = fileSize / nrFrames;
+  results.append(timeRuns("statistics", "Load frame", nrFrames, bytesPerFrame, [handler](int frameIdx) {
+    // Alternate between two frames so that every run has to load from the file
+    handler->loadStatistics(frameIdx % 2);
+    return !handler->statsCache.isEmpty();
+  }));
+
+  QImage image(frameSize, QImage::Format_ARGB32_Premultiplied);
+  handler->loadStatistics(0);
+  results.append(timeRuns("statistics", "Paint frame", nrFrames, int64_t(frameSize.width()) * frameSize.height() * 4, [handler, &image](int) {
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.translate(image.width() / 2, image.height() / 2);
+    handler->paintStatistics(&painter, 0, 1.0);
+    return true;
+  }));
+}
+
+// Append an SEI with a user_data_unregistered payload (payloadType 5) of the given size. The data does
+// not contain zero bytes so that no emulation prevention is needed.
+void appendUserDataSEIPayload(QByteArray &data, int payloadSize)
+{
+  data.append(char(5));
+  int size = payloadSize;
+  while (size >= 255)
+  {
+    data.append(char(0xff));
+    size -= 255;
+  }
+  data.append(char(size));
+  for (int i = 0; i < payloadSize; i++)
+    data.append(char('A' + i % 26));
+  data.append(char(0x80));  // rbsp_trailing_bits
+}
+
+// Create an annex B stream with alternating access unit delimiters and SEI NAL units
+QByteArray createSyntheticAnnexBStream(bool hevc, int nrUnits, int seiPayloadSize)
+{
+  QByteArray data;
+  for (int i = 0; i < nrUnits; i++)
+  {
+    data.append(QByteArray::fromHex("00000001"));
+    if (hevc)
+      data.append(QByteArray::fromHex("460150"));  // AUD_NUT with pic_type 2
+    else
+      data.append(QByteArray::fromHex("09f0"));    // AUD with primary_pic_type 7
+    data.append(QByteArray::fromHex("000001"));
+    data.append(hevc ? QByteArray::fromHex("4e01") : QByteArray::fromHex("06"));  // PREFIX_SEI_NUT / SEI
+    appendUserDataSEIPayload(data, seiPayloadSize);
+  }
+  return data;
+}
+
+// Create a low overhead AV1 bitstream with temporal delimiters and padding OBUs
+QByteArray createSyntheticOBUStream(int nrUnits, int paddingSize)
+{
+  QByteArray data;
+  for (int i = 0; i < nrUnits; i++)
+  {
+    data.append(QByteArray::fromHex("1200"));  // OBU_TEMPORAL_DELIMITER with obu_size 0
+    data.append(char(0x7a));                   // OBU_PADDING with obu_has_size_field
+    unsigned int size = paddingSize;
+    do
+    {
+      unsigned char byte = size & 0x7f;
+      size >>= 7;
+      if (size > 0)
+        byte |= 0x80;
+      data.append(char(byte));
+    } while (size > 0);
+    data.append(QByteArray(paddingSize, char(0x55)));
+  }
+  return data;
+}
+
+bool writeFile(const QString &fileName, const QByteArray &data)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  return file.write(data) == data.size();
+}
+
+void benchmarkParsers(const QString &tempPath, int nrUnits, const QStringList &avformatFiles, QJsonArray &results)
+{
+  const int payloadSize = 1000;
+
+  for (bool hevc : {true, false})
+  {
+    const QString fileName = tempPath + (hevc ? "/benchmark.hevc" : "/benchmark.h264");
+    const QByteArray stream = createSyntheticAnnexBStream(hevc, nrUnits, payloadSize);
+    if (!writeFile(fileName, stream))
+      continue;
+    results.append(timeRuns("parser", hevc ? "AnnexB HEVC" : "AnnexB AVC", 1, stream.size(), [hevc, &fileName](int) {
+      QScopedPointer<parserAnnexB> parser;
+      if (hevc)
+        parser.reset(new parserAnnexBHEVC());
+      else
+        parser.reset(new parserAnnexBAVC());
+      return parser->runParsingOfFile(fileName);
+    }));
+  }
+
+  const QByteArray obuStream = createSyntheticOBUStream(nrUnits, payloadSize);
+  results.append(timeRuns("parser", "AV1 OBU", 1, obuStream.size(), [&obuStream](int) {
+    parserAV1OBU parser;
+    int obuID = 0;
+    int pos = 0;
+    while (pos < obuStream.size())
+    {
+      // Don't copy the remaining stream for every OBU
+      const QByteArray remaining = QByteArray::fromRawData(obuStream.constData() + pos, obuStream.size() - pos);
+      const unsigned int nrBytes = parser.parseAndAddOBU(obuID++, remaining);
+      if (nrBytes == 0)
+        return false;
+      pos += nrBytes;
+    }
+    return true;
+  }));
+
+  // The avformat parser needs the ffmpeg libraries. If they can not be loaded, the entries are marked as skipped.
+  QStringList files = QStringList() << tempPath + "/benchmark.hevc" << avformatFiles;
+  for (const QString &fileName : files)
+  {
+    results.append(timeRuns("parser", "AVFormat " + QFileInfo(fileName).fileName(), 1, QFileInfo(fileName).size(), [&fileName](int) {
+      parserAVFormat parser;
+      return parser.runParsingOfFile(fileName);
+    }));
+  }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  // The benchmark never shows a window
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  qRegisterMetaType<recacheIndicator>("recacheIndicator");
+
+  QApplication app(argc, argv);
+  app.setApplicationName("YUView");
+  app.setOrganizationName("Institut für Nachrichtentechnik, RWTH Aachen University");
+  app.setOrganizationDomain("ient.rwth-aachen.de");
+
+  QCommandLineParser cmdParser;
+  cmdParser.setApplicationDescription("Non-interactive benchmark of the YUView conversion, difference, statistics and parsing code.");
+  cmdParser.addHelpOption();
+  QCommandLineOption widthOption("width", "Width of the synthetic frames.", "width", "1920");
+  QCommandLineOption heightOption("height", "Height of the synthetic frames.", "height", "1080");
+  QCommandLineOption framesOption("frames", "Number of frames to process per benchmark.", "frames", "20");
+  QCommandLineOption unitsOption("units", "Number of NAL/OBU units in the synthetic bitstreams.", "units", "16000");
+  QCommandLineOption groupOption("group", "Only run the given group (convertYUVToRGB, calculateDifference, statistics, parser). Can be given multiple times.", "group");
+  QCommandLineOption fileOption("avformat-file", "Additionally parse this file with the avformat parser. Can be given multiple times.", "file");
+  QCommandLineOption outputOption("output", "Write the JSON results to this file instead of stdout.", "file");
+  cmdParser.addOptions({widthOption, heightOption, framesOption, unitsOption, groupOption, fileOption, outputOption});
+  cmdParser.process(app);
+
+  const QSize frameSize(cmdParser.value(widthOption).toInt(), cmdParser.value(heightOption).toInt());
+  const int nrFrames = std::max(1, cmdParser.value(framesOption).toInt());
+  const int nrUnits = std::max(1, cmdParser.value(unitsOption).toInt());
+  const QStringList groups = cmdParser.values(groupOption);
+  if (!frameSize.isValid() || frameSize.width() % 4 != 0 || frameSize.height() % 4 != 0)
+  {
+    std::cerr << "The frame size must be valid and a multiple of 4.\n";
+    return 1;
+  }
+
+  QTemporaryDir tempDir;
+  if (!tempDir.isValid())
+  {
+    std::cerr << "Could not create a temporary directory.\n";
+    return 1;
+  }
+
+  QJsonArray results;
+  if (groups.isEmpty() || groups.contains("convertYUVToRGB"))
+    benchmarkYUVConversion(frameSize, nrFrames, results);
+  if (groups.isEmpty() || groups.contains("calculateDifference"))
+    benchmarkDifference(frameSize, nrFrames, results);
+  if (groups.isEmpty() || groups.contains("statistics"))
+    benchmarkStatistics(tempDir.path(), frameSize, nrFrames, results);
+  if (groups.isEmpty() || groups.contains("parser"))
+    benchmarkParsers(tempDir.path(), nrUnits, cmdParser.values(fileOption), results);
+
+  QJsonObject root;
+  root["qtVersion"] = QString(qVersion());
+  root["idealThreadCount"] = QThread::idealThreadCount();
+  root["width"] = frameSize.width();
+  root["height"] = frameSize.height();
+  root["results"] = results;
+  const QByteArray json = QJsonDocument(root).toJson();
+
+  if (cmdParser.isSet(outputOption))
+  {
+    if (!writeFile(cmdParser.value(outputOption), json))
+    {
+      std::cerr << "Could not write the output file.\n";
+      return 1;
+    }
+  }
+  else
+    std::cout << json.constData();
+
+  return 0;
+}
@@ -32,6 +32,8 @@
 
 #include "functions.h"
 
+#include <algorithm>
+
 #ifdef Q_OS_MAC
 #include <sys/types.h>
 #include <sys/sysctl.h>
@@ -41,12 +43,88 @@
 #include <windows.h>
 #endif
 
+#include <QFile>
 #include <QIcon>
 #include <QSettings>
 #include <QThread>
 
 using namespace YUView;
 
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+namespace
+{
+  // Read a single number from a file (like a cgroup limit). Returns -1 if there is no number in the file (e.g. "max").
+  int64_t readNumberFromFile(const QString &path)
+  {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+      return -1;
+    bool ok;
+    const int64_t value = file.readAll().trimmed().toLongLong(&ok);
+    return ok ? value : -1;
+  }
+
+  // Read the value of the given key from a file with "key value" lines (like /proc/meminfo or memory.stat)
+  int64_t readKeyValueFromFile(const QString &path, const QByteArray &key)
+  {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+      return -1;
+    for (const QByteArray &line : file.readAll().split('\n'))
+    {
+      const QList<QByteArray> fields = line.simplified().split(' ');
+      if (fields.count() >= 2 && (fields[0] == key || fields[0] == key + ':'))
+      {
+        bool ok;
+        const int64_t value = fields[1].toLongLong(&ok);
+        if (!ok)
+          return -1;
+        // /proc/meminfo reports kB
+        return (fields.count() >= 3 && fields[2] == "kB") ? value * 1024 : value;
+      }
+    }
+    return -1;
+  }
+
+  struct cgroupMemory
+  {
+    int64_t limit {-1};         //< -1 if there is no limit
+    int64_t usage {-1};
+    int64_t inactiveFile {0};  //< Page cache that can be reclaimed easily
+  };
+
+  // Get the memory limit and usage of the control group that this process runs in
+  cgroupMemory getCgroupMemory()
+  {
+    cgroupMemory mem;
+
+    // cgroup v2: The path of the group is given in the "0::" line
+    QString cgroupV2Dir = "/sys/fs/cgroup";
+    QFile cgroupFile("/proc/self/cgroup");
+    if (cgroupFile.open(QIODevice::ReadOnly))
+      for (const QByteArray &line : cgroupFile.readAll().split('\n'))
+        if (line.startsWith("0::") && QFile::exists(cgroupV2Dir + QString::fromUtf8(line.mid(3)) + "/memory.max"))
+          cgroupV2Dir += QString::fromUtf8(line.mid(3));
+    if (QFile::exists(cgroupV2Dir + "/memory.max"))
+    {
+      mem.limit = readNumberFromFile(cgroupV2Dir + "/memory.max");
+      mem.usage = readNumberFromFile(cgroupV2Dir + "/memory.current");
+      mem.inactiveFile = std::max(readKeyValueFromFile(cgroupV2Dir + "/memory.stat", "inactive_file"), int64_t(0));
+      return mem;
+    }
+
+    // cgroup v1: There is no limit if the limit is set to a huge value
+    const QString cgroupV1Dir = "/sys/fs/cgroup/memory";
+    mem.limit = readNumberFromFile(cgroupV1Dir + "/memory.limit_in_bytes");
+    if (mem.limit >= (int64_t(1) << 60))
+      mem.limit = -1;
+    mem.usage = readNumberFromFile(cgroupV1Dir + "/memory.usage_in_bytes");
+    mem.inactiveFile = std::max(readKeyValueFromFile(cgroupV1Dir + "/memory.stat", "total_inactive_file"), int64_t(0));
+    return mem;
+  }
+}
+#endif
+
 bool functions::isInputFormatTypeAnnexB(inputFormat format) 
 { 
     return format == inputAnnexBHEVC || format == inputAnnexBVVC || format == inputAnnexBAVC; 
@@ -123,6 +201,9 @@ unsigned int functions::systemMemorySizeInMB()
     long pages = sysconf(_SC_PHYS_PAGES);
     long page_size = sysconf(_SC_PAGE_SIZE);
     memorySizeInMB = (pages * page_size) >> 20;
+    const int64_t cgroupLimit = getCgroupMemory().limit;
+    if (cgroupLimit > 0 && (cgroupLimit >> 20) < memorySizeInMB)
+      memorySizeInMB = cgroupLimit >> 20;
   #elif defined Q_OS_WIN32
     MEMORYSTATUSEX status;
     status.dwLength = sizeof(status);
@@ -133,6 +214,29 @@ unsigned int functions::systemMemorySizeInMB()
   return memorySizeInMB;
 }
 
+int64_t functions::availableMemoryInBytes()
+{
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+  int64_t available = readKeyValueFromFile("/proc/meminfo", "MemAvailable");
+  const cgroupMemory cgroup = getCgroupMemory();
+  if (cgroup.limit > 0 && cgroup.usage >= 0)
+  {
+    // The page cache is counted as usage of the group but it is reclaimed before the OOM killer is invoked
+    const int64_t availableInGroup = std::max(cgroup.limit - (cgroup.usage - cgroup.inactiveFile), int64_t(0));
+    available = (available < 0) ? availableInGroup : std::min(available, availableInGroup);
+  }
+  return available;
+#elif defined(Q_OS_WIN32)
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (!GlobalMemoryStatusEx(&status))
+    return -1;
+  return int64_t(status.ullAvailPhys);
+#else
+  return -1;
+#endif
+}
+
 QIcon functions::convertIcon(QString iconPath)
 {
   QSettings settings;
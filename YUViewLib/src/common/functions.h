@@ -100,10 +100,15 @@ void setupUi(void *ui, void(*setupUi)(void *ui, QWidget *widget));
 // so that one thread is "reserved" for the main GUI. I don't know if this is optimal.
 unsigned int getOptimalThreadCount();
 
-// Returns the size of system memory in megabytes.
+// Returns the size of system memory in megabytes. If the process runs in a control group with a memory limit
+// (e.g. in a container), the limit is returned if it is lower.
 // This function is thread safe and inexpensive to call.
 unsigned int systemMemorySizeInMB();
 
+// Returns the number of bytes that can still be allocated without swapping or exceeding the memory limit of the control
+// group (if any). Returns -1 if this is not known on this platform. This reads from the system so don't call it too often.
+int64_t availableMemoryInBytes();
+
 // These are the names of the supported themes
 QStringList getThemeNameList();
 // Get the name of the theme in the resource file that we will load
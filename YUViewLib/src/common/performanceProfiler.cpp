@@ -0,0 +1,296 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "performanceProfiler.h"
+
+#include <algorithm>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QThreadStorage>
+
+// The number of durations per item/stage that are used to calculate the percentiles
+#define PROFILER_HISTORY_SIZE 1024
+// The maximum number of events that are kept for the trace export
+#define PROFILER_TRACE_SIZE 200000
+
+Q_GLOBAL_STATIC(performanceProfiler, globalProfiler)
+
+namespace
+{
+  // The name of the item that each thread is currently working on
+  QThreadStorage<QString> currentItemName;
+
+  double percentileMs(QVector<qint64> &durations, double percentile)
+  {
+    if (durations.isEmpty())
+      return 0.0;
+    const int idx = std::min(int(durations.count() * percentile), durations.count() - 1);
+    std::nth_element(durations.begin(), durations.begin() + idx, durations.end());
+    return durations[idx] / 1e6;
+  }
+}
+
+QString performanceProfiler::getStageName(stage s)
+{
+  switch (s)
+  {
+  case stageFileRead:
+    return "File read";
+  case stageDecode:
+    return "Decode";
+  case stageCopyDecodedImage:
+    return "Copy decoded image";
+  case stageConvertToRGB:
+    return "Conversion to RGB";
+  case stageLoadStatistics:
+    return "Statistics load";
+  case stagePaint:
+    return "Paint";
+  case stagePresentationDelay:
+    return "Presentation delay";
+  default:
+    return "Unknown";
+  }
+}
+
+performanceProfiler::performanceProfiler()
+{
+  clock.start();
+}
+
+performanceProfiler &performanceProfiler::instance()
+{
+  return *globalProfiler();
+}
+
+void performanceProfiler::setEnabled(bool enabled)
+{
+  enabledFlag.store(enabled ? 1 : 0);
+}
+
+void performanceProfiler::addMeasurement(stage s, qint64 startNs, qint64 durationNs)
+{
+  const QString itemName = currentItemName.hasLocalData() ? currentItemName.localData() : QString();
+
+  QMutexLocker lock(&dataMutex);
+
+  stageHistory &history = histories[qMakePair(itemName, int(s))];
+  if (history.durationsNs.isEmpty())
+    history.durationsNs.resize(PROFILER_HISTORY_SIZE);
+  history.durationsNs[history.nextIdx] = durationNs;
+  history.nextIdx = (history.nextIdx + 1) % PROFILER_HISTORY_SIZE;
+  history.count++;
+  history.totalNs += durationNs;
+  history.maxNs = std::max(history.maxNs, durationNs);
+
+  const Qt::HANDLE threadID = QThread::currentThreadId();
+  if (!threadIndices.contains(threadID))
+    threadIndices.insert(threadID, threadIndices.count());
+
+  traceEvent event;
+  event.startNs = startNs;
+  event.durationNs = durationNs;
+  event.threadIdx = threadIndices.value(threadID);
+  event.stageIdx = int(s);
+  event.name = itemName;
+  event.value = 0;
+  addTraceEvent(event);
+}
+
+void performanceProfiler::setQueueDepth(const QString &queueName, int depth)
+{
+  if (!isEnabled())
+    return;
+
+  QMutexLocker lock(&dataMutex);
+  if (queueDepths.contains(queueName) && queueDepths.value(queueName) == depth)
+    return;
+  queueDepths[queueName] = depth;
+
+  traceEvent event;
+  event.startNs = getTimestampNs();
+  event.durationNs = 0;
+  event.threadIdx = 0;
+  event.stageIdx = -1;
+  event.name = queueName;
+  event.value = depth;
+  addTraceEvent(event);
+}
+
+void performanceProfiler::incrementCounter(const QString &counterName, int increment)
+{
+  if (!isEnabled())
+    return;
+
+  QMutexLocker lock(&dataMutex);
+  const int value = counters.value(counterName, 0) + increment;
+  counters[counterName] = value;
+
+  traceEvent event;
+  event.startNs = getTimestampNs();
+  event.durationNs = 0;
+  event.threadIdx = 0;
+  event.stageIdx = -2;
+  event.name = counterName;
+  event.value = value;
+  addTraceEvent(event);
+}
+
+void performanceProfiler::addTraceEvent(const traceEvent &event)
+{
+  if (traceEvents.count() < PROFILER_TRACE_SIZE)
+    traceEvents.append(event);
+  else
+  {
+    // Overwrite the oldest event
+    traceEvents[traceNextIdx] = event;
+    traceNextIdx = (traceNextIdx + 1) % PROFILER_TRACE_SIZE;
+  }
+}
+
+QList<performanceProfiler::stageStatistics> performanceProfiler::getStageStatistics() const
+{
+  QMutexLocker lock(&dataMutex);
+
+  QList<stageStatistics> statistics;
+  for (auto it = histories.constBegin(); it != histories.constEnd(); ++it)
+  {
+    const stageHistory &history = it.value();
+    QVector<qint64> durations = history.durationsNs.mid(0, std::min(history.count, PROFILER_HISTORY_SIZE));
+
+    stageStatistics s;
+    s.itemName = it.key().first;
+    s.s = stage(it.key().second);
+    s.count = history.count;
+    s.totalMs = history.totalNs / 1e6;
+    s.p50Ms = percentileMs(durations, 0.5);
+    s.p99Ms = percentileMs(durations, 0.99);
+    s.maxMs = history.maxNs / 1e6;
+    statistics.append(s);
+  }
+  return statistics;
+}
+
+QMap<QString, int> performanceProfiler::getQueueDepths() const
+{
+  QMutexLocker lock(&dataMutex);
+  return queueDepths;
+}
+
+QMap<QString, int> performanceProfiler::getCounters() const
+{
+  QMutexLocker lock(&dataMutex);
+  return counters;
+}
+
+bool performanceProfiler::exportChromeTrace(const QString &fileName) const
+{
+  QJsonArray events;
+  {
+    QMutexLocker lock(&dataMutex);
+
+    for (auto it = threadIndices.constBegin(); it != threadIndices.constEnd(); ++it)
+    {
+      QJsonObject metaEvent;
+      metaEvent["name"] = "thread_name";
+      metaEvent["ph"] = "M";
+      metaEvent["pid"] = 1;
+      metaEvent["tid"] = it.value();
+      metaEvent["args"] = QJsonObject{{"name", QString("Thread %1").arg(it.value())}};
+      events.append(metaEvent);
+    }
+
+    // Start with the oldest event of the ring buffer
+    for (int i = 0; i < traceEvents.count(); i++)
+    {
+      const traceEvent &e = traceEvents[(traceNextIdx + i) % traceEvents.count()];
+      QJsonObject event;
+      event["pid"] = 1;
+      event["ts"] = e.startNs / 1000.0;
+      if (e.stageIdx < 0)
+      {
+        event["name"] = e.name;
+        event["ph"] = "C";
+        event["args"] = QJsonObject{{(e.stageIdx == -1) ? "depth" : "count", e.value}};
+      }
+      else
+      {
+        event["name"] = getStageName(stage(e.stageIdx));
+        event["cat"] = isIOStage(stage(e.stageIdx)) ? "io" : (isTimingStage(stage(e.stageIdx)) ? "timing" : "cpu");
+        event["ph"] = "X";
+        event["tid"] = e.threadIdx;
+        event["dur"] = e.durationNs / 1000.0;
+        event["args"] = QJsonObject{{"item", e.name}};
+      }
+      events.append(event);
+    }
+  }
+
+  QJsonObject root;
+  root["traceEvents"] = events;
+  root["displayTimeUnit"] = "ms";
+
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  return file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) >= 0;
+}
+
+void performanceProfiler::clear()
+{
+  QMutexLocker lock(&dataMutex);
+  histories.clear();
+  traceEvents.clear();
+  traceNextIdx = 0;
+  queueDepths.clear();
+  counters.clear();
+}
+
+performanceProfiler::scopedItem::scopedItem(const QString &itemName)
+{
+  active = globalProfiler()->isEnabled();
+  if (!active)
+    return;
+  if (currentItemName.hasLocalData())
+    previousItemName = currentItemName.localData();
+  currentItemName.setLocalData(itemName);
+}
+
+performanceProfiler::scopedItem::~scopedItem()
+{
+  if (active)
+    currentItemName.setLocalData(previousItemName);
+}
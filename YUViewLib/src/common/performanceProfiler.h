@@ -0,0 +1,166 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERFORMANCEPROFILER_H
+#define PERFORMANCEPROFILER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+/* The performance profiler collects the time spent in the stages of the frame loading pipeline
+ * (file read, decoding, conversion, painting ...) per playlist item. For each item/stage combination
+ * a histogram of the recent durations is kept so that p50/p99 values can be shown. All measurements
+ * are also kept in a ring buffer which can be exported as a Chrome trace (chrome://tracing, Perfetto).
+ * Recording is off by default. If it is off, a scopedTimer costs only one atomic read.
+ */
+class performanceProfiler
+{
+public:
+  enum stage
+  {
+    stageFileRead,
+    stageDecode,
+    stageCopyDecodedImage,
+    stageConvertToRGB,
+    stageLoadStatistics,
+    stagePaint,
+    stagePresentationDelay,
+    stageNum
+  };
+  static QString getStageName(stage s);
+  // Is the stage (mainly) limited by I/O or by the CPU?
+  static bool isIOStage(stage s) { return s == stageFileRead; }
+  // The presentation delay is not work that is done but the difference between the time that a frame was
+  // shown during playback and the time that it should have been shown (the jitter of the playback).
+  static bool isTimingStage(stage s) { return s == stagePresentationDelay; }
+
+  // Don't create your own profiler. Use the global one.
+  performanceProfiler();
+  static performanceProfiler &instance();
+
+  void setEnabled(bool enabled);
+  bool isEnabled() const { return enabledFlag.load() != 0; }
+
+  // Add a measurement. It is accounted to the item that the calling thread is currently working on (see scopedItem).
+  void addMeasurement(stage s, qint64 startNs, qint64 durationNs);
+  // Set the current depth of a queue (e.g. the number of frames in the caching queue)
+  void setQueueDepth(const QString &queueName, int depth);
+  // Count an event (e.g. a playback stall). The counters only grow until the profiler is cleared.
+  void incrementCounter(const QString &counterName, int increment = 1);
+
+  // Nanoseconds since the profiler was created. This is thread-safe.
+  qint64 getTimestampNs() const { return clock.nsecsElapsed(); }
+
+  struct stageStatistics
+  {
+    QString itemName;
+    stage s;
+    int count;
+    double totalMs;
+    double p50Ms;
+    double p99Ms;
+    double maxMs;
+  };
+  QList<stageStatistics> getStageStatistics() const;
+  QMap<QString, int> getQueueDepths() const;
+  QMap<QString, int> getCounters() const;
+
+  // Write all recorded measurements and queue depths in the Chrome trace event format
+  bool exportChromeTrace(const QString &fileName) const;
+  void clear();
+
+  // Set the name of the item that the current thread is working on for the lifetime of this object.
+  class scopedItem
+  {
+  public:
+    scopedItem(const QString &itemName);
+    ~scopedItem();
+  private:
+    QString previousItemName;
+    bool active;
+  };
+
+  // Measure the time from construction to destruction of this object for the given stage.
+  class scopedTimer
+  {
+  public:
+    scopedTimer(stage s) : s(s), startNs(-1) { if (instance().isEnabled()) startNs = instance().getTimestampNs(); }
+    ~scopedTimer() { if (startNs >= 0) instance().addMeasurement(s, startNs, instance().getTimestampNs() - startNs); }
+  private:
+    stage s;
+    qint64 startNs;
+  };
+
+private:
+  QAtomicInt enabledFlag;
+  QElapsedTimer clock;
+  mutable QMutex dataMutex;
+
+  // The most recent durations per item and stage (a ring buffer)
+  struct stageHistory
+  {
+    QVector<qint64> durationsNs;
+    int nextIdx {0};
+    int count {0};
+    qint64 totalNs {0};
+    qint64 maxNs {0};
+  };
+  QMap<QPair<QString, int>, stageHistory> histories;
+
+  // All events for the trace export (a ring buffer). Queue depth and counter changes are saved as counter events.
+  struct traceEvent
+  {
+    qint64 startNs;
+    qint64 durationNs;
+    int threadIdx;
+    int stageIdx;       // -1 for a queue depth, -2 for a counter
+    QString name;       // The item name or the name of the queue/counter
+    int value;          // The queue depth or counter value
+  };
+  QVector<traceEvent> traceEvents;
+  int traceNextIdx {0};
+  void addTraceEvent(const traceEvent &event);
+
+  QMap<QString, int> queueDepths;
+  QMap<QString, int> counters;
+  // Small numbers for the threads in the trace
+  QHash<Qt::HANDLE, int> threadIndices;
+};
+
+#endif // PERFORMANCEPROFILER_H
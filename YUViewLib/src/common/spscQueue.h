@@ -0,0 +1,139 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+/* A bounded queue for exactly one producer thread and one consumer thread.
+ * Pushing and popping is lock-free (a ring buffer with atomic read/write positions). Only if the queue is
+ * full (push) or empty (pop) the calling thread sleeps on a wait condition until the other side made progress.
+ * The wait is done with a timeout so a wake up that is missed is not a problem. Waiting is aborted if the given
+ * abort flag is set (call wakeAll after setting the flag so that the threads react immediately).
+ */
+template<typename T>
+class spscQueue
+{
+public:
+  spscQueue(int capacity) : items(capacity + 1) {}
+
+  // Producer side. Returns false if waiting for a free slot was aborted.
+  bool push(T item, const std::atomic<bool> &abort)
+  {
+    const int writeIdx = writePos.load(std::memory_order_relaxed);
+    const int nextIdx = (writeIdx + 1) % items.size();
+    while (nextIdx == readPos.load(std::memory_order_acquire))
+    {
+      if (abort.load())
+        return false;
+      waitForChange();
+    }
+    items[writeIdx] = std::move(item);
+    writePos.store(nextIdx, std::memory_order_release);
+    notifyChange();
+    return true;
+  }
+
+  // Consumer side. Returns false if waiting for an item was aborted.
+  bool pop(T &item, const std::atomic<bool> &abort)
+  {
+    const int readIdx = readPos.load(std::memory_order_relaxed);
+    while (readIdx == writePos.load(std::memory_order_acquire))
+    {
+      if (abort.load())
+      {
+        // The producer may have pushed a last item right before it set the flag
+        if (readIdx == writePos.load(std::memory_order_acquire))
+          return false;
+        break;
+      }
+      waitForChange();
+    }
+    item = std::move(items[readIdx]);
+    items[readIdx] = T();
+    readPos.store((readIdx + 1) % items.size(), std::memory_order_release);
+    notifyChange();
+    return true;
+  }
+
+  // The number of items in the queue. This is only a snapshot if the other side is working.
+  int count() const
+  {
+    const int n = writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_acquire);
+    return n < 0 ? n + items.size() : n;
+  }
+
+  // Remove all items. Only call this if neither the producer nor the consumer are working.
+  void clear()
+  {
+    for (T &item : items)
+      item = T();
+    readPos.store(0);
+    writePos.store(0);
+  }
+
+  // Wake up all waiting threads (e.g. after setting the abort flag)
+  void wakeAll()
+  {
+    QMutexLocker lock(&waitMutex);
+    changed.wakeAll();
+  }
+
+private:
+  void waitForChange()
+  {
+    QMutexLocker lock(&waitMutex);
+    nrWaiting++;
+    changed.wait(&waitMutex, 5);
+    nrWaiting--;
+  }
+  void notifyChange()
+  {
+    // Only take the lock if the other side is sleeping
+    if (nrWaiting.load() > 0)
+      wakeAll();
+  }
+
+  QVector<T> items;  //< One slot is always free to distinguish a full from an empty queue
+  std::atomic<int> readPos {0};
+  std::atomic<int> writePos {0};
+
+  QMutex waitMutex;
+  QWaitCondition changed;
+  std::atomic<int> nrWaiting {0};
+};
+
+#endif // SPSCQUEUE_H
@@ -238,6 +238,12 @@ struct RangeInt
   int max;
 };
 
+struct RangeInt64
+{
+  int64_t min;
+  int64_t max;
+};
+
 // A list of value pair lists, where every list has a string (title)
 class ValuePairListSets : public QList<QPair<QString, QStringPairList>>
 {
@@ -32,6 +32,8 @@
 
 #include "decoderBase.h"
 
+#include <algorithm>
+
 #include <QDir>
 #include <QSettings>
 
@@ -78,6 +80,16 @@ statisticsData decoderBase::getStatisticsData(int typeIdx)
   return curPOCStats[typeIdx];
 }
 
+int64_t decoderBase::getMemoryUsage() const
+{
+  int64_t pictureSize = 0;
+  if (rawFormat == raw_YUV)
+    pictureSize = formatYUV.bytesPerFrame(frameSize);
+  else if (rawFormat == raw_RGB)
+    pictureSize = formatRGB.bytesPerFrame(frameSize);
+  return 17 * std::max(pictureSize, int64_t(0));
+}
+
 void decoderBaseSingleLib::loadDecoderLibrary(QString specificLibrary)
 {
   // Try to load the HM library from the current working directory
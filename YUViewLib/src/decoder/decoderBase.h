@@ -71,6 +71,10 @@ public:
   // Call decodeNextFrame to advance to the next frame. When the function returns false, more data is probably needed.
   virtual bool decodeNextFrame() = 0;
   virtual QByteArray getRawFrameData() = 0;
+  // Get the full decoded sample arrays of the current frame (before the conformance window cropping) of the given
+  // luma size. offset is the position of the cropped output in the luma array. This is only possible for the
+  // reconstruction signal. An empty array is returned if the decoder does not support this.
+  virtual QByteArray getRawFrameDataUncropped(const QPoint &offset, const QSize &size) { Q_UNUSED(offset); Q_UNUSED(size); return QByteArray(); }
   YUView::RawFormat getRawFormat() const { return rawFormat; }
   YUV_Internals::yuvPixelFormat getYUVPixelFormat() const { return formatYUV; }
   RGB_Internals::rgbPixelFormat getRGBPixelFormat() const { return formatRGB; }
@@ -91,6 +95,11 @@ public:
   statisticsData getStatisticsData(int typeIdx);
   virtual void fillStatisticList(statisticHandler &statSource) const { Q_UNUSED(statSource); };
 
+  // Get an estimate of the memory (in bytes) that the decoder uses internally. The default assumes a full decoded
+  // picture buffer (16 reference pictures and the current picture) in the output format. Decoders that know better
+  // can override this. The statistics of the current frame are not included since they are counted by the item.
+  virtual int64_t getMemoryUsage() const;
+
   // Error handling
   bool errorInDecoder() const { return decoderState == decoderError; }
   QString decoderErrorString() const { return errorString; }
@@ -38,6 +38,7 @@
 #include <QDir>
 #include <QSettings>
 
+#include "common/performanceProfiler.h"
 #include "common/typedef.h"
 
 using namespace YUView;
@@ -308,7 +309,10 @@ QByteArray decoderDav1d::getRawFrameData()
   if (currentOutputBuffer.isEmpty())
   {
     // Put image data into buffer
-    copyImgToByteArray(curPicture, currentOutputBuffer);
+    {
+      performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageCopyDecodedImage);
+      copyImgToByteArray(curPicture, currentOutputBuffer);
+    }
     DEBUG_DAV1D("decoderDav1d::getRawFrameData copied frame to buffer");
 
     if (retrieveStatistics)
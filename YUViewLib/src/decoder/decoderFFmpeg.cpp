@@ -32,6 +32,8 @@
 
 #include "decoderFFmpeg.h"
 
+#include "common/performanceProfiler.h"
+
 #define DECODERFFMPEG_DEBUG_OUTPUT 0
 #if DECODERFFMPEG_DEBUG_OUTPUT && !NDEBUG
 #include <QDebug>
@@ -168,6 +170,8 @@ void decoderFFmpeg::copyCurImageToBuffer()
   if (!frame)
     return;
 
+  performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageCopyDecodedImage);
+
   //// get metadata
   //AVDictionaryWrapper dict = ff.get_metadata(frame);
   //QStringPairList values = ff.get_dictionary_entries(dict, "", 0);
@@ -37,6 +37,7 @@
 #include <QDir>
 #include <QSettings>
 
+#include "common/performanceProfiler.h"
 #include "common/typedef.h"
 
 // Debug the decoder ( 0:off 1:interactive deocder only 2:caching decoder only 3:both)
@@ -302,7 +303,10 @@ QByteArray decoderHM::getRawFrameData()
   if (currentOutputBuffer.isEmpty())
   {
     // Put image data into buffer
-    copyImgToByteArray(currentHMPic, currentOutputBuffer);
+    {
+      performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageCopyDecodedImage);
+      copyImgToByteArray(currentHMPic, currentOutputBuffer);
+    }
     DEBUG_DECHM("decoderHM::getRawFrameData copied frame to buffer");
 
     if (retrieveStatistics)
@@ -37,6 +37,7 @@
 #include <QDir>
 #include <QSettings>
 
+#include "common/performanceProfiler.h"
 #include "common/typedef.h"
 
 using namespace YUView;
@@ -327,7 +328,10 @@ QByteArray decoderLibde265::getRawFrameData()
   if (currentOutputBuffer.isEmpty())
   {
     // Put image data into buffer
-    copyImgToByteArray(curImage, currentOutputBuffer);
+    {
+      performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageCopyDecodedImage);
+      copyImgToByteArray(curImage, currentOutputBuffer);
+    }
     DEBUG_LIBDE265("decoderLibde265::getRawFrameData copied frame to buffer");
     
     if (retrieveStatistics)
@@ -338,6 +342,55 @@ QByteArray decoderLibde265::getRawFrameData()
   return currentOutputBuffer;
 }
 
+QByteArray decoderLibde265::getRawFrameDataUncropped(const QPoint &offset, const QSize &size)
+{
+  if (curImage == nullptr || decoderState != decoderRetrieveFrames || decodeSignal != 0)
+    return QByteArray();
+
+  const de265_chroma cMode = de265_get_chroma_format(curImage);
+  const int nrPlanes = (cMode == de265_chroma_mono) ? 1 : 3;
+  const int subW = (cMode == de265_chroma_420 || cMode == de265_chroma_422) ? 2 : 1;
+  const int subH = (cMode == de265_chroma_420) ? 2 : 1;
+
+  int nrBytes = 0;
+  for (int c = 0; c < nrPlanes; c++)
+  {
+    const int nrBytesPerSample = (de265_get_bits_per_pixel(curImage, c) > 8) ? 2 : 1;
+    nrBytes += (c == 0) ? size.width() * size.height() * nrBytesPerSample : (size.width() / subW) * (size.height() / subH) * nrBytesPerSample;
+  }
+
+  QByteArray data;
+  data.resize(nrBytes);
+  uint8_t *dst_c = (uint8_t*)data.data();
+  for (int c = 0; c < nrPlanes; c++)
+  {
+    const int planeSubW = (c == 0) ? 1 : subW;
+    const int planeSubH = (c == 0) ? 1 : subH;
+    const int nrBytesPerSample = (de265_get_bits_per_pixel(curImage, c) > 8) ? 2 : 1;
+    const int width = size.width() / planeSubW;
+    const int height = size.height() / planeSubH;
+    // The decoded picture has to contain the output
+    if (offset.x() / planeSubW + de265_get_image_width(curImage, c) > width || offset.y() / planeSubH + de265_get_image_height(curImage, c) > height)
+      return QByteArray();
+
+    // libde265 returns a pointer to the cropped output within the full decoded sample array
+    int stride;
+    const uint8_t *img_c = de265_get_image_plane(curImage, c, &stride);
+    if (img_c == nullptr)
+      return QByteArray();
+    img_c -= (offset.y() / planeSubH) * stride + (offset.x() / planeSubW) * nrBytesPerSample;
+
+    const size_t widthInBytes = width * nrBytesPerSample;
+    for (int y = 0; y < height; y++)
+    {
+      memcpy(dst_c, img_c, widthInBytes);
+      img_c += stride;
+      dst_c += widthInBytes;
+    }
+  }
+  return data;
+}
+
 bool decoderLibde265::pushData(QByteArray &data) 
 {
   if (decoderState != decoderNeedsMoreData)
@@ -364,7 +417,7 @@ bool decoderLibde265::pushData(QByteArray &data)
         offset = 4;
     }
     // de265_push_NAL will return either DE265_OK or DE265_ERROR_OUT_OF_MEMORY
-    de265_error err = de265_push_NAL(decoder, data.data() + offset, data.size() - offset, 0, nullptr);
+    de265_error err = de265_push_NAL(decoder, data.constData() + offset, data.size() - offset, 0, nullptr);
     DEBUG_LIBDE265("decoderLibde265::pushData push data %d bytes%s%s", data.size(), err != DE265_OK ? " - err " : "", err != DE265_OK ? de265_get_error_text(err) : "");
     if (err != DE265_OK)
       return setErrorB("Error pushing data to decoder (de265_push_NAL): " + QString(de265_get_error_text(err)));
@@ -98,6 +98,7 @@ public:
   // Decoding / pushing data
   bool decodeNextFrame() Q_DECL_OVERRIDE;
   QByteArray getRawFrameData() Q_DECL_OVERRIDE;
+  QByteArray getRawFrameDataUncropped(const QPoint &offset, const QSize &size) Q_DECL_OVERRIDE;
   bool pushData(QByteArray &data) Q_DECL_OVERRIDE;
   
   // Statistics
@@ -37,6 +37,7 @@
 #include <QDir>
 #include <QSettings>
 
+#include "common/performanceProfiler.h"
 #include "common/typedef.h"
 
 // Debug the decoder ( 0:off 1:interactive deocder only 2:caching decoder only 3:both)
@@ -304,7 +305,10 @@ QByteArray decoderVTM::getRawFrameData()
   if (currentOutputBuffer.isEmpty())
   {
     // Put image data into buffer
-    copyImgToByteArray(currentVTMPic, currentOutputBuffer);
+    {
+      performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageCopyDecodedImage);
+      copyImgToByteArray(currentVTMPic, currentOutputBuffer);
+    }
     DEBUG_DECVTM("decoderVTM::getRawFrameData copied frame to buffer");
 
     if (retrieveStatistics)
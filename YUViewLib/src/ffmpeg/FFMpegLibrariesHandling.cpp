@@ -634,6 +634,17 @@ namespace
     AVCodecParameters *codecpar;
   } AVStream_57;
 
+  // The index entries are not part of the public API. This is the layout used by libavformat 57.
+  typedef struct AVIndexEntry_57
+  {
+    int64_t pos;
+    int64_t timestamp;
+  #define AVINDEX_KEYFRAME 0x0001
+    int flags:2;
+    int size:30;
+    int min_distance;
+  } AVIndexEntry_57;
+
   typedef struct AVStream_58
   {
     int index;
@@ -2254,6 +2265,22 @@ void AVStreamWrapper::update()
     assert(false);
 }
 
+QList<AVStreamWrapper::indexEntry> AVStreamWrapper::get_index_entries()
+{
+  QList<indexEntry> entries;
+  if (str == nullptr || libVer.avformat != 57)
+    return entries;
+
+  AVStream_57 *src = reinterpret_cast<AVStream_57*>(str);
+  if (src->index_entries == nullptr)
+    return entries;
+  AVIndexEntry_57 *srcEntries = reinterpret_cast<AVIndexEntry_57*>(src->index_entries);
+  entries.reserve(src->nb_index_entries);
+  for (int i = 0; i < src->nb_index_entries; i++)
+    entries.append({srcEntries[i].pos, srcEntries[i].timestamp, (srcEntries[i].flags & AVINDEX_KEYFRAME) != 0});
+  return entries;
+}
+
 QStringPairList AVStreamWrapper::getInfoText(AVCodecIDWrapper &codecIdWrapper)
 {
   QStringPairList info;
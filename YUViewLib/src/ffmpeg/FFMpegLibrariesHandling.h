@@ -403,9 +403,22 @@ public:
   int get_frame_height();
   AVColorSpace get_colorspace();
   int get_index() { update(); return index; }
+  int64_t get_nb_frames() { update(); return nb_frames; }
 
   AVCodecParametersWrapper get_codecpar() { update(); return codecpar; }
 
+  // The index that the demuxer read from the container (e.g. the mp4 stss/stts boxes or the mkv cues).
+  // The timestamps are in the time base of the stream. The index entries are not part of the public API,
+  // so this is only supported for the versions where we know the layout of the AVStream (57). Otherwise
+  // an empty list is returned.
+  struct indexEntry
+  {
+    int64_t pos;
+    int64_t timestamp;
+    bool keyframe;
+  };
+  QList<indexEntry> get_index_entries();
+
 private:
   void update();
 
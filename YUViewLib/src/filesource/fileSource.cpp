@@ -39,6 +39,9 @@
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
 
 #include "common/typedef.h"
  
@@ -74,6 +77,11 @@ bool fileSource::openFile(const QString &filePath)
   // Save the full file path
   fullFilePath = filePath;
 
+#ifdef Q_OS_LINUX
+  // Frames are mostly read in order. This increases the size of the read ahead window of the system.
+  posix_fadvise(srcFile.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
   // Install a watcher for the file (if file watching is active)
   updateFileWatchSetting();
   fileChanged = false;
@@ -332,5 +340,34 @@ void fileSource::clearFileCache()
 
   srcFile.setFileName(fullFilePath);
   srcFile.open(QIODevice::ReadOnly);
+#elif defined(Q_OS_LINUX)
+  // Drop all cached pages of the file. The file is only opened for reading so there are no dirty pages.
+  QMutexLocker locker(&readMutex);
+  posix_fadvise(srcFile.handle(), 0, 0, POSIX_FADV_DONTNEED);
+#endif
+}
+
+void fileSource::adviseWillNeed(int64_t startPos, int64_t nrBytes)
+{
+  if (!isFileOpened || nrBytes <= 0)
+    return;
+
+#ifdef Q_OS_LINUX
+  // This does not block. The system starts reading the range in the background.
+  posix_fadvise(srcFile.handle(), startPos, nrBytes, POSIX_FADV_WILLNEED);
+#else
+  Q_UNUSED(startPos);
+#endif
+}
+
+void fileSource::adviseDontNeed(int64_t startPos, int64_t nrBytes)
+{
+  if (!isFileOpened || nrBytes <= 0)
+    return;
+
+#ifdef Q_OS_LINUX
+  posix_fadvise(srcFile.handle(), startPos, nrBytes, POSIX_FADV_DONTNEED);
+#else
+  Q_UNUSED(startPos);
 #endif
 }
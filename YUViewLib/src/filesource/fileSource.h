@@ -105,9 +105,15 @@ public:
   // Check if we are supposed to watch the file for changes. If no, remove the file watcher. If yes, install one.
   void updateFileWatchSetting();
 
-  // Clear the cache of the file in the system. Currently only windows supported.
+  // Clear the cache of the file in the system. Currently only supported on windows and linux.
   void clearFileCache();
 
+  // Hints to the operating system about how the file will be accessed. Currently only supported on linux.
+  // The given range will be read soon. The system can start reading it in the background using large requests.
+  void adviseWillNeed(int64_t startPos, int64_t nrBytes);
+  // The given range was read and is not needed again soon. It can be released from the page cache.
+  void adviseDontNeed(int64_t startPos, int64_t nrBytes);
+
 private slots:
   void fileSystemWatcherFileChanged(const QString &path) { Q_UNUSED(path); fileChanged = true; }
 
@@ -32,6 +32,8 @@
 
 #include "fileSourceAnnexBFile.h"
 
+#include <algorithm>
+
 #define ANNEXBFILE_DEBUG_OUTPUT 0
 #if ANNEXBFILE_DEBUG_OUTPUT && !NDEBUG
 #include <QDebug>
@@ -86,25 +88,51 @@ void fileSourceAnnexBFile::seekToFirstNAL()
 }
 
 QByteArray fileSourceAnnexBFile::getNextNALUnit(bool getLastDataAgain, QUint64Pair *startEndPosInFile)
+{
+  return readNextNALUnit(getLastDataAgain, startEndPosInFile, false);
+}
+
+QByteArray fileSourceAnnexBFile::getNextNALUnitView(bool getLastDataAgain)
+{
+  return readNextNALUnit(getLastDataAgain, nullptr, true);
+}
+
+QByteArray fileSourceAnnexBFile::readNextNALUnit(bool getLastDataAgain, QUint64Pair *startEndPosInFile, bool returnView)
 {
   if (getLastDataAgain)
     return lastReturnArray;
 
   lastReturnArray.clear();
 
+  // After a start code that was split between two buffers, posInBuffer is "negative" (the start code
+  // began in the last buffer). These bytes are all zero bytes of the start code. They are not in the buffer anymore.
+  auto appendFromBuffer = [this](int64_t start, int64_t end)
+  {
+    if (start < 0)
+    {
+      lastReturnArray.append(int(-start), (char)0);
+      start = 0;
+    }
+    if (end > start)
+      lastReturnArray.append(fileBuffer.constData() + start, int(end - start));
+  };
+
   if (startEndPosInFile)
-    startEndPosInFile->first = bufferStartPosInFile + posInBuffer;
+    startEndPosInFile->first = int64_t(bufferStartPosInFile) + int(posInBuffer);
 
   int nextStartCodePos = -1;
   bool startCodeFound = false;
+  // Skip the start code of this NAL unit. In the next buffer, the search starts at the beginning.
+  int searchFrom = int(posInBuffer) + 3;
   while (!startCodeFound)
   {
-    nextStartCodePos = fileBuffer.indexOf(startCode, posInBuffer + 3);
+    nextStartCodePos = fileBuffer.indexOf(startCode, searchFrom);
 
-    if (nextStartCodePos < 0 || (uint64_t)nextStartCodePos > fileBufferSize)
+    // The buffer is not cleared. A start code must lie completely within the bytes that were read.
+    if (nextStartCodePos < 0 || (uint64_t)nextStartCodePos + 3 > fileBufferSize)
     {
       // No start code found ... append all data in the current buffer.
-      lastReturnArray += fileBuffer.mid(posInBuffer, fileBufferSize - posInBuffer);
+      appendFromBuffer(int(posInBuffer), fileBufferSize);
       DEBUG_ANNEXBFILE("fileSourceHEVCAnnexBFile::getNextNALUnit no start code found - ret size %d", retArray.size());
 
       if (fileBufferSize < BUFFER_SIZE)
@@ -123,7 +151,8 @@ QByteArray fileSourceAnnexBFile::getNextNALUnit(bool getLastDataAgain, QUint64Pa
 
       // We have to continue searching - get the next buffer
       updateBuffer();
-      
+      searchFrom = 0;
+
       if (fileBufferSize > 2)
       {
         // Now look for the special boundary case:
@@ -151,7 +180,7 @@ QByteArray fileSourceAnnexBFile::getNextNALUnit(bool getLastDataAgain, QUint64Pa
     {
       // Start code found. Check if the start code is 001 or 0001
       startCodeFound = true;
-      if (fileBuffer.at(nextStartCodePos - 1) == (char)0)
+      if (nextStartCodePos > 0 && fileBuffer.at(nextStartCodePos - 1) == (char)0)
         nextStartCodePos--;
     }
   }
@@ -159,7 +188,14 @@ QByteArray fileSourceAnnexBFile::getNextNALUnit(bool getLastDataAgain, QUint64Pa
   // Position found
   if (startEndPosInFile)
     startEndPosInFile->second = bufferStartPosInFile + nextStartCodePos;
-  lastReturnArray += fileBuffer.mid(posInBuffer, nextStartCodePos - posInBuffer);
+  if (nextStartCodePos < 0)
+    // The next start code began in the last buffer. Its zero bytes are not part of this NAL unit.
+    lastReturnArray.chop(-nextStartCodePos);
+  else if (returnView && lastReturnArray.isEmpty() && int(posInBuffer) >= 0)
+    // The NAL unit lies completely within the buffer. Don't copy it.
+    lastReturnArray = QByteArray::fromRawData(fileBuffer.constData() + posInBuffer, nextStartCodePos - posInBuffer);
+  else
+    appendFromBuffer(int(posInBuffer), nextStartCodePos);
   DEBUG_ANNEXBFILE("fileSourceHEVCAnnexBFile::getNextNALUnit start code found - ret size %d", lastReturnArray.size());
   posInBuffer = nextStartCodePos;
   return lastReturnArray;
@@ -170,35 +206,25 @@ QByteArray fileSourceAnnexBFile::getFrameData(QUint64Pair startEndFilePos)
   // Get all data for the frame (all NAL units in the raw format with start codes).
   // We don't need to convert the format to the mp4 ISO format. The ffmpeg decoder can also accept raw NAL units.
   // When the extradata is set as raw NAL units, the AVPackets must also be raw NAL units.
-  QByteArray retArray;
-  
-  uint64_t start = startEndFilePos.first;
-  uint64_t end = startEndFilePos.second;
+  // The NAL units of a frame are stored back to back in the file so they are read with one read into the
+  // returned array. This array has spare capacity so that the decoder can add its padding without a copy.
+  const int64_t start = startEndFilePos.first;
+  int64_t end = startEndFilePos.second;
 
-  // Seek the source file to the start position
-  seek(start);
-
-  // Retrieve NAL units (and repackage them) until we reached out end position
-  while (end > bufferStartPosInFile + posInBuffer)
-  {
-    QByteArray nalData = getNextNALUnit();
-
-    int headerOffset = 0;
-    if (nalData.at(0) == (char)0 && nalData.at(1) == (char)0)
-    {
-      if (nalData.at(2) == (char)0 && nalData.at(3) == (char)1)
-        headerOffset = 4;
-      else if (nalData.at(2) == (char)1)
-        headerOffset = 3;
-    }
-    assert(headerOffset > 0);
-    if (headerOffset == 3)
-      retArray.append((char)0);
-
-    DEBUG_ANNEXBFILE("fileSourceHEVCAnnexBFile::getFrameData Load NAL - size %d", nalData.length());
-    retArray += nalData;
-  }
+  // The end position is the start of the next start code or the last byte of the file (see getNextNALUnit)
+  const int64_t fileSize = getFileSize();
+  if (end + 1 >= fileSize)
+    end = fileSize;
+  if (end <= start)
+    return {};
 
+  const int nrBytes = int(end - start);
+  QByteArray retArray;
+  retArray.reserve(nrBytes + FRAME_DATA_PADDING);
+  retArray.resize(nrBytes);
+  const int64_t nrBytesRead = readBytes(retArray, start, nrBytes);
+  retArray.resize(int(std::max(nrBytesRead, int64_t(0))));
+  DEBUG_ANNEXBFILE("fileSourceHEVCAnnexBFile::getFrameData Read frame - size %d", retArray.size());
   return retArray;
 }
 
@@ -40,6 +40,8 @@ using namespace YUV_Internals;
 
 // Internally, we use a buffer which we only update if necessary
 #define BUFFER_SIZE 500000
+// Spare capacity of the arrays returned by getFrameData (at least AV_INPUT_BUFFER_PADDING_SIZE)
+#define FRAME_DATA_PADDING 64
 
 /* This class is a normal fileSource for opening of raw AnnexBFiles.
  * Basically it understands that this is a binary file where each unit starts with a start code (0x0000001)
@@ -68,9 +70,15 @@ public:
   // Also return the start and end position of the NAL unit in the file so you can seek to it.
   // startEndPosInFile: The file positions of the first byte in the NAL header and the end position of the last byte
   QByteArray getNextNALUnit(bool getLastDataAgain=false, QUint64Pair *startEndPosInFile = nullptr);
+  // Same as getNextNALUnit but if the NAL unit lies completely within the internal buffer, the data is not copied.
+  // The returned array only references the internal buffer and is only valid until the next call to this class.
+  // Use this if the data is consumed (copied) right away like it is done by the decoders.
+  QByteArray getNextNALUnitView(bool getLastDataAgain=false);
 
   // Get all bytes that are needed to decode the next frame (from the given start to the given end position)
-  // The data will be returned in the ISO/IEC 14496-15 format (4 bytes size followed by the payload).
+  // The data is read with one read from the file and returned in the raw format (NAL units with start codes).
+  // The returned array has at least FRAME_DATA_PADDING bytes of spare capacity so that padding can be appended.
+  // The position of the NAL unit reader is undefined afterwards (seek before using getNextNALUnit again).
   QByteArray getFrameData(QUint64Pair startEndFilePos);
   
   // Seek the file to the given byte position. Update the buffer.
@@ -95,6 +103,8 @@ protected:
   // Seek to the first NAL header in the bitstream
   void seekToFirstNAL();
 
+  QByteArray readNextNALUnit(bool getLastDataAgain, QUint64Pair *startEndPosInFile, bool returnView);
+
   // We will keep the last buffer in case the reader wants to get it again
   QByteArray lastReturnArray;
 };
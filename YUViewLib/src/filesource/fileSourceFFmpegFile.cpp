@@ -33,8 +33,11 @@
 #include "fileSourceFFmpegFile.h"
 
 #include <QSettings>
-#include <QProgressDialog>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
 
+#include "parser/parserAV1OBU.h"
 #include "parser/parserCommon.h"
 
 #define FILESOURCEFFMPEGFILE_DEBUG_OUTPUT 0
@@ -48,6 +51,9 @@
 using namespace YUView;
 using namespace YUV_Internals;
 
+// The frame indexing runs in its own pool so that it does not block the caching or the opening of other items
+Q_GLOBAL_STATIC(QThreadPool, frameIndexingThreadPool)
+
 fileSourceFFmpegFile::fileSourceFFmpegFile()
 {
   // Set the start code to look for (0x00 0x00 0x01)
@@ -321,11 +327,17 @@ QList<QByteArray> fileSourceFFmpegFile::getParameterSets()
 
 fileSourceFFmpegFile::~fileSourceFFmpegFile()
 {
+  // The indexing thread uses our libraries. Abort it and wait for it to finish.
+  if (indexingFuture.isRunning())
+  {
+    frameIndex->abort.store(1);
+    indexingFuture.waitForFinished();
+  }
   if (pkt)
     pkt.free_packet();
 }
 
-bool fileSourceFFmpegFile::openFile(const QString &filePath, QWidget *mainWindow, fileSourceFFmpegFile *other, bool parseFile)
+bool fileSourceFFmpegFile::openFile(const QString &filePath, fileSourceFFmpegFile *other, bool parseFile)
 {
   // Check if the file exists
   fileInfo.setFile(filePath);
@@ -345,22 +357,20 @@ bool fileSourceFFmpegFile::openFile(const QString &filePath, QWidget *mainWindow
   // Save the full file path
   fullFilePath = filePath;
 
-  // Install a watcher for the file (if file watching is active)
-  updateFileWatchSetting();
+  // Install a watcher for the file (if file watching is active). The watcher can only be used from the thread that this
+  // object lives in. If the file is opened from another thread, the owner has to call updateFileWatchSetting later.
+  if (QThread::currentThread() == thread())
+    updateFileWatchSetting();
   fileChanged = false;
 
-  // If another (already opened) bitstream is given, copy bitstream info from there; Otherwise scan the bitstream.
+  // If another (already opened) bitstream is given, share the frame index with it. Otherwise index the bitstream.
   if (other && other->isFileOpened)
-  {
-    nrFrames = other->nrFrames;
-    keyFrameList = other->keyFrameList;
-  }
+    frameIndex = other->frameIndex;
   else if (parseFile)
   {
-    if (!scanBitstream(mainWindow))
-      return false;
-    
-    seekFileToBeginning();
+    frameIndex.reset(new frameIndex_t);
+    if (!fillIndexFromContainer())
+      indexingFuture = QtConcurrent::run(frameIndexingThreadPool(), this, &fileSourceFFmpegFile::scanBitstream);
   }
 
   return true;
@@ -380,11 +390,25 @@ void fileSourceFFmpegFile::updateFileWatchSetting()
 
 int fileSourceFFmpegFile::getClosestSeekableDTSBefore(int frameIdx, int &seekToFrameIdx) const
 {
+  if (!frameIndex)
+  {
+    seekToFrameIdx = 0;
+    return 0;
+  }
+
+  QMutexLocker locker(&frameIndex->mutex);
+  const QList<pictureIdx> &keyFrameList = frameIndex->keyFrameList;
+  if (keyFrameList.isEmpty())
+  {
+    seekToFrameIdx = 0;
+    return 0;
+  }
+
   // We are always be able to seek to the beginning of the file
   int bestSeekDTS = keyFrameList[0].dts;
   seekToFrameIdx = keyFrameList[0].frame;
 
-  for (pictureIdx idx : keyFrameList)
+  for (const pictureIdx &idx : keyFrameList)
   {
     if (idx.frame >= 0) 
     {
@@ -402,51 +426,109 @@ int fileSourceFFmpegFile::getClosestSeekableDTSBefore(int frameIdx, int &seekToF
   return bestSeekDTS;
 }
 
-bool fileSourceFFmpegFile::scanBitstream(QWidget *mainWindow)
+bool fileSourceFFmpegFile::isIndexing() const
 {
-  if (!isFileOpened)
+  if (!frameIndex)
     return false;
+  QMutexLocker locker(&frameIndex->mutex);
+  return !frameIndex->done;
+}
 
-  // Create the dialog (if the given pointer is not null)
-  int64_t maxPTS = getMaxTS();
-  // Updating the dialog (setValue) is quite slow. Only do this if the percent value changes.
-  int curPercentValue = 0;
-  QScopedPointer<QProgressDialog> progress;
-  if (mainWindow != nullptr)
-  {
-    progress.reset(new QProgressDialog("Parsing (indexing) bitstream...", "Cancel", 0, 100, mainWindow));
-    progress->setMinimumDuration(1000);  // Show after 1s
-    progress->setAutoClose(false);
-    progress->setAutoReset(false);
-    progress->setWindowModality(Qt::WindowModal);
-  }
+void fileSourceFFmpegFile::waitForFirstKeyframe() const
+{
+  if (!frameIndex)
+    return;
+  QMutexLocker locker(&frameIndex->mutex);
+  while (!frameIndex->done && frameIndex->keyFrameList.isEmpty())
+    frameIndex->keyframeIndexed.wait(&frameIndex->mutex);
+}
 
-  nrFrames = 0;
-  while (goToNextPacket(true))
+bool fileSourceFFmpegFile::fillIndexFromContainer()
+{
+  // Most containers (e.g. mp4 or mkv) carry an index which the demuxer reads when opening the file. If the index
+  // has one entry per video frame, there is no need to walk through all packets.
+  const int64_t nrFramesInStream = video_stream.get_nb_frames();
+  QList<AVStreamWrapper::indexEntry> entries = video_stream.get_index_entries();
+  if (nrFramesInStream <= 0 || entries.count() != nrFramesInStream)
+    return false;
+
+  QList<pictureIdx> keyFrameList;
+  for (int i = 0; i < entries.count(); i++)
+    if (entries[i].keyframe)
+      keyFrameList.append(pictureIdx(i, entries[i].timestamp));
+  if (keyFrameList.isEmpty())
+    return false;
+
+  DEBUG_FFMPEG("fileSourceFFmpegFile::fillIndexFromContainer: Found %d frames and %d keyframes in the container index.", entries.count(), keyFrameList.length());
+  QMutexLocker locker(&frameIndex->mutex);
+  frameIndex->keyFrameList = keyFrameList;
+  frameIndex->nrFrames = entries.count();
+  frameIndex->progressPercent.store(100);
+  frameIndex->done = true;
+  return true;
+}
+
+void fileSourceFFmpegFile::scanBitstream()
+{
+  // Mark the index as done (also if anything goes wrong) and wake up everybody waiting for a keyframe
+  auto finishIndexing = [this]()
+  {
+    QMutexLocker locker(&frameIndex->mutex);
+    frameIndex->done = true;
+    frameIndex->keyframeIndexed.wakeAll();
+  };
+
+  // Use a separate format context so that the file can be read (decoded) while it is indexed
+  AVFormatContextWrapper ctx;
+  if (!ff.open_input(ctx, fullFilePath))
   {
-    DEBUG_FFMPEG("fileSourceFFmpegFile::scanBitstream: frame %d pts %d dts %d%s", nrFrames, (int)pkt.get_pts(), (int)pkt.get_dts(), pkt.get_flag_keyframe() ? " - keyframe" : "");
+    finishIndexing();
+    return;
+  }
+  AVPacketWrapper packet;
+  packet.allocate_paket(ff);
 
-    if (pkt.get_flag_keyframe())
-      keyFrameList.append(pictureIdx(nrFrames, pkt.get_dts()));
+  const int64_t maxPTS = getMaxTS();
 
-    if (progress && progress->wasCanceled())
-      return false;
+  // Not all demuxers set the keyframe flag correctly for AV1 (e.g. for IVF or raw OBU files).
+  // A minimal pass over the OBU and frame headers finds the shown key frames instead.
+  const bool isAV1 = getVideoStreamCodecID().isAV1();
+  parserAV1OBU::fastIndexer av1Indexer;
 
-    int newPercentValue = 0;
-    if (maxPTS != 0)
-      newPercentValue = clip(int(pkt.get_pts() * 100 / maxPTS), 0, 100);
-    if (newPercentValue != curPercentValue)
+  int nrFrames = 0;
+  while (!frameIndex->abort.load() && ctx.read_frame(ff, packet) == 0)
+  {
+    if (packet.get_stream_index() == streamIndices.video)
     {
-      if (progress)
-        progress->setValue(newPercentValue);
-      curPercentValue = newPercentValue;
-    }
+      bool keyframe = packet.get_flag_keyframe();
+      if (isAV1)
+      {
+        parserAV1OBU::fastIndexer::temporalUnitInfo info;
+        if (av1Indexer.indexTemporalUnit(packet.get_data(), packet.get_data_size(), info))
+          keyframe = info.isKeyframe;
+      }
+      DEBUG_FFMPEG("fileSourceFFmpegFile::scanBitstream: frame %d pts %d dts %d%s", nrFrames, (int)packet.get_pts(), (int)packet.get_dts(), keyframe ? " - keyframe" : "");
+
+      nrFrames++;
+      QMutexLocker locker(&frameIndex->mutex);
+      if (keyframe)
+      {
+        frameIndex->keyFrameList.append(pictureIdx(nrFrames - 1, packet.get_dts()));
+        frameIndex->keyframeIndexed.wakeAll();
+      }
+      frameIndex->nrFrames = nrFrames;
+      locker.unlock();
 
-    nrFrames++;
+      if (maxPTS != 0)
+        frameIndex->progressPercent.store(clip(int(packet.get_pts() * 100 / maxPTS), 0, 100));
+    }
+    packet.unref_packet(ff);
   }
 
-  DEBUG_FFMPEG("fileSourceFFmpegFile::scanBitstream: Scan done. Found %d frames and %d keyframes.", nrFrames, keyFrameList.length());
-  return !progress->wasCanceled();
+  packet.free_packet();
+  ctx.avformat_close_input(ff);
+  DEBUG_FFMPEG("fileSourceFFmpegFile::scanBitstream: Scan done. Found %d frames.", nrFrames);
+  finishIndexing();
 }
 
 void fileSourceFFmpegFile::openFileAndFindVideoStream(QString fileName)
@@ -615,12 +697,16 @@ int64_t fileSourceFFmpegFile::getMaxTS()
 
 indexRange fileSourceFFmpegFile::getDecodableFrameLimits() const
 {
-  if (this->keyFrameList.isEmpty() || nrFrames == 0)
+  if (!frameIndex)
+    return {};
+
+  QMutexLocker locker(&frameIndex->mutex);
+  if (frameIndex->keyFrameList.isEmpty() || frameIndex->nrFrames == 0)
     return {};
 
   indexRange range;
-  range.first = this->keyFrameList.at(0).frame;
-  range.second = nrFrames;
+  range.first = frameIndex->keyFrameList.at(0).frame;
+  range.second = frameIndex->nrFrames;
   return range;
 }
 
@@ -33,6 +33,12 @@
 #ifndef FILESOURCEFFMPEGFILE_H
 #define FILESOURCEFFMPEGFILE_H
 
+#include <QAtomicInt>
+#include <QFuture>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QWaitCondition>
+
 #include "fileSource.h"
 #include "ffmpeg/FFMpegLibrariesHandling.h"
 #include "video/videoHandlerYUV.h"
@@ -49,8 +55,9 @@ public:
   ~fileSourceFFmpegFile();
 
   // Load the ffmpeg libraries and try to open the file. The fileSource will install a watcher for the file.
-  // Return false if anything goes wrong.
-  bool openFile(const QString &filePath, QWidget *mainWindow=nullptr, fileSourceFFmpegFile *other=nullptr, bool parseFile=true);
+  // If parseFile is set, the frames are indexed in the background (see isIndexing). If another file is
+  // given, the index of that file is shared instead. Return false if anything goes wrong.
+  bool openFile(const QString &filePath, fileSourceFFmpegFile *other=nullptr, bool parseFile=true);
   
   // Is the file at the end?
   // TODO: How do we do this?
@@ -88,8 +95,14 @@ public:
   bool seekFileToBeginning();
   int64_t getMaxTS();
 
-  // Get information on the video stream
+  // Get information on the video stream. While indexing, this only covers the frames indexed so far.
   indexRange getDecodableFrameLimits() const;
+
+  // Is the frame index still being built in the background?
+  bool isIndexing() const;
+  int getIndexingProgressPercent() const { return frameIndex ? frameIndex->progressPercent.load() : 0; }
+  // Block until at least one keyframe was indexed (or the indexing is done)
+  void waitForFirstKeyframe() const;
   
   AVCodecIDWrapper getVideoStreamCodecID() { return ff.getCodecIDWrapper(video_stream.getCodecID()); }
   AVCodecParametersWrapper getVideoCodecPar() { return video_stream.get_codecpar(); }
@@ -154,12 +167,6 @@ protected:
   QFileInfo fileInfo;
   bool      isFileOpened {false};
 
-  // In order to translate from frames to PTS, we need to count the frames and keep a list of
-  // the PTS values of keyframes that we can start decoding at.
-  // If a mainWindow pointer is given, open a progress dialog. Return true on success. False if the process was canceled.
-  bool scanBitstream(QWidget *mainWindow);
-  int nrFrames {0};
-
   // Private struct for navigation. We index frames by frame number and FFMpeg uses the pts.
   // This connects both values.
   struct pictureIdx
@@ -169,15 +176,33 @@ protected:
     int64_t dts;
   };
 
+  // In order to translate from frames to PTS, we need to count the frames and keep a list of
+  // the PTS values of keyframes that we can start decoding at. The index is built once (in the background)
+  // and shared by all instances that opened the same file. Frames can be seeked to as soon as they are indexed.
+  struct frameIndex_t
+  {
+    mutable QMutex mutex;
+    QWaitCondition keyframeIndexed;
+    QList<pictureIdx> keyFrameList;  //< A list of pairs (frameNr, DTS) that we can seek to.
+    int nrFrames {0};
+    bool done {false};
+    QAtomicInt progressPercent {0};
+    QAtomicInt abort {0};
+  };
+  QSharedPointer<frameIndex_t> frameIndex;
+  QFuture<void> indexingFuture;
+
+  // Try to fill the index from the index that the demuxer read from the container (e.g. the mp4 stss/stts boxes).
+  // This only works if the container has an entry for every video frame.
+  bool fillIndexFromContainer();
+  // Walk through all video packets (using a separate format context) and fill the index. Called from a thread.
+  void scanBitstream();
+
   packetDataFormat_t packetDataFormat {packetFormatUnknown};
 
   // The start code pattern to look for in case of a raw format
   QByteArray startCode;
 
-  // These are filled after opening a file (after scanBitstream was called)
-  QList<pictureIdx> keyFrameList;  //< A list of pairs (frameNr, PTS) that we can seek to.
-  //pictureIdx getClosestSeekableFrameNumberBeforeBefore(int frameIdx);
-
   // For parsing NAL units from the compressed data:
   QByteArray currentPacketData;
   int posInFile {-1};
@@ -197,17 +197,96 @@ unsigned int parserAV1OBU::parseAndAddOBU(int obuID, QByteArray data, TreeItem *
     auto new_frame_header = QSharedPointer<frame_header>(new frame_header(obu));
     parsingSuccess = new_frame_header->parse_frame_header(obuData, obuRoot, active_sequence_header, decValues);
 
+    if (parsingSuccess)
+    {
+      static const QStringList frameTypeNames = QStringList() << "KEY" << "INTER" << "INTRA_ONLY" << "SWITCH";
+      currentFrameTypes += frameTypeNames.value(new_frame_header->frame_type) + (new_frame_header->show_existing_frame ? " SHOW_EXISTING " : " ");
+    }
+
     if (obuTypeName)
       *obuTypeName = parsingSuccess ? "FRAME" : "FRAME(ERR)";
   }
 
   if (obuRoot)
     // Set a useful name of the TreeItem (the root for this NAL)
-    obuRoot->itemData.append(QString("OBU %1: %2").arg(obu.obu_idx).arg(obu_type_toString.value(obu.obu_type)) + specificDescription);
+    obuRoot->setName(QString("OBU %1: %2").arg(obu.obu_idx).arg(obu_type_toString.value(obu.obu_type)) + specificDescription);
 
   return nrBytesHeader + (int)obu.obu_size;
 }
 
+QString parserAV1OBU::getAndResetFrameTypes()
+{
+  const QString frameTypes = currentFrameTypes;
+  currentFrameTypes.clear();
+  return frameTypes;
+}
+
+bool parserAV1OBU::fastIndexer::indexTemporalUnit(const unsigned char *data, int size, temporalUnitInfo &info)
+{
+  int pos = 0;
+  while (pos < size)
+  {
+    // obu_header(): forbidden bit, obu_type (4), obu_extension_flag, obu_has_size_field, reserved bit
+    const int obuType = (data[pos] >> 3) & 0x0F;
+    const bool obuExtensionFlag = data[pos] & 0x04;
+    const bool obuHasSizeField = data[pos] & 0x02;
+    pos += obuExtensionFlag ? 2 : 1;
+    if (pos > size)
+      return false;
+
+    // Without a size field, the OBU fills the rest of the data
+    uint64_t obuSize = size - pos;
+    if (obuHasSizeField)
+    {
+      obuSize = 0;
+      for (int i = 0; i < 8; i++)
+      {
+        if (pos >= size)
+          return false;
+        const unsigned char leb128Byte = data[pos++];
+        obuSize |= uint64_t(leb128Byte & 0x7F) << (i * 7);
+        if (!(leb128Byte & 0x80))
+          break;
+      }
+    }
+    if (obuSize > uint64_t(size - pos))
+      return false;
+
+    if (obuType == OBU_SEQUENCE_HEADER && obuSize > 0)
+    {
+      // seq_profile (3), still_picture (1), reduced_still_picture_header (1)
+      info.hasSequenceHeader = true;
+      reducedStillPictureHeader = data[pos] & 0x08;
+    }
+    else if ((obuType == OBU_FRAME || obuType == OBU_FRAME_HEADER) && obuSize > 0)
+    {
+      if (reducedStillPictureHeader)
+      {
+        info.isKeyframe = true;
+        info.nrShownFrames++;
+      }
+      else
+      {
+        // show_existing_frame (1), frame_type (2), show_frame (1)
+        const bool showExistingFrame = data[pos] & 0x80;
+        const int frameType = (data[pos] >> 5) & 0x03;
+        const bool showFrame = data[pos] & 0x10;
+        if (showExistingFrame)
+          info.nrShownFrames++;
+        else if (showFrame)
+        {
+          info.nrShownFrames++;
+          if (frameType == KEY_FRAME)
+            info.isKeyframe = true;
+        }
+      }
+    }
+
+    pos += int(obuSize);
+  }
+  return true;
+}
+
 bool parserAV1OBU::sequence_header::parse_sequence_header(const QByteArray &sequenceHeaderData, TreeItem *root)
 {
   obuPayload = sequenceHeaderData;
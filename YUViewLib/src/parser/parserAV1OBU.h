@@ -55,6 +55,28 @@ public:
     unsigned int getNrStreams() Q_DECL_OVERRIDE { return 1; }
     QString getShortStreamDescription(int streamIndex) const override { Q_UNUSED(streamIndex); return "Video"; }
 
+    // Get the types of all frames that were parsed since the last call (e.g. "KEY" or "INTER SHOW_EXISTING")
+    QString getAndResetFrameTypes();
+
+    // A minimal pass over the OBUs of a temporal unit for building a seek index. Only the obu_header, the obu_size
+    // and the first bits of the sequence and frame headers are read. Nothing is logged and no headers are kept.
+    class fastIndexer
+    {
+    public:
+      struct temporalUnitInfo
+      {
+        bool hasSequenceHeader {false};
+        bool isKeyframe {false};         //< Contains a shown key frame where decoding can start
+        unsigned int nrShownFrames {0};  //< Frames with show_frame or show_existing_frame set
+      };
+      // Returns false if the OBUs could not be read (e.g. the data is truncated)
+      bool indexTemporalUnit(const unsigned char *data, int size, temporalUnitInfo &info);
+
+    private:
+      // Set in the last sequence header. If set, each frame header is a shown key frame.
+      bool reducedStillPictureHeader {false};
+    };
+
 protected:
 
   enum frame_type_enum
@@ -556,6 +578,8 @@ protected:
   };  // struct frame_header
 
   QSharedPointer<sequence_header> active_sequence_header;
+
+  QString currentFrameTypes;
 };
 
 #endif // PARSERAV1OBU_H
\ No newline at end of file
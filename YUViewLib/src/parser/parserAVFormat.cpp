@@ -451,6 +451,14 @@ bool parserAVFormat::parseAVPacket(unsigned int packetID, AVPacketWrapper &packe
       specificDescription = " - OBUs:";
       for (QString n : obuNames)
         specificDescription += (" " + n);
+
+      // Unlike the AnnexB parsers, the OBU parser does not add bitrate entries itself
+      BitrateItemModel::bitrateEntry entry;
+      entry.pts = packet.get_pts();
+      entry.dts = packet.get_dts();
+      entry.bitrate = packet.get_data_size();
+      entry.keyframe = packet.get_flag_keyframe();
+      bitrateItemModel->addBitratePoint(packet.get_stream_index(), entry, obuParser->getAndResetFrameTypes());
     }
   }
   else if (packet.getPacketType() == PacketType::SUBTITLE_DVB)
@@ -507,7 +515,7 @@ bool parserAVFormat::parseAVPacket(unsigned int packetID, AVPacketWrapper &packe
   }
 
   // Set a useful name of the TreeItem (the root for this NAL)
-  itemTree->itemData.append(QString("AVPacket %1%2").arg(packetID).arg(packet.get_flag_keyframe() ? " - Keyframe": "") + specificDescription);
+  itemTree->setName(QString("AVPacket %1%2").arg(packetID).arg(packet.get_flag_keyframe() ? " - Keyframe": "") + specificDescription);
 
   return true;
 }
@@ -615,7 +623,7 @@ bool parserAVFormat::runParsingOfFile(QString compressedFilePath)
 {
   // Open the file but don't parse it yet.
   QScopedPointer<fileSourceFFmpegFile> ffmpegFile(new fileSourceFFmpegFile());
- if (!ffmpegFile->openFile(compressedFilePath, nullptr, nullptr, false))
+ if (!ffmpegFile->openFile(compressedFilePath, nullptr, false))
   {
     emit backgroundParsingDone("Error opening the ffmpeg file.");
     return false;
@@ -639,6 +647,10 @@ bool parserAVFormat::runParsingOfFile(QString compressedFilePath)
   int max_ts = ffmpegFile->getMaxTS();
   videoStreamIndex = ffmpegFile->getVideoStreamIndex();
 
+  // The AnnexB parsers set the timing of the bitrate analytics from the parameter sets
+  if (!annexBParser)
+    bitrateItemModel->setStreamTiming(videoStreamIndex, ffmpegFile->getFramerate());
+
   // Don't seek to the beginning here. This causes more problems then it solves.
   // ffmpegFile->seekFileToBeginning();
 
@@ -110,6 +110,17 @@ int parserAnnexB::getClosestSeekableFrameNumberBefore(int frameIdx, int &codingO
   return POCList.indexOf(bestSeekPOC);
 }
 
+bool parserAnnexB::getExpectedPictureHash(int frameIdx, decodedPictureHash &hash) const
+{
+  if (frameIdx < 0 || frameIdx >= POCList.size())
+    return false;
+  auto it = pictureHashList.find(POCList[frameIdx]);
+  if (it == pictureHashList.end())
+    return false;
+  hash = it.value();
+  return true;
+}
+
 QUint64Pair parserAnnexB::getFrameStartEndPos(int codingOrderFrameIdx)
 {
   if (codingOrderFrameIdx < 0 || codingOrderFrameIdx >= frameList.size())
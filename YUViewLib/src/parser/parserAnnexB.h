@@ -34,7 +34,9 @@
 #define PARSERANNEXB_H
 
 #include <QList>
+#include <QMap>
 
+#include "video/pictureHash.h"
 #include "video/videoHandlerYUV.h"
 #include "parserBase.h"
 #include "filesource/fileSourceAnnexBFile.h"
@@ -90,6 +92,13 @@ public:
 
   QUint64Pair getFrameStartEndPos(int codingOrderFrameIdx);
 
+  // Get the decoded picture hash that was transmitted in the bitstream for the given frame (display order).
+  // Returns false if there is no hash for the frame (or if the standard/parser does not support them).
+  bool getExpectedPictureHash(int frameIdx, decodedPictureHash &hash) const;
+  bool hasPictureHashes() const { return !pictureHashList.isEmpty(); }
+  // Get the POC of the given frame (display order). -1 if the frame index is invalid.
+  int getPOCOfFrame(int frameIdx) const { return POCList.value(frameIdx, -1); }
+
   bool parseAnnexBFile(QScopedPointer<fileSourceAnnexBFile> &file, QWidget *mainWindow=nullptr);
 
   // Called from the bitstream analyzer. This function can run in a background process.
@@ -161,6 +170,9 @@ protected:
 
   int pocOfFirstRandomAccessFrame {-1};
 
+  // The decoded picture hashes per POC as they were found in the bitstream
+  QMap<int, decodedPictureHash> pictureHashList;
+
   // Save general information about the file here
   struct stream_info_type
   {
@@ -222,6 +222,20 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
     if (new_sps->vui_parameters.nal_hrd_parameters_present_flag || new_sps->vui_parameters.vcl_hrd_parameters_present_flag)
       CpbDpbDelaysPresentFlag = true;
 
+    if (bitrateModel && parsingSuccess)
+    {
+      // Use the first NAL HRD CPB for the CPB simulation of the bitrate analytics (E.2.2)
+      BitrateAnalytics::hrdParameters hrd;
+      const auto &vui = new_sps->vui_parameters;
+      if (new_sps->vui_parameters_present_flag && vui.nal_hrd_parameters_present_flag && !vui.nal_hrd.bit_rate_value_minus1.isEmpty() && !vui.nal_hrd.cpb_size_value_minus1.isEmpty())
+      {
+        hrd.bitRate = (uint64_t(vui.nal_hrd.bit_rate_value_minus1[0]) + 1) << (6 + vui.nal_hrd.bit_rate_scale);
+        hrd.cpbSize = (uint64_t(vui.nal_hrd.cpb_size_value_minus1[0]) + 1) << (4 + vui.nal_hrd.cpb_size_scale);
+        hrd.cbr = !vui.nal_hrd.cbr_flag.isEmpty() && vui.nal_hrd.cbr_flag[0];
+      }
+      bitrateModel->setStreamTiming(0, getFramerate(), hrd);
+    }
+
     DEBUG_AVC("parserAnnexBAVC::parseAndAddNALUnit Parse SPS ID %d", new_sps->seq_parameter_set_id);
   }
   else if (nal_avc.nal_unit_type == PPS) 
@@ -314,7 +328,7 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
       sei_data.remove(0, nrBytes);
 
       if (message_tree)
-        message_tree->itemData[0] = QString("sei_message %1 - %2").arg(sei_count).arg(new_sei->payloadTypeName);
+        message_tree->setName(QString("sei_message %1 - %2").arg(sei_count).arg(new_sei->payloadTypeName));
 
       // The real number of bytes to read from the bitstream may be higher than the indicated payload size (emulation prevention)
       int realPayloadSize = determineRealNumberOfBytesSEIEmulationPrevention(sei_data, new_sei->payloadSize);
@@ -328,6 +342,13 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
         auto new_buffering_period_sei = QSharedPointer<buffering_period_sei>(new buffering_period_sei(new_sei));
         result = new_buffering_period_sei->parse_buffering_period_sei(sub_sei_data, active_SPS_list, message_tree);
         reparse = new_buffering_period_sei;
+        // The initial CPB removal delay of the first NAL HRD CPB for the CPB simulation of the bitrate analytics
+        if (result == SEI_PARSING_OK && bitrateModel && !new_buffering_period_sei->initial_cpb_removal_delay.isEmpty())
+        {
+          auto refSPS = active_SPS_list.value(new_buffering_period_sei->seq_parameter_set_id);
+          if (refSPS && refSPS->vui_parameters.nal_hrd_parameters_present_flag)
+            bitrateModel->setInitialCpbRemovalDelay(0, new_buffering_period_sei->initial_cpb_removal_delay[0]);
+        }
       }
       else if (new_sei->payloadType == 1)
       {
@@ -395,8 +416,7 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
       entry.dts = counterAU;
       entry.bitrate = sizeCurrentAU;
       entry.keyframe = currentAUAllSlicesIntra;
-      entry.frameType = currentAUAllSliceTypes;
-      bitrateModel->addBitratePoint(0, entry);
+      bitrateModel->addBitratePoint(0, entry, currentAUAllSliceTypes);
     }
     sizeCurrentAU = 0;
     counterAU++;
@@ -417,7 +437,7 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
   if (nalRoot)
   {
     // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1: %2").arg(nal_avc.nal_idx).arg(nal_unit_type_toString.value(nal_avc.nal_unit_type)) + specificDescription);
+    nalRoot->setName(QString("NAL %1: %2").arg(nal_avc.nal_idx).arg(nal_unit_type_toString.value(nal_avc.nal_unit_type)) + specificDescription);
     nalRoot->setError(!parsingSuccess);
   }
 
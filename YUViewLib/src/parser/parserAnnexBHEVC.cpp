@@ -412,6 +412,24 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
     // Also add sps to list of all nals
     nalUnitList.append(new_sps);
 
+    if (bitrateModel && parsingSuccess)
+    {
+      // Use the NAL HRD of the highest sub layer for the CPB simulation of the bitrate analytics
+      BitrateAnalytics::hrdParameters hrd;
+      const auto &vui = new_sps->sps_vui_parameters;
+      if (new_sps->vui_parameters_present_flag && vui.vui_hrd_parameters_present_flag && vui.vui_hrd_parameters.nal_hrd_parameters_present_flag)
+      {
+        const auto &subLayerHrd = vui.vui_hrd_parameters.nal_sub_hrd[new_sps->sps_max_sub_layers_minus1];
+        if (!subLayerHrd.BitRate.isEmpty() && !subLayerHrd.CpbSize.isEmpty())
+        {
+          hrd.bitRate = subLayerHrd.BitRate[0];
+          hrd.cpbSize = subLayerHrd.CpbSize[0];
+          hrd.cbr = !subLayerHrd.cbr_flag.isEmpty() && subLayerHrd.cbr_flag[0];
+        }
+      }
+      bitrateModel->setStreamTiming(0, getFramerate(), hrd);
+    }
+
     // Add the SPS ID
     specificDescription = parsingSuccess ? QString(" SPS_NUT ID %1").arg(new_sps->sps_seq_parameter_set_id) : " SPS_NUT ERR";
     if (nalTypeName)
@@ -534,7 +552,7 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
       sei_data.remove(0, nrBytes);
 
       if (message_tree)
-        message_tree->itemData[0] = QString("sei_message %1 - %2").arg(sei_count).arg(new_sei->payloadTypeName);
+        message_tree->setName(QString("sei_message %1 - %2").arg(sei_count).arg(new_sei->payloadTypeName));
 
       QByteArray sub_sei_data = sei_data.mid(0, new_sei->payloadSize);
 
@@ -546,6 +564,9 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
         auto new_buffering_period_sei = QSharedPointer<buffering_period_sei>(new buffering_period_sei(new_sei));
         result = new_buffering_period_sei->parse_buffering_period_sei(sub_sei_data, active_SPS_list, message_tree);
         reparse = new_buffering_period_sei;
+        // The initial CPB removal delay of the first NAL HRD CPB for the CPB simulation of the bitrate analytics
+        if (result == SEI_PARSING_OK && bitrateModel && !new_buffering_period_sei->nal_initial_cpb_removal_delay.isEmpty())
+          bitrateModel->setInitialCpbRemovalDelay(0, new_buffering_period_sei->nal_initial_cpb_removal_delay[0]);
       }
       else if (new_sei->payloadType == 1)
       {
@@ -575,6 +596,24 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
         result = new_alternative_transfer_characteristics_sei->parse_alternative_transfer_characteristics_sei(sub_sei_data, message_tree);
         reparse = new_alternative_transfer_characteristics_sei;
       }
+      else if (new_sei->payloadType == 132 && nal_hevc.nal_type == SUFFIX_SEI_NUT)
+      {
+        auto new_decoded_picture_hash_sei = QSharedPointer<decoded_picture_hash_sei>(new decoded_picture_hash_sei(new_sei));
+        result = new_decoded_picture_hash_sei->parse_decoded_picture_hash_sei(sub_sei_data, message_tree);
+        if (result == SEI_PARSING_OK && curFramePOC != -1)
+        {
+          // The suffix SEI belongs to the picture of the preceding slices. The hash is calculated over the
+          // decoded sample arrays before cropping.
+          decodedPictureHash hash = new_decoded_picture_hash_sei->pictureHash;
+          if (lastFirstSliceSegmentInPic && lastFirstSliceSegmentInPic->actSPS)
+          {
+            auto actSPS = lastFirstSliceSegmentInPic->actSPS;
+            hash.pictureSize = QSize(actSPS->pic_width_in_luma_samples, actSPS->pic_height_in_luma_samples);
+            hash.croppingOffset = QPoint(actSPS->SubWidthC * actSPS->conf_win_left_offset, actSPS->SubHeightC * actSPS->conf_win_top_offset);
+          }
+          pictureHashList[curFramePOC] = hash;
+        }
+      }
       else
         // The default parser just logs the raw bytes
         result = new_sei->parser_sei_bytes(sub_sei_data, message_tree);
@@ -628,8 +667,7 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
     entry.dts = counterAU;
     entry.bitrate = sizeCurrentAU;
     entry.keyframe = currentAUAllSlicesIntra;
-    entry.frameType = currentAUAllSliceTypes;
-    bitrateModel->addBitratePoint(0, entry);
+    bitrateModel->addBitratePoint(0, entry, currentAUAllSliceTypes);
 
     sizeCurrentAU = 0;
     counterAU++;
@@ -649,7 +687,7 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
 
   if (nalRoot)
     // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1: %2").arg(nal_hevc.nal_idx).arg(nal_unit_type_toString.value(nal_hevc.nal_type)) + specificDescription);
+    nalRoot->setName(QString("NAL %1: %2").arg(nal_hevc.nal_idx).arg(nal_unit_type_toString.value(nal_hevc.nal_type)) + specificDescription);
 
   return true;
 }
@@ -2296,6 +2334,49 @@ bool parserAnnexBHEVC::alternative_transfer_characteristics_sei::parse_internal(
   return true;
 }
 
+bool parserAnnexBHEVC::decoded_picture_hash_sei::parse_internal(QByteArray &data, TreeItem *root)
+{
+  reader_helper reader(data, root, "decoded picture hash");
+  READBITS_M(hash_type, 8, QStringList() << "MD5" << "CRC" << "Checksum");
+  if (hash_type > 2)
+    return reader.addErrorMessageChildItem("Unknown hash_type");
+
+  pictureHash.type = decodedPictureHash::hashType(hash_type);
+  // There is one hash for a monochrome picture and 3 hashes otherwise
+  const int hashLength = decodedPictureHash::getHashLength(pictureHash.type);
+  const int nrComponents = (payloadSize - 1) / hashLength;
+  if ((payloadSize - 1) % hashLength != 0 || (nrComponents != 1 && nrComponents != 3))
+    return reader.addErrorMessageChildItem("The payload size does not match the hash_type");
+
+  for (int cIdx = 0; cIdx < nrComponents; cIdx++)
+  {
+    QByteArray hash;
+    if (pictureHash.type == decodedPictureHash::hashMD5)
+    {
+      QByteArray picture_md5;
+      for (int i = 0; i < 16; i++)
+        READBITS_A(picture_md5, 8, i);
+      hash = picture_md5;
+    }
+    else if (pictureHash.type == decodedPictureHash::hashCRC)
+    {
+      unsigned int picture_crc;
+      READBITS(picture_crc, 16);
+      hash.append(char(picture_crc >> 8));
+      hash.append(char(picture_crc & 0xff));
+    }
+    else
+    {
+      unsigned int picture_checksum;
+      READBITS(picture_checksum, 32);
+      for (int i = 0; i < 4; i++)
+        hash.append(char((picture_checksum >> (24 - 8 * i)) & 0xff));
+    }
+    pictureHash.componentHashes.append(hash);
+  }
+  return true;
+}
+
 bool parserAnnexBHEVC::dolbyVisionMetadata::parse_metadata(const QByteArray &data, TreeItem *root)
 {
   if (root == nullptr)
@@ -744,6 +744,19 @@ protected:
     bool parse_internal(QByteArray &sliceHeaderData, parserCommon::TreeItem *root);
   };
 
+  class decoded_picture_hash_sei : public sei
+  {
+  public:
+    decoded_picture_hash_sei(QSharedPointer<sei> sei_src) : sei(sei_src) {};
+    parserAnnexB::sei_parsing_return_t parse_decoded_picture_hash_sei(QByteArray &sliceHeaderData, parserCommon::TreeItem *root) { return parse_internal(sliceHeaderData, root) ? SEI_PARSING_OK : SEI_PARSING_ERROR; }
+
+    unsigned int hash_type;
+    // One hash per color component. The number of components follows from the payload size.
+    decodedPictureHash pictureHash;
+  private:
+    bool parse_internal(QByteArray &sliceHeaderData, parserCommon::TreeItem *root);
+  };
+
   struct dolbyVisionMetadata : nal_unit_hevc
   {
     dolbyVisionMetadata(const nal_unit_hevc &nal) : nal_unit_hevc(nal) {}
@@ -188,6 +188,20 @@ bool parserAnnexBMpeg2::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIt
     if (parsingSuccess && !first_sequence_header)
       first_sequence_header = new_sequence_header;
 
+    if (bitrateModel && parsingSuccess)
+    {
+      // The VBV of the sequence header for the CPB simulation of the bitrate analytics. The bitrate is
+      // given in units of 400 bit/s (0x3FFFF is a variable bitrate) and the VBV size in units of 16 kbit.
+      // The upper bits in the sequence extension are ignored.
+      BitrateAnalytics::hrdParameters hrd;
+      if (new_sequence_header->bit_rate_value != 0x3FFFF)
+      {
+        hrd.bitRate = uint64_t(new_sequence_header->bit_rate_value) * 400;
+        hrd.cpbSize = uint64_t(new_sequence_header->vbv_buffer_size_value) * 16 * 1024;
+      }
+      bitrateModel->setStreamTiming(0, getFramerate(), hrd);
+    }
+
     DEBUG_MPEG2("parserAnnexBMpeg2::parseAndAddNALUnit Sequence header");
   }
   else if (nal_mpeg2.nal_unit_type == PICTURE)
@@ -203,6 +217,9 @@ bool parserAnnexBMpeg2::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIt
       }
       curFramePOC = pocOffset + new_picture_header->temporal_reference;
       currentSliceIntra = new_picture_header->isIntraPicture();
+      // The vbv_delay of the first picture is the initial CPB removal delay for the bitrate analytics (0xFFFF: not signaled)
+      if (bitrateModel && !lastPictureHeader && new_picture_header->vbv_delay != 0xFFFF)
+        bitrateModel->setInitialCpbRemovalDelay(0, new_picture_header->vbv_delay);
       lastPictureHeader = new_picture_header;
       currentSliceType = new_picture_header->getPictureTypeString();
       
@@ -245,7 +262,7 @@ bool parserAnnexBMpeg2::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIt
       return false;
 
     if (message_tree)
-      message_tree->itemData[0] = new_extension->get_extension_function_name();
+      message_tree->setName(new_extension->get_extension_function_name());
 
     if (new_extension->extension_type == EXT_SEQUENCE)
     {
@@ -290,8 +307,7 @@ bool parserAnnexBMpeg2::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIt
     entry.dts = counterAU;
     entry.bitrate = sizeCurrentAU;
     entry.keyframe = currentAUAllSlicesIntra;
-    entry.frameType = currentAUAllSliceTypes;
-    bitrateModel->addBitratePoint(0, entry);
+    bitrateModel->addBitratePoint(0, entry, currentAUAllSliceTypes);
 
     sizeCurrentAU = 0;
     counterAU++;
@@ -315,7 +331,7 @@ bool parserAnnexBMpeg2::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIt
   
   if (nalRoot)
     // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1: %2").arg(nal_mpeg2.nal_idx).arg(nal_unit_type_toString.value(nal_mpeg2.nal_unit_type)) + specificDescription);
+    nalRoot->setName(QString("NAL %1: %2").arg(nal_mpeg2.nal_idx).arg(nal_unit_type_toString.value(nal_mpeg2.nal_unit_type)) + specificDescription);
 
   return parsingSuccess;
 }
@@ -60,6 +60,9 @@ public:
   void updateNumberModelItems();
   void enableModel();
 
+  // Get an estimate of the memory (in bytes) that is used by the packet tree
+  int64_t getMemoryUsage() const { return packetModel->getMemoryUsageEstimate(); }
+
   // Get info about the stream organized in a tree
   virtual QList<QTreeWidgetItem*> getStreamInfo() = 0;
   virtual unsigned int getNrStreams() = 0;
@@ -33,7 +33,11 @@
 #include "parserCommon.h"
 
 #include <QString>
+#include <QTreeWidgetItem>
 #include <assert.h>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
 #include <stdlib.h>
 #include <time.h>
 
@@ -55,6 +59,9 @@
 #define DEBUG_MODEL(fmt,...) ((void)0)
 #endif
 
+// Each level of the bitrate pyramid aggregates this many blocks of the level below
+#define BITRATE_PYRAMID_FACTOR 16
+
 #if PARSERCOMMON_DEBUG_FILTER_OUTPUT && !NDEBUG
 #include <QDebug>
 #define DEBUG_FILTER qDebug
@@ -440,8 +447,390 @@ QByteArray sub_byte_writer::getByteArray()
   return byteArray;
 }
 
+/// --------------- TreeItem ---------------------
+
+unsigned int TreeItemStringTable::add(const QString &string)
+{
+  if (string.isEmpty())
+    return 0;
+
+  QMutexLocker locker(&this->mutex);
+  auto it = this->ids.constFind(string);
+  if (it != this->ids.constEnd())
+    return it.value();
+
+  const unsigned int id = this->strings.size();
+  this->strings.append(string);
+  this->ids.insert(string, id);
+  return id;
+}
+
+QString TreeItemStringTable::get(unsigned int id) const
+{
+  QMutexLocker locker(&this->mutex);
+  return this->strings.value(id);
+}
+
+int64_t TreeItemStringTable::getMemoryUsage() const
+{
+  QMutexLocker locker(&this->mutex);
+  // The string data is shared between the list and the hash
+  int64_t size = sizeof(TreeItemStringTable) + this->strings.capacity() * sizeof(QString);
+  for (const QString &s : this->strings)
+    size += sizeof(QArrayData) + (s.size() + 1) * sizeof(QChar);
+  size += this->ids.size() * (sizeof(QString) + sizeof(unsigned int) + 3 * sizeof(void*));
+  return size;
+}
+
+namespace
+{
+
+// TreeItems are small and there can be millions of them. Instead of allocating every item on the heap, they are
+// allocated from blocks. The items of one parsed unit are mostly created one after the other and end up in the same
+// block. A block is freed as a whole once all of its items were deleted.
+const unsigned int treeItemsPerBlock = 1024;
+
+struct TreeItemBlock;
+
+struct TreeItemSlot
+{
+  TreeItemBlock *block;  //< nullptr if the item was not allocated from a block
+  union
+  {
+    TreeItemSlot *nextFree;
+    alignas(TreeItem) unsigned char storage[sizeof(TreeItem)];
+  };
+};
+
+struct TreeItemBlock
+{
+  TreeItemSlot slots[treeItemsPerBlock];
+  TreeItemSlot *firstFree {nullptr};
+  unsigned int nrUsed {0};
+  // The list of blocks that have free slots
+  TreeItemBlock *previousPartial {nullptr};
+  TreeItemBlock *nextPartial {nullptr};
+};
+
+struct TreeItemAllocator
+{
+  QMutex mutex;
+  TreeItemBlock *partialBlocks {nullptr};
+
+  void linkPartial(TreeItemBlock *block)
+  {
+    block->previousPartial = nullptr;
+    block->nextPartial = this->partialBlocks;
+    if (this->partialBlocks)
+      this->partialBlocks->previousPartial = block;
+    this->partialBlocks = block;
+  }
+  void unlinkPartial(TreeItemBlock *block)
+  {
+    if (block->previousPartial)
+      block->previousPartial->nextPartial = block->nextPartial;
+    else
+      this->partialBlocks = block->nextPartial;
+    if (block->nextPartial)
+      block->nextPartial->previousPartial = block->previousPartial;
+    block->previousPartial = nullptr;
+    block->nextPartial = nullptr;
+  }
+};
+
+TreeItemAllocator &getTreeItemAllocator()
+{
+  static TreeItemAllocator allocator;
+  return allocator;
+}
+
+TreeItemSlot *getSlotOfItem(void *p)
+{
+  return reinterpret_cast<TreeItemSlot*>(static_cast<unsigned char*>(p) - offsetof(TreeItemSlot, storage));
+}
+
+} // namespace
+
+void *TreeItem::operator new(size_t size)
+{
+  if (size != sizeof(TreeItem))
+  {
+    // Not a TreeItem (a derived class). Don't use the blocks.
+    auto slot = static_cast<TreeItemSlot*>(::operator new(offsetof(TreeItemSlot, storage) + size));
+    slot->block = nullptr;
+    return slot->storage;
+  }
+
+  auto &allocator = getTreeItemAllocator();
+  QMutexLocker locker(&allocator.mutex);
+  auto block = allocator.partialBlocks;
+  if (block == nullptr)
+  {
+    block = new TreeItemBlock;
+    for (unsigned int i = treeItemsPerBlock; i > 0; i--)
+    {
+      auto slot = &block->slots[i - 1];
+      slot->block = block;
+      slot->nextFree = block->firstFree;
+      block->firstFree = slot;
+    }
+    allocator.linkPartial(block);
+  }
+
+  auto slot = block->firstFree;
+  block->firstFree = slot->nextFree;
+  block->nrUsed++;
+  if (block->firstFree == nullptr)
+    allocator.unlinkPartial(block);
+  return slot->storage;
+}
+
+void TreeItem::operator delete(void *p)
+{
+  if (p == nullptr)
+    return;
+
+  auto slot = getSlotOfItem(p);
+  auto block = slot->block;
+  if (block == nullptr)
+  {
+    ::operator delete(slot);
+    return;
+  }
+
+  auto &allocator = getTreeItemAllocator();
+  QMutexLocker locker(&allocator.mutex);
+  const bool wasFull = (block->firstFree == nullptr);
+  slot->nextFree = block->firstFree;
+  block->firstFree = slot;
+  block->nrUsed--;
+  if (block->nrUsed == 0)
+  {
+    if (!wasFull)
+      allocator.unlinkPartial(block);
+    delete block;
+  }
+  else if (wasFull)
+    allocator.linkPartial(block);
+}
+
+TreeItem::TreeItem(TreeItem *parent)
+{
+  this->init(parent, QString());
+}
+
+TreeItem::TreeItem(const QList<QString> &data, TreeItem *parent)
+{
+  this->init(parent, data.value(0), data.value(2), data.value(3), data.value(4));
+  if (data.count() > 1)
+    this->setStringValue(data[1]);
+}
+
+TreeItem::TreeItem(const QString &name, TreeItem *parent)
+{
+  this->init(parent, name);
+}
+
+TreeItem::TreeItem(const QString &name, int val, TreeItem *parent)
+{
+  this->init(parent, name);
+  this->valueType = ValueType::Int;
+  this->value.intValue = val;
+}
+
+TreeItem::TreeItem(const QString &name, QString val, TreeItem *parent)
+{
+  this->init(parent, name);
+  this->setStringValue(val);
+}
+
+TreeItem::TreeItem(const QString &name, int val, const QString &coding, const QString &code, TreeItem *parent)
+{
+  this->init(parent, name, coding, code);
+  this->valueType = ValueType::Int;
+  this->value.intValue = val;
+}
+
+TreeItem::TreeItem(const QString &name, unsigned int val, const QString &coding, const QString &code, TreeItem *parent)
+{
+  this->init(parent, name, coding, code);
+  this->valueType = ValueType::UInt;
+  this->value.uintValue = val;
+}
+
+TreeItem::TreeItem(const QString &name, uint64_t val, const QString &coding, const QString &code, TreeItem *parent)
+{
+  this->init(parent, name, coding, code);
+  this->valueType = ValueType::UInt;
+  this->value.uintValue = val;
+}
+
+TreeItem::TreeItem(const QString &name, int64_t val, const QString &coding, const QString &code, TreeItem *parent)
+{
+  this->init(parent, name, coding, code);
+  this->valueType = ValueType::Int;
+  this->value.intValue = val;
+}
+
+TreeItem::TreeItem(const QString &name, bool val, const QString &coding, const QString &code, TreeItem *parent)
+{
+  this->init(parent, name, coding, code);
+  this->valueType = ValueType::Bool;
+  this->value.uintValue = val ? 1 : 0;
+}
+
+TreeItem::TreeItem(const QString &name, double val, const QString &coding, const QString &code, TreeItem *parent)
+{
+  this->init(parent, name, coding, code);
+  this->valueType = ValueType::Double;
+  this->value.doubleValue = val;
+}
+
+TreeItem::TreeItem(const QString &name, QString val, const QString &coding, const QString &code, TreeItem *parent)
+{
+  this->init(parent, name, coding, code);
+  this->setStringValue(val);
+}
+
+TreeItem::TreeItem(const QString &name, int val, const QString &coding, const QString &code, QString meaning, TreeItem *parent)
+{
+  this->init(parent, name, coding, code, meaning);
+  this->valueType = ValueType::Int;
+  this->value.intValue = val;
+}
+
+TreeItem::TreeItem(const QString &name, QString val, const QString &coding, const QString &code, QString meaning, TreeItem *parent, bool isError)
+{
+  this->init(parent, name, coding, code, meaning);
+  this->setStringValue(val);
+  this->setError(isError);
+}
+
+TreeItem::~TreeItem()
+{
+  qDeleteAll(childItems);
+  this->stringTable->nrItems--;
+  if (this->parentItem == nullptr)
+    delete this->stringTable;
+}
+
+void TreeItem::init(TreeItem *parent, const QString &name, const QString &coding, const QString &code, const QString &meaning)
+{
+  this->parentItem = parent;
+  if (parent)
+  {
+    parent->childItems.append(this);
+    this->stringTable = parent->stringTable;
+  }
+  else
+    this->stringTable = new TreeItemStringTable();
+  this->stringTable->nrItems++;
+  this->value.uintValue = 0;
+
+  this->nameID = this->stringTable->add(name);
+  this->codingID = this->stringTable->add(coding);
+  this->meaningID = this->stringTable->add(meaning);
+
+  // Most codes are the read bits
+  if (code.size() <= 64 && std::all_of(code.begin(), code.end(), [](QChar c) { return c == '0' || c == '1'; }))
+  {
+    for (QChar c : code)
+      this->codeBits = (this->codeBits << 1) | (c == '1' ? 1 : 0);
+    this->codeLength = (unsigned char)code.size();
+  }
+  else
+  {
+    this->codeIsString = true;
+    this->codeBits = this->stringTable->add(code);
+  }
+}
+
+void TreeItem::setStringValue(const QString &val)
+{
+  this->valueType = ValueType::String;
+  this->value.stringValue = this->stringTable->add(val);
+}
+
+void TreeItem::setName(const QString &name)
+{
+  this->nameID = this->stringTable->add(name);
+}
+
+QString TreeItem::getName(bool showStreamIndex) const
+{
+  QString r = (showStreamIndex && streamIndex != -1) ? QString("Stream %1 - ").arg(streamIndex) : "";
+  return r + this->stringTable->get(this->nameID);
+}
+
+QString TreeItem::getData(int column) const
+{
+  if (column == 0)
+    return this->stringTable->get(this->nameID);
+  if (column == 1)
+  {
+    switch (this->valueType)
+    {
+    case ValueType::Int:
+      return QString::number(this->value.intValue);
+    case ValueType::UInt:
+      return QString::number(this->value.uintValue);
+    case ValueType::Bool:
+      return (this->value.uintValue != 0) ? "1" : "0";
+    case ValueType::Double:
+      return QString::number(this->value.doubleValue);
+    case ValueType::String:
+      return this->stringTable->get(this->value.stringValue);
+    default:
+      return {};
+    }
+  }
+  if (column == 2)
+    return this->stringTable->get(this->codingID);
+  if (column == 3)
+  {
+    if (this->codeIsString)
+      return this->stringTable->get((unsigned int)this->codeBits);
+    QString code(this->codeLength, '0');
+    for (int i = 0; i < this->codeLength; i++)
+      if ((this->codeBits >> (this->codeLength - 1 - i)) & 1)
+        code[i] = '1';
+    return code;
+  }
+  if (column == 4)
+    return this->stringTable->get(this->meaningID);
+  return {};
+}
+
 /// --------------- reader_helper ---------------------
 
+namespace
+{
+
+// The same coding strings are used for many items. Create them only once.
+class codingStrings
+{
+public:
+  codingStrings(const char *format) : format(format)
+  {
+    for (int i = 0; i <= 64; i++)
+      strings.append(QString(format).arg(i));
+  }
+  QString get(int nrBits) const { return (nrBits >= 0 && nrBits < strings.size()) ? strings[nrBits] : QString(format).arg(nrBits); }
+
+private:
+  const char *format;
+  QStringList strings;
+};
+
+const codingStrings codingFixed("u(v) -> u(%1)");
+const codingStrings codingUEV("ue(v) -> ue(%1)");
+const codingStrings codingSEV("se(v) -> se(%1)");
+const codingStrings codingLeb128("leb128(v) -> leb128(%1)");
+const codingStrings codingNS("ns(%1)");
+const codingStrings codingSU("su(%1)");
+
+} // namespace
+
 void reader_helper::init(const QByteArray &inArr, TreeItem *item, QString new_sub_item_name)
 {
   set_input(inArr);
@@ -480,7 +869,7 @@ bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName,
   if (!readBits_catch(into, numBits, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, meaning, currentTreeLevel);
+    new TreeItem(intoName, into, codingFixed.get(numBits), code, meaning, currentTreeLevel);
   return true;
 }
 
@@ -490,7 +879,7 @@ bool reader_helper::readBits(int numBits, uint64_t &into, QString intoName, QStr
   if (!readBits64_catch(into, numBits, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, meaning, currentTreeLevel);
+    new TreeItem(intoName, into, codingFixed.get(numBits), code, meaning, currentTreeLevel);
   return true;
 }
 
@@ -500,7 +889,7 @@ bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName,
   if (!readBits_catch(into, numBits, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, getMeaningValue(meanings, into), currentTreeLevel);
+    new TreeItem(intoName, into, codingFixed.get(numBits), code, getMeaningValue(meanings, into), currentTreeLevel);
   return true;
 }
 
@@ -510,7 +899,7 @@ bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName,
   if (!readBits_catch(into, numBits, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, getMeaningValue(meanings, into), currentTreeLevel);
+    new TreeItem(intoName, into, codingFixed.get(numBits), code, getMeaningValue(meanings, into), currentTreeLevel);
   return true;
 }
 
@@ -520,7 +909,7 @@ bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName,
   if (!readBits_catch(into, numBits, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, pMeaning(into), currentTreeLevel);
+    new TreeItem(intoName, into, codingFixed.get(numBits), code, pMeaning(into), currentTreeLevel);
   return true;
 }
 
@@ -534,7 +923,7 @@ bool reader_helper::readBits(int numBits, QList<unsigned int> &into, QString int
   if (idx >= 0)
     intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
-    new TreeItem(intoName, val, QString("u(v) -> u(%1)").arg(numBits), code, currentTreeLevel);
+    new TreeItem(intoName, val, codingFixed.get(numBits), code, currentTreeLevel);
   return true;
 }
 
@@ -548,7 +937,7 @@ bool reader_helper::readBits(int numBits, QList<unsigned int> &into, QString int
   if (idx >= 0)
     intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
-    new TreeItem(intoName, val, QString("u(v) -> u(%1)").arg(numBits), code, pMeaning(val), currentTreeLevel);
+    new TreeItem(intoName, val, codingFixed.get(numBits), code, pMeaning(val), currentTreeLevel);
   return true;
 }
 
@@ -563,7 +952,7 @@ bool reader_helper::readBits(int numBits, QByteArray &into, QString intoName, in
   if (idx >= 0)
     intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
-    new TreeItem(intoName, val, QString("u(v) -> u(%1)").arg(numBits), code, currentTreeLevel);
+    new TreeItem(intoName, val, codingFixed.get(numBits), code, currentTreeLevel);
   return true;
 }
 
@@ -573,7 +962,7 @@ bool reader_helper::readBits(int numBits, unsigned int &into, QMap<int, QString>
   if (!readBits_catch(into, numBits, code))
     return false;
   if (currentTreeLevel)    
-    new TreeItem(getMeaningValue(intoNames, into), into, QString("u(v) -> u(%1)").arg(numBits), code, currentTreeLevel);
+    new TreeItem(getMeaningValue(intoNames, into), into, codingFixed.get(numBits), code, currentTreeLevel);
   return true;
 }
 
@@ -593,7 +982,7 @@ bool reader_helper::readZeroBits(int numBits, QString intoName)
   }
   if (currentTreeLevel)
   {
-    new TreeItem(intoName, allZero ? QString("0") : QString("Not 0"), QString("u(v) -> u(%1)").arg(bitsToRead), code, currentTreeLevel);
+    new TreeItem(intoName, allZero ? QString("0") : QString("Not 0"), codingFixed.get(bitsToRead), code, currentTreeLevel);
     if (!allZero)
       addErrorMessageChildItem("The zero bits " + intoName + " must be zero");
   }
@@ -655,7 +1044,7 @@ bool reader_helper::readUEV(unsigned int &into, QString intoName, QStringList me
   if (!readUEV_catch(into, bit_count, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("ue(v) -> ue(%1)").arg(bit_count), code, getMeaningValue(meanings, into), currentTreeLevel);
+    new TreeItem(intoName, into, codingUEV.get(bit_count), code, getMeaningValue(meanings, into), currentTreeLevel);
   return true;
 }
 
@@ -666,7 +1055,7 @@ bool reader_helper::readUEV(unsigned int &into, QString intoName, QString meanin
   if (!readUEV_catch(into, bit_count, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("ue(v) -> ue(%1)").arg(bit_count), code, meaning, currentTreeLevel);
+    new TreeItem(intoName, into, codingUEV.get(bit_count), code, meaning, currentTreeLevel);
   return true;
 }
 
@@ -681,7 +1070,7 @@ bool reader_helper::readUEV(QList<quint32> &into, QString intoName, int idx, QSt
   if (idx >= 0)
     intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
-    new TreeItem(intoName, val, QString("ue(v) -> ue(%1)").arg(bit_count), code, meaning, currentTreeLevel);
+    new TreeItem(intoName, val, codingUEV.get(bit_count), code, meaning, currentTreeLevel);
   return true;
 }
 
@@ -692,7 +1081,7 @@ bool reader_helper::readSEV(int &into, QString intoName, QStringList meanings)
   if (!readSEV_catch(into, bit_count, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("se(v) -> se(%1)").arg(bit_count), code, getMeaningValue(meanings, (unsigned int)into), currentTreeLevel);
+    new TreeItem(intoName, into, codingSEV.get(bit_count), code, getMeaningValue(meanings, (unsigned int)into), currentTreeLevel);
   return true;
 }
 
@@ -707,7 +1096,7 @@ bool reader_helper::readSEV(QList<int> into, QString intoName, int idx)
   if (idx >= 0)
     intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
-    new TreeItem(intoName, val, QString("se(v) -> se(%1)").arg(bit_count), code, currentTreeLevel);
+    new TreeItem(intoName, val, codingSEV.get(bit_count), code, currentTreeLevel);
   return true;
 }
 
@@ -718,7 +1107,7 @@ bool reader_helper::readLeb128(uint64_t &into, QString intoName)
   if (!readLeb128_catch(into, bit_count, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("leb128(v) -> leb128(%1)").arg(bit_count), code, currentTreeLevel);
+    new TreeItem(intoName, into, codingLeb128.get(bit_count), code, currentTreeLevel);
   return true;
 }
 
@@ -729,7 +1118,7 @@ bool reader_helper::readUVLC(uint64_t &into, QString intoName)
   if (!readUVLC_catch(into, bit_count, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("leb128(v) -> leb128(%1)").arg(bit_count), code, currentTreeLevel);
+    new TreeItem(intoName, into, codingLeb128.get(bit_count), code, currentTreeLevel);
   return true;
 }
 
@@ -740,7 +1129,7 @@ bool reader_helper::readNS(int &into, QString intoName, int maxVal)
   if (!readNS_catch(into, maxVal, bit_count, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("ns(%1)").arg(bit_count), code, currentTreeLevel);
+    new TreeItem(intoName, into, codingNS.get(bit_count), code, currentTreeLevel);
   return true;
 }
 
@@ -750,7 +1139,7 @@ bool reader_helper::readSU(int &into, QString intoName, int nrBits)
   if (!readSU_catch(into, nrBits, code))
     return false;
   if (currentTreeLevel)
-    new TreeItem(intoName, into, QString("su(%1)").arg(nrBits), code, currentTreeLevel);
+    new TreeItem(intoName, into, codingSU.get(nrBits), code, currentTreeLevel);
   return true;
 }
 
@@ -951,7 +1340,7 @@ PacketItemModel::~PacketItemModel()
 QVariant PacketItemModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
   if (orientation == Qt::Horizontal && role == Qt::DisplayRole && rootItem != nullptr)
-    return rootItem->itemData.value(section, QString());
+    return rootItem->getData(section);
 
   return QVariant();
 }
@@ -982,7 +1371,7 @@ QVariant PacketItemModel::data(const QModelIndex &index, int role) const
     if (index.column() == 0)
       return QVariant(item->getName(!showVideoOnly));
     else
-      return QVariant(item->itemData.value(index.column()));
+      return QVariant(item->getData(index.column()));
   }
   return QVariant();
 }
@@ -1054,6 +1443,17 @@ void PacketItemModel::updateNumberModelItems()
   endInsertRows();
 }
 
+int64_t PacketItemModel::getMemoryUsageEstimate() const
+{
+  if (rootItem.isNull())
+    return 0;
+
+  // Each item uses its slot in a block (the item and the block pointer) and one pointer in the child list of
+  // its parent. The strings are shared by all items in the string table.
+  const int64_t itemSize = sizeof(TreeItem) + 2 * sizeof(void*);
+  return rootItem->getNumberItemsInTree() * itemSize + rootItem->getStringTableMemoryUsage();
+}
+
 void PacketItemModel::setUseColorCoding(bool colorCoding)
 {
   if (useColorCoding == colorCoding)
@@ -1072,14 +1472,215 @@ void PacketItemModel::setShowVideoStreamOnly(bool videoOnly)
   emit dataChanged(QModelIndex(), QModelIndex());
 }
 
+/// ------------------- BitrateAnalytics -----------------------------
+
+BitrateAnalytics::BitrateAnalytics(const QList<double> &windowDurations, double frameRate, const hrdParameters &hrd) :
+  frameRate(frameRate),
+  hrd(hrd)
+{
+  if (frameRate <= 0)
+    return;
+
+  unsigned int maxLength = 0;
+  for (auto duration : windowDurations)
+  {
+    slidingWindow window;
+    window.duration = duration;
+    window.length = qMax(1u, unsigned(std::lround(duration * frameRate)));
+    maxLength = qMax(maxLength, window.length);
+    this->windows.append(window);
+  }
+  this->lastSizes.resize(maxLength);
+
+  if (hrd.isValid())
+  {
+    // Without an initial CPB removal delay, the CPB is assumed to be full (see header)
+    this->initialCpbFullness = double(hrd.cpbSize);
+    if (hrd.initialCpbRemovalDelay >= 0)
+      this->initialCpbFullness = qMin(this->initialCpbFullness, double(hrd.bitRate) * hrd.initialCpbRemovalDelay / 90000);
+    this->cpbFullness = this->initialCpbFullness;
+    this->minCpbFullness = this->cpbFullness;
+  }
+}
+
+void BitrateAnalytics::addEntry(unsigned int size, bool keyframe, unsigned short frameType)
+{
+  const unsigned int entry = this->nrEntries++;
+  this->totalSize += size;
+
+  // Sliding windows
+  if (!this->lastSizes.isEmpty())
+  {
+    const unsigned int ringSize = this->lastSizes.size();
+    for (auto &window : this->windows)
+    {
+      window.sum += size;
+      if (entry >= window.length)
+        window.sum -= this->lastSizes[(entry - window.length) % ringSize];
+      if (entry + 1 >= window.length && window.sum > window.peakSum)
+      {
+        window.peakSum = window.sum;
+        window.peakEndEntry = entry;
+      }
+    }
+    this->lastSizes[entry % ringSize] = size;
+  }
+
+  // CPB simulation. The entry is removed at once. Until the next removal, the CPB is filled with the bitrate.
+  if (this->hrd.isValid() && this->frameRate > 0)
+  {
+    const double bits = double(size) * 8;
+    if (bits > this->cpbFullness)
+    {
+      if (this->nrCpbUnderflows++ == 0)
+        this->firstCpbUnderflowEntry = int(entry);
+      this->cpbFullness = 0;
+    }
+    else
+      this->cpbFullness -= bits;
+    this->minCpbFullness = qMin(this->minCpbFullness, this->cpbFullness);
+
+    this->cpbFullness += this->hrd.bitRate / this->frameRate;
+    if (this->cpbFullness > this->hrd.cpbSize)
+    {
+      // With a variable bitrate, the input just stops when the CPB is full. For a constant bitrate, this is an overflow.
+      if (this->hrd.cbr)
+        this->nrCpbOverflows++;
+      this->cpbFullness = double(this->hrd.cpbSize);
+    }
+  }
+
+  // GOP structure
+  if (keyframe && this->currentGOPLength > 0)
+  {
+    this->gopLengthHistogram[this->currentGOPLength]++;
+    this->nrGOPs++;
+    this->currentGOPLength = 0;
+  }
+  this->currentGOPLength++;
+  if (this->nrGOPs == 0 && this->firstGOPFrameTypes.size() < 64)
+    this->firstGOPFrameTypes.append(frameType);
+
+  // Size distribution per frame type
+  if (frameType >= this->statisticsPerFrameType.size())
+    this->statisticsPerFrameType.resize(frameType + 1);
+  auto &statistics = this->statisticsPerFrameType[frameType];
+  statistics.count++;
+  statistics.min = qMin(statistics.min, size);
+  statistics.max = qMax(statistics.max, size);
+  statistics.sum += size;
+  int bin = 0;
+  while ((size >> bin) > 1)
+    bin++;
+  if (bin >= statistics.log2Histogram.size())
+    statistics.log2Histogram.resize(bin + 1);
+  statistics.log2Histogram[bin]++;
+}
+
+QTreeWidgetItem *BitrateAnalytics::getInfo(const QString &title, const QStringList &frameTypeNames) const
+{
+  auto formatBitrate = [](double bitsPerSecond) { return QString("%1 kbit/s").arg(bitsPerSecond / 1000, 0, 'f', 1); };
+
+  auto root = new QTreeWidgetItem(QStringList() << title);
+  new QTreeWidgetItem(root, QStringList() << "Number Frames" << QString::number(this->nrEntries));
+  new QTreeWidgetItem(root, QStringList() << "Total size" << QString("%1 bytes").arg(this->totalSize));
+  if (this->nrEntries == 0)
+    return root;
+
+  if (this->frameRate > 0)
+  {
+    new QTreeWidgetItem(root, QStringList() << "Frame rate" << QString::number(this->frameRate));
+    new QTreeWidgetItem(root, QStringList() << "Average bitrate" << formatBitrate(this->totalSize * 8 * this->frameRate / this->nrEntries));
+    for (const auto &window : this->windows)
+    {
+      const QString name = QString("Peak bitrate (%1s window)").arg(window.duration);
+      if (this->nrEntries < window.length)
+        new QTreeWidgetItem(root, QStringList() << name << "Stream is shorter than the window");
+      else
+      {
+        const double peak = window.peakSum * 8 * this->frameRate / window.length;
+        new QTreeWidgetItem(root, QStringList() << name << QString("%1 (frames %2-%3)").arg(formatBitrate(peak)).arg(window.peakEndEntry + 1 - window.length).arg(window.peakEndEntry));
+      }
+    }
+  }
+  else
+    new QTreeWidgetItem(root, QStringList() << "Frame rate" << "Unknown (no time based analytics)");
+
+  auto cpbItem = new QTreeWidgetItem(root, QStringList() << "CPB simulation");
+  if (!this->hrd.isValid() || this->frameRate <= 0)
+    cpbItem->setText(1, "No HRD parameters");
+  else
+  {
+    cpbItem->setText(1, (this->nrCpbUnderflows == 0 && this->nrCpbOverflows == 0) ? "OK" : "CPB violations");
+    new QTreeWidgetItem(cpbItem, QStringList() << "Bitrate" << formatBitrate(this->hrd.bitRate) + (this->hrd.cbr ? " (CBR)" : " (VBR)"));
+    new QTreeWidgetItem(cpbItem, QStringList() << "CPB size" << QString("%1 bits").arg(this->hrd.cpbSize));
+    QString initialFullness = QString("%1 bits (%2%)").arg(qint64(this->initialCpbFullness)).arg(this->initialCpbFullness * 100 / this->hrd.cpbSize, 0, 'f', 1);
+    if (this->hrd.initialCpbRemovalDelay >= 0)
+      initialFullness += QString(" from initial removal delay %1 ms").arg(this->hrd.initialCpbRemovalDelay / 90.0, 0, 'f', 1);
+    else
+      initialFullness += " assumed (no initial removal delay in the stream)";
+    new QTreeWidgetItem(cpbItem, QStringList() << "Initial fullness" << initialFullness);
+    new QTreeWidgetItem(cpbItem, QStringList() << "Minimum fullness" << QString("%1 bits (%2%)").arg(qint64(this->minCpbFullness)).arg(this->minCpbFullness * 100 / this->hrd.cpbSize, 0, 'f', 1));
+    QString underflows = QString::number(this->nrCpbUnderflows);
+    if (this->firstCpbUnderflowEntry >= 0)
+      underflows += QString(" (first at frame %1)").arg(this->firstCpbUnderflowEntry);
+    new QTreeWidgetItem(cpbItem, QStringList() << "Underflows" << underflows);
+    if (this->hrd.cbr)
+      new QTreeWidgetItem(cpbItem, QStringList() << "Overflows" << QString::number(this->nrCpbOverflows));
+  }
+
+  // The last (unfinished) GOP also counts
+  auto gopLengths = this->gopLengthHistogram;
+  if (this->currentGOPLength > 0)
+    gopLengths[this->currentGOPLength]++;
+  const unsigned int nrAllGOPs = this->nrGOPs + (this->currentGOPLength > 0 ? 1 : 0);
+  auto gopItem = new QTreeWidgetItem(root, QStringList() << "GOP structure" << QString("%1 GOPs").arg(nrAllGOPs));
+  new QTreeWidgetItem(gopItem, QStringList() << "Average length" << QString::number(double(this->nrEntries) / nrAllGOPs, 'f', 1));
+  new QTreeWidgetItem(gopItem, QStringList() << "Minimum length" << QString::number(gopLengths.firstKey()));
+  new QTreeWidgetItem(gopItem, QStringList() << "Maximum length" << QString::number(gopLengths.lastKey()));
+  auto lengthsItem = new QTreeWidgetItem(gopItem, QStringList() << "Lengths");
+  for (auto it = gopLengths.begin(); it != gopLengths.end(); it++)
+    new QTreeWidgetItem(lengthsItem, QStringList() << QString("Length %1").arg(it.key()) << QString("%1 GOPs").arg(it.value()));
+  QStringList firstGOPTypes;
+  for (auto frameType : this->firstGOPFrameTypes)
+    firstGOPTypes.append(frameTypeNames.value(frameType));
+  if (this->nrGOPs == 0 && this->currentGOPLength > unsigned(this->firstGOPFrameTypes.size()))
+    firstGOPTypes.append("...");
+  new QTreeWidgetItem(gopItem, QStringList() << "Frame types of the first GOP" << firstGOPTypes.join(", "));
+
+  auto frameTypesItem = new QTreeWidgetItem(root, QStringList() << "Frame types");
+  for (int i = 0; i < this->statisticsPerFrameType.size(); i++)
+  {
+    const auto &statistics = this->statisticsPerFrameType[i];
+    if (statistics.count == 0)
+      continue;
+    auto typeItem = new QTreeWidgetItem(frameTypesItem, QStringList() << frameTypeNames.value(i) << QString("%1 frames").arg(statistics.count));
+    new QTreeWidgetItem(typeItem, QStringList() << "Minimum size" << QString("%1 bytes").arg(statistics.min));
+    new QTreeWidgetItem(typeItem, QStringList() << "Average size" << QString("%1 bytes").arg(double(statistics.sum) / statistics.count, 0, 'f', 0));
+    new QTreeWidgetItem(typeItem, QStringList() << "Maximum size" << QString("%1 bytes").arg(statistics.max));
+    new QTreeWidgetItem(typeItem, QStringList() << "Share of total size" << QString("%1%").arg(double(statistics.sum) * 100 / qMax(uint64_t(1), this->totalSize), 0, 'f', 1));
+    auto distributionItem = new QTreeWidgetItem(typeItem, QStringList() << "Size distribution");
+    for (int bin = 0; bin < statistics.log2Histogram.size(); bin++)
+    {
+      if (statistics.log2Histogram[bin] == 0)
+        continue;
+      const uint64_t binStart = (bin == 0) ? 0 : (uint64_t(1) << bin);
+      const uint64_t binEnd = (uint64_t(1) << (bin + 1)) - 1;
+      new QTreeWidgetItem(distributionItem, QStringList() << QString("%1-%2 bytes").arg(binStart).arg(binEnd) << QString("%1 frames").arg(statistics.log2Histogram[bin]));
+    }
+  }
+
+  return root;
+}
+
 /// ------------------- BitrateItemModel -----------------------------
 
 BitrateItemModel::BitrateItemModel(QObject *parent) : QAbstractTableModel(parent)
 {
-  dtsRange.min = INT_MAX;
-  dtsRange.max = INT_MIN;
-  ptsRange.min = INT_MAX;
-  ptsRange.max = INT_MIN;
+  dtsRange.min = INT64_MAX;
+  dtsRange.max = INT64_MIN;
+  ptsRange.min = INT64_MAX;
+  ptsRange.max = INT64_MIN;
 }
 
 BitrateItemModel::~BitrateItemModel()
@@ -1097,9 +1698,9 @@ int BitrateItemModel::columnCount(const QModelIndex &parent) const
   Q_UNUSED(parent);
   /* 0: The index (the order the values were added)
    * 1: The average value
-   * 2: Bitrate
-   * 3: dts
-   * 4: pts
+   * 2: Bitrate (non-keyframe)
+   * 3: Bitrate (keyframe)
+   * 4: Bitrate (marked)
    */
   return 5;
 }
@@ -1117,6 +1718,8 @@ QVariant BitrateItemModel::headerData(int section, Qt::Orientation orientation,
       return "Bitrate Non-Keyframe";
     if (section == 3)
       return "Bitrate Keyframe";
+    if (section == 4)
+      return "Hash Mismatch";
   }
   return {};
 }
@@ -1142,9 +1745,12 @@ QVariant BitrateItemModel::data(const QModelIndex &index, int role) const
       return averageBitrate / (end - start);
     }
     const bool key = this->bitratePerStreamData[0][index.row()].keyframe;
-    if (!key && index.column() == 2)
+    const bool marked = this->markedPTS.contains(this->bitratePerStreamData[0][index.row()].pts);
+    if (!key && !marked && index.column() == 2)
       return this->bitratePerStreamData[0][index.row()].bitrate;
-    if (key && index.column() == 3)
+    if (key && !marked && index.column() == 3)
+      return this->bitratePerStreamData[0][index.row()].bitrate;
+    if (marked && index.column() == 4)
       return this->bitratePerStreamData[0][index.row()].bitrate;
     // if (index.column() == 3)
     //   return this->bitratePerStreamData[0][index.row()].dts;
@@ -1165,13 +1771,15 @@ QVariant BitrateItemModel::data(const QModelIndex &index, int role) const
 QString BitrateItemModel::getItemInfoText(int index)
 {
   QString text;
+  QMutexLocker locker(&this->bitratePerStreamDataMutex);
   if (index >= 0 && index < bitratePerStreamData[0].count())
   {
     text += QString("PTS: %1\n").arg(bitratePerStreamData[0][index].pts);
     text += QString("DTS: %1\n").arg(bitratePerStreamData[0][index].dts);
     text += QString("Bitrate: %1").arg(bitratePerStreamData[0][index].bitrate);
-    if (!bitratePerStreamData[0][index].frameType.isEmpty())
-      text += QString("\nFrame Type: " + bitratePerStreamData[0][index].frameType);
+    text += QString("\nFrame Type: " + frameTypeNames.value(bitratePerStreamData[0][index].frameType));
+    if (markedPTS.contains(bitratePerStreamData[0][index].pts))
+      text += QString("\nPicture hash mismatch");
   }
   return text;
 }
@@ -1196,7 +1804,7 @@ void BitrateItemModel::updateNumberModelItems()
   endInsertRows();
 }
 
-void BitrateItemModel::addBitratePoint(int streamIndex, bitrateEntry &entry)
+void BitrateItemModel::addBitratePoint(int streamIndex, bitrateEntry &entry, const QString &frameType)
 {
   dtsRange.min = qMin(dtsRange.min, entry.dts);
   dtsRange.max = qMax(dtsRange.max, entry.dts);
@@ -1210,18 +1818,229 @@ void BitrateItemModel::addBitratePoint(int streamIndex, bitrateEntry &entry)
 
   DEBUG_PARSER("BitrateItemModel::addBitratePoint streamIndex %d pts %d dts %d rate %d keyframe %d", streamIndex, pts, dts, bitrate, keyframe);
 
-  // Keep the list sorted
   QMutexLocker locker(&this->bitratePerStreamDataMutex);
+
+  // Entries without a frame type are distinguished by the keyframe flag
+  const QString frameTypeName = frameType.trimmed().isEmpty() ? (entry.keyframe ? "Keyframe" : "Non-keyframe") : frameType.trimmed();
+  int frameTypeIndex = this->frameTypeNames.indexOf(frameTypeName);
+  if (frameTypeIndex < 0)
+  {
+    frameTypeIndex = this->frameTypeNames.size();
+    this->frameTypeNames.append(frameTypeName);
+  }
+  entry.frameType = (unsigned short)frameTypeIndex;
+
+  // The entries are added in decoding order so the analytics can be updated right away
+  if (!this->analyticsPerStream.contains(streamIndex))
+    this->resetAnalytics(streamIndex);
+  this->analyticsPerStream[streamIndex].addEntry(entry.bitrate, entry.keyframe, entry.frameType);
+
+  // Keep the list sorted
   const auto currentSortMode = this->sortMode;
   auto compareFunctionLessThen = [currentSortMode](const bitrateEntry &a, const bitrateEntry &b)
   {
     if (currentSortMode == SortMode::DECODE_ORDER)
       return a.dts < b.dts;
     else
-      return b.pts < a.pts;
+      return a.pts < b.pts;
   };
-  auto insertIterator = std::upper_bound(bitratePerStreamData[streamIndex].begin(), bitratePerStreamData[streamIndex].end(), entry, compareFunctionLessThen);
-  bitratePerStreamData[streamIndex].insert(insertIterator, entry);
+  auto &entries = bitratePerStreamData[streamIndex];
+  auto insertIterator = std::upper_bound(entries.begin(), entries.end(), entry, compareFunctionLessThen);
+  const int insertIndex = int(insertIterator - entries.begin());
+  entries.insert(insertIterator, entry);
+  if (streamIndex == 0)
+    this->pyramidValidEntries = qMin(this->pyramidValidEntries, insertIndex);
+}
+
+bool BitrateItemModel::setMarkedPTS(const QList<int> &ptsList)
+{
+  QSet<int64_t> newMarkedPTS;
+  for (int pts : ptsList)
+    newMarkedPTS.insert(pts);
+  QMutexLocker locker(&this->bitratePerStreamDataMutex);
+  if (newMarkedPTS == this->markedPTS)
+    return false;
+  this->markedPTS = newMarkedPTS;
+  this->pyramidValidEntries = 0;
+  return true;
+}
+
+void BitrateItemModel::bitrateAggregate::add(const bitrateAggregate &other)
+{
+  if (other.count == 0)
+    return;
+  this->min = qMin(this->min, other.min);
+  this->max = qMax(this->max, other.max);
+  this->sum += other.sum;
+  this->count += other.count;
+  this->keyframe |= other.keyframe;
+  this->marked |= other.marked;
+}
+
+void BitrateItemModel::updatePyramid()
+{
+  const auto &entries = this->bitratePerStreamData[0];
+  const int nrEntries = entries.size();
+  if (this->pyramidValidEntries >= nrEntries)
+    return;
+
+  DEBUG_PARSER("BitrateItemModel::updatePyramid from entry %d of %d", this->pyramidValidEntries, nrEntries);
+
+  // Level 0 is calculated from the entries, all other levels from the level below
+  int blockSize = BITRATE_PYRAMID_FACTOR;
+  int nrValuesBelow = nrEntries;
+  int level = 0;
+  while (nrValuesBelow > 1)
+  {
+    const int nrBlocks = (nrValuesBelow + BITRATE_PYRAMID_FACTOR - 1) / BITRATE_PYRAMID_FACTOR;
+    if (this->pyramid.size() <= level)
+      this->pyramid.append(QVector<bitrateAggregate>());
+    auto &blocks = this->pyramid[level];
+    blocks.resize(nrBlocks);
+
+    for (int b = this->pyramidValidEntries / blockSize; b < nrBlocks; b++)
+    {
+      bitrateAggregate block;
+      const int start = b * BITRATE_PYRAMID_FACTOR;
+      const int end = qMin(start + BITRATE_PYRAMID_FACTOR, nrValuesBelow);
+      if (level == 0)
+        block = this->getAggregateOfEntries(start, end);
+      else
+      {
+        const auto &below = this->pyramid[level - 1];
+        for (int i = start; i < end; i++)
+          block.add(below[i]);
+      }
+      blocks[b] = block;
+    }
+
+    nrValuesBelow = nrBlocks;
+    blockSize *= BITRATE_PYRAMID_FACTOR;
+    level++;
+  }
+  while (this->pyramid.size() > level)
+    this->pyramid.removeLast();
+
+  this->pyramidValidEntries = nrEntries;
+}
+
+BitrateItemModel::bitrateAggregate BitrateItemModel::getAggregateOfEntries(int first, int last) const
+{
+  bitrateAggregate aggregate;
+  const auto &entries = this->bitratePerStreamData[0];
+  for (int i = first; i < last; i++)
+  {
+    const auto &entry = entries[i];
+    aggregate.min = qMin(aggregate.min, entry.bitrate);
+    aggregate.max = qMax(aggregate.max, entry.bitrate);
+    aggregate.sum += entry.bitrate;
+    aggregate.count++;
+    aggregate.keyframe |= entry.keyframe;
+    if (!this->markedPTS.isEmpty())
+      aggregate.marked |= this->markedPTS.contains(entry.pts);
+  }
+  return aggregate;
+}
+
+QVector<BitrateItemModel::bitrateAggregate> BitrateItemModel::getAggregates(double first, double entriesPerBucket, int nrBuckets)
+{
+  QVector<bitrateAggregate> aggregates(qMax(nrBuckets, 0));
+
+  QMutexLocker locker(&this->bitratePerStreamDataMutex);
+  this->updatePyramid();
+
+  const int nrEntries = this->bitratePerStreamData[0].size();
+  for (int b = 0; b < nrBuckets; b++)
+  {
+    const int start = qMax(0, int(first + b * entriesPerBucket));
+    const int end = qMin(nrEntries, qMax(start + 1, int(first + (b + 1) * entriesPerBucket)));
+
+    // Walk from the start to the end and always use the biggest aligned block of the pyramid that fits
+    bitrateAggregate &aggregate = aggregates[b];
+    int i = start;
+    while (i < end)
+    {
+      int level = -1;
+      int blockSize = 1;
+      while (level + 1 < this->pyramid.size())
+      {
+        const int nextBlockSize = blockSize * BITRATE_PYRAMID_FACTOR;
+        if (i % nextBlockSize != 0 || i + nextBlockSize > end)
+          break;
+        blockSize = nextBlockSize;
+        level++;
+      }
+      if (level == -1)
+        aggregate.add(this->getAggregateOfEntries(i, i + 1));
+      else
+        aggregate.add(this->pyramid[level][i / blockSize]);
+      i += blockSize;
+    }
+  }
+  return aggregates;
+}
+
+void BitrateItemModel::setStreamTiming(int streamIndex, double frameRate, const BitrateAnalytics::hrdParameters &hrd)
+{
+  QMutexLocker locker(&this->bitratePerStreamDataMutex);
+  auto &timing = this->timingPerStream[streamIndex];
+  auto newHrd = hrd;
+  if (newHrd.initialCpbRemovalDelay < 0)
+    newHrd.initialCpbRemovalDelay = timing.hrd.initialCpbRemovalDelay;
+  if (timing.frameRate == frameRate && timing.hrd == newHrd)
+    return;
+
+  DEBUG_PARSER("BitrateItemModel::setStreamTiming streamIndex %d frameRate %f bitRate %d cpbSize %d", streamIndex, frameRate, int(hrd.bitRate), int(hrd.cpbSize));
+  timing.frameRate = frameRate;
+  timing.hrd = newHrd;
+  this->resetAnalytics(streamIndex);
+}
+
+void BitrateItemModel::setInitialCpbRemovalDelay(int streamIndex, int64_t initialCpbRemovalDelay)
+{
+  QMutexLocker locker(&this->bitratePerStreamDataMutex);
+  auto &timing = this->timingPerStream[streamIndex];
+  if (initialCpbRemovalDelay < 0 || timing.hrd.initialCpbRemovalDelay >= 0)
+    return;
+
+  DEBUG_PARSER("BitrateItemModel::setInitialCpbRemovalDelay streamIndex %d delay %d", streamIndex, int(initialCpbRemovalDelay));
+  timing.hrd.initialCpbRemovalDelay = initialCpbRemovalDelay;
+  this->resetAnalytics(streamIndex);
+}
+
+void BitrateItemModel::setAnalyticsWindowDurations(const QList<double> &durations)
+{
+  QMutexLocker locker(&this->bitratePerStreamDataMutex);
+  this->analyticsWindowDurations = durations;
+  for (auto streamIndex : this->analyticsPerStream.keys())
+    this->resetAnalytics(streamIndex);
+}
+
+QList<QTreeWidgetItem*> BitrateItemModel::getAnalyticsInfo() const
+{
+  QList<QTreeWidgetItem*> info;
+  QMutexLocker locker(&this->bitratePerStreamDataMutex);
+  for (auto it = this->analyticsPerStream.begin(); it != this->analyticsPerStream.end(); it++)
+  {
+    const QString title = (this->analyticsPerStream.size() == 1) ? QString("Bitrate Analytics") : QString("Bitrate Analytics Stream %1").arg(it.key());
+    info.append(it.value().getInfo(title, this->frameTypeNames));
+  }
+  return info;
+}
+
+void BitrateItemModel::resetAnalytics(unsigned int streamIndex)
+{
+  const auto timing = this->timingPerStream.value(streamIndex);
+  BitrateAnalytics analytics(this->analyticsWindowDurations, timing.frameRate, timing.hrd);
+
+  // Feed all entries that we already have again (in decoding order)
+  auto entries = this->bitratePerStreamData.value(streamIndex);
+  if (this->sortMode != SortMode::DECODE_ORDER)
+    std::stable_sort(entries.begin(), entries.end(), [](const bitrateEntry &a, const bitrateEntry &b) { return a.dts < b.dts; });
+  for (const auto &entry : entries)
+    analytics.addEntry(entry.bitrate, entry.keyframe, entry.frameType);
+
+  this->analyticsPerStream[streamIndex] = analytics;
 }
 
 void BitrateItemModel::setBitrateSortingIndex(int index)
@@ -1248,10 +2067,12 @@ void BitrateItemModel::setBitrateSortingIndex(int index)
       return a.pts < b.pts;
   };
 
-  // Note: None of these signals really update the bar chart. The way that worked is to set a null Model and then set the model again (see BitstreamAnalysisWidget::bitratePlotOrderComboBoxIndexChanged)
+  // Note: The bar chart draws directly from the aggregates. It only has to be repainted (see BitstreamAnalysisWidget::bitratePlotOrderComboBoxIndexChanged)
   //emit QAbstractItemModel::layoutAboutToBeChanged();
+  QMutexLocker locker(&this->bitratePerStreamDataMutex);
   for (auto &list : this->bitratePerStreamData)
     std::sort(list.begin(), list.end(), compareFunctionLessThen);
+  this->pyramidValidEntries = 0;
   //emit QAbstractItemModel::layoutChanged();
 
   // auto topLeft = this->index(0, 0);
@@ -34,16 +34,24 @@
 #ifndef PARSERCOMMON_H
 #define PARSERCOMMON_H
 
+#include <atomic>
+#include <climits>
 #include <QBrush>
 #include <QByteArray>
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QMutex>
+#include <QSet>
 #include <QSortFilterProxyModel>
 #include <QString>
+#include <QStringList>
+#include <QVector>
 
 #include "common/typedef.h"
 
+class QTreeWidgetItem;
+
 namespace parserCommon 
 {
   /* This class provides the ability to read a byte array bit wise. Reading of ue(v) symbols is also supported.
@@ -118,41 +126,106 @@ namespace parserCommon
     int posInByte;        // The bit position in the current byte
   };
 
-  // The tree item is used to feed the tree view. Each NAL unit can return a representation using TreeItems
+  // All strings of the items of one tree (names, codings, codes and meanings) are stored only once in this table.
+  // The items only keep the index. Index 0 is always the empty string. The table is owned by the root of the tree.
+  class TreeItemStringTable
+  {
+  public:
+    unsigned int add(const QString &string);
+    QString get(unsigned int id) const;
+    int64_t getMemoryUsage() const;
+
+    // The number of items in the tree. The items count themselves when they are created and deleted so
+    // that the memory usage of the tree can be queried from any thread without walking the tree.
+    std::atomic<int64_t> nrItems {0};
+
+  private:
+    mutable QMutex mutex;
+    QHash<QString, unsigned int> ids;
+    QVector<QString> strings {QString()};
+  };
+
+  // The tree item is used to feed the tree view. Each NAL unit can return a representation using TreeItems.
+  // There can be millions of items for long streams so the items are kept small. The strings are interned in the
+  // string table of the tree and numeric values are only converted to text when they are shown (getData).
+  // The items are allocated from blocks (see operator new) which are freed once all their items are deleted.
   class TreeItem
   {
   public:
     // Some useful constructors of new Tree items. You must at least specify a parent. The new item is atomatically added as a child 
     // of the parent.
-    TreeItem(TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); }
-    TreeItem(QList<QString> &data, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData = data; }
-    TreeItem(const QString &name, TreeItem *parent)  { parentItem = parent; if (parent) parent->childItems.append(this); itemData.append(name); }
-    TreeItem(const QString &name, int          val, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << QString::number(val); }
-    TreeItem(const QString &name, QString      val, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << val; }
-    TreeItem(const QString &name, int          val, const QString &coding, const QString &code, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << QString::number(val) << coding << code; }
-    TreeItem(const QString &name, unsigned int val, const QString &coding, const QString &code, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << QString::number(val) << coding << code; }
-    TreeItem(const QString &name, uint64_t     val, const QString &coding, const QString &code, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << QString::number(val) << coding << code; }
-    TreeItem(const QString &name, int64_t      val, const QString &coding, const QString &code, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << QString::number(val) << coding << code; }
-    TreeItem(const QString &name, bool         val, const QString &coding, const QString &code, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << (val ? "1" : "0")    << coding << code; }
-    TreeItem(const QString &name, double       val, const QString &coding, const QString &code, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << QString::number(val) << coding << code; }
-    TreeItem(const QString &name, QString      val, const QString &coding, const QString &code, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << val << coding << code; }
-    TreeItem(const QString &name, int          val, const QString &coding, const QString &code, QString meaning, TreeItem *parent) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << QString::number(val) << coding << code; itemData.append(meaning); }
-    TreeItem(const QString &name, QString      val, const QString &coding, const QString &code, QString meaning, TreeItem *parent, bool isError=false) { parentItem = parent; if (parent) parent->childItems.append(this); itemData << name << val << coding << code; itemData.append(meaning); setError(isError); }
-
-    ~TreeItem() { qDeleteAll(childItems); }
+    TreeItem(TreeItem *parent);
+    TreeItem(const QList<QString> &data, TreeItem *parent);
+    TreeItem(const QString &name, TreeItem *parent);
+    TreeItem(const QString &name, int          val, TreeItem *parent);
+    TreeItem(const QString &name, QString      val, TreeItem *parent);
+    TreeItem(const QString &name, int          val, const QString &coding, const QString &code, TreeItem *parent);
+    TreeItem(const QString &name, unsigned int val, const QString &coding, const QString &code, TreeItem *parent);
+    TreeItem(const QString &name, uint64_t     val, const QString &coding, const QString &code, TreeItem *parent);
+    TreeItem(const QString &name, int64_t      val, const QString &coding, const QString &code, TreeItem *parent);
+    TreeItem(const QString &name, bool         val, const QString &coding, const QString &code, TreeItem *parent);
+    TreeItem(const QString &name, double       val, const QString &coding, const QString &code, TreeItem *parent);
+    TreeItem(const QString &name, QString      val, const QString &coding, const QString &code, TreeItem *parent);
+    TreeItem(const QString &name, int          val, const QString &coding, const QString &code, QString meaning, TreeItem *parent);
+    TreeItem(const QString &name, QString      val, const QString &coding, const QString &code, QString meaning, TreeItem *parent, bool isError=false);
+
+    ~TreeItem();
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     void setError(bool isError = true) { error = isError; }
-    bool isError()                     { return error; }
+    bool isError() const               { return error; }
 
-    QString getName(bool showStreamIndex) const { QString r = (showStreamIndex && streamIndex != -1) ? QString("Stream %1 - ").arg(streamIndex) : ""; if (itemData.count() > 0) r += itemData[0]; return r; }
+    // Get the text of the given column (name, value, coding, code, meaning)
+    QString getData(int column) const;
+    QString getName(bool showStreamIndex) const;
+    void setName(const QString &name);
 
     QList<TreeItem*> childItems;
-    QList<QString> itemData;
     TreeItem *parentItem { nullptr };
 
     int getStreamIndex() { if (streamIndex >= 0) return streamIndex; if (parentItem) return parentItem->getStreamIndex(); return -1; }
     void setStreamIndex(int idx) { streamIndex = idx; }
 
+    // The memory that is used by the string table of the tree
+    int64_t getStringTableMemoryUsage() const { return stringTable ? stringTable->getMemoryUsage() : 0; }
+    // The number of items in the tree (including the root)
+    int64_t getNumberItemsInTree() const { return stringTable ? stringTable->nrItems.load() : 0; }
+
   private:
+    void init(TreeItem *parent, const QString &name, const QString &coding = QString(), const QString &code = QString(), const QString &meaning = QString());
+    void setStringValue(const QString &val);
+
+    // Shared by all items of the tree. Created (and deleted) by the root item.
+    TreeItemStringTable *stringTable {nullptr};
+
+    enum class ValueType : unsigned char
+    {
+      None,
+      Int,
+      UInt,
+      Bool,
+      Double,
+      String
+    };
+    union
+    {
+      int64_t intValue;
+      uint64_t uintValue;
+      double doubleValue;
+      unsigned int stringValue;
+    } value;
+    ValueType valueType {ValueType::None};
+
+    // A code of up to 64 zeros and ones is stored as bits. Other codes are stored in the string table.
+    uint64_t codeBits {0};
+    unsigned char codeLength {0};
+    bool codeIsString {false};
+
+    unsigned int nameID {0};
+    unsigned int codingID {0};
+    unsigned int meaningID {0};
+
     bool error { false };
     // This is set for the first layer items in case of AVPackets
     int streamIndex { -1 };
@@ -285,6 +358,11 @@ namespace parserCommon
     void setShowVideoStreamOnly(bool showVideoOnly);
 
     void updateNumberModelItems();
+
+    // Get an estimate of the memory (in bytes) that is used by the tree. Walking a tree with millions of items takes
+    // too long (and the parser adds items in the background) so the estimate is calculated from the running item count.
+    int64_t getMemoryUsageEstimate() const;
+
   private:
     // This is the current number of first level child items which we show right now.
     // The brackground parser will add more items and it will notify the bitstreamAnalysisWindow
@@ -315,6 +393,85 @@ namespace parserCommon
     int streamIndex { -1 };
   };
 
+  /* Analytics of the bitrate of one stream. All values are updated incrementally with every entry (in decoding
+   * order) so that no second pass over the data is needed:
+   * - The bitrate over sliding windows of a configurable duration and the peak of each window
+   * - A leaky bucket simulation of the fullness of the coded picture buffer (CPB/VBV)
+   * - The GOP structure (the distance between keyframes)
+   * - The size distribution of the entries per frame type
+   * The time based values need the frame rate. If it is not known, only the GOP and size values are collected.
+   */
+  class BitrateAnalytics
+  {
+  public:
+    // The HRD parameters for the CPB simulation (e.g. from the VUI of the SPS)
+    struct hrdParameters
+    {
+      bool isValid() const { return bitRate > 0 && cpbSize > 0; }
+      bool operator==(const hrdParameters &other) const { return bitRate == other.bitRate && cpbSize == other.cpbSize && cbr == other.cbr && initialCpbRemovalDelay == other.initialCpbRemovalDelay; }
+      bool operator!=(const hrdParameters &other) const { return !(*this == other); }
+      uint64_t bitRate {0};  //< In bits per second
+      uint64_t cpbSize {0};  //< In bits
+      bool cbr {false};
+      // The delay from the arrival of the first bit until the removal of the first entry from the CPB in units of
+      // a 90 kHz clock (initial_cpb_removal_delay of the first buffering period SEI or vbv_delay). -1 if not known.
+      int64_t initialCpbRemovalDelay {-1};
+    };
+
+    BitrateAnalytics() {}
+    BitrateAnalytics(const QList<double> &windowDurations, double frameRate, const hrdParameters &hrd);
+
+    void addEntry(unsigned int size, bool keyframe, unsigned short frameType);
+    // Get the analytics as a tree. The frame types are the indices into the given list of names.
+    QTreeWidgetItem *getInfo(const QString &title, const QStringList &frameTypeNames) const;
+
+  private:
+    double frameRate {0};
+    hrdParameters hrd;
+
+    unsigned int nrEntries {0};
+    uint64_t totalSize {0};
+
+    // The sizes of the last entries are kept in a ring buffer that is as long as the longest window
+    struct slidingWindow
+    {
+      double duration {0};        //< In seconds
+      unsigned int length {0};    //< In entries
+      uint64_t sum {0};
+      uint64_t peakSum {0};
+      unsigned int peakEndEntry {0};
+    };
+    QVector<slidingWindow> windows;
+    QVector<unsigned int> lastSizes;
+
+    // The CPB simulation (all values in bits). When the first entry is removed, the CPB contains the bits that
+    // arrived during the initial CPB removal delay. If the stream does not signal this delay, the CPB is assumed
+    // to be full. This is the upper limit of the delay (C.1 / E.2.2) and the VBV behavior with vbv_delay 0xFFFF.
+    double initialCpbFullness {0};
+    double cpbFullness {0};
+    double minCpbFullness {0};
+    unsigned int nrCpbUnderflows {0};
+    unsigned int nrCpbOverflows {0};
+    int firstCpbUnderflowEntry {-1};
+
+    // The GOP structure
+    unsigned int nrGOPs {0};
+    unsigned int currentGOPLength {0};
+    QMap<unsigned int, unsigned int> gopLengthHistogram;
+    QVector<unsigned short> firstGOPFrameTypes;
+
+    // The size distribution per frame type. The histogram counts the sizes in power of two bins.
+    struct frameTypeStatistics
+    {
+      unsigned int count {0};
+      unsigned int min {UINT_MAX};
+      unsigned int max {0};
+      uint64_t sum {0};
+      QVector<unsigned int> log2Histogram;
+    };
+    QVector<frameTypeStatistics> statisticsPerFrameType;
+  };
+
   class BitrateItemModel : public QAbstractTableModel
   {
     Q_OBJECT
@@ -333,19 +490,52 @@ namespace parserCommon
     QString getItemInfoText(int index);
 
     void updateNumberModelItems();
-    RangeInt getXRange() { return ptsRange; }
+    RangeInt64 getXRange() { return ptsRange; }
 
+    // The timestamps of a transport stream wrap after 33 bits so they are kept in 64 bit
     struct bitrateEntry
     {
-      int dts {0};
-      int pts {0};
+      int64_t dts {0};
+      int64_t pts {0};
       unsigned int bitrate {0};
       bool keyframe {false};
-      QString frameType;
+      unsigned short frameType {0};  //< Index into frameTypeNames
     };
 
-    void addBitratePoint(int streamIndex, bitrateEntry &entry);
+    // Add the entry. The frame type name (e.g. the slice types) is stored as an index into a list of names.
+    void addBitratePoint(int streamIndex, bitrateEntry &entry, const QString &frameType = QString());
     void setBitrateSortingIndex(int index);
+    // The bars of the entries with these PTS are shown in a separate set (e.g. pictures with a hash mismatch).
+    // Returns false if the marked values did not change.
+    bool setMarkedPTS(const QList<int> &ptsList);
+
+    // The aggregated values of a range of entries
+    struct bitrateAggregate
+    {
+      unsigned int min {UINT_MAX};
+      unsigned int max {0};
+      uint64_t sum {0};
+      unsigned int count {0};
+      bool keyframe {false};  //< At least one of the entries is a keyframe
+      bool marked {false};    //< At least one of the entries is marked
+      void add(const bitrateAggregate &other);
+      double average() const { return count == 0 ? 0.0 : double(sum) / count; }
+    };
+    // Get the aggregates of nrBuckets consecutive ranges of entries (of stream 0 in the current sort order).
+    // Bucket i contains the entries [first + i * entriesPerBucket, first + (i+1) * entriesPerBucket). Buckets after
+    // the last entry are empty. Thanks to the pyramid, this is cheap even for millions of entries.
+    QVector<bitrateAggregate> getAggregates(double first, double entriesPerBucket, int nrBuckets);
+
+    // Set the frame rate and the HRD parameters of the stream for the bitrate analytics. If these change,
+    // the analytics of the stream are recalculated.
+    // An unknown initial CPB removal delay in the HRD parameters keeps the delay that was set before.
+    void setStreamTiming(int streamIndex, double frameRate, const BitrateAnalytics::hrdParameters &hrd = BitrateAnalytics::hrdParameters());
+    // Set the initial CPB removal delay (in units of a 90 kHz clock) from the first buffering period of the stream.
+    // Once a delay was set, further calls are ignored.
+    void setInitialCpbRemovalDelay(int streamIndex, int64_t initialCpbRemovalDelay);
+    // Set the durations (in seconds) of the sliding windows of the bitrate analytics
+    void setAnalyticsWindowDurations(const QList<double> &durations);
+    QList<QTreeWidgetItem*> getAnalyticsInfo() const;
 
   private:
     // The current number of bitrate points that we show.
@@ -359,10 +549,30 @@ namespace parserCommon
     };
     SortMode sortMode { SortMode::DECODE_ORDER };
 
-    QMap<unsigned int, QList<bitrateEntry>> bitratePerStreamData;
+    QMap<unsigned int, QVector<bitrateEntry>> bitratePerStreamData;
     mutable QMutex bitratePerStreamDataMutex;
-    RangeInt dtsRange;
-    RangeInt ptsRange;
+    QSet<int64_t> markedPTS;
+    QStringList frameTypeNames;
+
+    struct streamTiming
+    {
+      double frameRate {0};
+      BitrateAnalytics::hrdParameters hrd;
+    };
+    QMap<unsigned int, streamTiming> timingPerStream;
+    QMap<unsigned int, BitrateAnalytics> analyticsPerStream;
+    QList<double> analyticsWindowDurations {1.0, 5.0};
+    void resetAnalytics(unsigned int streamIndex);
+
+    // A min/max/sum pyramid over the entries of stream 0. Level i aggregates blocks of BITRATE_PYRAMID_FACTOR^(i+1)
+    // entries. Inserting an entry only invalidates the blocks from the insert position on. These are updated lazily
+    // when aggregates are requested. The pyramid is protected by bitratePerStreamDataMutex.
+    QList<QVector<bitrateAggregate>> pyramid;
+    int pyramidValidEntries {0};
+    void updatePyramid();
+    bitrateAggregate getAggregateOfEntries(int first, int last) const;
+    RangeInt64 dtsRange;
+    RangeInt64 ptsRange;
 
     double maxYValue {0};
   };
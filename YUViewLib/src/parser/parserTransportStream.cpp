@@ -0,0 +1,1078 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "parserTransportStream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegExp>
+
+#include "parserAnnexBAVC.h"
+#include "parserAnnexBHEVC.h"
+#include "parserAnnexBMpeg2.h"
+#include "parserAnnexBVVC.h"
+#include "parserCommonMacros.h"
+#include "parserSubtitleDVB.h"
+
+using namespace parserCommon;
+
+#define PARSERTRANSPORTSTREAM_DEBUG_OUTPUT 0
+#if PARSERTRANSPORTSTREAM_DEBUG_OUTPUT && !NDEBUG
+#include <QDebug>
+#define DEBUG_TS qDebug
+#else
+#define DEBUG_TS(fmt,...) ((void)0)
+#endif
+
+namespace
+{
+
+const int TS_PACKET_SIZE = 188;
+const unsigned char TS_SYNC_BYTE = 0x47;
+const int PID_PAT = 0x0000;
+const int PID_NULL = 0x1FFF;
+const int NR_PIDS = 8192;
+// The number of consecutive sync bytes that must be found to detect the packet size
+const int NR_SYNC_BYTES_DETECT = 5;
+// The file is read in blocks of this many packets. The packets are demultiplexed in place in the block buffer.
+const int NR_PACKETS_PER_BLOCK = 8192;
+// The initial capacity of the PES reassembly buffers. The buffers grow if needed and are reused for all PES packets.
+const int PES_BUFFER_RESERVE = 256 * 1024;
+// The fixed PES header (9 byte) plus the maximum PES_header_data_length
+const int PES_MAX_HEADER_SIZE = 9 + 255;
+
+// The PCR runs at 27MHz and wraps around after 2^33 * 300 ticks. The PTS/DTS run at 90kHz and wrap after 2^33 ticks.
+const int64_t PCR_CLOCK = 27000000;
+const int64_t PCR_WRAP = (int64_t(1) << 33) * 300;
+const int64_t PTS_CLOCK = 90000;
+const int64_t PTS_WRAP = int64_t(1) << 33;
+// The PCR interval must not exceed 100ms (ISO/IEC 13818-1 2.7.2). Jumps of more than 1s are counted as discontinuities.
+const int64_t PCR_MAX_INTERVAL = PCR_CLOCK / 10;
+const int64_t PCR_MAX_JUMP = PCR_CLOCK;
+
+const unsigned int STREAM_TYPE_MPEG2_VIDEO = 0x02;
+const unsigned int STREAM_TYPE_AVC = 0x1B;
+const unsigned int STREAM_TYPE_HEVC = 0x24;
+const unsigned int STREAM_TYPE_VVC = 0x33;
+
+const QMap<int,QString> streamTypeMeaning = {
+  {0x01, "MPEG-1 Video"},
+  {0x02, "MPEG-2 Video"},
+  {0x03, "MPEG-1 Audio"},
+  {0x04, "MPEG-2 Audio"},
+  {0x05, "Private sections"},
+  {0x06, "PES private data"},
+  {0x0F, "AAC Audio (ADTS)"},
+  {0x11, "AAC Audio (LATM)"},
+  {0x15, "Metadata in PES"},
+  {0x1B, "AVC Video"},
+  {0x24, "HEVC Video"},
+  {0x33, "VVC Video"},
+  {0x81, "AC-3 Audio"},
+  {0x86, "SCTE-35"},
+  {0x87, "E-AC-3 Audio"}
+};
+
+const QMap<int,QString> descriptorTagMeaning = {
+  {0x05, "registration_descriptor"},
+  {0x0A, "ISO_639_language_descriptor"},
+  {0x52, "stream_identifier_descriptor"},
+  {0x56, "teletext_descriptor"},
+  {0x59, "subtitling_descriptor"},
+  {0x6A, "AC-3_descriptor"},
+  {0x7A, "enhanced_AC-3_descriptor"}
+};
+
+bool isSupportedVideoStreamType(unsigned int streamType)
+{
+  return streamType == STREAM_TYPE_MPEG2_VIDEO || streamType == STREAM_TYPE_AVC || streamType == STREAM_TYPE_HEVC || streamType == STREAM_TYPE_VVC;
+}
+
+QString formatClockTime(int64_t ticks, int64_t clock)
+{
+  return QString("%1 s").arg(double(ticks) / clock, 0, 'f', 3);
+}
+
+// The CRC_32 of the PSI sections (ISO/IEC 13818-1 Annex A). Running it over a section including the CRC_32 gives 0.
+struct CRC32Table
+{
+  CRC32Table()
+  {
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t c = i << 24;
+      for (int k = 0; k < 8; k++)
+        c = (c & 0x80000000) ? (c << 1) ^ 0x04C11DB7 : (c << 1);
+      values[i] = c;
+    }
+  }
+  uint32_t values[256];
+};
+
+uint32_t calculateCRC32(const char *data, int size)
+{
+  static const CRC32Table table;
+  uint32_t crc = 0xFFFFFFFF;
+  for (int i = 0; i < size; i++)
+    crc = (crc << 8) ^ table.values[((crc >> 24) ^ (unsigned char)data[i]) & 0xFF];
+  return crc;
+}
+
+// Find the position of the next start code (0x000001) at or after from. Returns -1 if there is none.
+int findStartCode(const char *data, int size, int from)
+{
+  int i = from + 2;
+  while (i < size)
+  {
+    const void *one = memchr(data + i, 1, size - i);
+    if (one == nullptr)
+      return -1;
+    i = int((const char*)one - data);
+    if (data[i - 1] == 0 && data[i - 2] == 0)
+      return i - 2;
+    i++;
+  }
+  return -1;
+}
+
+// Find the packet size by looking for consecutive sync bytes. In 192 byte M2TS packets, the 4 byte
+// TP_extra_header precedes the sync byte. In 204 byte packets, 16 byte of parity data follow the packet.
+unsigned int detectPacketSize(const unsigned char *data, int64_t size, int &firstSyncPos)
+{
+  for (unsigned int candidate : {188u, 192u, 204u})
+  {
+    for (unsigned int offset = 0; offset < candidate; offset++)
+    {
+      if (offset + candidate * (NR_SYNC_BYTES_DETECT - 1) >= size)
+        break;
+      bool found = true;
+      for (int i = 0; i < NR_SYNC_BYTES_DETECT && found; i++)
+        found = data[offset + i * candidate] == TS_SYNC_BYTE;
+      if (found)
+      {
+        firstSyncPos = offset;
+        return candidate;
+      }
+    }
+  }
+  return 0;
+}
+
+bool readTimestamp(reader_helper &reader, const QString &name, int64_t &timestamp)
+{
+  reader_sub_level sub_level_adder(reader, name);
+
+  unsigned int prefix, bits_32_30, bits_29_15, bits_14_0, marker_bit;
+  READBITS(prefix, 4);
+  READBITS(bits_32_30, 3);
+  READBITS(marker_bit, 1);
+  READBITS(bits_29_15, 15);
+  READBITS(marker_bit, 1);
+  READBITS(bits_14_0, 15);
+  READBITS(marker_bit, 1);
+
+  timestamp = (int64_t(bits_32_30) << 30) | (int64_t(bits_29_15) << 15) | int64_t(bits_14_0);
+  LOGSTRVAL(name, QString("%1 (%2)").arg(timestamp).arg(formatClockTime(timestamp, PTS_CLOCK)));
+  return true;
+}
+
+} // namespace
+
+parserTransportStream::parserTransportStream(QObject *parent) : parserBase(parent)
+{
+  pidStates.resize(NR_PIDS);
+  pidStates[PID_PAT].type = PIDType::PAT;
+}
+
+bool parserTransportStream::isTransportStreamFile(const QString &filePath)
+{
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  const QByteArray start = file.read(204 * (NR_SYNC_BYTES_DETECT + 1));
+  int firstSyncPos;
+  return detectPacketSize((const unsigned char*)start.constData(), start.size(), firstSyncPos) != 0;
+}
+
+QList<int> parserTransportStream::parsePIDList(const QString &text)
+{
+  QList<int> pids;
+  for (const QString &entry : text.split(QRegExp("[,;\\s]+"), QString::SkipEmptyParts))
+  {
+    bool ok;
+    // Base 0 accepts decimal and hex (0x...) values
+    const int pid = entry.toInt(&ok, 0);
+    if (ok && pid >= 0 && pid < PID_NULL && !pids.contains(pid))
+      pids.append(pid);
+  }
+  return pids;
+}
+
+QList<QTreeWidgetItem*> parserTransportStream::getStreamInfo()
+{
+  QMutexLocker locker(&streamInfoMutex);
+
+  // The first QStringPairList contains the general info, next all infos for each stream follows
+  QList<QTreeWidgetItem*> info;
+  if (streamInfoAllStreams.count() == 0)
+    return info;
+
+  QTreeWidgetItem *general = new QTreeWidgetItem(QStringList() << "General");
+  for (QStringPair p : streamInfoAllStreams[0])
+    new QTreeWidgetItem(general, QStringList() << p.first << p.second);
+  info.append(general);
+
+  for (int i = 1; i < streamInfoAllStreams.count(); i++)
+  {
+    QTreeWidgetItem *streamInfo = new QTreeWidgetItem(QStringList() << QString("Stream %1").arg(i-1));
+    for (QStringPair p : streamInfoAllStreams[i])
+      new QTreeWidgetItem(streamInfo, QStringList() << p.first << p.second);
+    info.append(streamInfo);
+  }
+
+  return info;
+}
+
+unsigned int parserTransportStream::getNrStreams()
+{
+  QMutexLocker locker(&streamInfoMutex);
+  return shortStreamInfoAllStreams.count();
+}
+
+QString parserTransportStream::getShortStreamDescription(int streamIndex) const
+{
+  QMutexLocker locker(&streamInfoMutex);
+  if (streamIndex >= shortStreamInfoAllStreams.count())
+    return {};
+  return shortStreamInfoAllStreams[streamIndex];
+}
+
+bool parserTransportStream::runParsingOfFile(QString compressedFilePath)
+{
+  QFile file(compressedFilePath);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    emit backgroundParsingDone("Error opening the transport stream file.");
+    return false;
+  }
+  fileSize = file.size();
+
+  QByteArray buffer;
+  buffer.resize(204 * NR_PACKETS_PER_BLOCK);
+  int bufferFill = std::max(int(file.read(buffer.data(), buffer.size())), 0);
+
+  int firstSyncPos = 0;
+  packetSize = detectPacketSize((const unsigned char*)buffer.constData(), bufferFill, firstSyncPos);
+  if (packetSize == 0)
+  {
+    emit backgroundParsingDone("No transport stream packets found in the file.");
+    return false;
+  }
+  DEBUG_TS("parserTransportStream::runParsingOfFile packet size %d first sync byte at %d", packetSize, firstSyncPos);
+
+  updateStreamInfoLists();
+  emit streamInfoUpdated();
+
+  int64_t bufferFilePos = 0;
+  int pos = firstSyncPos;
+  bool inSync = true;
+  bool abortParsing = false;
+  QElapsedTimer signalEmitTimer;
+  signalEmitTimer.start();
+  while (!abortParsing)
+  {
+    const unsigned char *data = (const unsigned char*)buffer.constData();
+    while (pos + TS_PACKET_SIZE <= bufferFill)
+    {
+      if (data[pos] != TS_SYNC_BYTE || (!inSync && pos + int(packetSize) < bufferFill && data[pos + packetSize] != TS_SYNC_BYTE))
+      {
+        // Search byte by byte until two sync bytes are found one packet apart
+        if (inSync)
+        {
+          DEBUG_TS("parserTransportStream::runParsingOfFile lost sync at %lld", bufferFilePos + pos);
+          nrSyncLosses++;
+          inSync = false;
+        }
+        pos++;
+        continue;
+      }
+      inSync = true;
+      parseTSPacket(data + pos, bufferFilePos + pos);
+      pos += packetSize;
+    }
+
+    // Move the incomplete packet at the end of the block to the front and read the next block
+    int remaining = bufferFill - pos;
+    if (remaining > 0)
+      memmove(buffer.data(), buffer.constData() + pos, remaining);
+    else
+    {
+      // The last packet of the block was longer than 188 bytes (M2TS or 204 byte packets). Skip the rest.
+      if (remaining < 0)
+        file.seek(file.pos() - remaining);
+      remaining = 0;
+    }
+    bufferFilePos += pos;
+    pos = 0;
+
+    const qint64 nrBytesRead = file.read(buffer.data() + remaining, buffer.size() - remaining);
+    if (nrBytesRead <= 0)
+      break;
+    bufferFill = remaining + int(nrBytesRead);
+
+    if (fileSize > 0)
+      progressPercentValue = clip(int(bufferFilePos * 100 / fileSize), 0, 100);
+
+    if (signalEmitTimer.elapsed() > 1000 && packetModel)
+    {
+      signalEmitTimer.start();
+      updateStreamInfoLists();
+      emit modelDataUpdated();
+      emit streamInfoUpdated();
+    }
+
+    if (cancelBackgroundParser)
+    {
+      DEBUG_TS("parserTransportStream::runParsingOfFile Abort parsing by user request");
+      abortParsing = true;
+    }
+    if (parsingLimitEnabled && annexBParser && annexBParser->getNumberPOCs() > PARSER_FILE_FRAME_NR_LIMIT)
+    {
+      DEBUG_TS("parserTransportStream::runParsingOfFile Abort parsing because frame limit was reached.");
+      abortParsing = true;
+    }
+  }
+
+  // Parse the PES packets that are still pending and the last access unit of the video stream
+  for (ElementaryStream &stream : elementaryStreams)
+    if (!stream.pesData.isEmpty())
+      finishPESPacket(stream);
+  if (annexBParser)
+    annexBParser->parseAndAddNALUnit(-1, QByteArray(), this->bitrateItemModel.data());
+
+  if (packetModel)
+    emit modelDataUpdated();
+
+  updateStreamInfoLists();
+  emit streamInfoUpdated();
+  emit backgroundParsingDone("");
+
+  return !cancelBackgroundParser;
+}
+
+void parserTransportStream::parseTSPacket(const unsigned char *packet, int64_t filePos)
+{
+  nrTSPackets++;
+
+  const bool transportErrorIndicator = packet[1] & 0x80;
+  const bool payloadUnitStartIndicator = packet[1] & 0x40;
+  const int pid = ((packet[1] & 0x1F) << 8) | packet[2];
+  const unsigned int adaptationFieldControl = (packet[3] >> 4) & 0x03;
+  const int continuityCounter = packet[3] & 0x0F;
+
+  if (pid == PID_NULL)
+  {
+    nrNullPackets++;
+    return;
+  }
+
+  PIDState &state = pidStates[pid];
+  state.nrPackets++;
+  ElementaryStream *stream = (state.type == PIDType::ElementaryStream) ? &elementaryStreams[state.streamIndex] : nullptr;
+
+  if (transportErrorIndicator)
+  {
+    // The packet is corrupt (e.g. an uncorrectable reception error). None of its data can be used.
+    state.nrTransportErrors++;
+    if (stream && !stream->pesData.isEmpty())
+      stream->pesErrors.append(QString("The transport_error_indicator is set in the TS packet at position %1.").arg(filePos));
+    return;
+  }
+
+  int payloadPos = 4;
+  bool discontinuityIndicator = false;
+  bool randomAccessIndicator = false;
+  if (adaptationFieldControl & 0x02)
+  {
+    const int adaptationFieldLength = packet[4];
+    if (adaptationFieldLength > 0)
+    {
+      discontinuityIndicator = packet[5] & 0x80;
+      randomAccessIndicator = packet[5] & 0x40;
+      const bool pcrFlag = packet[5] & 0x10;
+      if (pcrFlag && adaptationFieldLength >= 7)
+      {
+        const int64_t base = (int64_t(packet[6]) << 25) | (int64_t(packet[7]) << 17) | (int64_t(packet[8]) << 9) | (int64_t(packet[9]) << 1) | (packet[10] >> 7);
+        const int64_t extension = (int64_t(packet[10] & 0x01) << 8) | packet[11];
+        handlePCR(pid, base * 300 + extension, filePos, discontinuityIndicator);
+      }
+    }
+    payloadPos = 5 + adaptationFieldLength;
+  }
+
+  // The continuity_counter is only incremented for packets with payload
+  if (adaptationFieldControl & 0x01)
+  {
+    const int expectedCounter = (state.continuityCounter + 1) & 0x0F;
+    if (state.continuityCounter >= 0 && !discontinuityIndicator && continuityCounter != expectedCounter)
+    {
+      // A packet may be sent twice (ISO/IEC 13818-1 2.4.3.3). The payload of the duplicate is discarded.
+      if (continuityCounter == state.continuityCounter)
+        return;
+
+      DEBUG_TS("parserTransportStream::parseTSPacket continuity error PID %d expected %d got %d", pid, expectedCounter, continuityCounter);
+      state.nrContinuityErrors++;
+      if (stream && !stream->pesData.isEmpty())
+        stream->pesErrors.append(QString("Continuity error in the TS packet at position %1. Expected continuity_counter %2 but got %3.").arg(filePos).arg(expectedCounter).arg(continuityCounter));
+    }
+    state.continuityCounter = continuityCounter;
+  }
+
+  if (!(adaptationFieldControl & 0x01) || payloadPos >= TS_PACKET_SIZE)
+    return;
+
+  const char *payload = (const char*)packet + payloadPos;
+  const int payloadSize = TS_PACKET_SIZE - payloadPos;
+  if (state.type == PIDType::PAT || state.type == PIDType::PMT)
+    handleSectionData(pid, payload, payloadSize, payloadUnitStartIndicator);
+  else if (stream)
+    handlePESData(*stream, payload, payloadSize, payloadUnitStartIndicator, randomAccessIndicator, filePos);
+}
+
+void parserTransportStream::handlePCR(int pid, int64_t pcr, int64_t filePos, bool discontinuity)
+{
+  if (pid != pcrInfo.pid)
+    return;
+
+  pcrInfo.nrPCRs++;
+  if (pcrInfo.last >= 0)
+  {
+    const int64_t interval = (pcr - pcrInfo.last + PCR_WRAP) % PCR_WRAP;
+    if (discontinuity || interval > PCR_MAX_JUMP)
+      pcrInfo.nrDiscontinuities++;
+    else
+    {
+      if (interval > PCR_MAX_INTERVAL)
+        pcrInfo.nrIntervalViolations++;
+      pcrInfo.maxInterval = std::max(pcrInfo.maxInterval, interval);
+      pcrInfo.duration += interval;
+      pcrInfo.nrBytes += filePos - pcrInfo.lastFilePos;
+    }
+  }
+  pcrInfo.last = pcr;
+  pcrInfo.lastFilePos = filePos;
+}
+
+void parserTransportStream::handleSectionData(int pid, const char *data, int size, bool payloadUnitStart)
+{
+  QByteArray &section = psiSections[pid];
+
+  // Parse all complete sections in the buffer. After the last section, the packet is filled with stuffing (0xFF).
+  auto parseCompleteSections = [this, pid, &section]()
+  {
+    while (section.size() >= 3 && (unsigned char)section.at(0) != 0xFF)
+    {
+      const int sectionLength = 3 + ((((unsigned char)section.at(1) & 0x0F) << 8) | (unsigned char)section.at(2));
+      if (section.size() < sectionLength)
+        return;
+      parseSection(pid, section.left(sectionLength));
+      section.remove(0, sectionLength);
+    }
+    if (!section.isEmpty() && (unsigned char)section.at(0) == 0xFF)
+      section.clear();
+  };
+
+  if (payloadUnitStart)
+  {
+    // The pointer_field gives the number of bytes that still belong to the previous section
+    const int pointerField = (unsigned char)data[0];
+    data++;
+    size--;
+    if (pointerField > size)
+    {
+      section.clear();
+      return;
+    }
+    if (!section.isEmpty())
+    {
+      section.append(data, pointerField);
+      parseCompleteSections();
+    }
+    section.clear();
+    data += pointerField;
+    size -= pointerField;
+  }
+  else if (section.isEmpty())
+    // Wait for the start of the next section
+    return;
+
+  section.append(data, size);
+  parseCompleteSections();
+}
+
+void parserTransportStream::parseSection(int pid, const QByteArray &section)
+{
+  // The PAT and PMT have at least the 8 byte header and the CRC_32
+  if (section.size() < 12)
+    return;
+
+  const unsigned int tableID = (unsigned char)section.at(0);
+  const PIDType pidType = pidStates[pid].type;
+  if (!(tableID == 0x00 && pidType == PIDType::PAT) && !(tableID == 0x02 && pidType == PIDType::PMT))
+    return;
+
+  // The tables are repeated regularly. Only parse them again if the version changed.
+  const unsigned int version = ((unsigned char)section.at(5) >> 1) & 0x1F;
+  const bool currentNextIndicator = section.at(5) & 0x01;
+  const unsigned int tableIDExtension = ((unsigned char)section.at(3) << 8) | (unsigned char)section.at(4);
+  const quint64 versionKey = (quint64(pid) << 24) | (quint64(tableID) << 16) | tableIDExtension;
+  if (!currentNextIndicator || psiVersions.value(versionKey, -1) == int(version))
+    return;
+
+  TreeItem *itemTree = packetModel->isNull() ? nullptr : new TreeItem(packetModel->getRootItem());
+  const QString tableName = (tableID == 0x00) ? "PAT" : "PMT";
+  if (itemTree)
+    itemTree->setName(QString("%1 - PID %2 - version %3").arg(tableName).arg(pid).arg(version));
+
+  if (calculateCRC32(section.constData(), section.size()) != 0)
+  {
+    // Don't remember the version so that the next repetition of the table is parsed
+    reader_helper::addErrorMessageChildItem("CRC_32 mismatch. The section is corrupt.", itemTree);
+    return;
+  }
+  psiVersions[versionKey] = version;
+
+  const bool parsingOK = (tableID == 0x00) ? parsePAT(section, itemTree) : parsePMT(section, itemTree);
+  if (!parsingOK && itemTree)
+    itemTree->setError();
+}
+
+bool parserTransportStream::parsePAT(const QByteArray &section, TreeItem *root)
+{
+  reader_helper reader(section, root, "program_association_section()");
+  reader.disableEmulationPrevention();
+
+  unsigned int table_id, section_length, transport_stream_id, version_number, section_number, last_section_number;
+  bool section_syntax_indicator, current_next_indicator;
+  READBITS(table_id, 8);
+  READFLAG(section_syntax_indicator);
+  IGNOREBITS(3);  // '0' and reserved
+  READBITS(section_length, 12);
+  if (section_length < 9)
+    return reader.addErrorMessageChildItem("The section_length of a PAT must be at least 9.");
+  READBITS(transport_stream_id, 16);
+  IGNOREBITS(2);
+  READBITS(version_number, 5);
+  READFLAG(current_next_indicator);
+  READBITS(section_number, 8);
+  READBITS(last_section_number, 8);
+
+  // The section_length includes the 5 bytes after it and the CRC_32. Each program has 4 bytes.
+  const unsigned int nrPrograms = (section_length - 9) / 4;
+  for (unsigned int i = 0; i < nrPrograms; i++)
+  {
+    reader_sub_level sub_level_adder(reader, QString("program %1").arg(i));
+
+    unsigned int program_number;
+    READBITS(program_number, 16);
+    IGNOREBITS(3);
+    if (program_number == 0)
+    {
+      unsigned int network_PID;
+      READBITS(network_PID, 13);
+    }
+    else
+    {
+      unsigned int program_map_PID;
+      READBITS(program_map_PID, 13);
+      if (pidStates[program_map_PID].type == PIDType::Unknown)
+        pidStates[program_map_PID].type = PIDType::PMT;
+    }
+  }
+
+  unsigned int CRC_32;
+  READBITS(CRC_32, 32);
+  return true;
+}
+
+bool parserTransportStream::parsePMT(const QByteArray &section, TreeItem *root)
+{
+  reader_helper reader(section, root, "TS_program_map_section()");
+  reader.disableEmulationPrevention();
+
+  unsigned int table_id, section_length, program_number, version_number, section_number, last_section_number, PCR_PID, program_info_length;
+  bool section_syntax_indicator, current_next_indicator;
+  READBITS(table_id, 8);
+  READFLAG(section_syntax_indicator);
+  IGNOREBITS(3);  // '0' and reserved
+  READBITS(section_length, 12);
+  if (section_length < 13)
+    return reader.addErrorMessageChildItem("The section_length of a PMT must be at least 13.");
+  READBITS(program_number, 16);
+  IGNOREBITS(2);
+  READBITS(version_number, 5);
+  READFLAG(current_next_indicator);
+  READBITS(section_number, 8);
+  READBITS(last_section_number, 8);
+  IGNOREBITS(3);
+  READBITS(PCR_PID, 13);
+  IGNOREBITS(4);
+  READBITS(program_info_length, 12);
+  for (unsigned int i = 0; i < program_info_length; i++)
+    IGNOREBITS(8);
+
+  // The PCR of the first program is used for the timing analysis
+  if (pcrInfo.pid < 0 && int(PCR_PID) != PID_NULL)
+    pcrInfo.pid = int(PCR_PID);
+
+  struct streamEntry
+  {
+    unsigned int pid;
+    unsigned int streamType;
+    QString language;
+    bool isDVBSubtitle;
+  };
+  QList<streamEntry> entries;
+
+  // The elementary stream loop ends before the CRC_32
+  const unsigned int loopEnd = 3 + section_length - 4;
+  int streamIdx = 0;
+  while (reader.nrBytesRead() + 5 <= loopEnd)
+  {
+    reader_sub_level sub_level_adder(reader, QString("elementary stream %1").arg(streamIdx++));
+
+    unsigned int stream_type, elementary_PID, ES_info_length;
+    READBITS_M(stream_type, 8, streamTypeMeaning);
+    IGNOREBITS(3);
+    READBITS(elementary_PID, 13);
+    IGNOREBITS(4);
+    READBITS(ES_info_length, 12);
+
+    streamEntry entry {elementary_PID, stream_type, QString(), false};
+    unsigned int descriptorBytesRead = 0;
+    while (descriptorBytesRead + 2 <= ES_info_length)
+    {
+      reader_sub_level descriptor_level_adder(reader, "descriptor()");
+
+      unsigned int descriptor_tag, descriptor_length;
+      READBITS_M(descriptor_tag, 8, descriptorTagMeaning);
+      READBITS(descriptor_length, 8);
+      unsigned int descriptorPayloadRead = 0;
+      if ((descriptor_tag == 0x0A || descriptor_tag == 0x59) && descriptor_length >= 3)
+      {
+        // The ISO_639_language_descriptor and the subtitling_descriptor start with the language code
+        unsigned int ISO_639_language_code;
+        READBITS(ISO_639_language_code, 24);
+        entry.language = QString() + QChar((ISO_639_language_code >> 16) & 0xFF) + QChar((ISO_639_language_code >> 8) & 0xFF) + QChar(ISO_639_language_code & 0xFF);
+        LOGSTRVAL("language", entry.language);
+        descriptorPayloadRead = 3;
+      }
+      for (unsigned int i = descriptorPayloadRead; i < descriptor_length; i++)
+        IGNOREBITS(8);
+      if (descriptor_tag == 0x59)
+        entry.isDVBSubtitle = true;
+      descriptorBytesRead += 2 + descriptor_length;
+    }
+    entries.append(entry);
+  }
+
+  unsigned int CRC_32;
+  READBITS(CRC_32, 32);
+
+  for (const streamEntry &e : entries)
+    addElementaryStream(int(e.pid), e.streamType, program_number, e.language, e.isDVBSubtitle);
+
+  return true;
+}
+
+void parserTransportStream::addElementaryStream(int pid, unsigned int streamType, unsigned int programNumber, const QString &language, bool isDVBSubtitle)
+{
+  PIDState &state = pidStates[pid];
+  if (state.type != PIDType::Unknown)
+    // The stream is already known (the PMT is repeated or was updated)
+    return;
+  if (!pidFilter.isEmpty() && !pidFilter.contains(pid))
+  {
+    state.type = PIDType::Filtered;
+    return;
+  }
+
+  // The AnnexB parsers add their bitrate entries for stream 0. So only the first supported
+  // video stream gets the index 0, even if other streams were added before it.
+  const bool isVideo = (videoStreamIndex < 0 && isSupportedVideoStreamType(streamType));
+
+  ElementaryStream stream;
+  stream.pid = pid;
+  stream.streamType = streamType;
+  stream.programNumber = programNumber;
+  stream.streamIndex = isVideo ? 0 : nextStreamIndex++;
+  stream.language = language;
+  stream.isDVBSubtitle = isDVBSubtitle;
+  elementaryStreams.append(stream);
+  elementaryStreams.last().pesData.reserve(PES_BUFFER_RESERVE);
+
+  state.type = PIDType::ElementaryStream;
+  state.streamIndex = elementaryStreams.count() - 1;
+
+  if (isVideo)
+  {
+    if (streamType == STREAM_TYPE_AVC)
+      annexBParser.reset(new parserAnnexBAVC());
+    else if (streamType == STREAM_TYPE_HEVC)
+      annexBParser.reset(new parserAnnexBHEVC());
+    else if (streamType == STREAM_TYPE_VVC)
+      annexBParser.reset(new parserAnnexBVVC());
+    else if (streamType == STREAM_TYPE_MPEG2_VIDEO)
+      annexBParser.reset(new parserAnnexBMpeg2());
+    videoStreamIndex = 0;
+  }
+
+  DEBUG_TS("parserTransportStream::addElementaryStream PID %d stream type %d index %d", pid, streamType, stream.streamIndex);
+}
+
+void parserTransportStream::handlePESData(ElementaryStream &stream, const char *data, int size, bool payloadUnitStart, bool randomAccess, int64_t filePos)
+{
+  if (payloadUnitStart)
+  {
+    // Most video streams signal a PES_packet_length of 0. These packets end with the start of the next one.
+    if (!stream.pesData.isEmpty())
+      finishPESPacket(stream);
+    stream.pesStartPos = filePos;
+    stream.pesPCR = pcrInfo.last;
+    stream.pesRandomAccess = randomAccess;
+  }
+  else if (stream.pesData.isEmpty())
+    // Wait for the start of the next PES packet
+    return;
+
+  stream.pesData.append(data, size);
+
+  if (stream.pesData.size() >= 6)
+  {
+    const unsigned char *pes = (const unsigned char*)stream.pesData.constData();
+    const int pesPacketLength = (pes[4] << 8) | pes[5];
+    if (pesPacketLength > 0 && stream.pesData.size() >= pesPacketLength + 6)
+      finishPESPacket(stream);
+  }
+}
+
+void parserTransportStream::finishPESPacket(ElementaryStream &stream)
+{
+  const int pesIdx = stream.nrPESPackets++;
+  if (packetModel->isNull())
+  {
+    stream.pesData.resize(0);
+    stream.pesErrors.clear();
+    return;
+  }
+
+  TreeItem *itemTree = new TreeItem(packetModel->getRootItem());
+  itemTree->setStreamIndex(stream.streamIndex);
+  new TreeItem("PID", stream.pid, itemTree);
+  new TreeItem("file_position", QString::number(stream.pesStartPos), itemTree);
+  if (stream.pesPCR >= 0)
+    new TreeItem("PCR", QString("%1 (%2)").arg(stream.pesPCR).arg(formatClockTime(stream.pesPCR, PCR_CLOCK)), itemTree);
+  new TreeItem("random_access_indicator", int(stream.pesRandomAccess), itemTree);
+  new TreeItem("data_size", stream.pesData.size(), itemTree);
+  for (const QString &error : stream.pesErrors)
+    reader_helper::addErrorMessageChildItem(error, itemTree);
+
+  // Only the header is copied to the reader. The payload is parsed directly from the reassembly buffer.
+  PESHeader header;
+  const int size = stream.pesData.size();
+  const QByteArray headerData = QByteArray::fromRawData(stream.pesData.constData(), std::min(size, PES_MAX_HEADER_SIZE));
+  QString specificDescription;
+  if (parsePESHeader(headerData, itemTree, header) && header.payloadStart <= size)
+  {
+    const char *payload = stream.pesData.constData() + header.payloadStart;
+    const int payloadSize = size - header.payloadStart;
+    stream.nrPayloadBytes += payloadSize;
+
+    if (stream.streamIndex == videoStreamIndex && annexBParser)
+    {
+      QStringList nalNames;
+      parseVideoPayload(payload, payloadSize, itemTree, nalNames);
+      // In mpeg2 there is no concept of NAL units
+      specificDescription = (stream.streamType == STREAM_TYPE_MPEG2_VIDEO) ? " -" : " - NALs:";
+      for (QString n : nalNames)
+        specificDescription += (" " + n);
+    }
+    else
+    {
+      if (stream.isDVBSubtitle)
+      {
+        QStringList segmentNames;
+        parseDVBSubtitlePayload(payload, payloadSize, itemTree, segmentNames);
+        specificDescription = " - Segments:";
+        for (QString n : segmentNames)
+          specificDescription += (" " + n);
+      }
+
+      // The AnnexB parser adds the bitrate entries of the video stream itself. The timestamps are relative to the first PTS.
+      if (stream.firstPTS < 0)
+        stream.firstPTS = header.pts;
+      BitrateItemModel::bitrateEntry entry;
+      if (header.pts >= 0 && stream.firstPTS >= 0)
+      {
+        entry.pts = (header.pts - stream.firstPTS + PTS_WRAP) % PTS_WRAP;
+        entry.dts = (header.dts >= 0) ? (header.dts - stream.firstPTS + PTS_WRAP) % PTS_WRAP : entry.pts;
+      }
+      entry.bitrate = payloadSize;
+      entry.keyframe = stream.pesRandomAccess;
+      bitrateItemModel->addBitratePoint(stream.streamIndex, entry);
+    }
+  }
+  else
+    itemTree->setError();
+
+  itemTree->setName(QString("PES %1 - PID %2%3").arg(pesIdx).arg(stream.pid).arg(stream.pesRandomAccess ? " - Random access" : "") + specificDescription);
+
+  stream.pesData.resize(0);
+  stream.pesErrors.clear();
+}
+
+bool parserTransportStream::parsePESHeader(const QByteArray &data, TreeItem *root, PESHeader &header)
+{
+  reader_helper reader(data, root, "PES_header()");
+  reader.disableEmulationPrevention();
+
+  unsigned int packet_start_code_prefix, stream_id, PES_packet_length;
+  READBITS(packet_start_code_prefix, 24);
+  if (packet_start_code_prefix != 1)
+    return reader.addErrorMessageChildItem("The packet_start_code_prefix must be 0x000001.");
+  READBITS(stream_id, 8);
+  READBITS(PES_packet_length, 16);
+  header.streamID = stream_id;
+  header.payloadStart = 6;
+
+  // These streams have no optional PES header (ISO/IEC 13818-1 Table 2-21)
+  if (stream_id == 0xBC || stream_id == 0xBE || stream_id == 0xBF || stream_id == 0xF0 || stream_id == 0xF1 || stream_id == 0xF2 || stream_id == 0xF8 || stream_id == 0xFF)
+    return true;
+
+  unsigned int marker_bits;
+  READBITS(marker_bits, 2);
+  if (marker_bits != 2)
+    return reader.addErrorMessageChildItem("The two bits before the PES_scrambling_control must be '10'.");
+  unsigned int PES_scrambling_control, PTS_DTS_flags, PES_header_data_length;
+  bool PES_priority, data_alignment_indicator, copyright, original_or_copy;
+  bool ESCR_flag, ES_rate_flag, DSM_trick_mode_flag, additional_copy_info_flag, PES_CRC_flag, PES_extension_flag;
+  READBITS_M(PES_scrambling_control, 2, QStringList() << "Not scrambled" << "User-defined" << "User-defined" << "User-defined");
+  READFLAG(PES_priority);
+  READFLAG(data_alignment_indicator);
+  READFLAG(copyright);
+  READFLAG(original_or_copy);
+  READBITS_M(PTS_DTS_flags, 2, QStringList() << "No PTS or DTS" << "Forbidden" << "PTS" << "PTS and DTS");
+  READFLAG(ESCR_flag);
+  READFLAG(ES_rate_flag);
+  READFLAG(DSM_trick_mode_flag);
+  READFLAG(additional_copy_info_flag);
+  READFLAG(PES_CRC_flag);
+  READFLAG(PES_extension_flag);
+  READBITS(PES_header_data_length, 8);
+  header.payloadStart = 9 + PES_header_data_length;
+
+  if (PTS_DTS_flags & 0x02)
+    if (!readTimestamp(reader, "PTS", header.pts))
+      return false;
+  if (PTS_DTS_flags == 3)
+    if (!readTimestamp(reader, "DTS", header.dts))
+      return false;
+
+  return true;
+}
+
+void parserTransportStream::parseVideoPayload(const char *data, int size, TreeItem *root, QStringList &nalNames)
+{
+  int startCodePos = findStartCode(data, size, 0);
+  if (startCodePos < 0)
+  {
+    reader_helper::addErrorMessageChildItem("No start code found in the PES payload.", root);
+    return;
+  }
+  // A 4 byte start code starts with a zero_byte. Any other data before the first start code can not be parsed.
+  if (std::any_of(data, data + startCodePos, [](char c) { return c != 0; }))
+    reader_helper::addErrorMessageChildItem("The PES payload does not start with a start code. The data before the first start code is skipped.", root);
+
+  while (startCodePos >= 0)
+  {
+    const int nalStart = startCodePos + 3;
+    const int nextStartCodePos = findStartCode(data, size, nalStart);
+    // Zero bytes before the next start code are the zero_byte or trailing_zero_8bits
+    int nalEnd = (nextStartCodePos < 0) ? size : nextStartCodePos;
+    while (nalEnd > nalStart && data[nalEnd - 1] == 0)
+      nalEnd--;
+
+    if (nalEnd > nalStart)
+    {
+      // The parsers may keep the NAL data (e.g. parameter sets). So it is copied out of the reassembly buffer.
+      const QByteArray nalData(data + nalStart, nalEnd - nalStart);
+      QString nalTypeName;
+      QUint64Pair nalStartEndPosFile; // Not used
+      try
+      {
+        if (!annexBParser->parseAndAddNALUnit(nalID, nalData, this->bitrateItemModel.data(), root, nalStartEndPosFile, &nalTypeName))
+          root->setError();
+      }
+      catch (...)
+      {
+        DEBUG_TS("parserTransportStream::parseVideoPayload Exception thrown parsing NAL %d", nalID);
+        root->setError();
+      }
+      if (!nalTypeName.isEmpty())
+        nalNames.append(nalTypeName);
+      nalID++;
+    }
+
+    startCodePos = nextStartCodePos;
+  }
+}
+
+void parserTransportStream::parseDVBSubtitlePayload(const char *data, int size, TreeItem *root, QStringList &segmentNames)
+{
+  int pos = 0;
+  if (size >= 2 && (unsigned char)data[0] == 0x20)
+  {
+    // The PES data starts with the data_identifier and the subtitle_stream_id (ETSI EN 300 743 7.1)
+    new TreeItem("data_identifier", 0x20, root);
+    new TreeItem("subtitle_stream_id", int((unsigned char)data[1]), root);
+    pos = 2;
+  }
+
+  const int MIN_DVB_SEGMENT_SIZE = 6;
+  int segmentID = 0;
+  while (pos + MIN_DVB_SEGMENT_SIZE <= size && (unsigned char)data[pos] == 0x0F)
+  {
+    QString segmentTypeName;
+    int nrBytesRead = 0;
+    try
+    {
+      nrBytesRead = subtitle_dvb::parseDVBSubtitleSegment(QByteArray::fromRawData(data + pos, size - pos), root, &segmentTypeName);
+    }
+    catch (...)
+    {
+      break;
+    }
+    if (nrBytesRead <= 0)
+      break;
+    pos += nrBytesRead;
+
+    if (!segmentTypeName.isEmpty())
+      segmentNames.append(segmentTypeName);
+    if (++segmentID > 200)
+    {
+      DEBUG_TS("parserTransportStream::parseDVBSubtitlePayload We encountered more than 200 DVB segments in one packet. This is probably an error.");
+      break;
+    }
+  }
+}
+
+void parserTransportStream::updateStreamInfoLists()
+{
+  unsigned int nrContinuityErrors = 0;
+  unsigned int nrTransportErrors = 0;
+  for (const PIDState &state : pidStates)
+  {
+    nrContinuityErrors += state.nrContinuityErrors;
+    nrTransportErrors += state.nrTransportErrors;
+  }
+
+  QStringPairList generalInfo;
+  generalInfo.append(QStringPair("File size", QString::number(fileSize)));
+  generalInfo.append(QStringPair("Packet size", QString::number(packetSize)));
+  generalInfo.append(QStringPair("Number TS packets", QString::number(nrTSPackets)));
+  generalInfo.append(QStringPair("Number null packets", QString::number(nrNullPackets)));
+  generalInfo.append(QStringPair("Sync losses", QString::number(nrSyncLosses)));
+  generalInfo.append(QStringPair("Continuity errors (all PIDs)", QString::number(nrContinuityErrors)));
+  generalInfo.append(QStringPair("Transport errors (all PIDs)", QString::number(nrTransportErrors)));
+  if (pcrInfo.pid >= 0)
+  {
+    generalInfo.append(QStringPair("PCR PID", QString::number(pcrInfo.pid)));
+    generalInfo.append(QStringPair("Number PCRs", QString::number(pcrInfo.nrPCRs)));
+    generalInfo.append(QStringPair("Duration (PCR)", formatClockTime(pcrInfo.duration, PCR_CLOCK)));
+    if (pcrInfo.duration > 0)
+    {
+      // Only the 188 bytes of each packet count for the mux rate (not the M2TS header or the parity bytes)
+      const double muxRate = double(pcrInfo.nrBytes) * TS_PACKET_SIZE / packetSize * 8 * PCR_CLOCK / pcrInfo.duration;
+      generalInfo.append(QStringPair("Mux rate (PCR)", QString("%1 kbit/s").arg(muxRate / 1000, 0, 'f', 1)));
+    }
+    generalInfo.append(QStringPair("Max PCR interval", QString("%1 ms").arg(double(pcrInfo.maxInterval) * 1000 / PCR_CLOCK, 0, 'f', 1)));
+    generalInfo.append(QStringPair("PCR intervals > 100ms", QString::number(pcrInfo.nrIntervalViolations)));
+    generalInfo.append(QStringPair("PCR discontinuities", QString::number(pcrInfo.nrDiscontinuities)));
+  }
+
+  // The lists are ordered by the stream index. If there is no video stream, the index 0 is not used.
+  const int nrStreams = elementaryStreams.isEmpty() ? 0 : nextStreamIndex;
+  QVector<QStringPairList> infoPerStream(nrStreams);
+  QVector<QString> shortInfoPerStream(nrStreams);
+  if (nrStreams > 0 && videoStreamIndex < 0)
+  {
+    infoPerStream[0].append(QStringPair("Stream type", "No supported video stream"));
+    shortInfoPerStream[0] = "No video stream";
+  }
+  for (const ElementaryStream &stream : elementaryStreams)
+  {
+    const PIDState &state = pidStates[stream.pid];
+    const QString streamTypeName = streamTypeMeaning.value(int(stream.streamType), stream.isDVBSubtitle ? "DVB Subtitle" : "Unknown");
+
+    QStringPairList info;
+    info.append(QStringPair("PID", QString::number(stream.pid)));
+    info.append(QStringPair("Program number", QString::number(stream.programNumber)));
+    info.append(QStringPair("Stream type", QString("%1 (0x%2)").arg(streamTypeName).arg(stream.streamType, 2, 16, QChar('0'))));
+    if (stream.isDVBSubtitle)
+      info.append(QStringPair("Subtitles", "DVB"));
+    if (!stream.language.isEmpty())
+      info.append(QStringPair("Language", stream.language));
+    info.append(QStringPair("Number TS packets", QString::number(state.nrPackets)));
+    info.append(QStringPair("Number PES packets", QString::number(stream.nrPESPackets)));
+    info.append(QStringPair("Payload bytes", QString::number(stream.nrPayloadBytes)));
+    info.append(QStringPair("Continuity errors", QString::number(state.nrContinuityErrors)));
+    info.append(QStringPair("Transport errors", QString::number(state.nrTransportErrors)));
+    infoPerStream[stream.streamIndex] = info;
+
+    QString shortInfo = QString("PID %1 - %2").arg(stream.pid).arg(stream.isDVBSubtitle ? "DVB Subtitle" : streamTypeName);
+    if (!stream.language.isEmpty())
+      shortInfo += QString(" (%1)").arg(stream.language);
+    shortInfoPerStream[stream.streamIndex] = shortInfo;
+  }
+
+  QList<QStringPairList> infoAllStreams;
+  infoAllStreams.append(generalInfo);
+  infoAllStreams.append(infoPerStream.toList());
+  const QList<QString> shortInfoAllStreams = shortInfoPerStream.toList();
+
+  QMutexLocker locker(&streamInfoMutex);
+  streamInfoAllStreams = infoAllStreams;
+  shortStreamInfoAllStreams = shortInfoAllStreams;
+}
@@ -0,0 +1,183 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PARSERTRANSPORTSTREAM_H
+#define PARSERTRANSPORTSTREAM_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include "parserBase.h"
+#include "parserAnnexB.h"
+
+/* A native demuxer for MPEG-2 transport streams (ISO/IEC 13818-1) for the bitstream analysis.
+ * The file is read in large blocks and the TS packets are demultiplexed in place without libavformat.
+ * The PAT/PMT are parsed to find the elementary streams. The PES packets of the video stream are passed
+ * to the matching AnnexB parser (AVC, HEVC, VVC or MPEG-2) and the DVB subtitle PES packets to the DVB
+ * subtitle parser. 608 closed captions are carried in the SEI of the video stream and are parsed by the
+ * AnnexB parser. While demultiplexing, the continuity counters of all PIDs are checked and the PCR is tracked.
+ */
+class parserTransportStream : public parserBase
+{
+  Q_OBJECT
+
+public:
+  parserTransportStream(QObject *parent = nullptr);
+  ~parserTransportStream() {}
+
+  // Check if the file starts with TS packets (188 byte TS, 192 byte M2TS or 204 byte packets)
+  static bool isTransportStreamFile(const QString &filePath);
+
+  QList<QTreeWidgetItem*> getStreamInfo() Q_DECL_OVERRIDE;
+  unsigned int getNrStreams() Q_DECL_OVERRIDE;
+  QString getShortStreamDescription(int streamIndex) const override;
+
+  // This function can run in a separate thread
+  bool runParsingOfFile(QString compressedFilePath) Q_DECL_OVERRIDE;
+
+  int getVideoStreamIndex() Q_DECL_OVERRIDE { return videoStreamIndex; }
+
+  // Only demultiplex the elementary streams with the given PIDs. The packets of all other PIDs are
+  // only counted and checked for continuity errors. If the list is empty, all streams are demultiplexed.
+  // This must be set before parsing starts.
+  void setPIDFilter(const QList<int> &pids) { pidFilter = pids; }
+  // Get the PIDs from a list like "256, 0x101". Entries that are no valid PID are ignored.
+  static QList<int> parsePIDList(const QString &text);
+
+private:
+  enum class PIDType
+  {
+    Unknown,
+    PAT,
+    PMT,
+    ElementaryStream,
+    Filtered
+  };
+
+  struct PIDState
+  {
+    PIDType type {PIDType::Unknown};
+    int streamIndex {-1};  //< Index into elementaryStreams (only for ElementaryStream PIDs)
+    int continuityCounter {-1};
+    unsigned int nrPackets {0};
+    unsigned int nrContinuityErrors {0};
+    unsigned int nrTransportErrors {0};
+  };
+
+  struct ElementaryStream
+  {
+    int pid {-1};
+    int streamIndex {-1};  //< The stream index of the packets and bitrate entries (0 only for the video stream)
+    unsigned int streamType {0};  //< The stream_type from the PMT
+    unsigned int programNumber {0};
+    QString language;
+    bool isDVBSubtitle {false};
+
+    // The PES packet that is currently reassembled. The buffer is reused for all PES packets.
+    QByteArray pesData;
+    int64_t pesStartPos {-1};
+    int64_t pesPCR {-1};
+    bool pesRandomAccess {false};
+    QStringList pesErrors;
+
+    unsigned int nrPESPackets {0};
+    uint64_t nrPayloadBytes {0};
+    int64_t firstPTS {-1};
+  };
+
+  struct PESHeader
+  {
+    unsigned int streamID {0};
+    int64_t pts {-1};
+    int64_t dts {-1};
+    int payloadStart {0};
+  };
+
+  void parseTSPacket(const unsigned char *packet, int64_t filePos);
+  void handlePCR(int pid, int64_t pcr, int64_t filePos, bool discontinuity);
+  void handleSectionData(int pid, const char *data, int size, bool payloadUnitStart);
+  void handlePESData(ElementaryStream &stream, const char *data, int size, bool payloadUnitStart, bool randomAccess, int64_t filePos);
+
+  void parseSection(int pid, const QByteArray &section);
+  bool parsePAT(const QByteArray &section, parserCommon::TreeItem *root);
+  bool parsePMT(const QByteArray &section, parserCommon::TreeItem *root);
+  void addElementaryStream(int pid, unsigned int streamType, unsigned int programNumber, const QString &language, bool isDVBSubtitle);
+
+  void finishPESPacket(ElementaryStream &stream);
+  bool parsePESHeader(const QByteArray &data, parserCommon::TreeItem *root, PESHeader &header);
+  void parseVideoPayload(const char *data, int size, parserCommon::TreeItem *root, QStringList &nalNames);
+  void parseDVBSubtitlePayload(const char *data, int size, parserCommon::TreeItem *root, QStringList &segmentNames);
+
+  // Copy the current counters into the lists that are used by getStreamInfo (from the main thread)
+  void updateStreamInfoLists();
+
+  QVector<PIDState> pidStates;
+  QList<ElementaryStream> elementaryStreams;
+  QHash<int, QByteArray> psiSections;
+  QHash<quint64, int> psiVersions;  //< The last parsed version per PID, table_id and table_id_extension
+  QList<int> pidFilter;
+
+  // Used for parsing the PES packets of the first video stream (which always has the stream index 0)
+  QScopedPointer<parserAnnexB> annexBParser;
+  int videoStreamIndex {-1};
+  // The stream index 0 is reserved for the video stream. All other streams are numbered from 1.
+  int nextStreamIndex {1};
+  int nalID {0};
+
+  unsigned int packetSize {188};
+  int64_t fileSize {0};
+  unsigned int nrTSPackets {0};
+  unsigned int nrNullPackets {0};
+  unsigned int nrSyncLosses {0};
+
+  struct
+  {
+    int pid {-1};
+    int64_t last {-1};
+    int64_t lastFilePos {0};
+    unsigned int nrPCRs {0};
+    unsigned int nrDiscontinuities {0};
+    unsigned int nrIntervalViolations {0};
+    int64_t maxInterval {0};
+    // The sum of all PCR intervals and the number of bytes transmitted in these intervals (for the mux rate)
+    int64_t duration {0};
+    int64_t nrBytes {0};
+  } pcrInfo;
+
+  // The stream info is updated while parsing and read from the main thread
+  mutable QMutex streamInfoMutex;
+  QList<QStringPairList> streamInfoAllStreams;
+  QList<QString> shortStreamInfoAllStreams;
+};
+
+#endif // PARSERTRANSPORTSTREAM_H
@@ -31,10 +31,17 @@
 */
 
 #include "playlistItem.h"
+#include <QLabel>
 #include <QPainter>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 unsigned int playlistItem::idCounter = 0;
 
+// Opening items is mostly waiting for the disk. Use a separate pool so that opening many files
+// does not block other background work (e.g. the statistics parsers) in the global pool.
+Q_GLOBAL_STATIC(QThreadPool, itemOpeningThreadPool)
+
 playlistItem::playlistItem(const QString &itemNameOrFileName, playlistItemType type)
 {
   setName(itemNameOrFileName);
@@ -50,6 +57,54 @@ playlistItem::~playlistItem()
 {
 }
 
+QWidget *playlistItem::getPropertiesWidget()
+{
+  if (!propertiesWidget)
+  {
+    if (opening)
+    {
+      // The item is not opened yet. Show a placeholder. The real properties widget is created once the item is opened.
+      preparePropertiesWidget(QStringLiteral("playlistItemOpening"));
+      QVBoxLayout *vAllLaout = new QVBoxLayout(propertiesWidget.data());
+      vAllLaout->addWidget(new QLabel("Opening file..."));
+      vAllLaout->addStretch(1);
+    }
+    else
+      createPropertiesWidget();
+  }
+  return propertiesWidget.data();
+}
+
+void playlistItem::startOpening(bool inBackground)
+{
+  if (!opening || openingWatcher.isRunning())
+    return;
+
+  if (inBackground)
+  {
+    connect(&openingWatcher, &QFutureWatcher<void>::finished, this, &playlistItem::slotOpeningFinished, Qt::UniqueConnection);
+    openingWatcher.setFuture(QtConcurrent::run(itemOpeningThreadPool(), this, &playlistItem::openItemInBackground));
+  }
+  else
+  {
+    openItemInBackground();
+    slotOpeningFinished();
+  }
+}
+
+void playlistItem::slotOpeningFinished()
+{
+  // Delete the placeholder properties widget. If it is shown, it is removed from the properties panel and the
+  // real one is created when the item is selected again.
+  propertiesWidget.reset();
+
+  finishOpeningItem();
+  opening = false;
+
+  emit signalItemOpened();
+  emit signalItemChanged(true, RECACHE_CLEAR);
+}
+
 void playlistItem::setName(const QString &name)
 { 
   plItemNameOrFileName = name;
@@ -106,6 +161,10 @@ void playlistItem::setType(playlistItemType newType)
     ui.rateSpinBox->setVisible(showIndexed);
     ui.labelSampling->setVisible(showIndexed);
     ui.samplingSpinBox->setVisible(showIndexed);
+    ui.labelCachePriority->setVisible(showIndexed);
+    ui.comboBoxCachePriority->setVisible(showIndexed);
+    ui.labelPinnedFrames->setVisible(showIndexed);
+    ui.lineEditPinnedFrames->setVisible(showIndexed);
 
     bool showStatic  = (newType == playlistItem_Static);
     ui.durationLabel->setVisible(showStatic);
@@ -137,12 +196,18 @@ void playlistItem::appendPropertiesToPlaylist(YUViewDomElement &d) const
   d.appendProperiteChild("viewCenterOffsetView1X", QString::number(savedCenterOffset[1].x()));
   d.appendProperiteChild("viewCenterOffsetView1Y", QString::number(savedCenterOffset[1].y()));
   d.appendProperiteChild("viewZoomFactorView1", QString::number(savedZoom[1]));
+
+  if (priority != cachePriorityNormal)
+    d.appendProperiteChild("cachePriority", QString::number(int(priority)));
+  if (!pinnedRanges.isEmpty())
+    d.appendProperiteChild("pinnedFrames", getPinnedRangesString());
 }
 
 // Load the start/end frame, sampling and frame rate from playlist
 void playlistItem::loadPropertiesFromPlaylist(const YUViewDomElement &root, playlistItem *newItem)
 {
   newItem->playlistID = root.findChildValue("id").toInt();
+  newItem->propertiesLoadedFromPlaylist = true;
 
   if (newItem->type == playlistItem_Indexed)
   {
@@ -161,6 +226,73 @@ void playlistItem::loadPropertiesFromPlaylist(const YUViewDomElement &root, play
   newItem->savedCenterOffset[1].setX(root.findChildValueInt("viewCenterOffsetView1X", 0));
   newItem->savedCenterOffset[1].setY(root.findChildValueInt("viewCenterOffsetView1Y", 0));
   newItem->savedZoom[1] = root.findChildValueDouble("viewZoomFactorView1", 1.0);
+
+  newItem->priority = cachePriority(clip(root.findChildValueInt("cachePriority", int(cachePriorityNormal)), int(cachePriorityLow), int(cachePriorityHigh)));
+  newItem->pinnedRanges = parsePinnedRangesString(root.findChildValue("pinnedFrames"));
+}
+
+void playlistItem::setCachePriority(cachePriority p)
+{
+  if (priority == p)
+    return;
+  priority = p;
+  if (ui.created())
+  {
+    const QSignalBlocker blocker(ui.comboBoxCachePriority);
+    ui.comboBoxCachePriority->setCurrentIndex(int(priority));
+  }
+  emit signalItemChanged(false, RECACHE_UPDATE);
+}
+
+void playlistItem::setPinnedRanges(const QList<indexRange> &ranges)
+{
+  if (pinnedRanges == ranges)
+    return;
+  pinnedRanges = ranges;
+  if (ui.created())
+  {
+    const QSignalBlocker blocker(ui.lineEditPinnedFrames);
+    ui.lineEditPinnedFrames->setText(getPinnedRangesString());
+  }
+  emit signalItemChanged(false, RECACHE_UPDATE);
+}
+
+bool playlistItem::isFramePinned(int frameIdx) const
+{
+  for (const indexRange &r : pinnedRanges)
+    if (frameIdx >= r.first && frameIdx <= r.second)
+      return true;
+  return false;
+}
+
+void playlistItem::reportFrameCachingTime(int64_t nanoseconds)
+{
+  // Exponential moving average. Concurrent updates may get lost but that does not matter for an average.
+  const int64_t average = averageCachingTimeNs.load();
+  averageCachingTimeNs.store(average == 0 ? nanoseconds : (average * 7 + nanoseconds) / 8);
+}
+
+QString playlistItem::getPinnedRangesString() const
+{
+  QStringList ranges;
+  for (const indexRange &r : pinnedRanges)
+    ranges.append(r.first == r.second ? QString::number(r.first) : QString("%1-%2").arg(r.first).arg(r.second));
+  return ranges.join(", ");
+}
+
+QList<indexRange> playlistItem::parsePinnedRangesString(const QString &str)
+{
+  QList<indexRange> ranges;
+  for (const QString &part : str.split(',', QString::SkipEmptyParts))
+  {
+    const QStringList limits = part.trimmed().split('-');
+    bool ok1, ok2 = true;
+    const int first = limits[0].trimmed().toInt(&ok1);
+    const int last = (limits.count() == 2) ? limits[1].trimmed().toInt(&ok2) : first;
+    if (ok1 && ok2 && limits.count() <= 2 && first >= 0 && last >= first)
+      ranges.append(indexRange(first, last));
+  }
+  return ranges;
 }
 
 void playlistItem::setStartEndFrame(indexRange range, bool emitSignal)
@@ -252,6 +384,8 @@ QLayout *playlistItem::createPlaylistItemControls()
   ui.samplingSpinBox->setMinimum(1);
   ui.samplingSpinBox->setMaximum(100000);
   ui.samplingSpinBox->setValue(sampling);
+  ui.comboBoxCachePriority->setCurrentIndex(int(priority));
+  ui.lineEditPinnedFrames->setText(getPinnedRangesString());
 
   setType(type);
 
@@ -261,6 +395,12 @@ QLayout *playlistItem::createPlaylistItemControls()
   connect(ui.rateSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &playlistItem::slotVideoControlChanged);
   connect(ui.samplingSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &playlistItem::slotVideoControlChanged);
   connect(ui.durationSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &playlistItem::slotVideoControlChanged);
+  connect(ui.comboBoxCachePriority, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int idx) { setCachePriority(cachePriority(idx)); });
+  connect(ui.lineEditPinnedFrames, &QLineEdit::editingFinished, this, [this]() {
+    setPinnedRanges(parsePinnedRangesString(ui.lineEditPinnedFrames->text()));
+    // Show the ranges that were understood
+    ui.lineEditPinnedFrames->setText(getPinnedRangesString());
+  });
 
   return ui.gridLayout;
 }
@@ -33,7 +33,9 @@
 #ifndef PLAYLISTITEM_H
 #define PLAYLISTITEM_H
 
+#include <QAtomicInteger>
 #include <QDir>
+#include <QFutureWatcher>
 #include <QTreeWidgetItem>
 #include "common/fileInfo.h"
 #include "common/saveUi.h"
@@ -114,7 +116,7 @@ public:
    * For example a playlistItemYUVFile will return "YUV File properties".
   */
   virtual QString getPropertiesTitle() const = 0;
-  QWidget *getPropertiesWidget() { if (!propertiesWidget) createPropertiesWidget(); return propertiesWidget.data(); }
+  QWidget *getPropertiesWidget();
   bool propertiesWidgetCreated() const { return propertiesWidget; }
 
   // Does the playlist item currently accept drops of the given item?
@@ -176,7 +178,7 @@ public:
   // Can this item be cached? The default is no. Set cachingEnabled in your subclass to true
   // if caching is enabled. Before every caching operation is started, this is checked. So caching
   // can also be temporarily disabled.
-  virtual bool isCachable() const { return cachingEnabled && !itemTaggedForDeletion; }
+  virtual bool isCachable() const { return cachingEnabled && !itemTaggedForDeletion && !opening; }
   // is the item being deleted?
   virtual bool taggedForDeletion() const { return itemTaggedForDeletion; }
   // Is there a limit on the number of threads that can cache from this item at the same time? (-1 = no limit)
@@ -186,15 +188,56 @@ public:
   // Cache the given frame. This function is thread save. So multiple instances of this function can run at the same time.
   // In test mode, we don't check if the frame is already cached and don't cache it. We just convert it and return.
   virtual void cacheFrame(int idx, bool testMode) { Q_UNUSED(idx); Q_UNUSED(testMode); }
+  // The video cache is going to cache the frames in the given range (in this order). Items that read from
+  // files can use this to prefetch the data with large sequential reads. The default implementation does nothing.
+  virtual void hintUpcomingCacheFrames(indexRange range) { Q_UNUSED(range); }
   // Get a list of all cached frames (just the frame indices)
   virtual QList<int> getCachedFrames() const { return QList<int>(); }
   virtual int getNumberCachedFrames() const { return 0; }
   // How many bytes will caching one frame use (in bytes)?
   virtual unsigned int getCachingFrameSize() const { return 0; }
+  // How much memory (in bytes) does the item use outside of the cache (decoders, statistics, buffers, ...)?
+  // This is called regularly by the video cache from the main thread so it must be cheap and must not block.
+  virtual int64_t getMemoryUsage() const { return 0; }
+
+  // Frames (external frame indices) that should be highlighted in the frame slider. For example frames for which
+  // the decoded picture does not match the hash transmitted in the bitstream. Must be cheap and must not block.
+  virtual QList<int> getFlaggedFrames() const { return QList<int>(); }
+
+  // ----- Cache priority and pinning -----
+
+  // Frames of items with a higher priority are cached first and removed from the cache last
+  enum cachePriority
+  {
+    cachePriorityLow,
+    cachePriorityNormal,
+    cachePriorityHigh
+  };
+  cachePriority getCachePriority() const { return priority; }
+  void setCachePriority(cachePriority p);
+  // Pinned frames (external frame indices) are never removed from the cache
+  QList<indexRange> getPinnedRanges() const { return pinnedRanges; }
+  void setPinnedRanges(const QList<indexRange> &ranges);
+  bool isFramePinned(int frameIdx) const;
+  // The video cache reports how long it took to cache a frame of this item. The average is the cost
+  // of producing the frame again if it is removed from the cache. This function is thread safe.
+  void reportFrameCachingTime(int64_t nanoseconds);
+  int64_t getAverageFrameCachingTime() const { return averageCachingTimeNs.load(); }
   // Remove the frame with the given index from the cache.
   virtual void removeFrameFromCache(int idx) { Q_UNUSED(idx); }
   virtual void removeAllFramesFromCache() {};
 
+  // ----- Opening in the background -----
+
+  // Opening some items is expensive (parsing/indexing a bitstream, detecting the format of a raw file). These items
+  // only do the cheap part in the constructor and set opening. startOpening() then runs openItemInBackground() on a
+  // thread pool and finishOpeningItem() in the main thread when it is done. Until then, the item must not be drawn,
+  // loaded or cached. If inBackground is not set, both are called right away.
+  void startOpening(bool inBackground=true);
+  bool isOpening() const { return opening; }
+  // The progress of opening the item in percent (-1 if unknown)
+  virtual int getOpeningProgress() const { return -1; }
+
   // ----- Detection of source/file change events -----
 
   // Returns if the items source (usually a file) was changed by another process. This means that the playlistItem
@@ -234,6 +277,9 @@ signals:
   // The item finished loading a frame into the double buffer. This is relevant if playback is paused and waiting
   // for the item to load the next frame into the double buffer. This will restart the timer. 
   void signalItemDoubleBufferLoaded();
+
+  // Opening the item in the background (startOpening) is done. The item is now ready to use.
+  void signalItemOpened();
   
 protected:
 
@@ -263,6 +309,18 @@ protected:
   void appendPropertiesToPlaylist(YUViewDomElement &d) const;
   // Load the properties (the playlist ID)
   static void loadPropertiesFromPlaylist(const YUViewDomElement &root, playlistItem *newItem);
+  // Were the properties (start/end frame, frame rate ...) loaded from a playlist?
+  bool propertiesLoadedFromPlaylist {false};
+
+  // Set in the constructor if the item has to be opened using startOpening()
+  bool opening {false};
+  // Do the expensive part of opening the item. This is called in a background thread. Don't create any QObjects
+  // or touch any widgets here.
+  virtual void openItemInBackground() {}
+  // Called in the main thread once openItemInBackground() returned. Finish setting up the item here.
+  virtual void finishOpeningItem() {}
+  // Wait until openItemInBackground() returned. Derived classes must call this in their destructor.
+  void waitForOpening() { openingWatcher.waitForFinished(); }
 
   // What is the (current) type of the item?
   playlistItemType type;
@@ -288,6 +346,8 @@ protected slots:
   void slotVideoControlChanged();
   // The frame limits of the object have changed. Update the limits (and maybe also the range).
   virtual void slotUpdateFrameLimits();
+  // openItemInBackground() returned
+  void slotOpeningFinished();
 
 private:
   // Every playlist item we create gets an id (automatically). This is saved to the playlist so we can match
@@ -303,6 +363,15 @@ private:
 
   // The UI
   SafeUi<Ui::playlistItem> ui;
+
+  cachePriority priority {cachePriorityNormal};
+  QList<indexRange> pinnedRanges;
+  QAtomicInteger<qint64> averageCachingTimeNs {0};
+  // Convert the pinned ranges from/to a string like "0-10, 100-300"
+  QString getPinnedRangesString() const;
+  static QList<indexRange> parsePinnedRangesString(const QString &str);
+
+  QFutureWatcher<void> openingWatcher;
 };
 
 #endif // PLAYLISTITEM_H
@@ -32,13 +32,17 @@
 
 #include "playlistItemCompressedVideo.h"
 
+#include <algorithm>
+#include <QDateTime>
 #include <QThread>
 #include <QInputDialog>
 #include <QPlainTextEdit>
+#include <QtConcurrent>
 
 #include <inttypes.h>
 
 #include "common/functions.h"
+#include "common/performanceProfiler.h"
 #include "common/YUViewDomElement.h"
 #include "decoder/decoderFFmpeg.h"
 #include "decoder/decoderHM.h"
@@ -48,6 +52,7 @@
 #include "parser/parserAnnexBAVC.h"
 #include "parser/parserAnnexBHEVC.h"
 #include "parser/parserAnnexBVVC.h"
+#include "video/pictureHash.h"
 #include "video/videoHandlerYUV.h"
 #include "video/videoHandlerRGB.h"
 #include "ui/mainwindow.h"
@@ -71,8 +76,20 @@ using namespace functions;
 // by lower than this threshold, we will not seek.
 #define FORWARD_SEEK_THRESHOLD 5
 
+// The number of threads per item that hash the decoded pictures in the background
+#define PICTURE_HASH_THREADS 2
+
+// The size of the queues of the caching pipeline. The units are NAL units (or frames if the ffmpeg decoder is used).
+// Decoded frames are big so the decode stage only works a few frames ahead.
+#define PIPELINE_UNIT_QUEUE_SIZE 64
+#define PIPELINE_FRAME_QUEUE_SIZE 4
+// The number of caching threads that convert the decoded frames at the same time
+#define PIPELINE_CONVERSION_THREADS 3
+
 playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compressedFilePath, int displayComponent, inputFormat input, decoderEngine decoder)
-  : playlistItemWithVideo(compressedFilePath, playlistItem_Indexed)
+  : playlistItemWithVideo(compressedFilePath, playlistItem_Indexed),
+    pipelineUnits(PIPELINE_UNIT_QUEUE_SIZE),
+    pipelineFrames(PIPELINE_FRAME_QUEUE_SIZE)
 {
   // Set the properties of the playlistItem
   // TODO: should this change with the type of video?
@@ -81,6 +98,8 @@ playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compress
 
   // An compressed file can be cached if nothing goes wrong
   cachingEnabled = true;
+  pictureHashThreadPool.setMaxThreadCount(PICTURE_HASH_THREADS);
+  pipelineThreadPool.setMaxThreadCount(2);
 
   // Open the input file and get some properties (size, bit depth, subsampling) from the file
   if (input == inputInvalid)
@@ -98,11 +117,11 @@ playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compress
   else
     inputFormatType = input;
 
+  // Remember the given settings. They are applied once the file is opened.
+  openingState.displayComponent = displayComponent;
+  openingState.decoder = decoder;
+
   // While opening the file, also determine which decoders we can use
-  QSize frameSize;
-  YUV_Internals::yuvPixelFormat format_yuv;
-  RGB_Internals::rgbPixelFormat format_rgb;
-  QWidget *mainWindow = MainWindow::getMainWindow();
   if (isInputFormatTypeAnnexB(inputFormatType))
   {
     // Open file
@@ -133,47 +152,74 @@ playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compress
       ffmpegCodec.setTypeAVC();
       possibleDecoders.append(decoderEngineFFMpeg);
     }
+    rawFormat = raw_YUV;  // Raw annexB files will always provide YUV data
+  }
+  else
+  {
+    // The file is opened using ffmpeg (twice if we also need it for caching)
+    inputFileFFmpegLoading.reset(new fileSourceFFmpegFile());
+    if (cachingEnabled)
+      inputFileFFmpegCaching.reset(new fileSourceFFmpegFile());
+  }
+
+  // Parsing/indexing the file is done in openItemInBackground(). Until then, only the info text is shown.
+  opening = true;
+  unresolvableError = true;
+  infoText = "Opening file...";
+}
+
+playlistItemCompressedVideo::~playlistItemCompressedVideo()
+{
+  // If the file is still being parsed, abort this
+  if (inputFileAnnexBParser)
+    inputFileAnnexBParser->setAbortParsing();
+  waitForOpening();
+  stopCachingPipeline();
+  pictureHashThreadPool.waitForDone();
+}
 
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo Start parsing of file");
-    inputFileAnnexBParser->parseAnnexBFile(inputFileAnnexBLoading, mainWindow);
+void playlistItemCompressedVideo::openItemInBackground()
+{
+  if (isInputFormatTypeAnnexB(inputFormatType))
+  {
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::openItemInBackground Start parsing of file");
+    inputFileAnnexBParser->parseAnnexBFile(inputFileAnnexBLoading);
     
     // Get the frame size and the pixel format
-    frameSize = inputFileAnnexBParser->getSequenceSizeSamples();
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo Frame size %dx%d", frameSize.width(), frameSize.height());
-    format_yuv = inputFileAnnexBParser->getPixelFormat();
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo YUV format %s", format_yuv.getName().toStdString().c_str());
-    rawFormat = raw_YUV;  // Raw annexB files will always provide YUV data
-    frameRate = inputFileAnnexBParser->getFramerate();
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo framerate %f", frameRate);
+    openingState.frameSize = inputFileAnnexBParser->getSequenceSizeSamples();
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::openItemInBackground Frame size %dx%d", openingState.frameSize.width(), openingState.frameSize.height());
+    openingState.formatYUV = inputFileAnnexBParser->getPixelFormat();
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::openItemInBackground YUV format %s", openingState.formatYUV.getName().toStdString().c_str());
+    openingState.frameRate = inputFileAnnexBParser->getFramerate();
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::openItemInBackground framerate %f", openingState.frameRate);
   }
   else
   {
     // Try ffmpeg to open the file
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo Open file using ffmpeg");
-    inputFileFFmpegLoading.reset(new fileSourceFFmpegFile());
-    if (!inputFileFFmpegLoading->openFile(compressedFilePath, mainWindow))
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::openItemInBackground Open file using ffmpeg");
+    if (!inputFileFFmpegLoading->openFile(plItemNameOrFileName))
     {
-      setError("Error opening file using libavcodec.");
+      openingState.error = "Error opening file using libavcodec.";
       return;
     }
     // Is this file RGB or YUV?
     rawFormat = inputFileFFmpegLoading->getRawFormat();
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo Raw format %s", rawFormat == raw_YUV ? "YUV" : rawFormat == raw_RGB ? "RGB" : "Unknown");
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::openItemInBackground Raw format %s", rawFormat == raw_YUV ? "YUV" : rawFormat == raw_RGB ? "RGB" : "Unknown");
     if (rawFormat == raw_YUV)
-      format_yuv = inputFileFFmpegLoading->getPixelFormatYUV();
+      openingState.formatYUV = inputFileFFmpegLoading->getPixelFormatYUV();
     else if (rawFormat == raw_RGB)
-      format_rgb = inputFileFFmpegLoading->getPixelFormatRGB();
+      openingState.formatRGB = inputFileFFmpegLoading->getPixelFormatRGB();
     else
     {
-      setError("Unknown raw format.");
+      openingState.error = "Unknown raw format.";
       return;
     }
-    frameSize = inputFileFFmpegLoading->getSequenceSizeSamples();
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo Frame size %dx%d", frameSize.width(), frameSize.height());
-    frameRate = inputFileFFmpegLoading->getFramerate();
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo framerate %f", frameRate);
+    openingState.frameSize = inputFileFFmpegLoading->getSequenceSizeSamples();
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::openItemInBackground Frame size %dx%d", openingState.frameSize.width(), openingState.frameSize.height());
+    openingState.frameRate = inputFileFFmpegLoading->getFramerate();
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::openItemInBackground framerate %f", openingState.frameRate);
     ffmpegCodec = inputFileFFmpegLoading->getVideoStreamCodecID();
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo ffmpeg codec %s", ffmpegCodec.getCodecName().toStdString().c_str());
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::openItemInBackground ffmpeg codec %s", ffmpegCodec.getCodecName().toStdString().c_str());
     if (!ffmpegCodec.isNone())
       possibleDecoders.append(decoderEngineFFMpeg);
     if (ffmpegCodec.isHEVC())
@@ -184,25 +230,46 @@ playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compress
     if (ffmpegCodec.isAV1())
       possibleDecoders.append(decoderEngineDav1d);
 
-    if (cachingEnabled)
+    // Open the file again for caching
+    if (inputFileFFmpegCaching && !inputFileFFmpegCaching->openFile(plItemNameOrFileName, inputFileFFmpegLoading.data()))
     {
-      // Open the file again for caching
-      inputFileFFmpegCaching.reset(new fileSourceFFmpegFile());
-      if (!inputFileFFmpegCaching->openFile(compressedFilePath, mainWindow, inputFileFFmpegLoading.data()))
-      {
-        setError("Error opening file a second time using libavcodec for caching.");
-        return;
-      }
+      openingState.error = "Error opening file a second time using libavcodec for caching.";
+      return;
     }
+
+    // The frames are indexed in the background. We can start as soon as the first frame can be seeked to.
+    inputFileFFmpegLoading->waitForFirstKeyframe();
+  }
+}
+
+void playlistItemCompressedVideo::finishOpeningItem()
+{
+  if (!openingState.error.isEmpty())
+  {
+    setError(openingState.error);
+    return;
   }
+  unresolvableError = false;
+  infoText.clear();
+
+  // The file watchers can only be installed in the main thread
+  if (inputFileFFmpegLoading)
+    inputFileFFmpegLoading->updateFileWatchSetting();
+  if (inputFileFFmpegCaching)
+    inputFileFFmpegCaching->updateFileWatchSetting();
+
+  // A frame rate loaded from the playlist overrides the one from the file
+  if (!propertiesLoadedFromPlaylist)
+    frameRate = openingState.frameRate;
 
   // Check/set properties
+  const QSize frameSize = openingState.frameSize;
   if (!frameSize.isValid())
   {
     setError("Error opening file: Unable to obtain frame size from file.");
     return;
   }
-  if (rawFormat == raw_Invalid || (rawFormat == raw_YUV && !format_yuv.isValid()) || (rawFormat == raw_RGB && !format_rgb.isValid()))
+  if (rawFormat == raw_Invalid || (rawFormat == raw_YUV && !openingState.formatYUV.isValid()) || (rawFormat == raw_RGB && !openingState.formatRGB.isValid()))
   {
     setError("Error opening file: Unable to obtain a valid pixel format from file.");
     return;
@@ -214,20 +281,22 @@ playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compress
     video.reset(new videoHandlerYUV());
     videoHandlerYUV *yuvVideo = getYUVVideo();
     yuvVideo->setFrameSize(frameSize);
-    yuvVideo->setYUVPixelFormat(format_yuv);
+    yuvVideo->setYUVPixelFormat(openingState.formatYUV);
+    yuvVideo->setOutputMode(outputModeFromPlaylist);
   }
   else
   {
     video.reset(new videoHandlerRGB());
     videoHandlerRGB *rgbVideo = getRGBVideo();
     rgbVideo->setFrameSize(frameSize);
-    rgbVideo->setRGBPixelFormat(format_rgb);
+    rgbVideo->setRGBPixelFormat(openingState.formatRGB);
   }
 
   // Connect the basic signals from the video
   playlistItemWithVideo::connectVideo();
   statSource.setFrameSize(frameSize);
 
+  const decoderEngine decoder = openingState.decoder;
   decoderEngineType = decoderEngineInvalid;
   if (decoder != decoderEngineInvalid)
   {
@@ -260,9 +329,10 @@ playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compress
   }
 
   // Allocate the decoders
-  DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo Initializing decoder enigne type %d", decoderEngineType);
-  if (!allocateDecoder(displayComponent))
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::finishOpeningItem Initializing decoder enigne type %d", decoderEngineType);
+  if (!allocateDecoder(openingState.displayComponent))
     return;
+  updateDiskCacheKey();
 
   if (rawFormat == raw_YUV)
   {
@@ -271,18 +341,23 @@ playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compress
   }
 
   // Fill the list of statistics that we can provide
-  DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo Fill the statistics list");
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::finishOpeningItem Fill the statistics list");
   fillStatisticList();
 
-  // Set the frame number limits
-  startEndFrame = getStartEndFrameLimits();
-  DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo Start end frame limits %d,%d", startEndFrame.first, startEndFrame.second);
-  if (startEndFrame.second == -1)
+  // Set the frame number limits (unless they were loaded from the playlist)
+  const indexRange startEndFrameLimits = getStartEndFrameLimits();
+  if (!propertiesLoadedFromPlaylist)
+    startEndFrame = startEndFrameLimits;
+  indexedFrameLimits = startEndFrameLimits;
+  if (inputFileFFmpegLoading && inputFileFFmpegLoading->isIndexing())
+    indexingTimer.start(1000, this);
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::finishOpeningItem Start end frame limits %d,%d", startEndFrameLimits.first, startEndFrameLimits.second);
+  if (startEndFrameLimits.second == -1)
     // No frames to decode
     return;
 
   // Seek both decoders to the start of the bitstream (this will also push the parameter sets / extradata to the decoder)
-  DEBUG_COMPRESSED("playlistItemCompressedVideo::playlistItemCompressedVideo Seek decoders to 0");
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::finishOpeningItem Seek decoders to 0");
   seekToPosition(0, 0, false);
   if (cachingEnabled)
     seekToPosition(0, 0, true);
@@ -294,6 +369,31 @@ playlistItemCompressedVideo::playlistItemCompressedVideo(const QString &compress
   connect(&statSource, &statisticHandler::requestStatisticsLoading, this, &playlistItemCompressedVideo::loadStatisticToCache, Qt::DirectConnection);
 }
 
+int playlistItemCompressedVideo::getOpeningProgress() const
+{
+  if (inputFileAnnexBParser)
+    return inputFileAnnexBParser->getParsingProgressPercent();
+  return -1;
+}
+
+void playlistItemCompressedVideo::timerEvent(QTimerEvent *event)
+{
+  if (event->timerId() != indexingTimer.timerId())
+    return playlistItemWithVideo::timerEvent(event);
+
+  if (!inputFileFFmpegLoading->isIndexing())
+    indexingTimer.stop();
+
+  // More frames were indexed. Grow the end frame if it was at the end of the indexed range.
+  const indexRange limits = getStartEndFrameLimits();
+  indexRange range = startEndFrame;
+  if (range.second == indexedFrameLimits.second)
+    range.second = limits.second;
+  indexedFrameLimits = limits;
+  setStartEndFrame(range, false);
+  emit signalItemChanged(false, RECACHE_NONE);
+}
+
 void playlistItemCompressedVideo::savePlaylist(QDomElement &root, const QDir &playlistDir) const
 {
   // Determine the relative path to the HEVC file. We save both in the playlist.
@@ -313,6 +413,13 @@ void playlistItemCompressedVideo::savePlaylist(QDomElement &root, const QDir &pl
 
   d.appendProperiteChild("inputFormat", functions::getInputFormatName(inputFormatType));
   d.appendProperiteChild("decoder", functions::getDecoderEngineName(decoderEngineType));
+  if (pictureHashVerification)
+    d.appendProperiteChild("verifyPictureHashes", "1");
+  if (!video)
+    // Still opening. Keep the mode from the playlist.
+    d.appendProperiteChild("outputMode", QString::number(int(outputModeFromPlaylist)));
+  else if (rawFormat == raw_YUV)
+    d.appendProperiteChild("outputMode", QString::number(int(getYUVVideo()->getOutputMode())));
   
   root.appendChild(d);
 }
@@ -339,6 +446,9 @@ playlistItemCompressedVideo *playlistItemCompressedVideo::newPlaylistItemCompres
   
   // We can still not be sure that the file really exists, but we gave our best to try to find it.
   playlistItemCompressedVideo *newFile = new playlistItemCompressedVideo(filePath, displaySignal, input, decoder);
+  newFile->pictureHashVerification = (root.findChildValue("verifyPictureHashes") == "1");
+  const int outputMode = clip(root.findChildValueInt("outputMode", int(YUV_Internals::Output8Bit)), int(YUV_Internals::Output8Bit), int(YUV_Internals::Output16BitHLG));
+  newFile->outputModeFromPlaylist = YUV_Internals::OutputMode(outputMode);
 
   // Load the propertied of the playlistItemIndexed
   playlistItem::loadPropertiesFromPlaylist(root, newFile);
@@ -346,6 +456,26 @@ playlistItemCompressedVideo *playlistItemCompressedVideo::newPlaylistItemCompres
   return newFile;
 }
 
+int64_t playlistItemCompressedVideo::getMemoryUsage() const
+{
+  int64_t size = playlistItemWithVideo::getMemoryUsage();
+  // The decoders are allocated in the background while opening
+  if (opening)
+    return size;
+
+  if (loadingDecoder)
+    size += loadingDecoder->getMemoryUsage();
+  if (cachingDecoder)
+    size += cachingDecoder->getMemoryUsage();
+  // The decoded frames in the caching pipeline
+  const int nrPipelineFrames = pipelineFrames.count() + pipelinePendingFrameCount.load();
+  size += int64_t(nrPipelineFrames) * std::max(video->getBytesPerFrame(), int64_t(0));
+  if (inputFileAnnexBParser)
+    size += inputFileAnnexBParser->getMemoryUsage();
+  size += statSource.getMemoryUsage();
+  return size;
+}
+
 infoData playlistItemCompressedVideo::getInfo() const
 {
   infoData info("HEVC File Info");
@@ -354,6 +484,11 @@ infoData playlistItemCompressedVideo::getInfo() const
   // info.items.append(loadingDecoder->getFileInfoList());
 
   info.items.append(infoItem("Reader", functions::getInputFormatName(inputFormatType)));
+  if (isOpening())
+  {
+    info.items.append(infoItem("Status", "Opening file..."));
+    return info;
+  }
   if (inputFileFFmpegLoading)
   {
     QStringList l = inputFileFFmpegLoading->getLibraryPaths();
@@ -368,6 +503,8 @@ infoData playlistItemCompressedVideo::getInfo() const
     QSize videoSize = video->getFrameSize();
     info.items.append(infoItem("Resolution", QString("%1x%2").arg(videoSize.width()).arg(videoSize.height()), "The video resolution in pixel (width x height)"));
     info.items.append(infoItem("Num POCs", QString::number(startEndFrame.second - startEndFrame.first + 1), "The number of pictures in the stream."));
+    if (inputFileFFmpegLoading && inputFileFFmpegLoading->isIndexing())
+      info.items.append(infoItem("Indexing", QString("%1%...").arg(inputFileFFmpegLoading->getIndexingProgressPercent()), "The frames of the file are indexed in the background. Frames can be seeked to as soon as they are indexed."));
     if (decodingEnabled)
     {
       QStringList l = loadingDecoder->getLibraryPaths();
@@ -381,6 +518,39 @@ infoData playlistItemCompressedVideo::getInfo() const
       info.items.append(infoItem("Statistics", loadingDecoder->statisticsSupported() ? "Yes" : "No", "Is the decoder able to provide internals (statistics)?"));
       info.items.append(infoItem("Stat Parsing", loadingDecoder->statisticsEnabled() ? "Yes" : "No", "Are the statistics of the sequence currently extracted from the stream?"));
     }
+    if (pictureHashVerification)
+    {
+      if (!inputFileAnnexBParser || !inputFileAnnexBParser->hasPictureHashes())
+        info.items.append(infoItem("Picture Hash", "Not in bitstream", "The bitstream contains no decoded picture hash SEI messages that the pictures could be verified against."));
+      else if (!isPictureHashVerificationActive())
+        info.items.append(infoItem("Picture Hash", "Inactive", "Only the reconstruction signal can be verified."));
+      else
+      {
+        int nrMatch = 0, nrMismatch = 0, nrUnverifiable = 0;
+        int firstMismatch = -1;
+        {
+          QMutexLocker lock(&pictureHashResultsMutex);
+          for (auto it = pictureHashResults.constBegin(); it != pictureHashResults.constEnd(); it++)
+          {
+            if (it.value() == pictureHashMatch)
+              nrMatch++;
+            else if (it.value() == pictureHashUnverifiable)
+              nrUnverifiable++;
+            else
+            {
+              if (nrMismatch == 0)
+                firstMismatch = it.key();
+              nrMismatch++;
+            }
+          }
+        }
+        info.items.append(infoItem("Picture Hash", QString("%1 ok, %2 mismatch").arg(nrMatch).arg(nrMismatch), "The number of decoded pictures that match/do not match the decoded picture hash from the bitstream. Only decoded pictures are verified (cache the sequence to verify all of them)."));
+        if (nrUnverifiable > 0)
+          info.items.append(infoItem("Unverifiable", QString::number(nrUnverifiable), "The hash of these pictures could not be calculated because the output is not in a planar YUV format or it is cropped and the decoder can not provide the full decoded picture."));
+        if (firstMismatch >= 0)
+          info.items.append(infoItem("First Mismatch", QString("Frame %1 (POC %2)").arg(getFrameIdxExternal(firstMismatch)).arg(inputFileAnnexBParser->getPOCOfFrame(firstMismatch)), "The first frame (in display order) for which the decoded picture does not match the hash from the bitstream."));
+      }
+    }
   }
   if (decoderEngineType == decoderEngineFFMpeg)
     info.items.append(infoItem("FFMpeg Log", "Show FFmpeg Log", "Show the log messages from FFmpeg.", true, 0));
@@ -426,7 +596,7 @@ itemLoadingState playlistItemCompressedVideo::needsLoading(int frameIdx, bool lo
 
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
   auto videoState = video->needsLoading(frameIdxInternal, loadRawData);
-  if (videoState == LoadingNeeded && decodingNotPossibleAfter >= 0 && frameIdxInternal >= decodingNotPossibleAfter && frameIdxInternal >= currentFrameIdx[0])
+  if (videoState == LoadingNeeded && isDecodingNotPossible(frameIdxInternal, false) && frameIdxInternal >= currentFrameIdx[0])
     // The decoder can not decode this frame. 
     return LoadingNotNeeded;
   if (videoState == LoadingNeeded || statSource.needsLoading(frameIdxInternal) == LoadingNeeded)
@@ -438,7 +608,7 @@ void playlistItemCompressedVideo::drawItem(QPainter *painter, int frameIdx, doub
 {
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
 
-  if (decodingNotPossibleAfter >= 0 && frameIdxInternal >= decodingNotPossibleAfter)
+  if (isDecodingNotPossible(frameIdxInternal, false) || isDecodingNotPossible(frameIdxInternal, true))
   {
     infoText = "Decoding of the frame not possible:\n";
     infoText += "The frame could not be decoded. Possibly, the bitstream is corrupt or was cut at an invalid position.";
@@ -462,9 +632,13 @@ void playlistItemCompressedVideo::drawItem(QPainter *painter, int frameIdx, doub
 
 void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching)
 {
-  if (caching && !cachingEnabled)
+  if (caching)
+  {
+    if (cachingEnabled && !cachingDecoder->errorInDecoder())
+      loadRawDataFromCachingPipeline(frameIdxInternal);
     return;
-  if (!caching && loadingDecoder->errorInDecoder())
+  }
+  if (loadingDecoder->errorInDecoder())
   {
     if (frameIdxInternal < currentFrameIdx[0])
     {
@@ -473,10 +647,8 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
     else
       return;
   }
-  if (caching && cachingDecoder->errorInDecoder())
-    return;
-  
-  DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData %d %s", frameIdxInternal, caching ? "caching" : "");
+
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData %d", frameIdxInternal);
 
   if (frameIdxInternal > startEndFrame.second || frameIdxInternal < 0)
   {
@@ -484,9 +656,8 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
     return;
   }
 
-  // Get the right decoder
-  decoderBase *dec = caching ? cachingDecoder.data() : loadingDecoder.data();
-  int curFrameIdx = caching ? currentFrameIdx[1] : currentFrameIdx[0];
+  decoderBase *dec = loadingDecoder.data();
+  int curFrameIdx = currentFrameIdx[0];
 
   // Should we seek?
   if (curFrameIdx == -1 || frameIdxInternal < curFrameIdx || frameIdxInternal > curFrameIdx + FORWARD_SEEK_THRESHOLD)
@@ -495,18 +666,9 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
     bool seek = (frameIdxInternal < curFrameIdx);
 
     // Get the closest possible seek position
-    int seekToFrame = -1;
-    int seekToAnnexBFrameCount = -1;
     int seekToDTS = -1;
-    if (isInputFormatTypeAnnexB(inputFormatType))
-      seekToFrame = inputFileAnnexBParser->getClosestSeekableFrameNumberBefore(frameIdxInternal, seekToAnnexBFrameCount);
-    else
-    {
-      if (caching)
-        seekToDTS = inputFileFFmpegCaching->getClosestSeekableDTSBefore(frameIdxInternal, seekToFrame);
-      else
-        seekToDTS = inputFileFFmpegLoading->getClosestSeekableDTSBefore(frameIdxInternal, seekToFrame);
-    }
+    int seekToAnnexBFrameCount = -1;
+    int seekToFrame = getClosestSeekableFrame(frameIdxInternal, false, seekToDTS, seekToAnnexBFrameCount);
 
     if (curFrameIdx == -1 || seekToFrame > curFrameIdx + FORWARD_SEEK_THRESHOLD)
     {
@@ -519,12 +681,12 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
       // Seek and update the frame counters. The seekToPosition function will update the currentFrameIdx[] indices
       readAnnexBFrameCounterCodingOrder = seekToAnnexBFrameCount;
       DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData seeking to frame %d PTS %d AnnexBCnt %d", seekToFrame, seekToDTS, readAnnexBFrameCounterCodingOrder);
-      seekToPosition(seekToFrame, seekToDTS, caching);
+      seekToPosition(seekToFrame, seekToDTS, false);
     }
   }
   
   // Decode until we get the right frame from the deocder
-  bool rightFrame = caching ? currentFrameIdx[1] == frameIdxInternal : currentFrameIdx[0] == frameIdxInternal;
+  bool rightFrame = currentFrameIdx[0] == frameIdxInternal;
   while (!rightFrame)
   {
     while (dec->needsMoreData())
@@ -534,13 +696,17 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
       {
         // In this scenario, we can read and push AVPackets
         // from the FFmpeg file and pass them to the FFmpeg decoder directly.
-        AVPacketWrapper pkt = caching ? inputFileFFmpegCaching->getNextPacket(repushData) : inputFileFFmpegLoading->getNextPacket(repushData);
+        AVPacketWrapper pkt;
+        {
+          performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageFileRead);
+          pkt = inputFileFFmpegLoading->getNextPacket(repushData);
+        }
         repushData = false;
         if (pkt)
           DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived packet PTS %" PRId64 "", pkt.get_pts());
         else
           DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived empty packet");
-        decoderFFmpeg *ffmpegDec = (caching ? dynamic_cast<decoderFFmpeg*>(cachingDecoder.data()) : dynamic_cast<decoderFFmpeg*>(loadingDecoder.data()));
+        decoderFFmpeg *ffmpegDec = dynamic_cast<decoderFFmpeg*>(loadingDecoder.data());
         if (!ffmpegDec->pushAVPacket(pkt))
         {
           if (!ffmpegDec->decodeFrames())
@@ -556,14 +722,17 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
         QUint64Pair frameStartEndFilePos = inputFileAnnexBParser->getFrameStartEndPos(readAnnexBFrameCounterCodingOrder);
         QByteArray data;
         if (frameStartEndFilePos != QUint64Pair(-1, -1))
-          data = caching ? inputFileAnnexBCaching->getFrameData(frameStartEndFilePos) : inputFileAnnexBLoading->getFrameData(frameStartEndFilePos);
+        {
+          performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageFileRead);
+          data = inputFileAnnexBLoading->getFrameData(frameStartEndFilePos);
+        }
         DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived frame data from file - AnnexBCnt %d startEnd %lu-%lu - size %d", readAnnexBFrameCounterCodingOrder, frameStartEndFilePos.first, frameStartEndFilePos.second, data.size());
         if (!dec->pushData(data))
         {
           if (!dec->decodeFrames())
           {
             DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData The decoder did not switch to decoding frame mode. Error.");
-            decodingNotPossibleAfter = frameIdxInternal;
+            decodingNotPossibleAfter[0] = frameIdxInternal;
             break;
           }
           // Pushing the data failed because the ffmpeg decoder wants us to read frames first.
@@ -574,14 +743,22 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
       }
       else if (isInputFormatTypeAnnexB(inputFormatType) && decoderEngineType != decoderEngineFFMpeg)
       {
-        QByteArray data = caching ? inputFileAnnexBCaching->getNextNALUnit(repushData) : inputFileAnnexBLoading->getNextNALUnit(repushData);
+        QByteArray data;
+        {
+          performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageFileRead);
+          data = inputFileAnnexBLoading->getNextNALUnitView(repushData);
+        }
         DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived nal unit from file - size %d", data.size());
         repushData = !dec->pushData(data);
       }
       else if (isInputFormatTypeFFmpeg(inputFormatType) && decoderEngineType != decoderEngineFFMpeg)
       {
         // Get the next unit (NAL or OBU) form ffmepg and push it to the decoder
-        QByteArray data = caching ? inputFileFFmpegCaching->getNextUnit(repushData) : inputFileFFmpegLoading->getNextUnit(repushData);
+        QByteArray data;
+        {
+          performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageFileRead);
+          data = inputFileFFmpegLoading->getNextUnit(repushData);
+        }
         DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived nal unit from file - size %d", data.size());
         repushData = !dec->pushData(data);
       }
@@ -591,19 +768,29 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
 
     if (dec->decodeFrames())
     {
-      if (dec->decodeNextFrame())
+      // Copying the frame (getRawFrameData) is measured by the decoder as stageCopyDecodedImage
+      bool frameDecoded;
       {
-        if (caching)
-          currentFrameIdx[1]++;
-        else
-          currentFrameIdx[0]++;
+        performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageDecode);
+        frameDecoded = dec->decodeNextFrame();
+      }
+      if (frameDecoded)
+      {
+        currentFrameIdx[0]++;
 
-        DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData decoded frame %d", caching ? currentFrameIdx[1] : currentFrameIdx[0]);
-        rightFrame = caching ? currentFrameIdx[1] == frameIdxInternal : currentFrameIdx[0] == frameIdxInternal;
-        if (rightFrame)
+        DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData decoded frame %d", currentFrameIdx[0]);
+        rightFrame = currentFrameIdx[0] == frameIdxInternal;
+        const bool verify = isPictureHashVerificationActive();
+        if (rightFrame || verify)
         {
-          video->rawData = dec->getRawFrameData();
-          video->rawData_frameIdx = frameIdxInternal;
+          const QByteArray data = dec->getRawFrameData();
+          if (rightFrame)
+          {
+            video->rawData = data;
+            video->rawData_frameIdx = frameIdxInternal;
+          }
+          if (verify)
+            verifyDecodedPicture(currentFrameIdx[0], dec, data);
         }
       }
     }
@@ -611,19 +798,16 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
     if (!dec->needsMoreData() && !dec->decodeFrames())
     {
       DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData decoder neither needs more data nor can decode frames");
-      decodingNotPossibleAfter = frameIdxInternal;
+      decodingNotPossibleAfter[0] = frameIdxInternal;
       break;
     }
   }
 
-  if (decodingNotPossibleAfter >= 0 && frameIdxInternal >= decodingNotPossibleAfter)
+  if (isDecodingNotPossible(frameIdxInternal, false))
   {
     // The specified frame (which is thoretically in the bitstream) can not be decoded.
     // Maybe the bitstream was cut at a position that it was not supposed to be cut at.
-    if (caching)
-      currentFrameIdx[1] = frameIdxInternal;
-    else
-      currentFrameIdx[0] = frameIdxInternal;
+    currentFrameIdx[0] = frameIdxInternal;
     // Just set the frame number of the buffer to the current frame so that it will trigger a
     // reload when the frame number changes.
     video->rawData_frameIdx = frameIdxInternal;
@@ -645,7 +829,7 @@ void playlistItemCompressedVideo::seekToPosition(int seekToFrame, int seekToDTS,
   decoderBase *dec = caching ? cachingDecoder.data() : loadingDecoder.data();
   dec->resetDecoder();
   repushData = false;
-  decodingNotPossibleAfter = -1;
+  decodingNotPossibleAfter[caching ? 1 : 0] = -1;
 
   // Retrieval of the raw metadata is only required if the the reader or the decoder is not ffmpeg
   const bool bothFFmpeg = (!isInputFormatTypeAnnexB(inputFormatType) && decoderEngineType == decoderEngineFFMpeg);
@@ -693,6 +877,314 @@ void playlistItemCompressedVideo::seekToPosition(int seekToFrame, int seekToDTS,
     currentFrameIdx[0] = seekToFrame - 1;
 }
 
+int playlistItemCompressedVideo::getClosestSeekableFrame(int frameIdxInternal, bool caching, int &seekToDTS, int &seekToAnnexBFrameCount) const
+{
+  int seekToFrame = -1;
+  if (isInputFormatTypeAnnexB(inputFormatType))
+    seekToFrame = inputFileAnnexBParser->getClosestSeekableFrameNumberBefore(frameIdxInternal, seekToAnnexBFrameCount);
+  else if (caching)
+    seekToDTS = inputFileFFmpegCaching->getClosestSeekableDTSBefore(frameIdxInternal, seekToFrame);
+  else
+    seekToDTS = inputFileFFmpegLoading->getClosestSeekableDTSBefore(frameIdxInternal, seekToFrame);
+  return seekToFrame;
+}
+
+int playlistItemCompressedVideo::cachingThreadLimit()
+{
+  return PIPELINE_CONVERSION_THREADS;
+}
+
+void playlistItemCompressedVideo::loadRawDataFromCachingPipeline(int frameIdxInternal)
+{
+  if (frameIdxInternal > startEndFrame.second || frameIdxInternal < 0)
+    return;
+
+  QMutexLocker lock(&pipelineMutex);
+
+  // Only one thread at a time takes frames from the pipeline (it is a single consumer queue). The others wait
+  // until a frame was taken and check if it is theirs.
+  while (true)
+  {
+    // Another caching thread may already have taken the frame from the pipeline
+    auto pending = pipelinePendingFrames.find(frameIdxInternal);
+    if (pending != pipelinePendingFrames.end())
+    {
+      DEBUG_COMPRESSED("playlistItemCompressedVideo::loadRawDataFromCachingPipeline frame %d was already decoded", frameIdxInternal);
+      video->rawData = pending.value();
+      video->rawData_frameIdx = frameIdxInternal;
+      pipelinePendingFrames.erase(pending);
+      pipelinePendingFrameCount.store(pipelinePendingFrames.count());
+      return;
+    }
+    if (!pipelineConsumerActive)
+      break;
+    pipelineFrameTaken.wait(&pipelineMutex);
+  }
+
+  if (pipelineRunning && pipelineAbort.load())
+    // The pipeline is being stopped. Don't restart it.
+    return;
+
+  // Restart the pipeline if we have to go backwards or if seeking forward makes sense
+  bool restart = !pipelineRunning || frameIdxInternal < pipelineNextFrame;
+  if (!restart && frameIdxInternal > pipelineNextFrame + FORWARD_SEEK_THRESHOLD)
+  {
+    int seekToDTS = -1;
+    int seekToAnnexBFrameCount = -1;
+    restart = getClosestSeekableFrame(frameIdxInternal, true, seekToDTS, seekToAnnexBFrameCount) > pipelineNextFrame + FORWARD_SEEK_THRESHOLD;
+  }
+  if (restart)
+    startCachingPipeline(frameIdxInternal);
+  if (!pipelineRunning)
+    return;
+
+  // Wait for the decoder without holding the lock so that the other caching threads can take their pending
+  // frames and the pipeline can be stopped in the meantime.
+  pipelineConsumerActive = true;
+  pipelineFrame frame;
+  bool gotFrame = false;
+  while (true)
+  {
+    lock.unlock();
+    const bool popped = pipelineFrames.pop(frame, pipelineDecodeStageDone);
+    lock.relock();
+    if (!popped)
+      break;
+
+    performanceProfiler::instance().setQueueDepth("Decoded frames queue (frames)", pipelineFrames.count());
+    pipelineNextFrame = frame.frameIdx + 1;
+    if (frame.frameIdx == frameIdxInternal)
+    {
+      gotFrame = true;
+      break;
+    }
+
+    // Keep the frame for the caching thread that will request it. Only keep the last few frames.
+    pipelinePendingFrames.insert(frame.frameIdx, frame.data);
+    while (pipelinePendingFrames.count() > PIPELINE_CONVERSION_THREADS)
+      pipelinePendingFrames.erase(pipelinePendingFrames.begin());
+    pipelinePendingFrameCount.store(pipelinePendingFrames.count());
+    pipelineFrameTaken.wakeAll();
+  }
+  pipelineConsumerActive = false;
+  pipelineFrameTaken.wakeAll();
+
+  if (gotFrame)
+  {
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::loadRawDataFromCachingPipeline got frame %d", frameIdxInternal);
+    video->rawData = frame.data;
+    video->rawData_frameIdx = frameIdxInternal;
+    return;
+  }
+
+  if (pipelineAbort.load())
+    // The pipeline was stopped. The frame is not loaded.
+    return;
+
+  // The decode stage ended before the frame was decoded. Maybe the bitstream was cut at a position that
+  // it was not supposed to be cut at. Just set the frame number of the buffer (like it is done for the
+  // interactive decoder). There is no data for the frame so it is not cached (or written to the disk cache).
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::loadRawDataFromCachingPipeline decoding ended before frame %d", frameIdxInternal);
+  decodingNotPossibleAfter[1] = pipelineNextFrame;
+  video->rawData.clear();
+  video->rawData_frameIdx = frameIdxInternal;
+}
+
+void playlistItemCompressedVideo::startCachingPipeline(int frameIdxInternal)
+{
+  stopCachingPipelineStages();
+
+  int seekToDTS = -1;
+  int seekToAnnexBFrameCount = -1;
+  const int seekToFrame = getClosestSeekableFrame(frameIdxInternal, true, seekToDTS, seekToAnnexBFrameCount);
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::startCachingPipeline seeking to frame %d PTS %d AnnexBCnt %d", seekToFrame, seekToDTS, seekToAnnexBFrameCount);
+  seekToPosition(seekToFrame, seekToDTS, true);
+  if (!decodingEnabled)
+    return;
+
+  pipelineNextFrame = seekToFrame;
+  pipelineAbort.store(false);
+  pipelineReadStageDone.store(false);
+  pipelineDecodeStageDone.store(false);
+  pipelineItemName = getName();
+
+  // If the ffmpeg decoder reads from the ffmpeg file, the packets are read by the decode stage
+  const bool readPackets = isInputFormatTypeFFmpeg(inputFormatType) && decoderEngineType == decoderEngineFFMpeg;
+  if (readPackets)
+    pipelineReadStageDone.store(true);
+  else
+    pipelineReadStage = QtConcurrent::run(&pipelineThreadPool, [this, seekToAnnexBFrameCount]() { runPipelineReadStage(seekToAnnexBFrameCount); });
+  pipelineDecodeStage = QtConcurrent::run(&pipelineThreadPool, [this]() { runPipelineDecodeStage(); });
+  pipelineRunning = true;
+}
+
+void playlistItemCompressedVideo::stopCachingPipeline()
+{
+  QMutexLocker lock(&pipelineMutex);
+  stopCachingPipelineStages();
+}
+
+void playlistItemCompressedVideo::stopCachingPipelineStages()
+{
+  if (!pipelineRunning)
+    return;
+
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::stopCachingPipelineStages");
+  pipelineAbort.store(true);
+  pipelineUnits.wakeAll();
+  pipelineFrames.wakeAll();
+  pipelineReadStage.waitForFinished();
+  pipelineDecodeStage.waitForFinished();
+  // A caching thread may still be taking a frame from the queue. It returns once the decode stage is done.
+  while (pipelineConsumerActive)
+    pipelineFrameTaken.wait(&pipelineMutex);
+
+  pipelineUnits.clear();
+  pipelineFrames.clear();
+  pipelinePendingFrames.clear();
+  pipelinePendingFrameCount.store(0);
+  pipelineRunning = false;
+  pipelineNextFrame = -1;
+}
+
+void playlistItemCompressedVideo::runPipelineReadStage(int annexBFrameCounterCodingOrder)
+{
+  performanceProfiler::scopedItem profilerItem(pipelineItemName);
+  const bool readFrames = isInputFormatTypeAnnexB(inputFormatType) && decoderEngineType == decoderEngineFFMpeg;
+
+  while (!pipelineAbort.load())
+  {
+    QByteArray data;
+    {
+      performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageFileRead);
+      if (readFrames)
+      {
+        // Get the data of the next frame (which might be multiple NAL units)
+        QUint64Pair frameStartEndFilePos = inputFileAnnexBParser->getFrameStartEndPos(annexBFrameCounterCodingOrder++);
+        if (frameStartEndFilePos != QUint64Pair(-1, -1))
+          data = inputFileAnnexBCaching->getFrameData(frameStartEndFilePos);
+      }
+      else if (isInputFormatTypeAnnexB(inputFormatType))
+        data = inputFileAnnexBCaching->getNextNALUnit();
+      else
+      {
+        // The unit may reference the data of the AVPacket which is reused for the next packet
+        data = inputFileFFmpegCaching->getNextUnit();
+        data.detach();
+      }
+    }
+
+    // An empty unit signals the end of the bitstream to the decoder. This is the last unit.
+    const bool endOfBitstream = data.isEmpty();
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::runPipelineReadStage read unit - size %d", data.size());
+    if (!pipelineUnits.push(data, pipelineAbort))
+      break;
+    performanceProfiler::instance().setQueueDepth("Compressed data queue (units)", pipelineUnits.count());
+    if (endOfBitstream)
+      break;
+  }
+
+  pipelineReadStageDone.store(true);
+  pipelineUnits.wakeAll();
+}
+
+bool playlistItemCompressedVideo::pushNextUnitInDecodeStage(QByteArray &data, bool &repush)
+{
+  decoderBase *dec = cachingDecoder.data();
+  if (isInputFormatTypeFFmpeg(inputFormatType) && decoderEngineType == decoderEngineFFMpeg)
+  {
+    // Read the next AVPacket from the ffmpeg file and pass it to the ffmpeg decoder directly
+    AVPacketWrapper pkt;
+    {
+      performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageFileRead);
+      pkt = inputFileFFmpegCaching->getNextPacket(repush);
+    }
+    repush = !dynamic_cast<decoderFFmpeg*>(dec)->pushAVPacket(pkt);
+  }
+  else
+  {
+    if (!repush && !pipelineUnits.pop(data, pipelineReadStageDone))
+      // There is no more data
+      return false;
+    performanceProfiler::instance().setQueueDepth("Compressed data queue (units)", pipelineUnits.count());
+    repush = !dec->pushData(data);
+  }
+
+  // If pushing fails, the decoder must switch to decoding frames. Then we push the same data again.
+  return !repush || dec->decodeFrames();
+}
+
+void playlistItemCompressedVideo::runPipelineDecodeStage()
+{
+  performanceProfiler::scopedItem profilerItem(pipelineItemName);
+  decoderBase *dec = cachingDecoder.data();
+  QByteArray data;
+  bool repush = false;
+
+  while (!pipelineAbort.load())
+  {
+    if (dec->needsMoreData() && !pushNextUnitInDecodeStage(data, repush))
+      break;
+
+    if (dec->decodeFrames())
+    {
+      pipelineFrame frame;
+      bool frameDecoded;
+      {
+        performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageDecode);
+        frameDecoded = dec->decodeNextFrame();
+      }
+      if (frameDecoded)
+      {
+        frame.frameIdx = ++currentFrameIdx[1];
+        frame.data = dec->getRawFrameData();
+      }
+      if (frame.frameIdx >= 0)
+      {
+        DEBUG_COMPRESSED("playlistItemCompressedVideo::runPipelineDecodeStage decoded frame %d", frame.frameIdx);
+        if (isPictureHashVerificationActive())
+          verifyDecodedPicture(frame.frameIdx, dec, frame.data);
+        if (frame.frameIdx > startEndFrame.second)
+          break;
+        if (!pipelineFrames.push(std::move(frame), pipelineAbort))
+          break;
+        performanceProfiler::instance().setQueueDepth("Decoded frames queue (frames)", pipelineFrames.count());
+      }
+    }
+
+    if (!dec->needsMoreData() && !dec->decodeFrames())
+    {
+      DEBUG_COMPRESSED("playlistItemCompressedVideo::runPipelineDecodeStage decoder neither needs more data nor can decode frames");
+      break;
+    }
+  }
+
+  pipelineDecodeStageDone.store(true);
+  pipelineFrames.wakeAll();
+}
+
+void playlistItemCompressedVideo::updateDiskCacheKey()
+{
+  if (!video)
+    return;
+  if (!loadingDecoder)
+  {
+    video->setDiskCacheSourceKey(QString());
+    return;
+  }
+
+  if (pictureHashVerification)
+  {
+    // Every picture must be decoded to be verified so none are read from the disk cache
+    video->setDiskCacheSourceKey(QString());
+    return;
+  }
+
+  QFileInfo fileInfo(plItemNameOrFileName);
+  const QString key = QString("%1|%2|%3|%4|%5").arg(fileInfo.absoluteFilePath()).arg(fileInfo.size()).arg(fileInfo.lastModified().toMSecsSinceEpoch()).arg(int(decoderEngineType)).arg(loadingDecoder->getDecodeSignal());
+  video->setDiskCacheSourceKey(key);
+}
+
 void playlistItemCompressedVideo::createPropertiesWidget()
 {
   // Absolutely always only call this once
@@ -738,15 +1230,19 @@ void playlistItemCompressedVideo::createPropertiesWidget()
     ui.comboBoxDecoder->addItem(decoderTypeName);
   }
   ui.comboBoxDecoder->setCurrentIndex(possibleDecoders.indexOf(decoderEngineType));
+  ui.checkBoxVerifyPictureHash->setChecked(pictureHashVerification);
+  ui.checkBoxVerifyPictureHash->setEnabled(inputFileAnnexBParser && inputFileAnnexBParser->hasPictureHashes());
 
   // Connect signals/slots
   connect(ui.comboBoxDisplaySignal, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &playlistItemCompressedVideo::displaySignalComboBoxChanged);
   connect(ui.comboBoxDecoder, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &playlistItemCompressedVideo::decoderComboxBoxChanged);
+  connect(ui.checkBoxVerifyPictureHash, &QCheckBox::toggled, this, &playlistItemCompressedVideo::verifyPictureHashCheckBoxToggled);
 }
 
 bool playlistItemCompressedVideo::allocateDecoder(int displayComponent)
 {
-  // Reset (existing) decoders
+  // Reset (existing) decoders. The caching pipeline must not use the caching decoder anymore.
+  stopCachingPipeline();
   loadingDecoder.reset();
   cachingDecoder.reset();
 
@@ -891,6 +1387,8 @@ indexRange playlistItemCompressedVideo::getStartEndFrameLimits() const
 ValuePairListSets playlistItemCompressedVideo::getPixelValues(const QPoint &pixelPos, int frameIdx)
 {
   ValuePairListSets newSet;
+  if (unresolvableError)
+    return newSet;
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
 
   newSet.append("YUV", video->getPixelValues(pixelPos, frameIdxInternal));
@@ -927,6 +1425,7 @@ void playlistItemCompressedVideo::reloadItemSource()
 
   // Set the frame number limits
   startEndFrame = getStartEndFrameLimits();
+  updateDiskCacheKey();
 
   // Reset the videoHandlerYUV source. With the next draw event, the videoHandlerYUV will request to decode the frame again.
   video->invalidateAllBuffers();
@@ -941,10 +1440,9 @@ void playlistItemCompressedVideo::cacheFrame(int frameIdx, bool testMode)
   if (!cachingEnabled)
     return;
 
-  // Cache a certain frame. This is always called in a separate thread.
-  cachingMutex.lock();
+  // Cache a certain frame. This is always called in a separate thread. The frame is taken from the
+  // caching pipeline (see loadRawDataFromCachingPipeline) and converted in this thread.
   video->cacheFrame(getFrameIdxInternal(frameIdx), testMode);
-  cachingMutex.unlock();
 }
 
 void playlistItemCompressedVideo::loadFrame(int frameIdx, bool playing, bool loadRawdata, bool emitSignals)
@@ -997,6 +1495,7 @@ void playlistItemCompressedVideo::displaySignalComboBoxChanged(int idx)
   if (loadingDecoder && idx != loadingDecoder->getDecodeSignal())
   {
     bool resetDecoder = false;
+    stopCachingPipeline();
     loadingDecoder->setDecodeSignal(idx, resetDecoder);
     cachingDecoder->setDecodeSignal(idx, resetDecoder);
 
@@ -1005,15 +1504,17 @@ void playlistItemCompressedVideo::displaySignalComboBoxChanged(int idx)
       loadingDecoder->resetDecoder();
       cachingDecoder->resetDecoder();
 
-      // Reset the decoded frame indices so that decoding of the current frame is triggered
+      // Reset the decoded frame index so that decoding of the current frame is triggered.
+      // The caching pipeline will seek when it is started again.
       currentFrameIdx[0] = -1;
-      currentFrameIdx[1] = -1;
     }
 
     // A different display signal was chosen. Invalidate the cache and signal that we will need a redraw.
     videoHandlerYUV *yuvVideo = dynamic_cast<videoHandlerYUV*>(video.data());
     yuvVideo->showPixelValuesAsDiff = loadingDecoder->isSignalDifference(idx);
     yuvVideo->invalidateAllBuffers();
+    updateDiskCacheKey();
+    clearPictureHashResults();
 
     emit signalItemChanged(true, RECACHE_CLEAR);
   }
@@ -1034,9 +1535,8 @@ void playlistItemCompressedVideo::decoderComboxBoxChanged(int idx)
       yuvVideo->showPixelValuesAsDiff = loadingDecoder->isSignalDifference(idx);
     yuvVideo->invalidateAllBuffers();
 
-    // Reset the decoded frame indices so that decoding of the current frame is triggered
+    // Reset the decoded frame index so that decoding of the current frame is triggered
     currentFrameIdx[0] = -1;
-    currentFrameIdx[1] = -1;
 
     // Update the list of display signals
     if (loadingDecoder)
@@ -1051,7 +1551,129 @@ void playlistItemCompressedVideo::decoderComboxBoxChanged(int idx)
     statSource.clearStatTypes();
     fillStatisticList();
     statSource.updateStatisticsHandlerControls();
+    updateDiskCacheKey();
+    // The results of the previous decoder are no longer valid
+    clearPictureHashResults();
 
     emit signalItemChanged(true, RECACHE_CLEAR);
   }
 }
+
+bool playlistItemCompressedVideo::isPictureHashVerificationActive() const
+{
+  // Only the reconstruction can be compared to the hash
+  return pictureHashVerification && inputFileAnnexBParser && inputFileAnnexBParser->hasPictureHashes() && loadingDecoder && loadingDecoder->getDecodeSignal() == 0;
+}
+
+void playlistItemCompressedVideo::verifyDecodedPicture(int frameIdxInternal, decoderBase *dec, const QByteArray &data)
+{
+  decodedPictureHash expectedHash;
+  if (!inputFileAnnexBParser->getExpectedPictureHash(frameIdxInternal, expectedHash))
+    return;
+
+  int generation;
+  {
+    QMutexLocker lock(&pictureHashResultsMutex);
+    if (pictureHashResults.contains(frameIdxInternal))
+      // The decoders are deterministic. No need to verify the picture again.
+      return;
+    generation = pictureHashGeneration;
+  }
+
+  const YUView::RawFormat format = dec->getRawFormat();
+  const yuvPixelFormat formatYUV = dec->getYUVPixelFormat();
+  QByteArray hashData = data;
+  QSize hashSize = dec->getFrameSize();
+  if (format == raw_YUV && expectedHash.pictureSize.isValid() && expectedHash.pictureSize != hashSize)
+  {
+    // The output is cropped but the hash is calculated over the full decoded sample arrays. Get them
+    // from the decoder now while it still holds the picture. This is empty if the decoder can not provide them.
+    hashData = dec->getRawFrameDataUncropped(expectedHash.croppingOffset, expectedHash.pictureSize);
+    hashSize = expectedHash.pictureSize;
+  }
+
+  auto verify = [this, frameIdxInternal, expectedHash, format, formatYUV, hashSize, hashData, generation]()
+  {
+    pictureHashResult result = pictureHashUnverifiable;
+    if (format == raw_YUV && !hashData.isEmpty())
+    {
+      const decodedPictureHash hash = decodedPictureHash::calculate(expectedHash.type, expectedHash.componentHashes.count(), hashData, hashSize, formatYUV);
+      if (hash.isValid())
+        result = (hash == expectedHash) ? pictureHashMatch : pictureHashMismatch;
+      DEBUG_COMPRESSED("playlistItemCompressedVideo::verifyDecodedPicture frame %d expected %s got %s", frameIdxInternal, expectedHash.toString().toLatin1().data(), hash.toString().toLatin1().data());
+    }
+
+    {
+      QMutexLocker lock(&pictureHashResultsMutex);
+      if (generation != pictureHashGeneration)
+        // The results were cleared (e.g. a different decoder was selected) while this hash was calculated
+        return;
+      pictureHashResults[frameIdxInternal] = result;
+    }
+    if (pictureHashUpdatePending.testAndSetOrdered(0, 1))
+      QMetaObject::invokeMethod(this, "pictureHashResultsUpdated", Qt::QueuedConnection);
+  };
+  QtConcurrent::run(&pictureHashThreadPool, verify);
+}
+
+void playlistItemCompressedVideo::clearPictureHashResults()
+{
+  // Don't wait for the running hashes. Hashes that were not started yet are removed and the
+  // results of the running ones are dropped because of the new generation.
+  pictureHashThreadPool.clear();
+  {
+    QMutexLocker lock(&pictureHashResultsMutex);
+    pictureHashGeneration++;
+    pictureHashResults.clear();
+  }
+  emit signalPictureHashResultsChanged();
+}
+
+void playlistItemCompressedVideo::pictureHashResultsUpdated()
+{
+  pictureHashUpdatePending.store(0);
+  emit signalItemChanged(false, RECACHE_NONE);
+  emit signalPictureHashResultsChanged();
+}
+
+void playlistItemCompressedVideo::verifyPictureHashCheckBoxToggled(bool checked)
+{
+  if (checked == pictureHashVerification)
+    return;
+
+  pictureHashVerification = checked;
+  clearPictureHashResults();
+  updateDiskCacheKey();
+  if (checked)
+  {
+    // Decode all pictures again so that they are verified. Cached frames would otherwise never be decoded.
+    video->invalidateAllBuffers();
+    stopCachingPipeline();
+    currentFrameIdx[0] = -1;
+    emit signalItemChanged(true, RECACHE_CLEAR);
+  }
+  else
+    emit signalItemChanged(false, RECACHE_NONE);
+}
+
+QList<int> playlistItemCompressedVideo::getFlaggedFrames() const
+{
+  QList<int> frames;
+  QMutexLocker lock(&pictureHashResultsMutex);
+  for (auto it = pictureHashResults.constBegin(); it != pictureHashResults.constEnd(); it++)
+    if (it.value() == pictureHashMismatch)
+      frames.append(getFrameIdxExternal(it.key()));
+  return frames;
+}
+
+QList<int> playlistItemCompressedVideo::getPictureHashMismatchPOCs() const
+{
+  QList<int> pocs;
+  if (!inputFileAnnexBParser)
+    return pocs;
+  QMutexLocker lock(&pictureHashResultsMutex);
+  for (auto it = pictureHashResults.constBegin(); it != pictureHashResults.constEnd(); it++)
+    if (it.value() == pictureHashMismatch)
+      pocs.append(inputFileAnnexBParser->getPOCOfFrame(it.key()));
+  return pocs;
+}
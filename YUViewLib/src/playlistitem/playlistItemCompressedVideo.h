@@ -33,6 +33,16 @@
 #ifndef PLAYLISTITEMCOMPRESSEDVIDEO_H
 #define PLAYLISTITEMCOMPRESSEDVIDEO_H
 
+#include <atomic>
+#include <QAtomicInt>
+#include <QBasicTimer>
+#include <QFuture>
+#include <QMap>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "common/spscQueue.h"
 #include "decoder/decoderBase.h"
 #include "filesource/fileSourceFFmpegFile.h"
 #include "parser/parserAnnexB.h"
@@ -59,6 +69,7 @@ public:
   * 'displayComponent' initializes the component to display (reconstruction/prediction/residual/trCoeff).
   */
   playlistItemCompressedVideo(const QString &fileName, int displayComponent=0, YUView::inputFormat input = YUView::inputInvalid, YUView::decoderEngine decoder = YUView::decoderEngineInvalid);
+  virtual ~playlistItemCompressedVideo();
 
   // Save the compressed file element to the given XML structure.
   virtual void savePlaylist(QDomElement &root, const QDir &playlistDir) const Q_DECL_OVERRIDE;
@@ -99,16 +110,50 @@ public:
   virtual bool isLoadingDoubleBuffer() const Q_DECL_OVERRIDE { return isFrameLoadingDoubleBuffer; }
 
   // Cache the frame with the given index.
-  // For all compressed items, a mutex must be locked when caching a frame (only one frame can be cached at a time because we only have one decoder).
+  // The frames are decoded by the caching pipeline. Only the conversion of the decoded frame is done in the calling thread.
   void cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE;
 
-  // We only have one caching decoder so it is better if only one thread caches frames from this item.
-  // This way, the frames will always be cached in the right order and no unnecessary decoding is performed.
-  virtual int cachingThreadLimit() Q_DECL_OVERRIDE { return 1; }
+  // We only have one caching decoder. It decodes the frames in order in the caching pipeline. Multiple threads
+  // can take the decoded frames from the pipeline and convert them at the same time.
+  virtual int cachingThreadLimit() Q_DECL_OVERRIDE;
+
+  // The video buffers, both decoders, the statistics and the parser
+  virtual int64_t getMemoryUsage() const Q_DECL_OVERRIDE;
 
   YUView::inputFormat getInputFormat() const { return inputFormatType; }
-  
+
+  // The progress of parsing the annexB file (-1 for other inputs)
+  virtual int getOpeningProgress() const Q_DECL_OVERRIDE;
+
+  // The frames for which the decoded picture does not match the picture hash from the bitstream
+  virtual QList<int> getFlaggedFrames() const Q_DECL_OVERRIDE;
+  // The POCs of the frames with a picture hash mismatch (for the bitrate plot of the bitstream analysis)
+  QList<int> getPictureHashMismatchPOCs() const;
+
+signals:
+  // New picture hash verification results are available
+  void signalPictureHashResultsChanged();
+
 protected:
+  // Parse/index the file in the background. Then allocate the video handler and decoders in the main thread.
+  virtual void openItemInBackground() Q_DECL_OVERRIDE;
+  virtual void finishOpeningItem() Q_DECL_OVERRIDE;
+
+  // The constructor parameters and the results of openItemInBackground which are applied in finishOpeningItem
+  struct
+  {
+    int displayComponent {0};
+    YUView::decoderEngine decoder {YUView::decoderEngineInvalid};
+    QSize frameSize;
+    YUV_Internals::yuvPixelFormat formatYUV;
+    RGB_Internals::rgbPixelFormat formatRGB;
+    double frameRate {DEFAULT_FRAMERATE};
+    QString error;
+  } openingState;
+
+  // The YUV output mode is loaded from the playlist before the video handler exists (it is created when opening is done)
+  YUV_Internals::OutputMode outputModeFromPlaylist {YUV_Internals::Output8Bit};
+
   // Override from playlistItemIndexed. The readerEngine can tell us how many frames there are in the sequence.
   virtual indexRange getStartEndFrameLimits() const Q_DECL_OVERRIDE;
 
@@ -143,14 +188,60 @@ protected:
   // read the NAL units from the compressed file.
   QScopedPointer<fileSourceFFmpegFile> inputFileFFmpegLoading;
   QScopedPointer<fileSourceFFmpegFile> inputFileFFmpegCaching;
+
+  // While the ffmpeg file is indexed in the background, the frame range is updated frequently using a timer.
+  // The end frame follows the indexed range unless the user changed it.
+  QBasicTimer indexingTimer;
+  indexRange indexedFrameLimits;
+  virtual void timerEvent(QTimerEvent *event) Q_DECL_OVERRIDE;
   
   // Is the loadFrame function currently loading?
   bool isFrameLoading { false };
   bool isFrameLoadingDoubleBuffer { false };
 
-  // Only cache one frame at a time. Caching should also always be done in display order of the frames.
-  // TODO: Could we somehow make shure that caching is always performed in display order?
-  QMutex cachingMutex;
+  // Caching is done in a pipeline of stages that work at the same time: The read stage reads the compressed data
+  // from the caching file source and the decode stage pushes it to the caching decoder. Both stages run in their own
+  // thread and work ahead of the caching threads. The caching threads only take the decoded frames from the pipeline
+  // and convert them. The stages are connected by bounded lock-free queues. If an AVPacket is pushed to the ffmpeg
+  // decoder directly, the packets are read in the decode stage because the file source reuses the AVPacket.
+  struct pipelineFrame
+  {
+    int frameIdx {-1};
+    QByteArray data;
+  };
+  spscQueue<QByteArray> pipelineUnits;
+  spscQueue<pipelineFrame> pipelineFrames;
+  QThreadPool pipelineThreadPool;
+  QFuture<void> pipelineReadStage;
+  QFuture<void> pipelineDecodeStage;
+  std::atomic<bool> pipelineAbort {false};
+  std::atomic<bool> pipelineReadStageDone {false};
+  std::atomic<bool> pipelineDecodeStageDone {false};
+  bool pipelineRunning {false};
+  int pipelineNextFrame {-1};  //< The frame that is expected to be requested next
+  // Frames that were taken from the pipeline but not requested yet (the caching threads can request them out of order)
+  QMap<int, QByteArray> pipelinePendingFrames;
+  // The number of pending frames for getMemoryUsage() so that the main thread does not lock the pipelineMutex.
+  // Updated under the pipelineMutex whenever the map changes.
+  std::atomic<int> pipelinePendingFrameCount {0};
+  // Protects the pipeline state. It is not held while a caching thread waits for the decoder.
+  QMutex pipelineMutex;
+  // Is a caching thread currently taking frames from the pipeline? The others wait for pipelineFrameTaken.
+  bool pipelineConsumerActive {false};
+  QWaitCondition pipelineFrameTaken;
+  QString pipelineItemName;
+  // Get the given frame from the pipeline. Restart the pipeline (seek) if necessary.
+  void loadRawDataFromCachingPipeline(int frameIdxInternal);
+  void startCachingPipeline(int frameIdxInternal);
+  // Stop the pipeline from any thread (e.g. before the caching decoder is changed)
+  void stopCachingPipeline();
+  void stopCachingPipelineStages();
+  void runPipelineReadStage(int annexBFrameCounterCodingOrder);
+  void runPipelineDecodeStage();
+  bool pushNextUnitInDecodeStage(QByteArray &data, bool &repush);
+
+  // Get the closest position before the given frame that decoding can start from
+  int getClosestSeekableFrame(int frameIdxInternal, bool caching, int &seekToDTS, int &seekToAnnexBFrameCount) const;
 
   statisticHandler statSource;
 
@@ -165,6 +256,10 @@ protected:
   // Seek the input file to the given position, reset the decoder and prepare it to start decoding from the given position.
   void seekToPosition(int seekToFrame, int seekToDTS, bool caching);
 
+  // Decoding is expensive so the decoded frames are also kept in the disk cache. The key identifies the file and
+  // the decoder settings. Update it whenever the file, the decoder or the decoded signal changes.
+  void updateDiskCacheKey();
+
   // For certain decoders (FFmpeg or HM), pushing data may fail. The decoder may or may not switch to retrieveing mode.
   // In this case, we must re-push the packet for which pushing failed.
   bool repushData {false};
@@ -174,18 +269,47 @@ protected:
   bool decodingEnabled {false};
 
   // If the bitstream is invalid (for example it was cut at a position that it should not be cut at), we
-  // might be unable to decode some of the frames at the end of the sequence.
-  int decodingNotPossibleAfter { -1 };
+  // might be unable to decode some of the frames at the end of the sequence. This is set per decoder
+  // (interactive/caching) because the caching pipeline sets it from a caching thread.
+  std::atomic<int> decodingNotPossibleAfter[2] {{-1}, {-1}};
+  bool isDecodingNotPossible(int frameIdxInternal, bool caching) const
+  {
+    const int notPossibleAfter = decodingNotPossibleAfter[caching ? 1 : 0].load();
+    return notPossibleAfter >= 0 && frameIdxInternal >= notPossibleAfter;
+  }
+
+  // Verification of the decoded pictures against the decoded picture hashes in the bitstream (HEVC SEI).
+  // Every picture that one of the decoders outputs is hashed in the background and compared to the expected hash.
+  enum pictureHashResult
+  {
+    pictureHashMatch,
+    pictureHashMismatch,
+    pictureHashUnverifiable   //< The output format is not supported or the decoder can not provide the uncropped picture
+  };
+  bool pictureHashVerification {false};
+  bool isPictureHashVerificationActive() const;
+  // Hash the decoded picture in the background (if it was not verified yet)
+  void verifyDecodedPicture(int frameIdxInternal, decoderBase *dec, const QByteArray &data);
+  void clearPictureHashResults();
+  QMap<int, pictureHashResult> pictureHashResults;  //< Per internal frame index
+  mutable QMutex pictureHashResultsMutex;
+  // Incremented when the results are cleared. Results of hashes that were started before are dropped.
+  int pictureHashGeneration {0};
+  QThreadPool pictureHashThreadPool;
+  // Results are reported to the main thread at most once per event loop iteration
+  QAtomicInt pictureHashUpdatePending;
 
 private slots:
   // Load the raw (YUV or RGN) data for the given frame index from file. This slot is called by the videoHandler if the frame that is
-  // requested to be drawn has not been loaded yet.
-  virtual void loadRawData(int frameIdxInternal, bool forceDecodingNow);
+  // requested to be drawn has not been loaded yet. Frames for caching are taken from the caching pipeline.
+  virtual void loadRawData(int frameIdxInternal, bool caching);
 
   // The statistic with the given frameIdx/typeIdx could not be found in the cache. Load it.
   virtual void loadStatisticToCache(int frameIdx, int typeIdx);
 
   void updateStatSource(bool bRedraw) { emit signalItemChanged(bRedraw, RECACHE_NONE); }
+  void pictureHashResultsUpdated();
+  void verifyPictureHashCheckBoxToggled(bool checked);
   void displaySignalComboBoxChanged(int idx);
   void decoderComboxBoxChanged(int idx);
 };
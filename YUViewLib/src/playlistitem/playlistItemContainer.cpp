@@ -34,8 +34,15 @@
 
 #include <algorithm>
 #include <QPainter>
+#include <QPointer>
+#include <QThreadPool>
+#include <QtConcurrent>
 #include "statistics/statisticHandler.h"
 
+// The threads that load the frames of the children of a container. The global thread pool is also used by
+// long running background parsers, so we use our own pool for this.
+Q_GLOBAL_STATIC(QThreadPool, childLoadingThreadPool)
+
 playlistItemContainer::playlistItemContainer(const QString &itemNameOrFileName) : playlistItem(itemNameOrFileName, playlistItem_Indexed)
 {
   // By default, there is no limit on the number of items
@@ -283,3 +290,41 @@ void playlistItemContainer::savePlaylistChildren(QDomElement &root, const QDir &
       childItem->savePlaylist(root, playlistDir);
   }
 }
+
+void playlistItemContainer::loadChildFrames(int frameIdx, bool playing, bool loadRawData, bool &itemLoaded, bool &itemLoadedDoubleBuffer)
+{
+  // Find all the children that need loading
+  QList<QPointer<playlistItem>> loadItems;
+  for (int i = 0; i < childCount(); i++)
+  {
+    playlistItem *item = getChildPlaylistItem(i);
+    auto state = item->needsLoading(frameIdx, loadRawData);
+    if (state == LoadingNotNeeded)
+      continue;
+
+    loadItems.append(item);
+    if (state == LoadingNeeded)
+      itemLoaded = true;
+    if (playing && (state == LoadingNeeded || state == LoadingNeededDoubleBuffer))
+      itemLoadedDoubleBuffer = true;
+  }
+
+  // Load the requested current frame (or the double buffer) without emitting any signals.
+  // The container will emit the signal that loading is complete when all children have loaded.
+  auto loadItem = [=](QPointer<playlistItem> item)
+  {
+    if (item.isNull() || item->taggedForDeletion())
+      // The child was removed in the meantime. Nothing to load for it anymore.
+      return;
+    item->loadFrame(frameIdx, playing, loadRawData, false);
+  };
+
+  // The first child is loaded in this thread. All others are loaded concurrently.
+  QList<QFuture<void>> futures;
+  for (int i = 1; i < loadItems.count(); i++)
+    futures.append(QtConcurrent::run(childLoadingThreadPool(), loadItem, loadItems[i]));
+  if (!loadItems.isEmpty())
+    loadItem(loadItems[0]);
+  for (auto &f : futures)
+    f.waitForFinished();
+}
@@ -98,6 +98,11 @@ protected:
 
   // Save all child items to playlist
   void savePlaylistChildren(QDomElement &root, const QDir &playlistDir) const;
+
+  // Load the given frame in all child items that need loading. The children are loaded concurrently and this
+  // function returns when all of them are done. Children that are deleted before their loading started are skipped.
+  // Set itemLoaded/itemLoadedDoubleBuffer if any child loaded the frame/the double buffer.
+  void loadChildFrames(int frameIdx, bool playing, bool loadRawData, bool &itemLoaded, bool &itemLoadedDoubleBuffer);
 };
 
 #endif // PLAYLISTITEMCONTAINER_H
@@ -58,6 +58,7 @@ playlistItemDifference::playlistItemDifference()
   frameLimitsMax = false;
   isDifferenceLoading = false;
   isDifferenceLoadingToDoubleBuffer = false;
+  cachingEnabled = true;
 
   // The text that is shown when no difference can be drawn
   infoText = DIFFERENCE_INFO_TEXT;
@@ -251,10 +252,34 @@ void playlistItemDifference::loadFrame(int frameIdx, bool playing, bool loadRawD
   }
 }
 
+void playlistItemDifference::cacheFrame(int frameIdx, bool testMode)
+{
+  if (!cachingEnabled || childCount() != 2 || !difference.inputsValid())
+    return;
+
+  // Since every playlist item can have it's own relative indexing, we need two frame indices
+  const int frameIdxInternal = getFrameIdxInternal(frameIdx);
+  const int idx0 = getChildPlaylistItem(0)->getFrameIdxInternal(frameIdxInternal);
+  const int idx1 = getChildPlaylistItem(1)->getFrameIdxInternal(frameIdxInternal);
+  DEBUG_DIFF("playlistItemDifference::cacheFrame caching difference for frame %d", frameIdxInternal);
+  difference.cacheFrameDifference(frameIdxInternal, idx0, idx1, testMode);
+}
+
+QList<int> playlistItemDifference::getCachedFrames() const
+{
+  // Convert indices from internal to external indices
+  QList<int> retList;
+  for (int i : difference.getCachedFrames())
+    retList.append(getFrameIdxExternal(i));
+  return retList;
+}
+
 void playlistItemDifference::childChanged(bool redraw, recacheIndicator recache)
 {
-  // One of the child items changed and needs to redraw. This means that the difference is out of date
-  // and has to be recalculated.
-  difference.invalidateAllBuffers();
+  // One of the child items changed. If the child has to be recached, its frames changed. This means
+  // that the difference (and all cached difference frames) are out of date and have to be recalculated.
+  // The recache request is passed on, so the video cache will also clear and recache the difference.
+  if (recache == RECACHE_CLEAR)
+    difference.invalidateDifference();
   playlistItemContainer::childChanged(redraw, recache);
 }
\ No newline at end of file
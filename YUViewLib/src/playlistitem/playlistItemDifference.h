@@ -72,6 +72,19 @@ public:
   // Return the frame handler pointer that draws the difference
   virtual frameHandler *getFrameHandler() Q_DECL_OVERRIDE { return &difference; }
 
+  // -- Caching
+  // The difference frames are calculated in the background and cached just like the frames of a video item.
+  virtual void cacheFrame(int frameIdx, bool testMode) Q_DECL_OVERRIDE;
+  virtual QList<int> getCachedFrames() const Q_DECL_OVERRIDE;
+  virtual int getNumberCachedFrames() const Q_DECL_OVERRIDE { return difference.getNumberCachedFrames(); }
+  virtual unsigned int getCachingFrameSize() const Q_DECL_OVERRIDE { return difference.getCachingFrameSize(); }
+  virtual int64_t getMemoryUsage() const Q_DECL_OVERRIDE { return difference.getMemoryUsage(); }
+  virtual void removeFrameFromCache(int idx) Q_DECL_OVERRIDE { difference.removeFrameFromCache(getFrameIdxInternal(idx)); }
+  virtual void removeAllFramesFromCache() Q_DECL_OVERRIDE { difference.removeAllFrameFromCache(); }
+  virtual bool isCachable() const Q_DECL_OVERRIDE { return playlistItem::isCachable() && !childLlistUpdateRequired && childCount() == 2 && difference.inputsValid(); }
+  // The inputs serve the raw data for caching one request at a time, so more threads would only wait for each other.
+  virtual int cachingThreadLimit() Q_DECL_OVERRIDE { return 1; }
+
 protected slots:
   virtual void childChanged(bool redraw, recacheIndicator recache) Q_DECL_OVERRIDE;
 
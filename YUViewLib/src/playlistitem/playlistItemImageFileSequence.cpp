@@ -32,13 +32,21 @@
 
 #include "playlistItemImageFileSequence.h"
 
+#include <QBuffer>
+#include <QFile>
 #include <QImageReader>
+#include <QSet>
 #include <QSettings>
+#include <QtConcurrent>
 #include <QUrl>
 
 #include "common/functions.h"
+#include "common/performanceProfiler.h"
 #include "filesource/fileSource.h"
 
+// The number of frames that are decoded in the background ahead of the frame that was requested last
+#define IMAGESEQUENCE_READ_AHEAD_FRAMES 4
+
 playlistItemImageFileSequence::playlistItemImageFileSequence(const QString &rawFilePath)
   : playlistItemWithVideo(rawFilePath, playlistItem_Indexed)
 {
@@ -55,8 +63,9 @@ playlistItemImageFileSequence::playlistItemImageFileSequence(const QString &rawF
   // Connect the basic signals from the video
   playlistItemWithVideo::connectVideo();
 
-  // Connect the video signalRequestFrame to this::loadFrame
-  connect(video.data(), &videoHandler::signalRequestFrame, this, &playlistItemImageFileSequence::slotFrameRequest);
+  // Connect the video signalRequestFrame to this::loadFrame. The frame is requested from the loading threads
+  // and must be ready when the signal returns.
+  connect(video.data(), &videoHandler::signalRequestFrame, this, &playlistItemImageFileSequence::slotFrameRequest, Qt::DirectConnection);
   
   if (!rawFilePath.isEmpty())
   {
@@ -263,18 +272,144 @@ void playlistItemImageFileSequence::getSupportedFileExtensions(QStringList &allE
 
 void playlistItemImageFileSequence::slotFrameRequest(int frameIdxInternal, bool caching)
 {
-  Q_UNUSED(caching);
-
   // Does the index/file exist?
-  if (frameIdxInternal < 0 || frameIdxInternal >= imageFiles.count())
+  if (!isImageFileAvailable(frameIdxInternal))
     return;
-  QFileInfo fileInfo(imageFiles[frameIdxInternal]);
-  if (!fileInfo.exists() || !fileInfo.isFile())
-    return;
-  
+
+  // Was the frame already decoded (or is it being decoded) in the background?
+  QFuture<QImage> readAheadFrame;
+  bool readAheadFound = false;
+  {
+    QMutexLocker lock(&readAheadMutex);
+    auto it = readAheadFutures.find(frameIdxInternal);
+    if (it != readAheadFutures.end())
+    {
+      readAheadFrame = it.value();
+      readAheadFutures.erase(it);
+      readAheadFound = true;
+    }
+  }
+
   // Load the given frame
-  video->requestedFrame = QImage(imageFiles[frameIdxInternal]);
+  video->requestedFrame = readAheadFound ? readAheadFrame.result() : loadImageFile(imageFiles[frameIdxInternal]);
   video->requestedFrame_idx = frameIdxInternal;
+
+  // The next frames are probably requested next (e.g. during playback). Start decoding them now.
+  if (!caching)
+    startReadAhead(frameIdxInternal + 1);
+}
+
+void playlistItemImageFileSequence::cacheFrame(int frameIdx, bool testMode)
+{
+  if (!cachingEnabled || unresolvableError)
+    return;
+
+  const int frameIdxInternal = getFrameIdxInternal(frameIdx);
+  if (!isImageFileAvailable(frameIdxInternal))
+    return;
+  if (video->isInCache(frameIdxInternal) && !testMode)
+    return;
+
+  // Load the image in this thread. We don't use the shared requestedFrame buffer of the video handler so
+  // we don't have to lock it and other threads can load other frames at the same time.
+  video->addFrameToCache(frameIdxInternal, loadImageFile(imageFiles[frameIdxInternal]), testMode);
+}
+
+QImage playlistItemImageFileSequence::loadImageFile(const QString &filePath)
+{
+  // Read the whole file first so that the file access and the decoding are measured separately.
+  QByteArray fileData;
+  {
+    performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageFileRead);
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+      return QImage();
+    fileData = file.readAll();
+  }
+
+  QImage image;
+  {
+    performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageDecode);
+    // All images in the sequence have the same suffix. Use it to select the plugin directly.
+    QBuffer buffer(&fileData);
+    QImageReader reader(&buffer, QFileInfo(filePath).suffix().toLower().toLatin1());
+    reader.setDecideFormatFromContent(false);
+    image = reader.read();
+    if (image.isNull())
+      // The suffix does not match the content. Let Qt figure it out.
+      image = QImage::fromData(fileData);
+  }
+
+  // Convert the image now so that this does not have to be done for every draw operation.
+  if (!image.isNull() && image.format() != functions::platformImageFormat())
+  {
+    performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageConvertToRGB);
+    image = image.convertToFormat(functions::platformImageFormat());
+  }
+
+  return image;
+}
+
+void playlistItemImageFileSequence::startReadAhead(int firstFrameIdxInternal)
+{
+  const int lastFrameIdxInternal = firstFrameIdxInternal + IMAGESEQUENCE_READ_AHEAD_FRAMES - 1;
+
+  QMutexLocker lock(&readAheadMutex);
+
+  // Drop all frames that are not within the read ahead window anymore (e.g. the user jumped to another frame).
+  // Running futures can not be stopped. The result is just not used.
+  for (auto it = readAheadFutures.begin(); it != readAheadFutures.end();)
+  {
+    if (it.key() < firstFrameIdxInternal || it.key() > lastFrameIdxInternal)
+      it = readAheadFutures.erase(it);
+    else
+      ++it;
+  }
+
+  for (int i = firstFrameIdxInternal; i <= lastFrameIdxInternal && i <= startEndFrame.second; i++)
+  {
+    if (!isImageFileAvailable(i) || readAheadFutures.contains(i) || video->isInCache(i))
+      continue;
+    readAheadFutures.insert(i, QtConcurrent::run(&playlistItemImageFileSequence::loadImageFile, imageFiles[i]));
+  }
+}
+
+void playlistItemImageFileSequence::clearReadAhead()
+{
+  QMutexLocker lock(&readAheadMutex);
+  readAheadFutures.clear();
+}
+
+void playlistItemImageFileSequence::updateFileListSnapshot()
+{
+  // List every directory only once and look up the files in the listing. The file system is queried
+  // without holding the lock. Only the finished snapshot is swapped in.
+  QMap<QString, QSet<QString>> directoryListings;
+  QVector<bool> fileExists;
+  fileExists.reserve(imageFiles.count());
+  for (const QString &file : imageFiles)
+  {
+    QFileInfo fileInfo(file);
+    const QString dirPath = fileInfo.absolutePath();
+    if (!directoryListings.contains(dirPath))
+    {
+      QSet<QString> entries;
+      const QStringList dirEntries = QDir(dirPath).entryList(QDir::Files | QDir::NoDotAndDotDot);
+      for (const QString &entry : dirEntries)
+        entries.insert(entry);
+      directoryListings.insert(dirPath, entries);
+    }
+    fileExists.append(directoryListings[dirPath].contains(fileInfo.fileName()));
+  }
+
+  QMutexLocker lock(&imageFileExistsMutex);
+  imageFileExists.swap(fileExists);
+}
+
+bool playlistItemImageFileSequence::isImageFileAvailable(int frameIdxInternal) const
+{
+  QMutexLocker lock(&imageFileExistsMutex);
+  return frameIdxInternal >= 0 && frameIdxInternal < imageFileExists.count() && imageFileExists[frameIdxInternal];
 }
 
 void playlistItemImageFileSequence::setInternals(const QString &filePath)
@@ -283,11 +418,17 @@ void playlistItemImageFileSequence::setInternals(const QString &filePath)
   if (startEndFrame == indexRange(-1,-1))
     startEndFrame = getStartEndFrameLimits();
 
-  // Open frame 0 and set the size of it
-  QImage frame0 = QImage(imageFiles[0]);
-  video->setFrameSize(frame0.size());
+  updateFileListSnapshot();
+
+  // Get the size of frame 0. Most image plugins can read the size from the header without decoding the image.
+  QImageReader reader(imageFiles[0]);
+  QSize frameSize = reader.size();
+  if (!frameSize.isValid())
+    frameSize = QImage(imageFiles[0]).size();
+  video->setFrameSize(frameSize);
 
-  cachingEnabled = false;  
+  // The images can be loaded independently of each other so caching of the sequence can be done in parallel.
+  cachingEnabled = true;
 
   // Set the internal name
   QFileInfo fi(filePath);
@@ -309,6 +450,10 @@ void playlistItemImageFileSequence::setInternals(const QString &filePath)
 
 void playlistItemImageFileSequence::reloadItemSource()
 {
+  // Files may have been added or removed. Frames that were decoded ahead may be outdated.
+  updateFileListSnapshot();
+  clearReadAhead();
+
   // Clear the video's buffers. The video will ask to reload the images.
   video->invalidateAllBuffers();
 }
@@ -35,6 +35,9 @@
 
 #include <QFileSystemWatcher>
 #include <QFuture>
+#include <QMap>
+#include <QMutex>
+#include <QVector>
 #include "playlistItemWithVideo.h"
 #include "playlistItemRawFile.h"
 #include "video/videoHandler.h"
@@ -79,6 +82,10 @@ public:
   // Is an image currently being loaded?
   virtual bool isLoading() const Q_DECL_OVERRIDE { return isFrameLoading; }
 
+  // Override from playlistItemWithVideo. Every image is decoded independently so the frame is loaded directly
+  // in the calling caching thread. Multiple caching threads can work on the sequence at the same time.
+  virtual void cacheFrame(int frameIdx, bool testMode) Q_DECL_OVERRIDE;
+
 private slots:
   // Load the given frame from file. This slot is called by the videoHandler if the frame that is
   // requested to be drawn has not been loaded yet.
@@ -110,6 +117,26 @@ private:
   // Fill the given imageFiles list with all the files that can be found for the given file.
   static void fillImageFileList(QStringList &imageFiles, const QString &filePath);
   QStringList imageFiles;
+
+  // For each entry in imageFiles, does the file exist? This is a snapshot of the directory listing so that we
+  // don't have to query the file system for every frame that is loaded. Update it with updateFileListSnapshot().
+  // The snapshot is read from the loading and caching threads. It is only accessed with the mutex locked.
+  QVector<bool> imageFileExists;
+  mutable QMutex imageFileExistsMutex;
+  void updateFileListSnapshot();
+  bool isImageFileAvailable(int frameIdxInternal) const;
+
+  // Load the image from the given file and convert it to the platform image format. This is thread-safe.
+  // The image plugin is selected from the file suffix so that the plugins don't have to probe the file content.
+  // High bit depth images (e.g. 16 bit PNG) are converted in the loading thread and not when drawing.
+  static QImage loadImageFile(const QString &filePath);
+
+  // While frames are requested by the interactive loader (e.g. during playback), the next frames are already
+  // decoded in the background. The futures are indexed by the internal frame index.
+  QMap<int, QFuture<QImage>> readAheadFutures;
+  QMutex readAheadMutex;
+  void startReadAhead(int firstFrameIdxInternal);
+  void clearReadAhead();
   
   // This is true if the sequence was loaded from playlist and a frame is missing
   bool loadPlaylistFrameMissing;
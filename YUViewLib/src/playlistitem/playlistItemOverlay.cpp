@@ -569,27 +569,11 @@ void playlistItemOverlay::onGroupBoxToggled(int idx, bool on)
 
 void playlistItemOverlay::loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals)
 {
-  // Does one of the items need loading?
+  // Load all child items that need loading (in parallel)
+  DEBUG_OVERLAY("playlistItemOverlay::loadFrame loading frame %d%s%s", frameIdx, playing ? " playing" : "", loadRawData ? " raw" : "");
   bool itemLoadedDoubleBuffer = false;
   bool itemLoaded = false;
-
-  for (int i = 0; i < childCount(); i++)
-  {
-    playlistItem *item = getChildPlaylistItem(i);
-    auto state = item->needsLoading(frameIdx, loadRawData);
-    if (state != LoadingNotNeeded)
-    {
-      // Load the requested current frame (or the double buffer) without emitting any signals.
-      // We will emit the signal that loading is complete when all overlay items have loaded.
-      DEBUG_OVERLAY("playlistItemWithVideo::loadFrame loading frame %d%s%s", frameIdx, playing ? " playing" : "", loadRawData ? " raw" : "");
-      item->loadFrame(frameIdx, playing, loadRawData, false);
-    }
-
-    if (state == LoadingNeeded)
-      itemLoaded = true;
-    if (playing && (state == LoadingNeeded || state == LoadingNeededDoubleBuffer))
-      itemLoadedDoubleBuffer = true;
-  }
+  loadChildFrames(frameIdx, playing, loadRawData, itemLoaded, itemLoadedDoubleBuffer);
 
   if (emitSignals && itemLoaded)
     emit signalItemChanged(true, RECACHE_NONE);
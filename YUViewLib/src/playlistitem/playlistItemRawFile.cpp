@@ -32,16 +32,21 @@
 
 #include "playlistItemRawFile.h"
 
+#include <algorithm>
 #include <QFileInfo>
 #include <QPainter>
 #include <QUrl>
 #include <QVBoxLayout>
 
 #include "common/functions.h"
+#include "common/performanceProfiler.h"
 
 using namespace YUView;
 using namespace YUV_Internals;
 
+// When caching, let the system read this many bytes ahead of the frame that is currently cached
+#define RAWFILE_READ_AHEAD_BYTES (64*1024*1024)
+
 // Activate this if you want to know when which buffer is loaded/converted to image and so on.
 #define PLAYLISTITEMRAWFILE_DEBUG_LOADING 0
 #if PLAYLISTITEMRAWFILE_DEBUG_LOADING && !NDEBUG
@@ -102,10 +107,10 @@ playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize
 
     if (!video->isFormatValid())
     {
-      // Load 24883200 bytes from the input and try to get the format from the correlation.
-      QByteArray rawData;
-      dataSource.readBytes(rawData, 0, 24883200);
-      video->setFormatFromCorrelation(rawData, dataSource.getFileSize());
+      // Try to get the format from the correlation. This is done in openItemInBackground().
+      opening = true;
+      unresolvableError = true;
+      infoText = "Detecting the format of the file...";
     }
   }
   else
@@ -132,6 +137,31 @@ playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize
   cachingEnabled = true;
 }
 
+void playlistItemRawFile::openItemInBackground()
+{
+  // The correlation detection is only implemented for YUV
+  if (rawFormat != raw_YUV)
+    return;
+
+  // Load 24883200 bytes from the input and try to get the format from the correlation.
+  QByteArray rawData;
+  dataSource.readBytes(rawData, 0, 24883200);
+  correlationFormatFound = videoHandlerYUV::getFormatFromCorrelation(rawData, dataSource.getFileSize(), correlationFrameSize, correlationFormat);
+}
+
+void playlistItemRawFile::finishOpeningItem()
+{
+  unresolvableError = false;
+  infoText.clear();
+  if (correlationFormatFound)
+  {
+    getYUVVideo()->setYUVPixelFormat(correlationFormat);
+    video->setFrameSize(correlationFrameSize);
+  }
+  if (video->isFormatValid() && !propertiesLoadedFromPlaylist)
+    startEndFrame = getStartEndFrameLimits();
+}
+
 int64_t playlistItemRawFile::getNumberFrames() const
 {
   if (!dataSource.isOk() || !video->isFormatValid())
@@ -154,6 +184,11 @@ infoData playlistItemRawFile::getInfo() const
 
   // At first append the file information part (path, date created, file size...)
   info.items.append(dataSource.getFileInfoList());
+  if (isOpening())
+  {
+    info.items.append(infoItem("Status", "Detecting the format of the file..."));
+    return info;
+  }
 
   info.items.append(infoItem("Num Frames", QString::number(getNumberFrames())));
   info.items.append(infoItem("Bytes per Frame", QString("%1").arg(getBytesPerFrame())));
@@ -420,7 +455,10 @@ void playlistItemRawFile::savePlaylist(QDomElement &root, const QDir &playlistDi
 
   // Append the videoHandler properties
   if (rawFormat == raw_YUV)
+  {
     d.appendProperiteChild("pixelFormat", getYUVVideo()->getRawYUVPixelFormatName());
+    d.appendProperiteChild("outputMode", QString::number(int(getYUVVideo()->getOutputMode())));
+  }
   else if (rawFormat == raw_RGB)
     d.appendProperiteChild("pixelFormat", getRGBVideo()->getRawRGBPixelFormatName());
 
@@ -448,6 +486,11 @@ playlistItemRawFile *playlistItemRawFile::newplaylistItemRawFile(const YUViewDom
 
   // We can still not be sure that the file really exists, but we gave our best to try to find it.
   playlistItemRawFile *newFile = new playlistItemRawFile(filePath, QSize(width,height), sourcePixelFormat, type);
+  if (newFile->rawFormat == raw_YUV)
+  {
+    const int outputMode = clip(root.findChildValueInt("outputMode", int(Output8Bit)), int(Output8Bit), int(Output16BitHLG));
+    newFile->getYUVVideo()->setOutputMode(OutputMode(outputMode));
+  }
 
   // Load the propertied of the playlistItem
   playlistItem::loadPropertiesFromPlaylist(root, newFile);
@@ -455,27 +498,69 @@ playlistItemRawFile *playlistItemRawFile::newplaylistItemRawFile(const YUViewDom
   return newFile;
 }
 
-void playlistItemRawFile::loadRawData(int frameIdxInternal)
+int64_t playlistItemRawFile::getFrameFileStartPos(int frameIdxInternal) const
+{
+  if (isY4MFile)
+    return y4mFrameIndices.at(frameIdxInternal);
+  return frameIdxInternal * getBytesPerFrame();
+}
+
+void playlistItemRawFile::loadRawData(int frameIdxInternal, bool caching)
 {
   if (!video->isFormatValid())
     return;
 
   // Load the raw data for the given frameIdx from file and set it in the video
-  int64_t fileStartPos;
-  if (isY4MFile)
-    fileStartPos = y4mFrameIndices.at(frameIdxInternal);
-  else
-    fileStartPos = frameIdxInternal * getBytesPerFrame();
+  int64_t fileStartPos = getFrameFileStartPos(frameIdxInternal);
   int64_t nrBytes = getBytesPerFrame();
 
   DEBUG_RAWFILE("playlistItemRawFile::loadRawData frame %d bytes %d", frameIdxInternal, int(nrBytes));
+  performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageFileRead);
   if (dataSource.readBytes(video->rawData, fileStartPos, nrBytes) < nrBytes)
     return; // Error
   video->rawData_frameIdx = frameIdxInternal;
 
+  if (caching)
+    // The frame will be in the cache. We don't need the data in the page cache anymore.
+    dataSource.adviseDontNeed(fileStartPos, nrBytes);
+
   DEBUG_RAWFILE("playlistItemRawFile::loadRawData %d Done", frameIdxInternal);
 }
 
+void playlistItemRawFile::hintUpcomingCacheFrames(indexRange range)
+{
+  const int64_t bytesPerFrame = getBytesPerFrame();
+  if (!video->isFormatValid() || bytesPerFrame <= 0)
+    return;
+
+  const int firstFrame = getFrameIdxInternal(range.first);
+  const int lastFrame = std::min(getFrameIdxInternal(range.second), int(getNumberFrames()) - 1);
+  const int nrFramesAhead = std::max(int(RAWFILE_READ_AHEAD_BYTES / bytesPerFrame), 1);
+  const int windowEnd = std::min(lastFrame, firstFrame + nrFramesAhead - 1);
+  if (firstFrame < 0 || firstFrame > windowEnd)
+    return;
+
+  QMutexLocker lock(&readAheadMutex);
+  int adviseFrom = firstFrame;
+  if (readAheadBytesPerFrame == bytesPerFrame && firstFrame >= readAheadRange.first && firstFrame <= readAheadRange.second)
+  {
+    // Only extend the window when half of it was consumed. This way, the system gets few large requests.
+    if (readAheadRange.second - firstFrame >= nrFramesAhead / 2)
+      return;
+    adviseFrom = readAheadRange.second + 1;
+  }
+  if (adviseFrom > windowEnd)
+    return;
+
+  const int64_t startPos = getFrameFileStartPos(adviseFrom);
+  const int64_t endPos = getFrameFileStartPos(windowEnd) + bytesPerFrame;
+  DEBUG_RAWFILE("playlistItemRawFile::hintUpcomingCacheFrames frames %d-%d", adviseFrom, windowEnd);
+  dataSource.adviseWillNeed(startPos, endPos - startPos);
+
+  readAheadRange = indexRange(firstFrame, windowEnd);
+  readAheadBytesPerFrame = bytesPerFrame;
+}
+
 ValuePairListSets playlistItemRawFile::getPixelValues(const QPoint &pixelPos, int frameIdx)
 {
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
@@ -34,6 +34,7 @@
 #define PLAYLISTITEMRAWFILE_H
 
 #include <QFuture>
+#include <QMutex>
 #include <QString>
 
 #include "filesource/fileSource.h"
@@ -49,6 +50,7 @@ public:
   // extensions (getSupportedFileExtensions), set the format "fmt" to either "rgb" or "yuv". If you already know the frame size and/or 
   // sourcePixelFormat, you can set them as well.
   playlistItemRawFile(const QString &rawFilePath, const QSize &frameSize=QSize(-1,-1), const QString &sourcePixelFormat=QString(), const QString &fmt=QString());
+  virtual ~playlistItemRawFile() { waitForOpening(); }
 
   // Overload from playlistItem. Save the raw file item to playlist.
   virtual void savePlaylist(QDomElement &root, const QDir &playlistDir) const Q_DECL_OVERRIDE;
@@ -78,11 +80,13 @@ public:
 
   // Cache the given frame
   virtual void cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE { if (testMode) dataSource.clearFileCache(); playlistItemWithVideo::cacheFrame(idx, testMode); }
+  // Let the system read the upcoming frames ahead using large sequential reads
+  virtual void hintUpcomingCacheFrames(indexRange range) Q_DECL_OVERRIDE;
 
 public slots:
   // Load the raw data for the given frame index from file. This slot is called by the videoHandler if the frame that is
-  // requested to be drawn has not been loaded yet.
-  virtual void loadRawData(int frameIdxInternal);
+  // requested to be drawn has not been loaded yet. Frames read for caching are released from the page cache afterwards.
+  virtual void loadRawData(int frameIdxInternal, bool caching);
 
 protected:
   // Override from playlistItemIndexed. For a raw file the index range is 0...numFrames-1. 
@@ -91,6 +95,15 @@ protected:
   // Try to get and set the format from file name. If after calling this function isFormatValid()
   // returns false then it failed.
   void setFormatFromFileName();
+
+  // If the format could not be guessed from the file name, it is detected from the correlation of the first frames.
+  // Reading the data and the detection are done in the background.
+  virtual void openItemInBackground() Q_DECL_OVERRIDE;
+  virtual void finishOpeningItem() Q_DECL_OVERRIDE;
+  // The result of the detection in the background. The video handler is only changed in the main thread.
+  bool correlationFormatFound {false};
+  QSize correlationFrameSize;
+  YUV_Internals::yuvPixelFormat correlationFormat;
   
 private:
 
@@ -103,6 +116,12 @@ private:
   fileSource dataSource;
 
   int64_t getBytesPerFrame() const { return video->getBytesPerFrame(); }
+  int64_t getFrameFileStartPos(int frameIdxInternal) const;
+
+  // The frames that the system was last told to read ahead (and the frame size at that time)
+  indexRange readAheadRange {-1, -1};
+  int64_t readAheadBytesPerFrame {-1};
+  QMutex readAheadMutex;
 
   // A y4m file is a raw YUV file but it adds a header (which has information about the YUV format)
   // and start indicators for every frame. This file will parse the header and save all the byte
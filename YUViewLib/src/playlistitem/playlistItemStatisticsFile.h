@@ -81,10 +81,15 @@ public:
   virtual bool              providesStatistics() const Q_DECL_OVERRIDE { return true; }
   virtual statisticHandler *getStatisticsHandler() Q_DECL_OVERRIDE { return &statSource; }
 
+  virtual int64_t getMemoryUsage() const Q_DECL_OVERRIDE { return statSource.getMemoryUsage(); }
+
   // ----- Detection of source/file change events -----
   virtual bool isSourceChanged()  Q_DECL_OVERRIDE { return file.isFileChanged(); }
   virtual void updateSettings()   Q_DECL_OVERRIDE { file.updateFileWatchSetting(); statSource.updateSettings(); }
 
+  // Block until the background parser has scanned the whole file (for non-interactive use like the benchmark)
+  void waitForBackgroundParsing() { backgroundParserFuture.waitForFinished(); }
+
 protected:
   virtual indexRange getStartEndFrameLimits() const Q_DECL_OVERRIDE { return indexRange(0, maxPOC); }
 
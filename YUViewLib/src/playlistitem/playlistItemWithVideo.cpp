@@ -107,6 +107,9 @@ void playlistItemWithVideo::loadFrame(int frameIdx, bool playing, bool loadRawDa
 
 itemLoadingState playlistItemWithVideo::needsLoading(int frameIdx, bool loadRawValues)
 {
+  if (unresolvableError)
+    return LoadingNotNeeded;
+
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
 
   // See if the item has so many frames
@@ -37,6 +37,7 @@
 #include <QtMath>
 
 #include "common/functions.h"
+#include "common/performanceProfiler.h"
 
 // Activate this if you want to know when what is loaded.
 #define STATISTICS_DEBUG_LOADING 0
@@ -105,6 +106,7 @@ itemLoadingState statisticHandler::needsLoading(int frameIdx)
 void statisticHandler::loadStatistics(int frameIdx)
 {
   DEBUG_STAT("statisticHandler::loadStatistics frame %d", frameIdx);
+  performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageLoadStatistics);
 
   QMutexLocker lock(&statsCacheAccessMutex);
   if (frameIdx != statsCacheFrameIdx)
@@ -186,6 +188,11 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
       // This statistics type is not rendered or could not be loaded.
       continue;
 
+    // Compile the color mapper into a lookup table (only if its settings changed)
+    colorMapper &colMapper = statsTypeList[i].colMapper;
+    colMapper.prepareLookupTable();
+    const int alphaFactor = statsTypeList[i].alphaFactor;
+
     // Go through all the value data
     for (const statisticsItem_Value &valueItem : statsCache[typeIdx].valueData)
     {
@@ -201,12 +208,12 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
         if (statsTypeList[i].renderValueData)
         {
           // Get the right color for the item and draw it.
-          QColor rectColor;
+          QRgb rgba;
           if (statsTypeList[i].scaleValueToBlockSize)
-            rectColor = statsTypeList[i].colMapper.getColor(float(value) / (valueItem.size[0] * valueItem.size[1]));
+            rgba = colMapper.getColorFromLookupTable(float(value) / (valueItem.size[0] * valueItem.size[1]));
           else
-            rectColor = statsTypeList[i].colMapper.getColor(value);
-          rectColor.setAlpha(rectColor.alpha()*((float)statsTypeList[i].alphaFactor / 100.0));
+            rgba = colMapper.getColorFromLookupTable(value);
+          const QColor rectColor(qRed(rgba), qGreen(rgba), qBlue(rgba), qAlpha(rgba) * alphaFactor / 100);
           painter->setBrush(rectColor);
           painter->fillRect(displayRect, rectColor);
         }
@@ -265,6 +272,11 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
       // This statistics type is not rendered or could not be loaded.
       continue;
 
+    // Compile the color mapper into a lookup table (only if its settings changed)
+    colorMapper &colMapper = statsTypeList[i].colMapper;
+    colMapper.prepareLookupTable();
+    const int alphaFactor = statsTypeList[i].alphaFactor;
+
     // Go through all the value data
     for (const statisticsItemPolygon_Value &valueItem : statsCache[typeIdx].polygonValueData)
     {
@@ -284,12 +296,12 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
         if (statsTypeList[i].renderValueData)
         {
           // Get the right color for the item and draw it.
-          QColor color;
+          QRgb rgba;
           if (statsTypeList[i].scaleValueToBlockSize)
-            color = statsTypeList[i].colMapper.getColor(float(value) / (boundingRect.size().width() * boundingRect.size().height()));
+            rgba = colMapper.getColorFromLookupTable(float(value) / (boundingRect.size().width() * boundingRect.size().height()));
           else
-            color = statsTypeList[i].colMapper.getColor(value);
-          color.setAlpha(color.alpha()*((float)statsTypeList[i].alphaFactor / 100.0));
+            rgba = colMapper.getColorFromLookupTable(value);
+          const QColor color(qRed(rgba), qGreen(rgba), qBlue(rgba), qAlpha(rgba) * alphaFactor / 100);
           painter->setBrush(color);
 
           // Fill polygon
@@ -1222,6 +1234,21 @@ void statisticHandler::updateSettings()
   }
 }
 
+int64_t statisticHandler::getMemoryUsage() const
+{
+  // This is called from the video cache. Don't wait for the loading thread.
+  if (!statsCacheAccessMutex.tryLock())
+    return lastMemoryUsage.load();
+
+  int64_t size = 0;
+  for (const statisticsData &data : statsCache)
+    size += data.getMemoryUsage();
+  statsCacheAccessMutex.unlock();
+
+  lastMemoryUsage.store(size);
+  return size;
+}
+
 void statisticHandler::updateStatisticsHandlerControls()
 {
   // First run a check if all statisticsTypes are identical
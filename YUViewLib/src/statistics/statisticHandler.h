@@ -33,6 +33,7 @@
 #ifndef STATISTICSOURCE_H
 #define STATISTICSOURCE_H
 
+#include <QAtomicInteger>
 #include <QPointer>
 #include <QVector>
 #include <QMutex>
@@ -116,6 +117,10 @@ public:
   // Update the settings. For the statistics this means updating the icons for editing statistic.
   void updateSettings();
 
+  // Get the memory (in bytes) that is used by the statistics cache. This does not block. If the cache is currently
+  // being changed, the last known value is returned.
+  int64_t getMemoryUsage() const;
+
 signals:
   // Update the item (and maybe redraw it)
   void updateItem(bool redraw);
@@ -128,7 +133,8 @@ private:
   QSize statFrameSize;
 
   // Make sure that nothing is read from the stats cache while it is being changed.
-  QMutex statsCacheAccessMutex;
+  mutable QMutex statsCacheAccessMutex;
+  mutable QAtomicInteger<qint64> lastMemoryUsage {0};
 
   // The list of all statistics that this class can provide (and a backup for updating the list)
   StatisticsTypeList statsTypeList;
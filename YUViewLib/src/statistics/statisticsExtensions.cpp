@@ -32,6 +32,7 @@
 
 #include "statisticsExtensions.h"
 
+#include <algorithm>
 #include <cmath>
 #include <random>
 
@@ -391,6 +392,23 @@ void statisticsData::addPolygonVector(const QVector<QPoint> &points, int vecX, i
   polygonVectorData.append(vec);
 }
 
+int64_t statisticsData::getMemoryUsage() const
+{
+  // QList stores large items as pointers to heap allocated copies
+  auto listSize = [](int count, size_t itemSize) { return int64_t(count) * int64_t(itemSize + sizeof(void*)); };
+  int64_t size = sizeof(statisticsData);
+  size += listSize(valueData.count(), sizeof(statisticsItem_Value));
+  size += listSize(vectorData.count(), sizeof(statisticsItem_Vector));
+  size += listSize(affineTFData.count(), sizeof(statisticsItem_AffineTF));
+  size += listSize(polygonValueData.count(), sizeof(statisticsItemPolygon_Value));
+  size += listSize(polygonVectorData.count(), sizeof(statisticsItemPolygon_Vector));
+  for (const statisticsItemPolygon_Value &p : polygonValueData)
+    size += p.corners.count() * sizeof(QPoint);
+  for (const statisticsItemPolygon_Vector &p : polygonVectorData)
+    size += p.corners.count() * sizeof(QPoint);
+  return size;
+}
+
 // Setup an invalid (uninitialized color mapper)
 colorMapper::colorMapper()
 {
@@ -530,16 +548,20 @@ QColor colorMapper::getColor(float value)
     {
       int rangeSize = rangeMax - rangeMin;
       // randomly remap the x value, but always with the same random seed
-      unsigned seed = 42;
-      std::vector<int> randomMap;
-      for (int val = 0; val < rangeSize; ++val) {
-        randomMap.push_back(val);
+      if (int(shuffleMap.size()) != rangeSize)
+      {
+        unsigned seed = 42;
+        shuffleMap.clear();
+        for (int val = 0; val < rangeSize; ++val) {
+          shuffleMap.push_back(val);
+        }
+        shuffle (shuffleMap.begin(), shuffleMap.end(), std::default_random_engine(seed));
       }
-      shuffle (randomMap.begin(), randomMap.end(), std::default_random_engine(seed));
 
-      int valueInt = (int) (value - rangeMin);
-      float rem = value - valueInt;
-      float valueMapped = randomMap[valueInt] + rem;
+      // The maximum value is mapped like the last value of the range
+      int valueInt = std::min((int) (value - rangeMin), std::max(rangeSize - 1, 0));
+      float rem = value - rangeMin - valueInt;
+      float valueMapped = shuffleMap.empty() ? 0 : shuffleMap[valueInt] + rem;
 
       float x = valueMapped / (rangeMax-rangeMin);
 
@@ -724,6 +746,113 @@ QColor colorMapper::getColor(float value)
   return QColor();
 }
 
+// The lookup table of gradients and complex maps has at least this many entries so that non integer values
+// (e.g. values scaled to the block size) are still mapped smoothly. It never has more than the maximum.
+#define COLORMAPPER_LUT_MIN_SIZE 1024
+#define COLORMAPPER_LUT_MAX_SIZE 65536
+
+void colorMapper::prepareLookupTable()
+{
+  const lookupTableSettings settings = getLookupTableSettings();
+  if (lutValid && lutSettings == settings)
+    return;
+
+  lut.clear();
+  if (type == map)
+  {
+    // One entry per integer value. Values outside of the table are mapped to colorMapOther.
+    lutScale = 1.0;
+    lutRangeMin = colorMap.isEmpty() ? 0 : colorMap.firstKey();
+    lutRangeMax = colorMap.isEmpty() ? -1 : colorMap.lastKey();
+    if (int64_t(lutRangeMax) - lutRangeMin < COLORMAPPER_LUT_MAX_SIZE)
+    {
+      lut.fill(colorMapOther.rgba(), lutRangeMax - lutRangeMin + 1);
+      for (auto it = colorMap.constBegin(); it != colorMap.constEnd(); it++)
+        lut[it.key() - lutRangeMin] = it.value().rgba();
+    }
+  }
+  else if (type == gradient || type == complex)
+  {
+    lutRangeMin = rangeMin;
+    lutRangeMax = rangeMax;
+    const int64_t rangeSize = int64_t(rangeMax) - rangeMin;
+    if (rangeSize <= 0)
+    {
+      lutScale = 1.0;
+      lut.append(getColor(float(rangeMin)).rgba());
+    }
+    else
+    {
+      // Use an integer number of entries per value if possible so that integer values hit an entry exactly
+      if (rangeSize < COLORMAPPER_LUT_MAX_SIZE)
+        lutScale = std::max(int64_t(1), std::min((COLORMAPPER_LUT_MIN_SIZE + rangeSize - 1) / rangeSize, (COLORMAPPER_LUT_MAX_SIZE - 1) / rangeSize));
+      else
+        lutScale = double(COLORMAPPER_LUT_MAX_SIZE - 1) / rangeSize;
+      const int nrEntries = int(rangeSize * lutScale) + 1;
+      lut.resize(nrEntries);
+      for (int i = 0; i < nrEntries; i++)
+        lut[i] = getColor(float(rangeMin + i / lutScale)).rgba();
+    }
+  }
+
+  lutSettings = settings;
+  lutValid = true;
+}
+
+QRgb colorMapper::getColorFromLookupTable(int value) const
+{
+  Q_ASSERT_X(lutValid, "colorMapper::getColorFromLookupTable", "prepareLookupTable() was not called");
+  if (type == map)
+  {
+    if (lut.isEmpty())
+      return colorMap.value(value, colorMapOther).rgba();
+    if (value < lutRangeMin || value > lutRangeMax)
+      return colorMapOther.rgba();
+    return lut[value - lutRangeMin];
+  }
+  if (lut.isEmpty())
+    return QColor().rgba();
+
+  value = clip(value, lutRangeMin, lutRangeMax);
+  const int idx = (lutScale == 1.0) ? value - lutRangeMin : int((int64_t(value) - lutRangeMin) * lutScale + 0.5);
+  return lut[std::min(idx, lut.size() - 1)];
+}
+
+QRgb colorMapper::getColorFromLookupTable(float value) const
+{
+  if (type == map)
+    // Round and use the integer value to get the value from the map
+    return getColorFromLookupTable(int(value+0.5));
+  if (lut.isEmpty())
+    return QColor().rgba();
+
+  value = clip(value, float(lutRangeMin), float(lutRangeMax));
+  const int idx = int((value - lutRangeMin) * lutScale + 0.5);
+  return lut[std::min(idx, lut.size() - 1)];
+}
+
+colorMapper::lookupTableSettings colorMapper::getLookupTableSettings() const
+{
+  lookupTableSettings s;
+  s.type = type;
+  s.rangeMin = rangeMin;
+  s.rangeMax = rangeMax;
+  s.minColor = minColor.rgba();
+  s.maxColor = maxColor.rgba();
+  s.colorMapOther = colorMapOther.rgba();
+  s.colorMap = colorMap;
+  s.complexType = complexType;
+  return s;
+}
+
+bool colorMapper::lookupTableSettings::operator==(const lookupTableSettings &other) const
+{
+  // The color map is implicitly shared so comparing it is cheap if it was not changed
+  return type == other.type && rangeMin == other.rangeMin && rangeMax == other.rangeMax && minColor == other.minColor &&
+         maxColor == other.maxColor && colorMapOther == other.colorMapOther && complexType == other.complexType &&
+         colorMap == other.colorMap;
+}
+
 int colorMapper::getMinVal()
 {
   if (type == gradient || type == complex)
@@ -33,9 +33,12 @@
 #ifndef STATISTICSEXTENSIONS_H
 #define STATISTICSEXTENSIONS_H
 
+#include <vector>
+
 #include <QColor>
 #include <QMap>
 #include <QPen>
+#include <QVector>
 
 class YUViewDomElement;
 
@@ -48,6 +51,8 @@ class YUViewDomElement;
  * 3: complex  - We use a specific complex color gradient for values from rangeMin to rangeMax.
  *               They are similar to the ones used in MATLAB. The are set by name. supportedComplexTypes
  *               has a list of all supported types.
+ * For drawing many values (e.g. all blocks of a frame), the mapper can be compiled into a lookup table
+ * (prepareLookupTable()) so that getting a color is only a clamped array access.
  */
 class colorMapper
 {
@@ -84,6 +89,38 @@ public:
 
   mappingType type;
   static QStringList supportedComplexTypes;
+
+  // Compile the mapper into a lookup table from value to color. The table is only rebuilt if the settings of the
+  // mapper changed since the last call. Call this before getting the colors of many values.
+  void prepareLookupTable();
+  // Get the color from the lookup table. prepareLookupTable() must have been called before.
+  QRgb getColorFromLookupTable(int value) const;
+  QRgb getColorFromLookupTable(float value) const;
+
+private:
+  // The lookup table covers the values from lutRangeMin to lutRangeMax with lutScale entries per value.
+  // For a map with a very large range of values, the table is empty and the map is used.
+  QVector<QRgb> lut;
+  int lutRangeMin {0};
+  int lutRangeMax {0};
+  double lutScale {1.0};
+  bool lutValid {false};
+
+  // The settings that the lookup table was created for
+  struct lookupTableSettings
+  {
+    mappingType type;
+    int rangeMin, rangeMax;
+    QRgb minColor, maxColor, colorMapOther;
+    QMap<int,QColor> colorMap;
+    QString complexType;
+    bool operator==(const lookupTableSettings &other) const;
+  };
+  lookupTableSettings getLookupTableSettings() const;
+  lookupTableSettings lutSettings;
+
+  // The random mapping of the "shuffle" type only depends on the size of the range
+  std::vector<int> shuffleMap;
 };
 
 /* This class defines a type of statistic to render. Each statistics type entry defines the name and and ID of a statistic. It also defines
@@ -243,6 +280,9 @@ public:
   void addPolygonVector(const QVector<QPoint> &points, int vecX, int vecY);
   void addPolygonValue(const QVector<QPoint> &points, int val);
 
+  // Get an estimate of the memory (in bytes) that is used by the data
+  int64_t getMemoryUsage() const;
+
   QList<statisticsItem_Value> valueData;
   QList<statisticsItem_Vector> vectorData;
   QList<statisticsItem_AffineTF> affineTFData;
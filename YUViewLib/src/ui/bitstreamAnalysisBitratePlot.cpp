@@ -32,234 +32,359 @@
 
 #include "bitstreamAnalysisBitratePlot.h"
 
+#include <cmath>
+#include <QtGui/QPainter>
+#include <QtGui/QWheelEvent>
+#include <QtWidgets/QToolTip>
 #include <QtWidgets/QVBoxLayout>
-#include <QtCharts/QStackedBarSeries>
-#include <QtCharts/QLineSeries>
 
-QT_CHARTS_USE_NAMESPACE
+// Below this many pixels per bar, the entries of each pixel column are aggregated
+const double minPixelsPerBar = 2.0;
+const double maxPixelsPerBar = 100.0;
+// The average line is the average over this many entries before and after each entry
+const int averageRange = 10;
+const int axisMarginLeft = 60;
+const int axisMarginBottom = 25;
+const int plotMargin = 10;
+
+const QColor colorNonKeyframe(32, 159, 223);
+const QColor colorKeyframe(153, 202, 83);
+const QColor colorMarked(220, 30, 30);
+const QColor colorAverage(246, 166, 37);
+
+namespace
+{
+
+// Get a "nice" step (1, 2 or 5 times a power of 10) that is at least the given value
+double getNiceStep(double minStep)
+{
+  if (minStep <= 0)
+    return 1;
+  const double magnitude = std::pow(10.0, std::floor(std::log10(minStep)));
+  const double m = minStep / magnitude;
+  if (m <= 1)
+    return magnitude;
+  if (m <= 2)
+    return 2 * magnitude;
+  if (m <= 5)
+    return 5 * magnitude;
+  return 10 * magnitude;
+}
 
-const int scrollBarScale = 10;
+} // namespace
 
-BitrateBarChartCallout::BitrateBarChartCallout() :
-  QGraphicsItem()
+BitrateBarChart::BitrateBarChart(QWidget *parent)
+  : QWidget(parent)
 {
+  QVBoxLayout *mainLayout = new QVBoxLayout(this);
+  mainLayout->addStretch(1);
+
+  this->scrollBar = new QScrollBar(Qt::Horizontal, this);
+  mainLayout->addWidget(this->scrollBar);
+  connect(this->scrollBar, &QAbstractSlider::valueChanged, this, &BitrateBarChart::onScrollBarValueChanged);
+
+  this->setMinimumSize(640, 480);
+  this->setMouseTracking(true);
 }
 
-void BitrateBarChartCallout::setChart(QtCharts::QChart *chart)
+void BitrateBarChart::setModel(parserCommon::BitrateItemModel *model)
 {
-  this->setParentItem(chart);
-  this->chart = chart;
+  if (this->model)
+    disconnect(this->model, &QAbstractItemModel::rowsInserted, this, &BitrateBarChart::onRowsInserted);
+
+  this->model = model;
+  if (this->model)
+    connect(this->model, &QAbstractItemModel::rowsInserted, this, &BitrateBarChart::onRowsInserted);
+
+  this->updateScrollBarRange();
+  {
+    QSignalBlocker scrollBarSignalBlocker(this->scrollBar);
+    this->scrollBar->setValue(0);
+  }
+  this->update();
 }
 
-QRectF BitrateBarChartCallout::boundingRect() const
+void BitrateBarChart::onScrollBarValueChanged(int value)
 {
-  if (this->parentItem() == nullptr || this->chart == nullptr)
-    return {};
-
-  QPointF anchor = mapFromParent(this->chart->mapToPosition(this->anchor));
-  QRectF rect;
-  rect.setLeft(qMin(this->rect.left(), anchor.x()));
-  rect.setRight(qMax(this->rect.right(), anchor.x()));
-  rect.setTop(qMin(this->rect.top(), anchor.y()));
-  rect.setBottom(qMax(this->rect.bottom(), anchor.y()));
-  return rect;
+  Q_UNUSED(value);
+  this->update();
 }
 
-void BitrateBarChartCallout::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+void BitrateBarChart::onRowsInserted(const QModelIndex &parent, int first, int last)
 {
-  Q_UNUSED(option)
-  Q_UNUSED(widget)
+  Q_UNUSED(parent);
+  Q_UNUSED(first);
+  Q_UNUSED(last);
 
-  painter->setBrush(QColor(255, 255, 255));
-  painter->drawRect(this->rect);
-  painter->drawText(this->textRect, this->text);
+  // No relayout needed. Only the visible part is drawn.
+  this->updateScrollBarRange();
+  this->update();
 }
 
-void BitrateBarChartCallout::setTextAndAnchor(const QString &text, QPointF anchor)
+void BitrateBarChart::resizeEvent(QResizeEvent *event)
 {
-  this->text = text;
-  QFont defaultFont;
-  QFontMetrics metrics(defaultFont);
-  this->textRect = metrics.boundingRect(QRect(0, 0, 150, 150), Qt::AlignLeft, this->text);
-  prepareGeometryChange();
-  this->rect = this->textRect.adjusted(-5, -5, 5, 5);
-  this->anchor = anchor;
-  setPos(this->chart->mapToPosition(anchor) + QPoint(-this->textRect.width() / 2, -this->textRect.height() - 10));
+  QWidget::resizeEvent(event);
+  this->updateScrollBarRange();
 }
 
-BitrateBarChart::BitrateBarChart(QWidget *parent)
-  : QWidget(parent)
+QRect BitrateBarChart::getPlotRect() const
 {
-  QVBoxLayout *mainLayout = new QVBoxLayout(this);
-
-  this->chartView = new QChartView(this);
-  this->chartView->setRenderHint(QPainter::Antialiasing);
-  this->chartView->setMinimumSize(640, 480);
-  mainLayout->addWidget(this->chartView);
+  QRect area = this->rect();
+  area.setBottom(this->scrollBar->geometry().top() - 1);
+  return area.adjusted(axisMarginLeft, plotMargin, -plotMargin, -axisMarginBottom);
+}
 
-  this->chartView->setChart(&this->chart);
-  this->currentTooltip.setChart(&this->chart);
+int BitrateBarChart::getNumberOfEntries() const
+{
+  return this->model ? this->model->rowCount() : 0;
+}
 
-  this->scrollBar = new QScrollBar(Qt::Horizontal, this);
-  mainLayout->addWidget(this->scrollBar);
-  connect(this->scrollBar, &QAbstractSlider::valueChanged, this, &BitrateBarChart::onScrollBarValueChanged);
+double BitrateBarChart::getVisibleEntries() const
+{
+  return this->getPlotRect().width() / this->pixelsPerBar;
 }
 
-void BitrateBarChart::setModel(parserCommon::BitrateItemModel *model)
+void BitrateBarChart::updateScrollBarRange()
 {
-  this->model = model;
-  
-  // Clear the current chart
-  this->chart.removeAllSeries();
-  if (!this->barMapper.isNull())
-  {
-    delete this->barMapper;
-    this->barMapper.clear();
-  }
-  if (!this->lineModelMapper.isNull())
-  {
-    delete this->lineModelMapper;
-    this->lineModelMapper.clear();
-  }
-  if (!this->axisX.isNull())
+  const int maxValue = this->getNumberOfEntries() - int(this->getVisibleEntries());
+  QSignalBlocker scrollBarSignalBlocker(this->scrollBar);
+  if (maxValue <= 0)
   {
-    this->chart.removeAxis(this->axisX);
-    delete this->axisX;
-    this->axisX.clear();
+    this->scrollBar->setRange(0, 0);
+    this->scrollBar->setEnabled(false);
   }
-  if (!this->axisY.isNull())
+  else
   {
-    this->chart.removeAxis(this->axisY);
-    delete this->axisY;
-    this->axisY.clear();
+    this->scrollBar->setEnabled(true);
+    this->scrollBar->setRange(0, maxValue);
+    this->scrollBar->setPageStep(qMax(1, int(this->getVisibleEntries())));
   }
+}
 
-  if (!this->model)
+void BitrateBarChart::zoom(double factor, int anchorX)
+{
+  const QRect plotRect = this->getPlotRect();
+  if (plotRect.width() <= 0)
     return;
 
-  Q_ASSERT(this->barMapper.isNull());
-  Q_ASSERT(this->lineModelMapper.isNull());
-  Q_ASSERT(this->axisX.isNull());
-  Q_ASSERT(this->axisY.isNull());
-
-  QStackedBarSeries *barSeries = new QStackedBarSeries;
-  barSeries->setBarWidth(1.0);
-  this->chart.setAnimationOptions(QChart::NoAnimation);
+  // Zooming out stops when all entries fit
+  const double minZoom = qMin(minPixelsPerBar, double(plotRect.width()) / qMax(1, this->getNumberOfEntries()));
+  const double anchorOffset = qBound(0, anchorX - plotRect.left(), plotRect.width());
+  const double anchorEntry = this->scrollBar->value() + anchorOffset / this->pixelsPerBar;
 
+  this->pixelsPerBar = qBound(minZoom, this->pixelsPerBar * factor, maxPixelsPerBar);
   this->updateScrollBarRange();
-
-  this->barMapper = new QVBarModelMapper(this);
-  this->barMapper->setFirstBarSetColumn(2);
-  this->barMapper->setLastBarSetColumn(3);
-  this->barMapper->setRowCount(this->model->rowCount());
-  this->barMapper->setSeries(barSeries);
-  this->barMapper->setModel(this->model);
-  this->chart.addSeries(barSeries);
-
-  QLineSeries *lineSeries = new QLineSeries;
-  lineSeries->setName("Average");
-  this->lineModelMapper = new QVXYModelMapper(this);
-  this->lineModelMapper->setXColumn(0);
-  this->lineModelMapper->setYColumn(1);
-  this->lineModelMapper->setSeries(lineSeries);
-  this->lineModelMapper->setModel(this->model);
-  this->chart.addSeries(lineSeries);
-
-  this->axisX = new QValueAxis();
-  this->axisX->setLabelFormat("%.0f");
-  this->axisY = new QValueAxis();
-  this->chart.addAxis(this->axisX, Qt::AlignBottom);
-  this->chart.addAxis(this->axisY, Qt::AlignLeft);
-  barSeries->attachAxis(this->axisX);
-  lineSeries->attachAxis(this->axisX);
-  barSeries->attachAxis(this->axisY);
-  lineSeries->attachAxis(this->axisY);
-  connect(barSeries, &QAbstractBarSeries::hovered, this, &BitrateBarChart::tooltip);
-
-  this->onScrollBarValueChanged(0);
-
-  connect(this->model, &QAbstractItemModel::rowsInserted, this, &BitrateBarChart::onRowsInserted);
+  {
+    QSignalBlocker scrollBarSignalBlocker(this->scrollBar);
+    this->scrollBar->setValue(int(std::round(anchorEntry - anchorOffset / this->pixelsPerBar)));
+  }
+  this->update();
 }
 
-void BitrateBarChart::onScrollBarValueChanged(int value)
+void BitrateBarChart::wheelEvent(QWheelEvent *event)
 {
-  Q_UNUSED(value);
-  this->updateAxis();
+  const double steps = event->angleDelta().y() / 120.0;
+  if (steps == 0)
+  {
+    QWidget::wheelEvent(event);
+    return;
+  }
+  this->zoom(std::pow(1.25, steps), event->pos().x());
+  event->accept();
 }
 
-void BitrateBarChart::tooltip(bool status, int index, QBarSet *barset)
+void BitrateBarChart::mouseMoveEvent(QMouseEvent *event)
 {
-  Q_UNUSED(barset);
+  const QRect plotRect = this->getPlotRect();
+  const int nrEntries = this->getNumberOfEntries();
+  if (!this->model || nrEntries == 0 || !plotRect.contains(event->pos()))
+  {
+    QToolTip::hideText();
+    return;
+  }
 
-  if (status)
+  const double offset = event->pos().x() - plotRect.left();
+  QString text;
+  if (this->pixelsPerBar >= minPixelsPerBar)
   {
-    if (this->model)
+    const int index = this->scrollBar->value() + int(offset / this->pixelsPerBar);
+    if (index < nrEntries)
+      text = this->model->getItemInfoText(index);
+  }
+  else
+  {
+    const double entriesPerPixel = 1.0 / this->pixelsPerBar;
+    const double first = this->scrollBar->value() + std::floor(offset) * entriesPerPixel;
+    const auto aggregate = this->model->getAggregates(first, entriesPerPixel, 1).first();
+    if (aggregate.count > 0)
     {
-      QString itemInfoText = this->model->getItemInfoText(index);
-      this->currentTooltip.setTextAndAnchor(itemInfoText, QPointF(double(index), 3));
-      this->currentTooltip.setZValue(11);
-      this->currentTooltip.show();
+      text = QString("Entries %1-%2\n").arg(int(first)).arg(int(first) + aggregate.count - 1);
+      text += QString("Min: %1\nAvg: %2\nMax: %3").arg(aggregate.min).arg(aggregate.average(), 0, 'f', 0).arg(aggregate.max);
+      if (aggregate.marked)
+        text += "\nContains picture hash mismatches";
     }
   }
+
+  if (text.isEmpty())
+    QToolTip::hideText();
   else
-    this->currentTooltip.hide();
+    QToolTip::showText(event->globalPos(), text, this);
 }
 
-void BitrateBarChart::onRowsInserted(const QModelIndex &parent, int first, int last)
+void BitrateBarChart::paintEvent(QPaintEvent *event)
 {
-  Q_UNUSED(parent);
-  Q_UNUSED(first);
-  Q_UNUSED(last);
+  Q_UNUSED(event);
 
-  if (!this->barMapper.isNull())
+  QPainter painter(this);
+  painter.fillRect(this->rect(), this->palette().base());
+
+  const QRect plotRect = this->getPlotRect();
+  const int nrEntries = this->getNumberOfEntries();
+  if (!this->model || nrEntries == 0 || plotRect.width() <= 0 || plotRect.height() <= 0)
   {
-    this->axisY->setMax(this->model->getMaximumBitrateValue() * 1.05);
-    this->barMapper->setRowCount(this->model->rowCount());
-    this->updateScrollBarRange();
+    painter.drawText(this->rect(), Qt::AlignCenter, "No data");
+    return;
   }
-}
 
-void BitrateBarChart::resizeEvent(QResizeEvent *event)
-{
-  Q_UNUSED(event);
-  this->updateScrollBarRange();
-  this->updateAxis();
-}
+  const int first = this->scrollBar->value();
+  const bool aggregated = this->pixelsPerBar < minPixelsPerBar;
 
-void BitrateBarChart::updateAxis()
-{
-  if (this->axisX.isNull())
-    return;
+  // Get the values to draw. In bar mode, also get the entries around the visible range for the average.
+  QVector<parserCommon::BitrateItemModel::bitrateAggregate> values;
+  int valuesStart = first;
+  int nrVisible;
+  if (aggregated)
+  {
+    nrVisible = plotRect.width();
+    values = this->model->getAggregates(first, 1.0 / this->pixelsPerBar, nrVisible);
+  }
+  else
+  {
+    nrVisible = qMin(nrEntries - first, int(std::ceil(plotRect.width() / this->pixelsPerBar)) + 1);
+    valuesStart = qMax(0, first - averageRange);
+    const int valuesEnd = qMin(nrEntries, first + nrVisible + averageRange);
+    values = this->model->getAggregates(valuesStart, 1.0, valuesEnd - valuesStart);
+  }
+  const int visibleOffset = first - valuesStart;
+
+  unsigned int maxValue = 0;
+  for (int i = 0; i < nrVisible && visibleOffset + i < values.size(); i++)
+    if (values[visibleOffset + i].count > 0)
+      maxValue = qMax(maxValue, values[visibleOffset + i].max);
+  const double yMax = qMax(1.0, maxValue * 1.05);
+  auto yPos = [&plotRect, yMax](double value) { return plotRect.bottom() - value / yMax * plotRect.height(); };
 
-  const auto plotWidth = this->chart.plotArea().width();
-  double barsVisible = plotWidth / 100 * this->barsPerWidthOf100Pixels;
+  this->drawAxes(painter, plotRect, first, yMax);
+
+  painter.save();
+  painter.setClipRect(plotRect);
+  QPolygonF averageLine;
+  if (aggregated)
+  {
+    // Each pixel column shows the range from the minimum to the maximum and the average of its entries
+    const QColor colorBelowMin = colorNonKeyframe.lighter(150);
+    for (int x = 0; x < nrVisible; x++)
+    {
+      const auto &bucket = values[x];
+      if (bucket.count == 0)
+        continue;
+      const double xPos = plotRect.left() + x + 0.5;
+      painter.setPen(colorBelowMin);
+      painter.drawLine(QPointF(xPos, plotRect.bottom()), QPointF(xPos, yPos(bucket.min)));
+      painter.setPen(bucket.marked ? colorMarked : colorNonKeyframe);
+      painter.drawLine(QPointF(xPos, yPos(bucket.min)), QPointF(xPos, yPos(bucket.max)));
+      averageLine.append(QPointF(xPos, yPos(bucket.average())));
+    }
+  }
+  else
+  {
+    // The moving average uses a running sum over the fetched values
+    QVector<uint64_t> sums(values.size() + 1, 0);
+    for (int i = 0; i < values.size(); i++)
+      sums[i + 1] = sums[i] + values[i].sum;
+
+    const double barWidth = this->pixelsPerBar >= 4 ? this->pixelsPerBar - 1 : this->pixelsPerBar;
+    for (int i = 0; i < nrVisible; i++)
+    {
+      const int idx = visibleOffset + i;
+      const auto &bar = values[idx];
+      if (bar.count == 0)
+        continue;
+      const double xPos = plotRect.left() + i * this->pixelsPerBar;
+      const QColor color = bar.marked ? colorMarked : (bar.keyframe ? colorKeyframe : colorNonKeyframe);
+      painter.fillRect(QRectF(xPos, yPos(bar.max), barWidth, plotRect.bottom() - yPos(bar.max)), color);
+
+      const int avgStart = qMax(0, idx - averageRange);
+      const int avgEnd = qMin(values.size(), idx + averageRange);
+      averageLine.append(QPointF(xPos + barWidth / 2, yPos(double(sums[avgEnd] - sums[avgStart]) / (avgEnd - avgStart))));
+    }
+  }
+  painter.setPen(QPen(colorAverage, 2));
+  painter.drawPolyline(averageLine);
+  painter.restore();
 
-  auto currentScrollBarValue = this->scrollBar->value();
-  double v = double(currentScrollBarValue) / scrollBarScale;
-  this->axisX->setRange(v - 0.5, v + barsVisible - 0.5);
-#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
-  this->axisX->setTickType(QValueAxis::TicksDynamic);
-  this->axisX->setTickInterval(5.0);
-#endif
+  this->drawLegend(painter, plotRect);
 }
 
-void BitrateBarChart::updateScrollBarRange()
+void BitrateBarChart::drawAxes(QPainter &painter, const QRect &plotRect, double firstEntry, double maxValue) const
 {
-  if (this->barMapper.isNull())
-    return;
+  const QColor gridColor = this->palette().mid().color();
+  const QColor textColor = this->palette().text().color();
+  const int textHeight = painter.fontMetrics().height();
 
-  const auto plotWidth = this->chart.plotArea().width();
-  const double barsVisible = plotWidth / 100 * this->barsPerWidthOf100Pixels;
+  // Y axis with horizontal grid lines
+  const double yStep = getNiceStep(maxValue / qMax(1, plotRect.height() / (3 * textHeight)));
+  for (double value = 0; value <= maxValue; value += yStep)
+  {
+    const int y = int(plotRect.bottom() - value / maxValue * plotRect.height());
+    painter.setPen(gridColor);
+    painter.drawLine(plotRect.left(), y, plotRect.right(), y);
+    painter.setPen(textColor);
+    painter.drawText(QRect(0, y - textHeight / 2, axisMarginLeft - 5, textHeight), Qt::AlignRight | Qt::AlignVCenter, QString::number(value));
+  }
 
-  auto nrRows = this->barMapper->model()->rowCount();
-  auto maxValue = scrollBarScale * nrRows - int(barsVisible * scrollBarScale);
-  if (maxValue <= 0)
-    this->scrollBar->setEnabled(false);
-  else
+  // X axis (the entry index) with tick marks about every 100 pixels
+  const double visibleEntries = plotRect.width() / this->pixelsPerBar;
+  const double xStep = qMax(1.0, getNiceStep(visibleEntries / qMax(1, plotRect.width() / 100)));
+  painter.setPen(textColor);
+  painter.drawLine(plotRect.bottomLeft(), plotRect.bottomRight());
+  for (double entry = std::ceil(firstEntry / xStep) * xStep; entry <= firstEntry + visibleEntries; entry += xStep)
   {
-    QSignalBlocker scrollBarSignalBlocker(this->scrollBar);
-    this->scrollBar->setEnabled(true);
-    this->scrollBar->setMinimum(0);
-    this->scrollBar->setMaximum(maxValue);
+    // In bar mode, the tick is at the center of the bar
+    const double center = this->pixelsPerBar >= minPixelsPerBar ? 0.5 : 0.0;
+    const int x = int(plotRect.left() + (entry - firstEntry + center) * this->pixelsPerBar);
+    if (x > plotRect.right())
+      break;
+    painter.drawLine(x, plotRect.bottom(), x, plotRect.bottom() + 3);
+    painter.drawText(QRect(x - 50, plotRect.bottom() + 4, 100, textHeight), Qt::AlignHCenter | Qt::AlignTop, QString::number(qint64(entry)));
+  }
+}
+
+void BitrateBarChart::drawLegend(QPainter &painter, const QRect &plotRect) const
+{
+  const QList<QPair<QColor, QString>> legend = QList<QPair<QColor, QString>>()
+    << qMakePair(colorNonKeyframe, QString("Bitrate Non-Keyframe"))
+    << qMakePair(colorKeyframe, QString("Bitrate Keyframe"))
+    << qMakePair(colorMarked, QString("Hash Mismatch"))
+    << qMakePair(colorAverage, QString("Average"));
+
+  const int textHeight = painter.fontMetrics().height();
+  int legendWidth = 0;
+  for (const auto &item : legend)
+    legendWidth = qMax(legendWidth, painter.fontMetrics().width(item.second));
+  legendWidth += textHeight + 15;
+
+  QRect legendRect(plotRect.right() - legendWidth - 5, plotRect.top() + 5, legendWidth, legend.size() * textHeight + 10);
+  painter.setPen(this->palette().mid().color());
+  painter.setBrush(this->palette().base());
+  painter.drawRect(legendRect);
+
+  int y = legendRect.top() + 5;
+  for (const auto &item : legend)
+  {
+    painter.fillRect(QRect(legendRect.left() + 5, y + 2, textHeight - 4, textHeight - 4), item.first);
+    painter.setPen(this->palette().text().color());
+    painter.drawText(QRect(legendRect.left() + textHeight + 8, y, legendWidth - textHeight - 8, textHeight), Qt::AlignLeft | Qt::AlignVCenter, item.second);
+    y += textHeight;
   }
 }
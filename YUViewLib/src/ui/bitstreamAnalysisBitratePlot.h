@@ -34,35 +34,16 @@
 
 #include "parser/parserCommon.h"
 
-#include <QtWidgets/QGraphicsItem>
-#include <QtCharts/QBarSet>
-#include <QtCharts/QChart>
-#include <QtCharts/QChartView>
 #include <QtCore/QPointer>
-#include <QtCharts/QVBarModelMapper>
-#include <QtCharts/QVXYModelMapper>
-#include <QtWidgets/QWidget>
 #include <QtWidgets/QScrollBar>
-#include <QtCharts/QValueAxis>
-
-class BitrateBarChartCallout : public QGraphicsItem
-{
-public:
-  BitrateBarChartCallout();
-  void setChart(QtCharts::QChart *chart);
-  QRectF boundingRect() const override;
-
-  void setTextAndAnchor(const QString &text, QPointF anchor);
-  void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
-
-private:
-  QString text;
-  QRectF textRect;
-  QRectF rect;
-  QPointF anchor;
-  QtCharts::QChart *chart{ nullptr };
-};
+#include <QtWidgets/QWidget>
 
+/* The bitrate plot of the bitstream analysis. The bars are painted directly from the aggregates of the
+ * BitrateItemModel. Only the visible range is drawn. When zoomed out so far that there is less than one
+ * pixel per bar, each pixel column shows the minimum, maximum and average of all entries in it (which the
+ * model provides from a pyramid). This way, the plot stays interactive for millions of entries.
+ * Use the mouse wheel to zoom and the scroll bar to move.
+ */
 class BitrateBarChart : public QWidget
 {
   Q_OBJECT
@@ -73,30 +54,28 @@ public:
 
 private slots:
   void onScrollBarValueChanged(int value);
-  void tooltip(bool status, int index, QtCharts::QBarSet *barset);
   void onRowsInserted(const QModelIndex &parent, int first, int last);
 
-private:
-  QPointer<QtCharts::QChartView> chartView;
-  QPointer<QScrollBar> scrollBar;
-
-  QPointer<QtCharts::QVBarModelMapper> barMapper;
-  QPointer<QtCharts::QVXYModelMapper> lineModelMapper;
-  QPointer<QtCharts::QValueAxis> axisX;
-  QPointer<QtCharts::QValueAxis> axisY;
-  
-  QtCharts::QChart chart;
-
-  QPointer<parserCommon::BitrateItemModel> model;
-
-  BitrateBarChartCallout currentTooltip;
-
 protected:
+  void paintEvent(QPaintEvent *event) override;
   void resizeEvent(QResizeEvent *event) override;
+  void wheelEvent(QWheelEvent *event) override;
+  void mouseMoveEvent(QMouseEvent *event) override;
 
-  void updateAxis();
+  // The area that the bars are drawn in (without the axes and the scroll bar)
+  QRect getPlotRect() const;
+  int getNumberOfEntries() const;
+  double getVisibleEntries() const;
   void updateScrollBarRange();
+  void zoom(double factor, int anchorX);
+
+  void drawAxes(QPainter &painter, const QRect &plotRect, double firstEntry, double maxValue) const;
+  void drawLegend(QPainter &painter, const QRect &plotRect) const;
 
-  double barsPerWidthOf100Pixels{ 8.0 };
-  double maxYValue{ 0 };
-};
\ No newline at end of file
+private:
+  QPointer<QScrollBar> scrollBar;
+  QPointer<parserCommon::BitrateItemModel> model;
+
+  // The zoom factor. Below a certain size, the bars are aggregated.
+  double pixelsPerBar {12.5};
+};
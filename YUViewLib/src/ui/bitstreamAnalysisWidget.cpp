@@ -37,6 +37,7 @@
 #include "parser/parserAnnexBVVC.h"
 #include "parser/parserAnnexBMpeg2.h"
 #include "parser/parserAVFormat.h"
+#include "parser/parserTransportStream.h"
 
 #define BITSTREAM_ANALYSIS_WIDGET_DEBUG_OUTPUT 0
 #if BITSTREAM_ANALYSIS_WIDGET_DEBUG_OUTPUT
@@ -58,6 +59,7 @@ BitstreamAnalysisWidget::BitstreamAnalysisWidget(QWidget *parent) :
   this->connect(this->ui.showStreamComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &BitstreamAnalysisWidget::showOnlyStreamComboBoxIndexChanged);
   this->connect(this->ui.colorCodeStreamsCheckBox, &QCheckBox::toggled, this, &BitstreamAnalysisWidget::colorCodeStreamsCheckBoxToggled);
   this->connect(this->ui.parseEntireFileCheckBox, &QCheckBox::toggled, this, &BitstreamAnalysisWidget::parseEntireBitstreamCheckBoxToggled);
+  this->connect(this->ui.pidFilterLineEdit, &QLineEdit::editingFinished, this, &BitstreamAnalysisWidget::pidFilterEditingFinished);
   this->connect(this->ui.bitratePlotOrderComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &BitstreamAnalysisWidget::bitratePlotOrderComboBoxIndexChanged);
 
   this->currentSelectedItemsChanged(nullptr, nullptr, false);
@@ -74,6 +76,8 @@ void BitstreamAnalysisWidget::updateStreamInfo()
   this->ui.streamInfoTreeWidget->clear();
   this->ui.streamInfoTreeWidget->addTopLevelItems(this->parser->getStreamInfo());
   this->ui.streamInfoTreeWidget->expandAll();
+  // The bitrate analytics can be long (e.g. the size distributions) so they are not expanded
+  this->ui.streamInfoTreeWidget->addTopLevelItems(this->parser->getBitrateItemModel()->getAnalyticsInfo());
 
   if (this->ui.showStreamComboBox->count() + 1 != int(this->parser->getNrStreams()))
   {
@@ -110,12 +114,37 @@ void BitstreamAnalysisWidget::bitratePlotOrderComboBoxIndexChanged(int index)
   if (this->parser)
   {
     this->parser->setBitrateSortingIndex(index);
-    // Note: This was the only way I found to update the bar graph. None of the emit signal ways worked.
-    this->ui.bitrateBarChart->setModel(nullptr);
-    this->ui.bitrateBarChart->setModel(this->parser->getBitrateItemModel());
+    this->ui.bitrateBarChart->update();
   }
 }
 
+void BitstreamAnalysisWidget::pidFilterEditingFinished()
+{
+  const QList<int> newFilter = parserTransportStream::parsePIDList(this->ui.pidFilterLineEdit->text());
+
+  // Show the PIDs that are actually used
+  QStringList pidStrings;
+  for (int pid : newFilter)
+    pidStrings.append(QString::number(pid));
+  this->ui.pidFilterLineEdit->setText(pidStrings.join(", "));
+
+  if (newFilter == this->pidFilter)
+    return;
+  this->pidFilter = newFilter;
+  this->restartParsingOfCurrentItem();
+}
+
+void BitstreamAnalysisWidget::updatePictureHashMarkers()
+{
+  if (!this->parser || this->currentCompressedVideo.isNull())
+    return;
+
+  // The bitrate entries of the parsed AnnexB streams use the POC as PTS
+  if (!this->parser->getBitrateItemModel()->setMarkedPTS(this->currentCompressedVideo->getPictureHashMismatchPOCs()))
+    return;
+  this->ui.bitrateBarChart->update();
+}
+
 void BitstreamAnalysisWidget::updateParsingStatusText(int progressValue)
 {
   if (progressValue <= -1)
@@ -156,7 +185,11 @@ void BitstreamAnalysisWidget::currentSelectedItemsChanged(playlistItem *item1, p
   Q_UNUSED(item2);
   Q_UNUSED(chageByPlayback);
 
+  if (this->currentCompressedVideo)
+    this->disconnect(this->currentCompressedVideo.data(), &playlistItemCompressedVideo::signalPictureHashResultsChanged, this, &BitstreamAnalysisWidget::updatePictureHashMarkers);
   this->currentCompressedVideo = dynamic_cast<playlistItemCompressedVideo*>(item1);
+  if (this->currentCompressedVideo)
+    this->connect(this->currentCompressedVideo.data(), &playlistItemCompressedVideo::signalPictureHashResultsChanged, this, &BitstreamAnalysisWidget::updatePictureHashMarkers);
   this->ui.streamInfoTreeWidget->clear();
 
   const bool isBitstream = !this->currentCompressedVideo.isNull();
@@ -164,6 +197,15 @@ void BitstreamAnalysisWidget::currentSelectedItemsChanged(playlistItem *item1, p
   this->ui.tabPacketAnalysis->setEnabled(isBitstream);
   this->ui.tabBitrateGraphicsView->setEnabled(isBitstream);
 
+  // The PID filter only applies to transport streams. It is reset for every new item.
+  const bool isTransportStream = isBitstream && this->currentCompressedVideo->getInputFormat() == inputLibavformat && parserTransportStream::isTransportStreamFile(this->currentCompressedVideo->getName());
+  this->pidFilter.clear();
+  {
+    const QSignalBlocker blocker(this->ui.pidFilterLineEdit);
+    this->ui.pidFilterLineEdit->clear();
+  }
+  this->ui.pidFilterLineEdit->setVisible(isTransportStream);
+
   this->restartParsingOfCurrentItem();
 }
 
@@ -188,12 +230,13 @@ void BitstreamAnalysisWidget::restartParsingOfCurrentItem()
     return;
   }
 
-  this->createAndConnectNewParser(this->currentCompressedVideo->getInputFormat());
+  this->createAndConnectNewParser(this->currentCompressedVideo->getInputFormat(), this->currentCompressedVideo->getName());
 
   this->ui.dataTreeView->setModel(this->parser->getPacketItemModel());
   this->ui.dataTreeView->setColumnWidth(0, 600);
   this->ui.dataTreeView->setColumnWidth(1, 100);
   this->ui.dataTreeView->setColumnWidth(2, 120);
+  this->parser->getBitrateItemModel()->setMarkedPTS(this->currentCompressedVideo->getPictureHashMismatchPOCs());
   this->ui.bitrateBarChart->setModel(this->parser->getBitrateItemModel());
 
   this->updateStreamInfo();
@@ -203,7 +246,7 @@ void BitstreamAnalysisWidget::restartParsingOfCurrentItem()
   DEBUG_ANALYSIS("BitstreamAnalysisWidget::restartParsingOfCurrentItem new parser created and started");
 }
 
-void BitstreamAnalysisWidget::createAndConnectNewParser(inputFormat inputFormatType)
+void BitstreamAnalysisWidget::createAndConnectNewParser(inputFormat inputFormatType, const QString &fileName)
 {
   Q_ASSERT_X(!this->parser, "BitstreamAnalysisWidget::restartParsingOfCurrentItem", "Error reinitlaizing parser. The current parser is not null.");
   if (inputFormatType == inputAnnexBHEVC)
@@ -213,7 +256,17 @@ void BitstreamAnalysisWidget::createAndConnectNewParser(inputFormat inputFormatT
   else if (inputFormatType == inputAnnexBAVC)
     this->parser.reset(new parserAnnexBAVC(this));
   else if (inputFormatType == inputLibavformat)
-    this->parser.reset(new parserAVFormat(this));
+  {
+    // Transport streams are demultiplexed natively which is much faster than reading them with libavformat
+    if (parserTransportStream::isTransportStreamFile(fileName))
+    {
+      auto tsParser = new parserTransportStream(this);
+      tsParser->setPIDFilter(this->pidFilter);
+      this->parser.reset(tsParser);
+    }
+    else
+      this->parser.reset(new parserAVFormat(this));
+  }
   this->parser->enableModel();
   const bool parsingLimitSet = !this->ui.parseEntireFileCheckBox->isChecked();
   this->parser->setParsingLimitEnabled(parsingLimitSet);
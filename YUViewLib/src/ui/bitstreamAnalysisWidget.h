@@ -62,7 +62,9 @@ private slots:
   void showOnlyStreamComboBoxIndexChanged(int index);
   void colorCodeStreamsCheckBoxToggled(bool state) { this->parser->setStreamColorCoding(state); }
   void parseEntireBitstreamCheckBoxToggled(bool state) { Q_UNUSED(state); this->restartParsingOfCurrentItem(); }
+  void pidFilterEditingFinished();
   void bitratePlotOrderComboBoxIndexChanged(int index);
+  void updatePictureHashMarkers();
 
 protected:
   void hideEvent(QHideEvent *event) override;
@@ -78,7 +80,7 @@ private:
   void stopAndDeleteParserBlocking();
 
   void restartParsingOfCurrentItem();
-  void createAndConnectNewParser(YUView::inputFormat inputFormatType);
+  void createAndConnectNewParser(YUView::inputFormat inputFormatType, const QString &fileName);
 
   QScopedPointer<parserBase> parser;
   QFuture<void> backgroundParserFuture;
@@ -88,6 +90,9 @@ private:
 
   // -1: Show all streams. Otherwise only show the given stream index.
   int showOnlyStream {-1};
+
+  // Only for transport streams: The PIDs of the elementary streams to demultiplex (all if empty)
+  QList<int> pidFilter;
 };
 
 #endif // BITSTREAMANALYSISDIALOG_H
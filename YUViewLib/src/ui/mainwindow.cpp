@@ -120,6 +120,7 @@ MainWindow::MainWindow(bool useAlternativeSources, QWidget *parent) : QMainWindo
   ui.displaySplitView->setPlaylistTreeWidget(ui.playlistTreeWidget);
   ui.displaySplitView->setVideoCache(cache.data());
   ui.cachingInfoWidget->setPlaylistAndCache(ui.playlistTreeWidget, cache.data());
+  tabifyDockWidget(ui.cachingInfoDock, ui.profilingInfoDock);
   separateViewWindow.splitView.setPlaybackController(ui.playbackController);
   separateViewWindow.splitView.setPlaylistTreeWidget(ui.playlistTreeWidget);
 
@@ -249,6 +250,7 @@ void MainWindow::createMenusAndActions()
   addDockViewAction(ui.propertiesDock, "Show &Properties", Qt::CTRL + Qt::Key_P);
   addDockViewAction(ui.fileInfoDock, "Show &Info", Qt::CTRL + Qt::Key_I);
   addDockViewAction(ui.cachingInfoDock, "Show Caching Info");
+  addDockViewAction(ui.profilingInfoDock, "Show Profiling Info");
   viewMenu->addSeparator();
   addDockViewAction(ui.playbackControllerDock, "Show Playback &Controls", Qt::CTRL + Qt::Key_D);
   ui.displaySplitView->addMenuActions(viewMenu);
@@ -492,6 +494,8 @@ void MainWindow::toggleFullscreen()
       ui.fileInfoDock->show();
     if (panelsVisible[4])
       ui.cachingInfoDock->show();
+    if (panelsVisible[5])
+      ui.profilingInfoDock->show();
 
     if (!is_Q_OS_MAC)
       ui.menuBar->show();
@@ -512,6 +516,7 @@ void MainWindow::toggleFullscreen()
     panelsVisible[2] = ui.playbackControllerDock->isVisible();
     panelsVisible[3] = ui.fileInfoDock->isVisible();
     panelsVisible[4] = ui.cachingInfoDock->isVisible();
+    panelsVisible[5] = ui.profilingInfoDock->isVisible();
 
     // Hide panels
     ui.propertiesDock->hide();
@@ -521,6 +526,7 @@ void MainWindow::toggleFullscreen()
       ui.playbackControllerDock->hide();
     ui.fileInfoDock->hide();
     ui.cachingInfoDock->hide();
+    ui.profilingInfoDock->hide();
 
     if (!is_Q_OS_MAC)
       ui.menuBar->hide();
@@ -740,6 +746,7 @@ void MainWindow::resetWindowLayout()
   ui.playbackControllerDock->setFloating(false);
   ui.fileInfoDock->setFloating(false);
   ui.cachingInfoDock->setFloating(false);
+  ui.profilingInfoDock->setFloating(false);
 
   // show the menu bar
   if (!is_Q_OS_MAC)
@@ -748,6 +755,9 @@ void MainWindow::resetWindowLayout()
   // Reset main window state (the size and position of the dock widgets). The code to obtain this raw value is above.
   QByteArray mainWindowState = QByteArray::fromHex("000000ff00000000fd00000003000000000000011600000348fc0200000003fb000000240070006c00610079006c0069007300740044006f0063006b005700690064006700650074010000001500000212000000c000fffffffb0000001800660069006c00650049006e0066006f0044006f0063006b010000022b000000840000005b00fffffffb0000002000630061006300680069006e0067004400650062007500670044006f0063006b01000002b3000000aa000000aa00ffffff00000001000000b900000348fc0200000002fb0000001c00700072006f00700065007200740069006500730044006f0063006b0100000015000002670000002d00fffffffb000000220064006900730070006c006100790044006f0063006b0057006900640067006500740100000280000000dd000000dd0007ffff000000030000048f00000032fc0100000001fb0000002c0070006c00610079006200610063006b0043006f006e00740072006f006c006c006500720044006f0063006b01000000000000048f000001460007ffff000002b80000034800000004000000040000000800000008fc00000000");
   restoreState(mainWindowState);
+  // The profiling panel is not part of the default layout
+  tabifyDockWidget(ui.cachingInfoDock, ui.profilingInfoDock);
+  ui.profilingInfoDock->hide();
 
   // Set the size/position of the main window
   setGeometry(0, 0, 1100, 750);
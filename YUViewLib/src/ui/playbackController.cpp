@@ -32,10 +32,13 @@
 
 #include "playbackController.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <QSettings>
 
 #include "playlistitem/playlistItem.h"
 #include "common/functions.h"
+#include "common/performanceProfiler.h"
 #include "common/typedef.h"
 
 // Activate this if you want to know when which buffer is loaded/converted to image and so on.
@@ -46,6 +49,9 @@
 #define DEBUG_PLAYBACK(fmt,...) ((void)0)
 #endif
 
+// The playback timer only has a resolution of milliseconds. A frame is shown if it is due within this time.
+#define PRESENTATION_TOLERANCE_NS 500000
+
 PlaybackController::PlaybackController()
 {
   setupUi(this);
@@ -64,9 +70,17 @@ PlaybackController::PlaybackController()
   // Initialize variables
   currentFrameIdx = -1;
   lastValidFrameIdx = -1;
-  timerInterval = -1;
   timerFPSCounter = 0;
-  timerLastFPSTime = QTime::currentTime();
+  timerLastFPSTimeNs = 0;
+  timerStaticItemCountDown = -1;
+  frameDurationNs = 0;
+  nextPresentationNs = 0;
+  stalledPresentationNs = -1;
+  dropLateFrames = false;
+  nrDroppedFrames = 0;
+  nrStalls = 0;
+  maxPresentationDelayNs = 0;
+  playbackClock.start();
   playbackMode = PlaybackStopped;
   playbackWasStalled = false;
   waitingForItem[0] = false;
@@ -127,6 +141,9 @@ void PlaybackController::on_playPauseButton_clicked()
   {
     // Playback is not running. Start it.
     DEBUG_PLAYBACK("PlaybackController::on_playPauseButton_clicked Start");
+    nrDroppedFrames = 0;
+    nrStalls = 0;
+    maxPresentationDelayNs = 0;
     if (currentFrameIdx >= frameSlider->maximum() && repeatMode == RepeatModeOff)
     {
       // We are currently at the end of the sequence and the user pressed play.
@@ -185,32 +202,69 @@ void PlaybackController::startPlayback()
 
 void PlaybackController::startOrUpdateTimer()
 {
-  // Get the frame rate of the current item. Lower limit is 0.01 fps (100 seconds per frame).
-  if (currentItem[0]->isIndexedByFrame() || (currentItem[1] && currentItem[1]->isIndexedByFrame()))
+  if (isItemIndexedByFrameSelected())
   {
-    // One (of the possibly two items) is indexed by frame. Get and set the frame rate
-    double frameRate = currentItem[0]->isIndexedByFrame() ? currentItem[0]->getFrameRate() : currentItem[1]->getFrameRate();
-    if (frameRate < 0.01)
-      frameRate = 0.01;
+    // One (of the possibly two items) is indexed by frame. The next frame is due one frame duration from now.
     timerStaticItemCountDown = -1;
-    timerInterval = 1000.0 / frameRate;
-    DEBUG_PLAYBACK("PlaybackController::startOrUpdateTimer framerate %f", frameRate);
+    frameDurationNs = getFrameDurationNs();
+    nextPresentationNs = playbackClock.nsecsElapsed() + frameDurationNs;
+    DEBUG_PLAYBACK("PlaybackController::startOrUpdateTimer frame duration %lld ns", frameDurationNs);
+    scheduleNextFrame();
   }
   else
   {
     // The item (or both items) are not indexed by frame.
     // Use the duration of item 0
-    timerInterval = int(1000 / 10);
     timerStaticItemCountDown = currentItem[0]->getDuration() * 10;
-    DEBUG_PLAYBACK("PlaybackController::startOrUpdateTimer duration %d", timerInterval);
+    DEBUG_PLAYBACK("PlaybackController::startOrUpdateTimer duration %d", timerStaticItemCountDown);
+    timer.start(1000 / 10, Qt::PreciseTimer, this);
   }
-  
-  timer.start(timerInterval, Qt::PreciseTimer, this);
+
   playbackMode = PlaybackRunning;
-  timerLastFPSTime = QTime::currentTime();
+  timerLastFPSTimeNs = playbackClock.nsecsElapsed();
   timerFPSCounter = 0;
 }
 
+bool PlaybackController::isItemIndexedByFrameSelected() const
+{
+  return (currentItem[0] && currentItem[0]->isIndexedByFrame()) || (currentItem[1] && currentItem[1]->isIndexedByFrame());
+}
+
+qint64 PlaybackController::getFrameDurationNs() const
+{
+  // Get the frame rate of the current item. Lower limit is 0.01 fps (100 seconds per frame). This is also
+  // the fallback if no item that is indexed by frame is selected.
+  double frameRate = 0;
+  if (currentItem[0] && currentItem[0]->isIndexedByFrame())
+    frameRate = currentItem[0]->getFrameRate();
+  else if (currentItem[1] && currentItem[1]->isIndexedByFrame())
+    frameRate = currentItem[1]->getFrameRate();
+  if (frameRate < 0.01)
+    frameRate = 0.01;
+  return qint64(1e9 / frameRate);
+}
+
+void PlaybackController::scheduleNextFrame()
+{
+  // Round down to milliseconds. If the timer fires too early, the remaining time is waited for again.
+  const qint64 remainingNs = nextPresentationNs - playbackClock.nsecsElapsed();
+  timer.start(int(std::max(remainingNs / 1000000, qint64(0))), Qt::PreciseTimer, this);
+}
+
+void PlaybackController::addPresentationDelay(qint64 delayNs)
+{
+  // The frame may also be shown a bit too early
+  delayNs = std::abs(delayNs);
+  maxPresentationDelayNs = std::max(maxPresentationDelayNs, delayNs);
+
+  performanceProfiler &profiler = performanceProfiler::instance();
+  if (profiler.isEnabled())
+  {
+    performanceProfiler::scopedItem profilerItem(currentItem[0]->getName());
+    profiler.addMeasurement(performanceProfiler::stagePresentationDelay, profiler.getTimestampNs() - delayNs, delayNs);
+  }
+}
+
 void PlaybackController::nextFrame()
 {
   // Abort playback (if running) and go to the next frame (if possible).
@@ -264,6 +318,7 @@ void PlaybackController::currentSelectedItemsChanged(playlistItem *item1, playli
   {
     // No item selected or the selected item(s) is/are not indexed by a frame (there is no navigation in the item)
     enableControls(false);
+    frameSlider->setMarkedFrames(QList<int>());
 
     // Save the last valid frame index. Now the frame index is invalid.
     if (currentFrameIdx != -1)
@@ -379,6 +434,7 @@ void PlaybackController::updateSettings()
   bool caching = settings.value("Enabled", true).toBool();
   bool wait = settings.value("PlaybackPauseCaching", false).toBool();
   waitForCachingOfItem = caching && wait;
+  dropLateFrames = settings.value("PlaybackDropFrames", false).toBool();
 
   // Load the icons for the buttons
   iconPlay = functions::convertIcon(":img_play.png");
@@ -420,6 +476,12 @@ void PlaybackController::updateFrameRange()
   frameSpinBox->setMinimum(range.first);
   frameSpinBox->setMaximum(range.second);
 
+  // Mark the flagged frames (e.g. picture hash mismatches) of the selected items
+  QList<int> flaggedFrames = currentItem[0] ? currentItem[0]->getFlaggedFrames() : QList<int>();
+  if (currentItem[1])
+    flaggedFrames.append(currentItem[1]->getFlaggedFrames());
+  frameSlider->setMarkedFrames(flaggedFrames);
+
   DEBUG_PLAYBACK("PlaybackController::updateFrameRange - new range %d-%d", frameSlider->minimum(), frameSlider->maximum());
 }
 
@@ -476,6 +538,14 @@ void PlaybackController::timerEvent(QTimerEvent *event)
     return;
   }
 
+  // The timer may fire a bit too early because of its millisecond resolution
+  const qint64 nowNs = playbackClock.nsecsElapsed();
+  if (timerStaticItemCountDown < 0 && nowNs < nextPresentationNs - PRESENTATION_TOLERANCE_NS)
+  {
+    scheduleNextFrame();
+    return;
+  }
+
   int nextFrameIdx = getNextFrameIndex();
   if (nextFrameIdx == -1)
   {
@@ -528,10 +598,44 @@ void PlaybackController::timerEvent(QTimerEvent *event)
       timer.stop();
       playbackMode = PlaybackStalled;
       playbackWasStalled = true;
+      nrStalls++;
+      performanceProfiler::instance().incrementCounter("Playback stalls");
       DEBUG_PLAYBACK("PlaybackController::timerEvent playback stalled");
       return;
     }
 
+    // Frame pacing only applies to items that are indexed by frame. A static item (e.g. repeated with
+    // RepeatModeOne) is shown again when its count down ran out.
+    const bool pacing = isItemIndexedByFrameSelected() && frameDurationNs > 0;
+
+    // Record the delay against the original schedule. Dropping or waiting below rebases the schedule.
+    // After a stall, the delay is measured against the schedule from before the stall.
+    qint64 presentationNs = nextPresentationNs;
+    if (pacing)
+      addPresentationDelay(nowNs - ((stalledPresentationNs >= 0) ? stalledPresentationNs : presentationNs));
+
+    // Are we late by one frame duration or more?
+    if (pacing && nowNs - presentationNs >= frameDurationNs)
+    {
+      if (dropLateFrames)
+      {
+        // Skip the frames that should already have been shown (but not beyond the end of the sequence)
+        const int nrLateFrames = int((nowNs - presentationNs) / frameDurationNs);
+        const int nrDrop = std::max(std::min(nrLateFrames, frameSlider->maximum() - nextFrameIdx), 0);
+        DEBUG_PLAYBACK("PlaybackController::timerEvent dropping %d frames", nrDrop);
+        nextFrameIdx += nrDrop;
+        presentationNs += nrDrop * frameDurationNs;
+        nrDroppedFrames += nrDrop;
+        playbackWasStalled = playbackWasStalled || nrDrop > 0;
+        performanceProfiler::instance().incrementCounter("Playback dropped frames", nrDrop);
+      }
+      else
+        // Wait. The frames after this one are due relative to now.
+        presentationNs = nowNs;
+    }
+    if (pacing)
+      nextPresentationNs = presentationNs + frameDurationNs;
+
     // Go to the next frame and update the splitView
     DEBUG_PLAYBACK("PlaybackController::timerEvent next frame %d", nextFrameIdx);
     setCurrentFrame(nextFrameIdx);
@@ -540,34 +644,29 @@ void PlaybackController::timerEvent(QTimerEvent *event)
     timerFPSCounter++;
     if (timerFPSCounter >= 50)
     {
-      QTime newFrameTime = QTime::currentTime();
-      double msecsSinceLastUpdate = (double)timerLastFPSTime.msecsTo(newFrameTime);
-
       // Print the frames per second as float with one digit after the decimal dot.
-      double framesPerSec = (50 / (msecsSinceLastUpdate / 1000.0));
-      if (framesPerSec > 0)
-        fpsLabel->setText(QString::number(framesPerSec, 'f', 1));
+      const double secsSinceLastUpdate = (nowNs - timerLastFPSTimeNs) / 1e9;
+      if (secsSinceLastUpdate > 0)
+        fpsLabel->setText(QString::number(50 / secsSinceLastUpdate, 'f', 1));
       if (playbackWasStalled)
         fpsLabel->setStyleSheet("QLabel { background-color: yellow }");
       else
         fpsLabel->setStyleSheet("");
+      fpsLabel->setToolTip(QString("Dropped frames: %1\nStalls: %2\nMax. presentation delay: %3 ms").arg(nrDroppedFrames).arg(nrStalls).arg(maxPresentationDelayNs / 1e6, 0, 'f', 1));
       playbackWasStalled = false;
+      maxPresentationDelayNs = 0;
 
-      timerLastFPSTime = QTime::currentTime();
+      timerLastFPSTimeNs = nowNs;
       timerFPSCounter = 0;
     }
 
-    // Check if the time interval changed (the user changed the rate of the item)
-    if (currentItem[0]->isIndexedByFrame() || (currentItem[1] && currentItem[1]->isIndexedByFrame()))
+    // Check if the frame rate changed (the user changed the rate of the item)
+    if (pacing)
     {
-      // One (of the possibly two items) is indexed by frame. Get and set the frame rate
-      double frameRate = currentItem[0]->isIndexedByFrame() ? currentItem[0]->getFrameRate() : currentItem[1]->getFrameRate();
-      if (frameRate < 0.01)
-        frameRate = 0.01;
-
-      int newtimerInterval = 1000.0 / frameRate;
-      if (timerInterval != newtimerInterval)
+      if (getFrameDurationNs() != frameDurationNs)
         startOrUpdateTimer();
+      else
+        scheduleNextFrame();
     }
   }
 }
@@ -581,12 +680,14 @@ void PlaybackController::currentSelectedItemsDoubleBufferLoad(int itemID)
     if (!waitingForItem[0] && !waitingForItem[1])
     {
       // Playback was stalled because we were waiting for the double buffer to load.
-      // We can go on now.
-      DEBUG_PLAYBACK("PlaybackController::currentSelectedItemsDoubleBufferLoad - timer interval %d", timerInterval);
-      timer.start(timerInterval, Qt::PreciseTimer, this);
-      timerEvent(nullptr);
-      // Playback is not stalled anymore
+      // We can go on now. The frame that was just loaded is due now. Dropping frames only makes up for
+      // lateness of the pacing. Frames after the stall would not be loaded yet and cause the next stall.
+      DEBUG_PLAYBACK("PlaybackController::currentSelectedItemsDoubleBufferLoad - frame duration %lld ns", frameDurationNs);
       playbackMode = PlaybackRunning;
+      stalledPresentationNs = nextPresentationNs;
+      nextPresentationNs = playbackClock.nsecsElapsed();
+      timerEvent(nullptr);
+      stalledPresentationNs = -1;
     }
   }
 }
@@ -34,8 +34,8 @@
 #define PLAYBACKCONTROLLER_H
 
 #include <QBasicTimer>
+#include <QElapsedTimer>
 #include <QPointer>
-#include <QTime>
 #include <QWidget>
 
 #include "playlistTreeWidget.h"
@@ -175,14 +175,34 @@ private:
   // Before starting playback of an item, do we wait until caching is complete?
   bool waitForCachingOfItem;
 
-  // The timer for playback
+  // The timer for playback. For indexed items, the timer is started again for every frame so that it fires when
+  // the next frame is due (see scheduleNextFrame). For static items it runs with a fixed interval.
   QBasicTimer timer;
-  int    timerInterval;        // The current timer interval in milli seconds. If it changes, update the running timer.
-  int    timerFPSCounter;      // Every time the timer is toggled count this up. If it reaches 50, calculate FPS.
-  QTime  timerLastFPSTime;     // The last time we updated the FPS counter. Used to calculate new FPS.
+  int    timerFPSCounter;      // Every time a frame is shown count this up. If it reaches 50, calculate FPS.
+  qint64 timerLastFPSTimeNs;   // The last time we updated the FPS counter. Used to calculate new FPS.
   int    timerStaticItemCountDown; // Also for static items we run the timer to update the slider.
   virtual void timerEvent(QTimerEvent *event) Q_DECL_OVERRIDE; // Overloaded from QObject. Called when the timer fires.
 
+  // Frame pacing: While playing, the frames are due at fixed presentation times (one frame duration apart) which
+  // are measured with a monotonic high resolution clock. If playback can not keep up, we either wait (the following
+  // presentation times are moved) or we drop the frames whose presentation time has already passed.
+  QElapsedTimer playbackClock;
+  qint64 frameDurationNs;
+  qint64 nextPresentationNs;   // The presentation time of the next frame
+  qint64 stalledPresentationNs;  // While resuming from a stall: the presentation time before the stall (else -1)
+  bool   dropLateFrames;
+  void   scheduleNextFrame();
+  // The frame duration from the frame rate of the current item(s)
+  qint64 getFrameDurationNs() const;
+  // Is one of the (possibly two) selected items indexed by frame?
+  bool   isItemIndexedByFrameSelected() const;
+
+  // Timing telemetry of the current playback. This is also reported to the performanceProfiler.
+  int    nrDroppedFrames;
+  int    nrStalls;
+  qint64 maxPresentationDelayNs;  // Since the last update of the FPS counter
+  void   addPresentationDelay(qint64 delayNs);
+
   // We keep a pointer to the currently selected item(s)
   QPointer<playlistItem> currentItem[2];
 
@@ -42,6 +42,7 @@
 #include <QPainter>
 #include <QScopedValueRollback>
 #include <QSettings>
+#include <QTreeWidgetItemIterator>
 #include <QHeaderView>
 
 #include "playlistitem/playlistItems.h"
@@ -66,6 +67,17 @@ public:
     QPainter painter(this);
     QSize s = size();
 
+    if (plItem->isOpening())
+    {
+      // The item is still being opened in the background. Show the progress (if known).
+      const int progress = plItem->getOpeningProgress();
+      if (progress >= 0)
+        painter.fillRect(0, 0, s.width() * progress / 100, s.height(), QColor(200,200,200));
+      painter.drawText(0, 0, s.width(), s.height(), Qt::AlignCenter, (progress >= 0) ? QString("%1%").arg(progress) : QString("..."));
+      painter.drawRect(0, 0, s.width()-1, s.height()-1);
+      return;
+    }
+
     if (!plItem->isCachable())
     {
       // Only draw the border
@@ -137,6 +149,7 @@ PlaylistTreeWidget::PlaylistTreeWidget(QWidget *parent) : QTreeWidget(parent)
 
   connect(this, &PlaylistTreeWidget::itemSelectionChanged, this, &PlaylistTreeWidget::slotSelectionChanged);
   connect(&autosaveTimer, &QTimer::timeout, this, &PlaylistTreeWidget::autoSavePlaylist);
+  connect(&openingProgressTimer, &QTimer::timeout, this, &PlaylistTreeWidget::updateOpeningProgress);
 }
 
 PlaylistTreeWidget::~PlaylistTreeWidget()
@@ -356,11 +369,65 @@ void PlaylistTreeWidget::appendNewItem(playlistItem *item, bool emitplaylistChan
   setItemWidget(item, 1, new bufferStatusWidget(item, this));
   header()->resizeSection(1, 50);
 
+  // Open the item and all its children in the background (if they have to be opened)
+  startOpeningItem(item);
+
   // A new item was appended. The playlist changed.
   if (emitplaylistChanged)
     emit playlistChanged();
 }
 
+void PlaylistTreeWidget::startOpeningItem(playlistItem *item)
+{
+  for (int i = 0; i < item->childCount(); i++)
+  {
+    playlistItem *childItem = dynamic_cast<playlistItem*>(item->child(i));
+    if (childItem)
+      startOpeningItem(childItem);
+  }
+
+  if (!item->isOpening())
+    return;
+
+  connect(item, &playlistItem::signalItemOpened, this, &PlaylistTreeWidget::slotItemOpened, Qt::UniqueConnection);
+  item->startOpening();
+  if (!openingProgressTimer.isActive())
+    openingProgressTimer.start(250);
+}
+
+void PlaylistTreeWidget::slotItemOpened()
+{
+  // If the item (or a container that it is in) is selected, the properties and the file info have to be updated
+  auto items = getSelectedItems();
+  for (playlistItem *item = dynamic_cast<playlistItem*>(QObject::sender()); item != nullptr; item = item->parentPlaylistItem())
+  {
+    if (item == items[0] || item == items[1])
+    {
+      slotSelectionChanged();
+      break;
+    }
+  }
+}
+
+void PlaylistTreeWidget::updateOpeningProgress()
+{
+  // Redraw the buffer status of all items. Stop the timer when all items are opened.
+  bool itemsOpening = false;
+  for (QTreeWidgetItemIterator it(this); *it && !itemsOpening; ++it)
+  {
+    playlistItem *item = dynamic_cast<playlistItem*>(*it);
+    if (item && item->isOpening())
+      itemsOpening = true;
+  }
+  for (int i = 0; i < topLevelItemCount(); i++)
+  {
+    if (QWidget *w = itemWidget(topLevelItem(i), 1))
+      w->update();
+  }
+  if (!itemsOpening)
+    openingProgressTimer.stop();
+}
+
 void PlaylistTreeWidget::contextMenuEvent(QContextMenuEvent * event)
 {
   QMenu menu(this);
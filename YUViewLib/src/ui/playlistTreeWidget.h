@@ -173,6 +173,11 @@ protected slots:
   // forward this to the playbackController which might me waiting for this.
   void slotItemDoubleBufferLoaded();
 
+  // An item that was opened in the background is ready. If it is selected, update the properties/info.
+  void slotItemOpened();
+  // Redraw the progress of the items that are still being opened
+  void updateOpeningProgress();
+
 private:
 
   playlistItem* getDropTarget(const QPoint &pos) const;
@@ -196,6 +201,9 @@ private:
 
   // Append the new item at the end of the playlist and connect signals/slots
   void appendNewItem(playlistItem *item, bool emitplaylistChanged = true);
+  // Start opening the item and all its children in the background (if they need to be opened)
+  void startOpeningItem(playlistItem *item);
+  QTimer openingProgressTimer;
 
   // Clone the selected item as often as the user wants
   void cloneSelectedItem();
@@ -0,0 +1,189 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "profilingInfoWidget.h"
+
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSet>
+#include <QSettings>
+#include <QVBoxLayout>
+
+#include "common/performanceProfiler.h"
+
+// Update the shown values every 500ms
+#define PROFILINGINFOWIDGET_UPDATE_INTERVAL 500
+
+ProfilingInfoWidget::ProfilingInfoWidget(QWidget *parent) : QWidget(parent)
+{
+  recordCheckBox = new QCheckBox("Record", this);
+  recordCheckBox->setToolTip("Measure the time spent in each stage of loading and drawing frames. This has a small overhead.");
+  QPushButton *clearButton = new QPushButton("Clear", this);
+  QPushButton *exportButton = new QPushButton("Export Trace...", this);
+  exportButton->setToolTip("Save all recorded events as a Chrome trace (JSON) which can be opened in chrome://tracing or Perfetto.");
+
+  QHBoxLayout *buttonLayout = new QHBoxLayout;
+  buttonLayout->addWidget(recordCheckBox);
+  buttonLayout->addStretch(1);
+  buttonLayout->addWidget(clearButton);
+  buttonLayout->addWidget(exportButton);
+
+  stageTree = new QTreeWidget(this);
+  stageTree->setHeaderLabels(QStringList() << "Item / Stage" << "Count" << "p50 (ms)" << "p99 (ms)" << "Max (ms)" << "Total (ms)");
+  stageTree->setRootIsDecorated(true);
+  stageTree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+  summaryLabel = new QLabel(this);
+  summaryLabel->setWordWrap(true);
+  queueLabel = new QLabel(this);
+  queueLabel->setAlignment(Qt::AlignTop);
+
+  QVBoxLayout *mainLayout = new QVBoxLayout(this);
+  mainLayout->addLayout(buttonLayout);
+  mainLayout->addWidget(stageTree, 1);
+  mainLayout->addWidget(summaryLabel);
+  mainLayout->addWidget(queueLabel);
+  setLayout(mainLayout);
+
+  // Restore the recording state
+  QSettings settings;
+  const bool record = settings.value("Profiling/Record", false).toBool();
+  recordCheckBox->setChecked(record);
+  performanceProfiler::instance().setEnabled(record);
+
+  connect(recordCheckBox, &QCheckBox::toggled, this, &ProfilingInfoWidget::onRecordToggled);
+  connect(clearButton, &QPushButton::clicked, this, &ProfilingInfoWidget::onClearClicked);
+  connect(exportButton, &QPushButton::clicked, this, &ProfilingInfoWidget::onExportClicked);
+  connect(&updateTimer, &QTimer::timeout, this, &ProfilingInfoWidget::updateStatistics);
+}
+
+void ProfilingInfoWidget::showEvent(QShowEvent *event)
+{
+  updateStatistics();
+  updateTimer.start(PROFILINGINFOWIDGET_UPDATE_INTERVAL);
+  QWidget::showEvent(event);
+}
+
+void ProfilingInfoWidget::hideEvent(QHideEvent *event)
+{
+  updateTimer.stop();
+  QWidget::hideEvent(event);
+}
+
+void ProfilingInfoWidget::onRecordToggled(bool on)
+{
+  performanceProfiler::instance().setEnabled(on);
+  QSettings settings;
+  settings.setValue("Profiling/Record", on);
+}
+
+void ProfilingInfoWidget::onClearClicked()
+{
+  performanceProfiler::instance().clear();
+  updateStatistics();
+}
+
+void ProfilingInfoWidget::onExportClicked()
+{
+  QString fileName = QFileDialog::getSaveFileName(this, "Export Chrome Trace", QString(), "Chrome trace (*.json)");
+  if (fileName.isEmpty())
+    return;
+  if (!fileName.endsWith(".json", Qt::CaseInsensitive))
+    fileName += ".json";
+
+  if (!performanceProfiler::instance().exportChromeTrace(fileName))
+    QMessageBox::critical(this, "Error exporting trace", "The trace could not be written to the file " + fileName);
+}
+
+void ProfilingInfoWidget::updateStatistics()
+{
+  performanceProfiler &profiler = performanceProfiler::instance();
+  const QList<performanceProfiler::stageStatistics> statistics = profiler.getStageStatistics();
+
+  // Remember which items were collapsed so that updating does not change the tree
+  QSet<QString> collapsedItems;
+  for (int i = 0; i < stageTree->topLevelItemCount(); i++)
+    if (!stageTree->topLevelItem(i)->isExpanded())
+      collapsedItems.insert(stageTree->topLevelItem(i)->text(0));
+  stageTree->clear();
+
+  // The statistics are sorted by item name. Measurements that are not made for a specific item (e.g. painting)
+  // are shown as "View".
+  double ioTimeMs = 0;
+  double cpuTimeMs = 0;
+  QTreeWidgetItem *itemNode = nullptr;
+  for (const performanceProfiler::stageStatistics &s : statistics)
+  {
+    const QString itemName = s.itemName.isEmpty() ? "View" : s.itemName;
+    if (itemNode == nullptr || itemNode->text(0) != itemName)
+    {
+      itemNode = new QTreeWidgetItem(stageTree, QStringList() << itemName);
+      itemNode->setExpanded(!collapsedItems.contains(itemName));
+    }
+    QStringList values = QStringList() << performanceProfiler::getStageName(s.s) << QString::number(s.count);
+    values << QString::number(s.p50Ms, 'f', 2) << QString::number(s.p99Ms, 'f', 2) << QString::number(s.maxMs, 'f', 2) << QString::number(s.totalMs, 'f', 1);
+    new QTreeWidgetItem(itemNode, values);
+
+    // The copy of the decoded image is part of the decoding stage. The presentation delay is no work.
+    if (performanceProfiler::isIOStage(s.s))
+      ioTimeMs += s.totalMs;
+    else if (s.s != performanceProfiler::stageCopyDecodedImage && !performanceProfiler::isTimingStage(s.s))
+      cpuTimeMs += s.totalMs;
+  }
+
+  if (!profiler.isEnabled() && statistics.isEmpty())
+    summaryLabel->setText("Recording is off.");
+  else if (ioTimeMs + cpuTimeMs <= 0)
+    summaryLabel->setText("No measurements yet.");
+  else
+  {
+    const double ioPercent = ioTimeMs * 100 / (ioTimeMs + cpuTimeMs);
+    QString summary = QString("Time spent: I/O %1% - CPU %2%").arg(ioPercent, 0, 'f', 0).arg(100 - ioPercent, 0, 'f', 0);
+    if (ioPercent > 50)
+      summary += " (I/O bound)";
+    else
+      summary += " (CPU bound)";
+    summaryLabel->setText(summary);
+  }
+
+  QStringList queueText;
+  const QMap<QString, int> queueDepths = profiler.getQueueDepths();
+  for (auto it = queueDepths.constBegin(); it != queueDepths.constEnd(); ++it)
+    queueText.append(QString("%1: %2").arg(it.key()).arg(it.value()));
+  const QMap<QString, int> counters = profiler.getCounters();
+  for (auto it = counters.constBegin(); it != counters.constEnd(); ++it)
+    queueText.append(QString("%1: %2").arg(it.key()).arg(it.value()));
+  queueLabel->setText(queueText.join("\n"));
+}
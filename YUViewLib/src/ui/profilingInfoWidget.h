@@ -0,0 +1,73 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILINGINFOWIDGET_H
+#define PROFILINGINFOWIDGET_H
+
+#include <QCheckBox>
+#include <QLabel>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QWidget>
+
+/* The profiling info widget shows the statistics of the performanceProfiler: The p50/p99 durations
+ * of each stage (file read, decode, conversion ...) per item and the depths of the video cache queues.
+ * The recorded events can be exported as a Chrome trace.
+ */
+class ProfilingInfoWidget : public QWidget
+{
+  Q_OBJECT
+
+public:
+  ProfilingInfoWidget(QWidget *parent = 0);
+
+protected:
+  // Only update the statistics while the widget is visible
+  virtual void showEvent(QShowEvent *event) Q_DECL_OVERRIDE;
+  virtual void hideEvent(QHideEvent *event) Q_DECL_OVERRIDE;
+
+private slots:
+  void onRecordToggled(bool on);
+  void onClearClicked();
+  void onExportClicked();
+  void updateStatistics();
+
+private:
+  QCheckBox *recordCheckBox {nullptr};
+  QTreeWidget *stageTree {nullptr};
+  QLabel *summaryLabel {nullptr};
+  QLabel *queueLabel {nullptr};
+
+  QTimer updateTimer;
+};
+
+#endif // PROFILINGINFOWIDGET_H
@@ -45,6 +45,7 @@
 #include "decoder/decoderLibde265.h"
 #include "decoder/decoderVTM.h"
 #include "ffmpeg/FFMpegLibrariesHandling.h"
+#include "video/videoDiskCache.h"
 
 #define MIN_CACHE_SIZE_IN_MB (20u)
 
@@ -120,12 +121,17 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
   else
     ui.spinBoxNrThreads->setValue(functions::getOptimalThreadCount());
   ui.spinBoxNrThreads->setEnabled(ui.checkBoxNrThreads->isChecked());
+  ui.checkBoxAdaptiveBudget->setChecked(settings.value("AdaptiveBudget", true).toBool());
   // Playback
   ui.checkBoxPausPlaybackForCaching->setChecked(settings.value("PlaybackPauseCaching", true).toBool());
   bool playbackCaching = settings.value("PlaybackCachingEnabled", false).toBool();
   ui.checkBoxEnablePlaybackCaching->setChecked(playbackCaching);
   ui.spinBoxThreadLimit->setValue(settings.value("PlaybackCachingThreadLimit", 1).toInt());
   ui.spinBoxThreadLimit->setEnabled(playbackCaching);
+  ui.checkBoxPlaybackDropFrames->setChecked(settings.value("PlaybackDropFrames", false).toBool());
+  // Disk cache
+  ui.groupBoxDiskCache->setChecked(settings.value("DiskCacheEnabled", false).toBool());
+  ui.spinBoxDiskCacheSize->setValue(settings.value("DiskCacheSizeGB", 10).toInt());
   settings.endGroup();
 
   // "Decoders" tab
@@ -170,6 +176,12 @@ void SettingsDialog::on_checkBoxEnablePlaybackCaching_stateChanged(int state)
   ui.spinBoxThreadLimit->setEnabled(state != Qt::Unchecked);
 }
 
+void SettingsDialog::on_pushButtonClearDiskCache_clicked()
+{
+  if (QMessageBox::question(this, "Clear disk cache", "Do you really want to remove all frames from the disk cache?") == QMessageBox::Yes)
+    videoDiskCache::instance().clear();
+}
+
 void SettingsDialog::on_pushButtonEditBackgroundColor_clicked()
 {
   QColor currentColor = ui.frameBackgroundColor->getPlainColor();
@@ -378,9 +390,13 @@ void SettingsDialog::on_pushButtonSave_clicked()
   settings.setValue("ThresholdValueMB", getCacheSizeInMB());
   settings.setValue("SetNrThreads", ui.checkBoxNrThreads->isChecked());
   settings.setValue("NrThreads", ui.spinBoxNrThreads->value());
+  settings.setValue("AdaptiveBudget", ui.checkBoxAdaptiveBudget->isChecked());
   settings.setValue("PlaybackPauseCaching", ui.checkBoxPausPlaybackForCaching->isChecked());
   settings.setValue("PlaybackCachingEnabled", ui.checkBoxEnablePlaybackCaching->isChecked());
   settings.setValue("PlaybackCachingThreadLimit", ui.spinBoxThreadLimit->value());
+  settings.setValue("PlaybackDropFrames", ui.checkBoxPlaybackDropFrames->isChecked());
+  settings.setValue("DiskCacheEnabled", ui.groupBoxDiskCache->isChecked());
+  settings.setValue("DiskCacheSizeGB", ui.spinBoxDiskCacheSize->value());
   settings.endGroup();
 
   // "Decoders" tab
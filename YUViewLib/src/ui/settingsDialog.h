@@ -54,6 +54,7 @@ private slots:
   // Caching threads check box
   void on_checkBoxNrThreads_stateChanged(int newState);
   void on_checkBoxEnablePlaybackCaching_stateChanged(int state);
+  void on_pushButtonClearDiskCache_clicked();
 
   // Colors buttons
   void on_pushButtonEditBackgroundColor_clicked();
@@ -43,6 +43,7 @@
 #include <QTextDocument>
 #include <QDebug>
 
+#include "common/performanceProfiler.h"
 #include "playbackController.h"
 #include "playlistitem/playlistItem.h"
 #include "video/frameHandler.h"
@@ -128,6 +129,7 @@ void splitViewWidget::updateSettings()
 void splitViewWidget::paintEvent(QPaintEvent *paint_event)
 {
   Q_UNUSED(paint_event);
+  performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stagePaint);
 
   if (paletteNeedsUpdate)
   {
@@ -32,9 +32,10 @@
 
 #include "videoCacheInfoWidget.h"
 
+#include <algorithm>
+
 #include <QGroupBox>
 #include <QPainter>
-#include <QSettings>
 
 #define VIDEOCACHEINFOWIDGET_DEBUG_OUTPUT 0
 #if VIDEOCACHEINFOWIDGET_DEBUG_OUTPUT && !NDEBUG
@@ -92,17 +93,14 @@ void videoCacheStatusWidget::paintEvent(QPaintEvent *event)
   painter.drawRect(0, 0, width-1, height-1);
 }
 
-void videoCacheStatusWidget::updateStatus(PlaylistTreeWidget *playlist, unsigned int cacheRate)
+void videoCacheStatusWidget::updateStatus(PlaylistTreeWidget *playlist, int64_t cacheLevelMax, unsigned int cacheRate)
 {
   // Get all items from the playlist
   QList<playlistItem*> allItems = playlist->getAllPlaylistItems();
 
-  // Get if caching is enabled and how much memory we can use for the cache
-  QSettings settings;
-  settings.beginGroup("VideoCache");
-  cacheLevelMaxMB = settings.value("ThresholdValueMB", 49).toUInt();
-  const int64_t cacheLevelMax = cacheLevelMaxMB * 1000 * 1000;
-  settings.endGroup();
+  // The budget of the cache adapts to the memory usage of the items and the available memory
+  cacheLevelMaxMB = cacheLevelMax / 1000000;
+  cacheLevelMax = std::max(cacheLevelMax, int64_t(1));
 
   // Clear the old percent values
   relativeValsEnd.clear();
@@ -176,7 +174,7 @@ void VideoCacheInfoWidget::onUpdateCacheStatus()
   playlist->updateCachingStatus();
 
   DEBUG_CACHINGINFO("VideoCacheInfoWidget::updateCacheStatus");
-  statusWidget->updateStatus(playlist, cacheRateInBytesPerMs);
+  statusWidget->updateStatus(playlist, cache->getCacheLevelMax(), cacheRateInBytesPerMs);
 
   QStringList statusText = cache->getCacheStatusText();
   cachingInfoLabel->setText(statusText.join("\n"));
@@ -288,8 +288,15 @@ QImage frameHandler::calculateDifference(frameHandler *item2, const int frameIdx
   Q_UNUSED(frameIdxItem0);
   Q_UNUSED(frameIdxItem1);
 
-  int width  = qMin(frameSize.width(), item2->frameSize.width());
-  int height = qMin(frameSize.height(), item2->frameSize.height());
+  return calculateImageDifference(currentImage, item2->currentImage, differenceInfoList, amplificationFactor, markDifference);
+}
+
+QImage frameHandler::calculateImageDifference(const QImage &image0, const QImage &image1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference)
+{
+  int width  = qMin(image0.width(), image1.width());
+  int height = qMin(image0.height(), image1.height());
+  if (width <= 0 || height <= 0)
+    return QImage();
 
   QImage diffImg(width, height, functions::platformImageFormat());
 
@@ -300,8 +307,8 @@ QImage frameHandler::calculateDifference(frameHandler *item2, const int frameIdx
   {
     for (int x = 0; x < width; x++)
     {
-      QRgb pixel1 = getPixelVal(x, y);
-      QRgb pixel2 = item2->getPixelVal(x, y);
+      QRgb pixel1 = image0.pixel(x, y);
+      QRgb pixel2 = image1.pixel(x, y);
 
       int dR = int(qRed(pixel1)) - int(qRed(pixel2));
       int dG = int(qGreen(pixel1)) - int(qGreen(pixel2));
@@ -83,6 +83,9 @@ public:
   // function can be overloaded by more specialized video items. For example the videoHandlerYUV
   // overloads this and calculates the difference directly on the YUV values (if possible).
   virtual QImage calculateDifference(frameHandler *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference);
+  // Calculate the RGB difference of the two given images (of the top left aligned part that overlaps). This does not
+  // use any buffers of a frameHandler so it can be used from a caching thread.
+  static QImage calculateImageDifference(const QImage &image0, const QImage &image1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference);
   
   // Create the frame controls and return a pointer to the layout. This can be used by
   // inherited classes to create a properties widget.
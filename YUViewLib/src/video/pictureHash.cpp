@@ -0,0 +1,208 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pictureHash.h"
+
+#include <QCryptographicHash>
+#include <QStringList>
+
+using namespace YUV_Internals;
+
+namespace
+{
+
+// Read one sample from the plane. Samples with more than 8 bits are stored in two bytes.
+inline unsigned int getSample(const unsigned char *plane, int i, bool twoBytes, bool bigEndian)
+{
+  if (!twoBytes)
+    return plane[i];
+  if (bigEndian)
+    return (plane[2*i] << 8) + plane[2*i+1];
+  return plane[2*i] + (plane[2*i+1] << 8);
+}
+
+// The hashes are calculated over the samples of one component as specified in the
+// decoded picture hash SEI semantics. Samples with a bit depth above 8 contribute the low byte first.
+QByteArray calculateMD5(const unsigned char *plane, int width, int height, bool twoBytes, bool bigEndian)
+{
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  const int nrSamples = width * height;
+  if (!twoBytes || !bigEndian)
+  {
+    // The samples are already in the right order
+    hash.addData((const char*)plane, nrSamples * (twoBytes ? 2 : 1));
+    return hash.result();
+  }
+
+  QByteArray line(width * 2, 0);
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      const unsigned int val = getSample(plane, y * width + x, true, true);
+      line[2*x]   = char(val & 0xff);
+      line[2*x+1] = char(val >> 8);
+    }
+    hash.addData(line);
+  }
+  return hash.result();
+}
+
+QByteArray calculateCRC(const unsigned char *plane, int width, int height, bool twoBytes, bool bigEndian)
+{
+  unsigned int crc = 0xffff;
+  auto addByte = [&crc](unsigned int dataByte)
+  {
+    for (int bitIdx = 7; bitIdx >= 0; bitIdx--)
+    {
+      const unsigned int crcMsb = (crc >> 15) & 1;
+      const unsigned int bitVal = (dataByte >> bitIdx) & 1;
+      crc = (((crc << 1) + bitVal) & 0xffff) ^ (crcMsb * 0x1021);
+    }
+  };
+
+  const int nrSamples = width * height;
+  for (int i = 0; i < nrSamples; i++)
+  {
+    const unsigned int val = getSample(plane, i, twoBytes, bigEndian);
+    addByte(val & 0xff);
+    if (twoBytes)
+      addByte(val >> 8);
+  }
+  // Two zero bytes are appended at the end of the data
+  addByte(0);
+  addByte(0);
+
+  QByteArray result(2, 0);
+  result[0] = char(crc >> 8);
+  result[1] = char(crc & 0xff);
+  return result;
+}
+
+QByteArray calculateChecksum(const unsigned char *plane, int width, int height, bool twoBytes, bool bigEndian)
+{
+  uint32_t sum = 0;
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      const unsigned int xorMask = (x & 0xff) ^ (y & 0xff) ^ (x >> 8) ^ (y >> 8);
+      const unsigned int val = getSample(plane, y * width + x, twoBytes, bigEndian);
+      sum += (val & 0xff) ^ xorMask;
+      if (twoBytes)
+        sum += (val >> 8) ^ xorMask;
+    }
+  }
+
+  QByteArray result(4, 0);
+  for (int i = 0; i < 4; i++)
+    result[i] = char((sum >> (24 - 8 * i)) & 0xff);
+  return result;
+}
+
+} // namespace
+
+QString decodedPictureHash::getTypeName() const
+{
+  if (type == hashMD5)
+    return "MD5";
+  if (type == hashCRC)
+    return "CRC";
+  if (type == hashChecksum)
+    return "Checksum";
+  return "None";
+}
+
+QString decodedPictureHash::toString() const
+{
+  const QStringList componentNames = QStringList() << "Y" << "U" << "V";
+  QStringList components;
+  for (int c = 0; c < componentHashes.count(); c++)
+    components.append(componentNames.value(c) + " " + QString(componentHashes[c].toHex()));
+  return components.join(" ");
+}
+
+int decodedPictureHash::getHashLength(hashType type)
+{
+  if (type == hashMD5)
+    return 16;
+  if (type == hashCRC)
+    return 2;
+  if (type == hashChecksum)
+    return 4;
+  return 0;
+}
+
+decodedPictureHash decodedPictureHash::calculate(hashType type, int nrComponents, const QByteArray &data, const QSize &frameSize, const yuvPixelFormat &format)
+{
+  decodedPictureHash pictureHash;
+  if (type == hashNone || !format.isValid() || !format.planar || format.uvInterleaved || format.bitsPerSample > 16)
+    return pictureHash;
+  if (nrComponents < 1 || nrComponents > 3 || (format.subsampling == YUV_400 && nrComponents > 1))
+    return pictureHash;
+  if (data.size() < format.bytesPerFrame(frameSize))
+    return pictureHash;
+
+  const bool twoBytes = format.bitsPerSample > 8;
+  const int bytesPerSample = twoBytes ? 2 : 1;
+  const int lumaSize = frameSize.width() * frameSize.height() * bytesPerSample;
+  const int chromaWidth = frameSize.width() / format.getSubsamplingHor();
+  const int chromaHeight = frameSize.height() / format.getSubsamplingVer();
+  const int chromaSize = chromaWidth * chromaHeight * bytesPerSample;
+  const bool swapUV = (format.planeOrder == Order_YVU || format.planeOrder == Order_YVUA);
+
+  const unsigned char *src = (const unsigned char*)data.constData();
+  for (int c = 0; c < nrComponents; c++)
+  {
+    const unsigned char *plane = src;
+    int width = frameSize.width();
+    int height = frameSize.height();
+    if (c > 0)
+    {
+      const int planeIdx = swapUV ? 3 - c : c;
+      plane = src + lumaSize + (planeIdx - 1) * chromaSize;
+      width = chromaWidth;
+      height = chromaHeight;
+    }
+
+    if (type == hashMD5)
+      pictureHash.componentHashes.append(calculateMD5(plane, width, height, twoBytes, format.bigEndian));
+    else if (type == hashCRC)
+      pictureHash.componentHashes.append(calculateCRC(plane, width, height, twoBytes, format.bigEndian));
+    else
+      pictureHash.componentHashes.append(calculateChecksum(plane, width, height, twoBytes, format.bigEndian));
+  }
+
+  pictureHash.type = type;
+  pictureHash.pictureSize = frameSize;
+  return pictureHash;
+}
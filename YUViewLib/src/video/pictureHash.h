@@ -0,0 +1,83 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PICTUREHASH_H
+#define PICTUREHASH_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPoint>
+#include <QSize>
+#include <QString>
+
+#include "video/videoHandlerYUV.h"
+
+/* The hash of a decoded picture as it is transmitted in the bitstream (for example in the HEVC
+ * decoded picture hash SEI). There is one hash per color component. The MD5 is 16 bytes, the CRC
+ * 2 bytes and the checksum 4 bytes long (CRC and checksum in big endian byte order).
+ * The hashes are calculated over the full decoded sample arrays (before the conformance window cropping).
+ */
+struct decodedPictureHash
+{
+  enum hashType
+  {
+    hashMD5,
+    hashCRC,
+    hashChecksum,
+    hashNone
+  };
+
+  hashType type {hashNone};
+  QList<QByteArray> componentHashes;
+  // The size of the decoded luma sample array that the hash is calculated over
+  QSize pictureSize;
+  // The position of the cropped output (conformance window) in the decoded luma sample array
+  QPoint croppingOffset;
+
+  bool isValid() const { return type != hashNone && !componentHashes.isEmpty(); }
+  bool operator==(const decodedPictureHash &other) const { return type == other.type && componentHashes == other.componentHashes; }
+  bool operator!=(const decodedPictureHash &other) const { return !(*this == other); }
+
+  QString getTypeName() const;
+  // All component hashes as hex values (e.g. "Y 1a2b U 3c4d V 5e6f")
+  QString toString() const;
+
+  // The number of bytes of one component hash of the given type (0 for hashNone)
+  static int getHashLength(hashType type);
+
+  // Calculate the hash of the given type over the first nrComponents components of a decoded picture.
+  // Only planar YUV formats without alpha are supported. Samples with more than 8 bits are expected to
+  // be stored in two bytes. Returns an invalid hash if the format is not supported.
+  static decodedPictureHash calculate(hashType type, int nrComponents, const QByteArray &data, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &format);
+};
+
+#endif // PICTUREHASH_H
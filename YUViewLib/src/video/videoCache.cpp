@@ -40,8 +40,10 @@
 #include <QThread>
 
 #include "common/functions.h"
+#include "common/performanceProfiler.h"
 #include "ui/playbackController.h"
 #include "playlistitem/playlistItem.h"
+#include "video/videoDiskCache.h"
 
 // This debug setting has two values:
 // 1: Basic operation is written to qDebug: If a new item is selected, what is the decision to cache/remove next?
@@ -131,7 +133,17 @@ void loadingWorker::processCacheJobInternal()
 
   // Just cache the frame that was given to us.
   // This is performed in the thread that this worker is currently placed in.
-  currentCacheItem->cacheFrame(currentFrame, testMode);
+  {
+    // Only get the name (a string copy for every frame) if the profiler records
+    const bool profiling = performanceProfiler::instance().isEnabled();
+    performanceProfiler::scopedItem profilerItem(profiling ? currentCacheItem->getName() : QString());
+    QElapsedTimer timer;
+    timer.start();
+    currentCacheItem->cacheFrame(currentFrame, testMode);
+    // This is the cost of producing the frame again if it is removed from the cache
+    if (!testMode)
+      currentCacheItem->reportFrameCachingTime(timer.nsecsElapsed());
+  }
   
   currentCacheItem = nullptr;
   DEBUG_JOBS("loadingWorker::processCacheJobInternal emit loadingFinished");
@@ -147,7 +159,11 @@ void loadingWorker::processLoadingJobInternal(bool playing, bool loadRawData)
 
   // Load the frame of the item that was given to us.
   // This is performed in the thread (the loading thread with higher priority.
-  currentCacheItem->loadFrame(currentFrame, playing, loadRawData);
+  {
+    const bool profiling = performanceProfiler::instance().isEnabled();
+    performanceProfiler::scopedItem profilerItem(profiling ? currentCacheItem->getName() : QString());
+    currentCacheItem->loadFrame(currentFrame, playing, loadRawData);
+  }
 
   currentCacheItem = nullptr;
   emit loadingFinished();
@@ -220,7 +236,10 @@ videoCache::videoCache(PlaylistTreeWidget *playlistTreeWidget, PlaybackControlle
   connect(playback.data(), &PlaybackController::waitForItemCaching, this, &videoCache::watchItemForCachingFinished);
   connect(playback.data(), &PlaybackController::signalPlaybackStarting, this, &videoCache::updateCacheQueue);
   connect(&statusUpdateTimer, &QTimer::timeout, this, [=]{ emit updateCacheStatus(); });
+  connect(this, &videoCache::updateCacheStatus, this, &videoCache::updateProfilerQueueDepths);
   connect(&testProgrssUpdateTimer, &QTimer::timeout, this, [=]{ updateTestProgress(); });
+  connect(&memoryPressureTimer, &QTimer::timeout, this, &videoCache::checkMemoryPressure);
+  memoryPressureTimer.start(2000);
 }
 
 videoCache::~videoCache()
@@ -281,7 +300,10 @@ void videoCache::updateSettings()
   QSettings settings;
   settings.beginGroup("VideoCache");
   cachingEnabled = settings.value("Enabled", true).toBool();
-  cacheLevelMax = (int64_t)settings.value("ThresholdValueMB", 49).toUInt() * 1000 * 1000;
+  cacheLevelMaxSettings = (int64_t)settings.value("ThresholdValueMB", 49).toUInt() * 1000 * 1000;
+  adaptiveBudget = settings.value("AdaptiveBudget", true).toBool();
+  cacheLevelMax = cacheLevelMaxSettings;
+  videoDiskCache::instance().updateSettings();
 
   // See if the user changed the number of threads
   int targetNrThreads = functions::getOptimalThreadCount();
@@ -453,6 +475,34 @@ void videoCache::scheduleCachingListUpdate()
   DEBUG_CACHING("videoCache::playlistChanged new state %d", workersState);
 }
 
+namespace
+{
+  // The pinned ranges of the item limited to its frame range. Overlapping or adjacent ranges are merged so that
+  // no frame is counted twice.
+  QList<indexRange> getMergedPinnedRanges(playlistItem *item)
+  {
+    const indexRange itemRange = item->getFrameIdxRange();
+    QList<indexRange> ranges;
+    for (const indexRange &pinned : item->getPinnedRanges())
+    {
+      const indexRange r(std::max(pinned.first, itemRange.first), std::min(pinned.second, itemRange.second));
+      if (r.first <= r.second)
+        ranges.append(r);
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    QList<indexRange> merged;
+    for (const indexRange &r : ranges)
+    {
+      if (!merged.isEmpty() && r.first <= merged.last().second + 1)
+        merged.last().second = std::max(merged.last().second, r.second);
+      else
+        merged.append(r);
+    }
+    return merged;
+  }
+}
+
 void videoCache::updateCacheQueue()
 {
   if (!cachingEnabled)
@@ -522,6 +572,7 @@ void videoCache::updateCacheQueue()
     int64_t cachingFrameSize = item->getCachingFrameSize();
     cacheLevel += item->getNumberCachedFrames() * cachingFrameSize;
   }
+  cacheLevelMax = calculateCacheBudget(allItems, cacheLevel);
   if (cacheLevel > cacheLevelMax)
   {
     // The cache is overflowing (maybe the user made the cache smaller).
@@ -536,6 +587,8 @@ void videoCache::updateCacheQueue()
       unsigned int frameSize = allItems[i]->getCachingFrameSize();
       for (int f : cachedFrames)
       {
+        if (allItems[i]->isFramePinned(f))
+          continue;
         allItems[i]->removeFrameFromCache(f);
         cacheLevel -= frameSize;
         if (cacheLevel < cacheLevelMax)
@@ -554,6 +607,30 @@ void videoCache::updateCacheQueue()
   // Save the current level of the cache
   cacheLevelCurrent = cacheLevel;
 
+  // Pinned frames are always cached and never removed. The space for all of them (also the ones that are not cached
+  // yet) is reserved so that the jobs for the other frames below can not use it up.
+  QList<cacheJob> pinnedJobs;
+  int64_t pinnedLevel = 0;
+  int64_t cachedPinnedLevel = 0;
+  for (playlistItem *item : allItemsTop)
+  {
+    if (!item->isCachable() || !item->isIndexedByFrame())
+      continue;
+    const int64_t frameSize = item->getCachingFrameSize();
+    for (const indexRange &r : getMergedPinnedRanges(item))
+    {
+      pinnedJobs.append(cacheJob(item, r));
+      pinnedLevel += (r.second - r.first + 1) * frameSize;
+    }
+    for (int f : item->getCachedFrames())
+      if (item->isFramePinned(f))
+        cachedPinnedLevel += frameSize;
+  }
+  // The space for all frames that are not pinned
+  const int64_t cacheLevelMaxUnpinned = std::max(cacheLevelMax - pinnedLevel, int64_t(0));
+  // The space that is still needed for the pinned frames that are not cached yet
+  const int64_t uncachedPinnedLevel = std::max(pinnedLevel - cachedPinnedLevel, int64_t(0));
+
   // How much space do we need to cache the entire item?
   indexRange range = selection[0]->getFrameIdxRange(); // These are the frames that we want to cache
   int64_t cachingFrameSize = selection[0]->getCachingFrameSize();
@@ -582,7 +659,7 @@ void videoCache::updateCacheQueue()
 
         if (adding && allItems[i]->isCachable())
         {
-          if (newCacheLevel + itemCacheSize <= cacheLevelMax)
+          if (newCacheLevel + itemCacheSize <= cacheLevelMaxUnpinned)
           {
             // All frames of the item fit and there is even more space. We remain in "adding" mode.
             enqueueCacheJob(allItems[i], itemRange);
@@ -591,12 +668,13 @@ void videoCache::updateCacheQueue()
           else
           {
             // Not all frames fit. Enqueue the ones that fit and set the ones that don't as "can be deleted".
-            int64_t availableSpace = cacheLevelMax - newCacheLevel;
-            int64_t nrFramesCachable = availableSpace / allItems[i]->getCachingFrameSize() + 1;
+            int64_t availableSpace = cacheLevelMaxUnpinned - newCacheLevel;
+            int64_t nrFramesCachable = std::max(availableSpace / allItems[i]->getCachingFrameSize() + 1, int64_t(0));
 
             // These frames should be added...
             indexRange addFrames = indexRange(itemRange.first, itemRange.first + nrFramesCachable - 1);
-            enqueueCacheJob(allItems[i], addFrames);
+            if (nrFramesCachable > 0)
+              enqueueCacheJob(allItems[i], addFrames);
             newCacheLevel += nrFramesCachable * allItems[i]->getCachingFrameSize();
             // ... and the rest should be removed (if they are cached)
             QList<int> cachedFrames = allItems[i]->getCachedFrames();
@@ -628,7 +706,7 @@ void videoCache::updateCacheQueue()
   }
   else // playback is not running
   {
-    if (selection[0]->isCachable() && itemSpaceNeeded > cacheLevelMax && additionalItemSpaceNeeded > 0)
+    if (selection[0]->isCachable() && itemSpaceNeeded > cacheLevelMaxUnpinned && additionalItemSpaceNeeded > 0)
     {
       DEBUG_CACHING("videoCache::updateCacheQueue Item needs more space than cacheLevelMax");
       // All frames of the currently selected item will not fit into the cache
@@ -644,103 +722,34 @@ void videoCache::updateCacheQueue()
         }
       }
 
-      // Adjust the range so that only the number of frames are cached that will fit
-      int64_t nrFramesCachable = cacheLevelMax / selection[0]->getCachingFrameSize();
+      // Adjust the range so that only the number of frames are cached that will fit next to the pinned frames.
+      int64_t nrFramesCachable = cacheLevelMaxUnpinned / selection[0]->getCachingFrameSize();
       range.second = range.first + nrFramesCachable - 1;
 
-      enqueueCacheJob(selection[0], range);
+      if (nrFramesCachable > 0)
+        enqueueCacheJob(selection[0], range);
     }
-    else if (selection[0]->isCachable() && additionalItemSpaceNeeded > (cacheLevelMax - cacheLevel) && additionalItemSpaceNeeded > 0)
+    else if (selection[0]->isCachable() && additionalItemSpaceNeeded > (cacheLevelMax - uncachedPinnedLevel - cacheLevel) && additionalItemSpaceNeeded > 0)
     {
       DEBUG_CACHING("videoCache::updateCacheQueue Not enough space for caching, deleting frames");
       // There is currently not enough space in the cache to cache all remaining frames but in general the cache can hold all frames.
       // Delete frames from the cache until it fits.
 
-      // We go through all other items and get the frames that we will delete.
-      // We start with the item before the one before the currently selected one and go back through the list,
-      // wrap around and keep going until we are at the current selected item. Then (as the last resort) we
-      // go to the item before the currently selected one.
-      int i = itemPos - 1;
-      // Go back in the list to the previous item that is indexed
-      while(true)
-      {
-        if (i < 0)
-          i = allItems.count() - 1;
-        if (allItems[i]->isIndexedByFrame())
-          break;
-        i--;
-      }
-      // Go back one item further to the one before the one before the currently selected one.
-      i--;
-      while(true)
-      {
-        if (i < 0)
-          i = allItems.count() - 1;
-        if (allItems[i]->isIndexedByFrame())
-          break;
-        i--;
-      }
-
-      // Get the cache level without the current item (frames from the current item do not really occupy space in the cache. We want to cache them anyways)
-      int64_t cacheLevelWithoutCurrent = cacheLevel - selection[0]->getNumberCachedFrames() * int64_t(selection[0]->getCachingFrameSize());
-      while ((itemSpaceNeeded + cacheLevelWithoutCurrent) > cacheLevelMax)
+      // Mark the frames of all other items as "can be removed if required". The frames are only removed when the
+      // space is needed. Without priorities and costs, they are removed in this order: We start with the item before
+      // the one before the currently selected one and go back through the list, wrap around and keep going until we
+      // are at the currently selected item. Then (as the last resort) we go to the item before the currently selected
+      // one. Within an item, the last frames are removed first.
+      const int nrItems = allItems.count();
+      for (int k = 2; k <= nrItems; k++)
       {
-        if (i == itemPos)
-          // We went through the whole list and arrived back at the beginning.
-          // If playback is running, we go to the previous item at last.
-          i--;
-        if (i < 0)
-        {
-          // There is no previous item or the previous item is the first one in the list
-          i = allItems.count() - 1;
-        }
-        if (allItems[i]->getNumberCachedFrames() == 0)
-        {
-          i--;
-          continue;  // Nothing to delete for this item
-        }
-
-        // Which frames are cached for the item at position i?
-        QList<int> cachedFrames = allItems[i]->getCachedFrames();
-        int64_t cachedFramesSize = cachedFrames.count() * int64_t(allItems[i]->getCachingFrameSize());
-
-        if (additionalItemSpaceNeeded < cachedFramesSize)
-        {
-          // If we delete all frames from item i, there is more than enough space. So we only delete as many frames as needed.
-          int64_t nrFrames = additionalItemSpaceNeeded / allItems[i]->getCachingFrameSize() + 1;
-
-          // Delete nrFrames frames from the back
-          for (int f = cachedFrames.count() - 1; f >= 0 && nrFrames > 0 ; f--)
-          {
-            cacheDeQueue.enqueue(plItemFrame(allItems[i], cachedFrames[f]));
-            cacheLevelWithoutCurrent -= allItems[i]->getCachingFrameSize();
-            if ((cacheLevelWithoutCurrent + itemSpaceNeeded) <= cacheLevelMax)
-              // Now there is enough space
-              break;
-          }
-        }
-        else
-        {
-          // Deleting all frames from this item will not be enough.
-          // Mark all frames of this item as "can be removed if required"
-          QList<int> cachedFrames = allItems[i]->getCachedFrames();
-          for (int f : cachedFrames)
-          {
-            cacheDeQueue.enqueue(plItemFrame(allItems[i], f));
-          }
-          cacheLevelWithoutCurrent -= cachedFramesSize;
-        }
-
-        if (i == itemPos-1)
-        {
-          // We went through all items and tried to delete frames but there is still not enough space.
-          // That is not possible because we determined that the curretn item should fit if we just delete enough frames.
-          DEBUG_CACHING("videoCache::updateCacheQueue ERROR! Deleting loop processed all frames but still not enough space in the cache.");
-          break;
-        }
-
-        // Go to the next (previous) item
-        i--;
+        playlistItem *item = allItems[(itemPos - (k == nrItems ? 1 : k) + nrItems) % nrItems];
+        if (!item->isIndexedByFrame())
+          continue;
+        QList<int> cachedFrames = item->getCachedFrames();
+        std::sort(cachedFrames.begin(), cachedFrames.end());
+        for (int f = cachedFrames.count() - 1; f >= 0; f--)
+          cacheDeQueue.enqueue(plItemFrame(item, cachedFrames[f]));
       }
 
       // Enqueue the job. This is the only job.
@@ -759,64 +768,84 @@ void videoCache::updateCacheQueue()
         cacheLevel = cacheLevel + additionalItemSpaceNeeded;
       }
 
-      // Continue caching with the next item
-      int i = itemPos + 1;
+      // Continue caching with the next items. Items with a higher priority are cached first. Items with the same
+      // priority are cached in the order of the playlist.
+      QList<playlistItem*> nextItems;
+      for (int k = 1; k < allItems.count(); k++)
+        nextItems.append(allItems[(itemPos + k) % allItems.count()]);
+      std::stable_sort(nextItems.begin(), nextItems.end(), [](playlistItem *a, playlistItem *b) { return a->getCachePriority() > b->getCachePriority(); });
 
-      while (true)
+      for (playlistItem *item : nextItems)
       {
         // There is still space
         DEBUG_CACHING("videoCache::updateCacheQueue Cache not full yet, attempting next item");
 
-        if (i >= allItems.count())
-          // Last item. Continue with item 0.
-          i = 0;
-        if (i == itemPos)
-        {
-          // We went through all items, wrapped around and are back at the current item. No more items to cache.
-          DEBUG_CACHING("videoCache::updateCacheQueue No more items to cache.");
-          break;
-        }
-        if (!allItems[i]->isCachable())
-        {
+        if (!item->isCachable())
           // Nothing to cache for this item.
-          i++;
           continue;
-        }
 
-        DEBUG_CACHING("videoCache::updateCacheQueue Attempt caching of next item %s.", allItems[i]->getName().toLatin1().data());
+        DEBUG_CACHING("videoCache::updateCacheQueue Attempt caching of next item %s.", item->getName().toLatin1().data());
         // How much space is there in the cache (excluding what is cached from the current item)?
         // Get the cache level without the current item (frames from the current item do not really occupy space in the cache. We want to cache them anyways)
-        int64_t cacheLevelWithoutCurrent = cacheLevel - allItems[i]->getNumberCachedFrames() * int64_t(allItems[i]->getCachingFrameSize());
+        int64_t cacheLevelWithoutCurrent = cacheLevel - item->getNumberCachedFrames() * int64_t(item->getCachingFrameSize());
         // How much space do we need to cache the entire item?
-        range = allItems[i]->getFrameIdxRange();
-        int64_t itemCacheSize = (range.second - range.first + 1) * int64_t(allItems[i]->getCachingFrameSize());
+        range = item->getFrameIdxRange();
+        int64_t itemCacheSize = (range.second - range.first + 1) * int64_t(item->getCachingFrameSize());
 
-        if ((itemCacheSize + cacheLevelWithoutCurrent) <= cacheLevelMax)
+        if ((itemCacheSize + cacheLevelWithoutCurrent) <= cacheLevelMax - uncachedPinnedLevel)
         {
-          DEBUG_CACHING("videoCache::updateCacheQueue Entire next item %s fits.", allItems[i]->getName().toLatin1().data());
+          DEBUG_CACHING("videoCache::updateCacheQueue Entire next item %s fits.", item->getName().toLatin1().data());
           // The entire item fits
-          enqueueCacheJob(allItems[i], range);
+          enqueueCacheJob(item, range);
         }
         else
         {
-          // Only a part of the next item fits without deleting frames
-          if ((itemCacheSize + cacheLevelWithoutCurrent) > cacheLevelMax)
-          {
-            // Only a part of the item fits.
-            int64_t nrFramesCachable = (cacheLevelMax - cacheLevelWithoutCurrent) / allItems[i]->getCachingFrameSize();
-            DEBUG_CACHING("videoCache::updateCacheQueue Only %lld frames of next item %s fit.",nrFramesCachable, allItems[i]->getName().toLatin1().data());
-            range.second = range.first + nrFramesCachable - 1;
-            enqueueCacheJob(allItems[i], range);
-
-            // The cache is now full
-            break;
-          }
+          // Only a part of the item fits.
+          int64_t nrFramesCachable = (cacheLevelMax - uncachedPinnedLevel - cacheLevelWithoutCurrent) / item->getCachingFrameSize();
+          DEBUG_CACHING("videoCache::updateCacheQueue Only %lld frames of next item %s fit.",nrFramesCachable, item->getName().toLatin1().data());
+          range.second = range.first + nrFramesCachable - 1;
+          if (nrFramesCachable > 0)
+            enqueueCacheJob(item, range);
+
+          // The cache is now full
+          break;
         }
-
-        i++;
       }
+      DEBUG_CACHING("videoCache::updateCacheQueue No more items to cache.");
+    }
+  }
+
+  // The pinned frames are cached before all other frames. The frames that the job of the selected item covers
+  // anyways are not scheduled twice.
+  QQueue<cacheJob> otherJobs;
+  otherJobs.swap(cacheQueue);
+  bool selectedJobFound = false;
+  indexRange selectedJobRange;
+  for (const cacheJob &job : otherJobs)
+  {
+    if (job.plItem == selection[0])
+    {
+      selectedJobFound = true;
+      selectedJobRange = job.frameRange;
+      break;
+    }
+  }
+  for (const cacheJob &job : pinnedJobs)
+  {
+    const indexRange r = job.frameRange;
+    if (!selectedJobFound || job.plItem != selection[0] || r.second < selectedJobRange.first || r.first > selectedJobRange.second)
+      enqueueCacheJob(job.plItem, r);
+    else
+    {
+      // Only the parts before and after the job of the selected item
+      if (r.first < selectedJobRange.first)
+        enqueueCacheJob(job.plItem, indexRange(r.first, selectedJobRange.first - 1));
+      if (r.second > selectedJobRange.second)
+        enqueueCacheJob(job.plItem, indexRange(selectedJobRange.second + 1, r.second));
     }
   }
+  cacheQueue.append(otherJobs);
+  sortRemovalQueue();
 
 #if CACHING_DEBUG_OUTPUT && !NDEBUG
   if (!cacheQueue.isEmpty())
@@ -861,10 +890,38 @@ void videoCache::enqueueCacheJob(playlistItem* item, indexRange range)
   int i = range.first;
   while (cachedFrames.contains(i) && i < range.second)
     range.first = ++i;
-  if (range.first != range.second)
+  if (range.first != range.second || !cachedFrames.contains(range.first))
     cacheQueue.append(cacheJob(item, range));
 }
 
+void videoCache::sortRemovalQueue()
+{
+  // The queue is sorted by the distance from the play head (the frames that will be needed last come first). Weight
+  // this with the priority of the item and the cost of producing the frame again so that cheap frames (e.g. read from
+  // a raw file) of low priority items that are far away from the play head are removed first. Pinned frames are never
+  // removed.
+  QList<QPair<double, plItemFrame>> weightedFrames;
+  const int nrFrames = cacheDeQueue.count();
+  for (int i = 0; i < nrFrames; i++)
+  {
+    const plItemFrame &f = cacheDeQueue[i];
+    if (f.first.isNull() || f.first->isFramePinned(f.second))
+      continue;
+
+    const playlistItem::cachePriority priority = f.first->getCachePriority();
+    const double priorityWeight = (priority == playlistItem::cachePriorityHigh) ? 4.0 : (priority == playlistItem::cachePriorityLow) ? 0.25 : 1.0;
+    // Frames that were never measured and frames that are very cheap count as 0.1 ms
+    const double cost = double(std::max(f.first->getAverageFrameCachingTime(), int64_t(100000)));
+    const double proximity = double(i + 1) / nrFrames;
+    weightedFrames.append(qMakePair(priorityWeight * cost * proximity, f));
+  }
+  std::stable_sort(weightedFrames.begin(), weightedFrames.end(), [](const QPair<double, plItemFrame> &a, const QPair<double, plItemFrame> &b) { return a.first < b.first; });
+
+  cacheDeQueue.clear();
+  for (const QPair<double, plItemFrame> &f : weightedFrames)
+    cacheDeQueue.enqueue(f.second);
+}
+
 void videoCache::startCaching()
 {
   DEBUG_CACHING("videoCache::startCaching %s", testMode ? "Test mode" : "");
@@ -1214,6 +1271,9 @@ bool videoCache::pushNextJobToCachingThread(loadingThread *thread)
   while (cacheLevelCurrent + frameSize >= cacheLevelMax && !cacheDeQueue.isEmpty())
   {
     plItemFrame frameToRemove = cacheDeQueue.dequeue();
+    if (frameToRemove.first.isNull() || frameToRemove.first->isFramePinned(frameToRemove.second))
+      // The item is gone or the frame was pinned after the queue was updated
+      continue;
     unsigned int frameToRemoveSize = frameToRemove.first->getCachingFrameSize();
 
     DEBUG_CACHING_DETAIL("videoCache::pushNextJobToCachingThread Remove frame %d of %s", frameToRemove.second, frameToRemove.first->getName().toStdString().c_str());
@@ -1229,6 +1289,9 @@ bool videoCache::pushNextJobToCachingThread(loadingThread *thread)
     return false;
   }
 
+  // Tell the item which frames will be cached next so that it can read ahead (sequentially)
+  plItem->hintUpcomingCacheFrames(range);
+
   // Push the job to the thread
   Q_ASSERT_X(plItem != nullptr && frameToCache >= 0, "push next job to cache", "Invalid job.");
   thread->worker()->setJob(plItem, frameToCache);
@@ -1366,9 +1429,85 @@ void videoCache::testConversionSpeed()
     workersState = workersIntReqRestart;
 }
 
+void videoCache::updateProfilerQueueDepths()
+{
+  performanceProfiler &profiler = performanceProfiler::instance();
+  if (!profiler.isEnabled())
+    return;
+
+  int framesToCache = 0;
+  for (const cacheJob &job : cacheQueue)
+    framesToCache += job.frameRange.second - job.frameRange.first + 1;
+  int threadsWorking = 0;
+  for (loadingThread *t : cachingThreadList)
+    if (t->worker()->isWorking())
+      threadsWorking++;
+  int interactiveQueued = 0;
+  for (int i = 0; i < 2; i++)
+    if (interactiveItemQueued[i] != nullptr)
+      interactiveQueued++;
+
+  profiler.setQueueDepth("Cache queue (frames)", framesToCache);
+  profiler.setQueueDepth("Removal queue (frames)", cacheDeQueue.count());
+  profiler.setQueueDepth("Caching threads working", threadsWorking);
+  profiler.setQueueDepth("Interactive loads queued", interactiveQueued);
+}
+
+int64_t videoCache::calculateCacheBudget(const QList<playlistItem*> &allItems, int64_t cacheLevel)
+{
+  // The threshold from the settings is for all memory that is used by the items. Subtract the memory that
+  // the decoders, statistics, buffers and parsers use.
+  itemsMemoryUsage = 0;
+  for (playlistItem *item : allItems)
+    itemsMemoryUsage += item->getMemoryUsage();
+  // The frames that wait to be written to the disk cache
+  itemsMemoryUsage += videoDiskCache::instance().getMemoryUsage();
+  int64_t budget = cacheLevelMaxSettings - itemsMemoryUsage;
+
+  availableMemory = adaptiveBudget ? functions::availableMemoryInBytes() : -1;
+  if (availableMemory >= 0)
+  {
+    // The cache may grow into the available memory (the memory it already uses can be reused) but we keep a reserve
+    // for the rest of the application and the system. In a container, the available memory considers the memory limit.
+    const int64_t reserve = std::max(int64_t(256) << 20, (int64_t(functions::systemMemorySizeInMB()) << 20) / 10);
+    budget = std::min(budget, cacheLevel + availableMemory - reserve);
+  }
+
+  DEBUG_CACHING("videoCache::calculateCacheBudget budget %lld items %lld available %lld", (long long)budget, (long long)itemsMemoryUsage, (long long)availableMemory);
+  return std::max(budget, int64_t(0));
+}
+
+void videoCache::checkMemoryPressure()
+{
+  if (!cachingEnabled || playlist.isNull())
+    return;
+
+  const int64_t budget = calculateCacheBudget(playlist->getAllPlaylistItems(), cacheLevelCurrent);
+  if (budget < cacheLevelCurrent)
+  {
+    // The memory is getting low (or the items need more memory). Shrink the cache now.
+    DEBUG_CACHING("videoCache::checkMemoryPressure Shrinking cache to %lld bytes", (long long)budget);
+    cacheLevelMax = budget;
+    scheduleCachingListUpdate();
+  }
+  else if (budget > cacheLevelMax + cacheLevelMax / 10 && workersState == workersIdle)
+  {
+    // More memory became available. Let the cache use it. Don't interrupt running workers for this.
+    DEBUG_CACHING("videoCache::checkMemoryPressure Growing cache to %lld bytes", (long long)budget);
+    scheduleCachingListUpdate();
+  }
+  else
+    cacheLevelMax = budget;
+}
+
 QStringList videoCache::getCacheStatusText()
 {
   QStringList txt;
+  txt.append("Memory:");
+  txt.append(QString("Cache budget %1 MB").arg(cacheLevelMax >> 20));
+  txt.append(QString("Used by items (outside of cache) %1 MB").arg(itemsMemoryUsage >> 20));
+  if (availableMemory >= 0)
+    txt.append(QString("Available in system %1 MB").arg(availableMemory >> 20));
   txt.append("Interactive:");
   txt.append(interactiveThread[0]->worker()->getStatus());
   txt.append(interactiveThread[1]->worker()->getStatus());
@@ -71,6 +71,10 @@ public:
 
   QStringList getCacheStatusText();
 
+  // The number of bytes that the cache may currently use. This is the threshold from the settings minus the memory that
+  // the items use outside of the cache. With the adaptive budget, it is also limited by the available system memory.
+  int64_t getCacheLevelMax() const { return cacheLevelMax; }
+
 signals:
   // This will be emitted on a regular basis to update the videoCacheInfoWidget
   void updateCacheStatus();
@@ -103,6 +107,12 @@ private slots:
   // Analyze the current situation and decide which items are to be cached next (in which order) and
   // which frames can be removed from the cache.
   void updateCacheQueue();
+
+  // Report the current depths of the queues to the performance profiler
+  void updateProfilerQueueDepths();
+
+  // Called regularly by the memoryPressureTimer. Recalculate the cache budget and shrink or grow the cache if necessary.
+  void checkMemoryPressure();
  
 private:
   // A cache job. Has a pointer to a playlist item and a range of frames to be cached.
@@ -118,6 +128,10 @@ private:
   // When the cache queue is updated, this function will start the background caching.
   void startCaching();
 
+  // Reorder the cacheDeQueue by the priority of the items, the cost of producing the frames again and the
+  // distance from the play head. Remove pinned frames from the queue.
+  void sortRemovalQueue();
+
   QPointer<PlaylistTreeWidget> playlist;
   QPointer<PlaybackController> playback;
   QPointer<splitViewWidget>    splitView;
@@ -133,6 +147,17 @@ private:
   int64_t cacheLevelMax;
   int64_t cacheLevelCurrent;
 
+  // The cache threshold as set in the settings and if the budget should adapt to the available system memory
+  int64_t cacheLevelMaxSettings;
+  bool adaptiveBudget;
+  // Calculate the cache budget from the settings, the memory that the items use outside of the cache and the available
+  // system memory. cacheLevel is the memory that the cache currently uses (it could be freed).
+  int64_t calculateCacheBudget(const QList<playlistItem*> &allItems, int64_t cacheLevel);
+  // The values of the last calculation (for the status text)
+  int64_t itemsMemoryUsage {0};
+  int64_t availableMemory {-1};
+  QTimer memoryPressureTimer;
+
   // Enqueue the job in the queue. If all frames within the range are already cached in the item, do nothing.
   void enqueueCacheJob(playlistItem* item, indexRange range);
 
@@ -0,0 +1,218 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "videoDiskCache.h"
+
+#include <algorithm>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#define VIDEODISKCACHE_DEBUG_OUTPUT 0
+#if VIDEODISKCACHE_DEBUG_OUTPUT && !NDEBUG
+#include <QDebug>
+#define DEBUG_DISKCACHE qDebug
+#else
+#define DEBUG_DISKCACHE(fmt,...) ((void)0)
+#endif
+
+// Every frame file starts with this header
+#define DISKCACHE_MAGIC 0x59564443  // "YVDC"
+#define DISKCACHE_VERSION 2
+// Writing is skipped if the writer can not keep up. The frames that wait to be written are held in memory.
+#define DISKCACHE_MAX_PENDING_BYTES (int64_t(256) << 20)
+// Remove the oldest files until the cache is at this fraction of the limit
+#define DISKCACHE_CLEANUP_TARGET 0.9
+
+Q_GLOBAL_STATIC(videoDiskCache, globalDiskCache)
+
+videoDiskCache::videoDiskCache()
+{
+  writerPool.setMaxThreadCount(1);
+  cacheDir.setPath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/frames");
+  updateSettings();
+}
+
+videoDiskCache &videoDiskCache::instance()
+{
+  return *globalDiskCache;
+}
+
+void videoDiskCache::updateSettings()
+{
+  QSettings settings;
+  settings.beginGroup("VideoCache");
+  const bool enabled = settings.value("DiskCacheEnabled", false).toBool();
+  const int64_t maxSize = (int64_t)settings.value("DiskCacheSizeGB", 10).toUInt() * 1000 * 1000 * 1000;
+  settings.endGroup();
+
+  QMutexLocker locker(&dataMutex);
+  maxCacheSize = maxSize;
+  if (enabled && !cacheDir.exists())
+    cacheDir.mkpath(".");
+  enabledFlag.store(enabled ? 1 : 0);
+}
+
+QString videoDiskCache::getFilePath(const QString &key, int frameIdx) const
+{
+  const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return cacheDir.filePath(QString("%1/%2.frame").arg(QString::fromLatin1(hash)).arg(frameIdx));
+}
+
+void videoDiskCache::storeFrame(const QString &key, int frameIdx, const QByteArray &rawData)
+{
+  if (!isEnabled() || rawData.isEmpty())
+    return;
+
+  const QString filePath = getFilePath(key, frameIdx);
+  {
+    QMutexLocker locker(&dataMutex);
+    if (pendingWrites.contains(filePath) || pendingWriteBytes + rawData.size() > DISKCACHE_MAX_PENDING_BYTES)
+      return;
+    if (QFile::exists(filePath))
+      return;
+    pendingWrites.insert(filePath);
+    pendingWriteBytes += rawData.size();
+  }
+
+  // The data is implicitly shared so no copy is made here. It is only held until it is written.
+  QtConcurrent::run(&writerPool, this, &videoDiskCache::writeFrame, filePath, rawData);
+}
+
+int64_t videoDiskCache::getMemoryUsage() const
+{
+  QMutexLocker locker(&dataMutex);
+  return pendingWriteBytes;
+}
+
+void videoDiskCache::writeFrame(const QString &filePath, const QByteArray &rawData)
+{
+  QDir().mkpath(QFileInfo(filePath).path());
+
+  QSaveFile file(filePath);
+  bool success = file.open(QIODevice::WriteOnly);
+  if (success)
+  {
+    QDataStream out(&file);
+    out << quint32(DISKCACHE_MAGIC) << quint32(DISKCACHE_VERSION);
+    // Use the fastest compression level. The frames are written and read much more often than they are kept.
+    out << qCompress(rawData, 1);
+    success = out.status() == QDataStream::Ok && file.commit();
+  }
+  DEBUG_DISKCACHE("videoDiskCache::writeFrame %s %s", filePath.toLatin1().data(), success ? "done" : "failed");
+
+  QMutexLocker locker(&dataMutex);
+  pendingWrites.remove(filePath);
+  pendingWriteBytes -= rawData.size();
+  if (!success)
+    return;
+  if (currentCacheSize >= 0)
+    currentCacheSize += QFileInfo(filePath).size();
+  const bool sizeExceeded = currentCacheSize < 0 || currentCacheSize > maxCacheSize;
+  locker.unlock();
+
+  if (sizeExceeded)
+    enforceSizeLimit();
+}
+
+QByteArray videoDiskCache::loadFrame(const QString &key, int frameIdx) const
+{
+  if (!isEnabled())
+    return QByteArray();
+
+  QFile file(getFilePath(key, frameIdx));
+  if (!file.open(QIODevice::ReadOnly))
+    return QByteArray();
+
+  QDataStream in(&file);
+  quint32 magic, version;
+  QByteArray compressedData;
+  in >> magic >> version >> compressedData;
+  if (in.status() != QDataStream::Ok || magic != DISKCACHE_MAGIC || version != DISKCACHE_VERSION)
+    return QByteArray();
+
+  DEBUG_DISKCACHE("videoDiskCache::loadFrame %d found", frameIdx);
+  return qUncompress(compressedData);
+}
+
+void videoDiskCache::enforceSizeLimit()
+{
+  // Get all files and the size on disk
+  QList<QFileInfo> files;
+  int64_t size = 0;
+  QDirIterator it(cacheDir.path(), QStringList() << "*.frame", QDir::Files, QDirIterator::Subdirectories);
+  while (it.hasNext())
+  {
+    it.next();
+    files.append(it.fileInfo());
+    size += it.fileInfo().size();
+  }
+
+  QMutexLocker locker(&dataMutex);
+  const int64_t maxSize = maxCacheSize;
+  locker.unlock();
+
+  if (size > maxSize)
+  {
+    // Remove the oldest files first
+    std::sort(files.begin(), files.end(), [](const QFileInfo &a, const QFileInfo &b) { return a.lastModified() < b.lastModified(); });
+    const int64_t targetSize = int64_t(maxSize * DISKCACHE_CLEANUP_TARGET);
+    for (const QFileInfo &f : files)
+    {
+      if (size <= targetSize)
+        break;
+      if (QFile::remove(f.filePath()))
+        size -= f.size();
+      // This only succeeds if it was the last frame of this key
+      cacheDir.rmdir(f.path());
+    }
+    DEBUG_DISKCACHE("videoDiskCache::enforceSizeLimit Reduced the cache to %lld bytes", (long long)size);
+  }
+
+  locker.relock();
+  currentCacheSize = size;
+}
+
+void videoDiskCache::clear()
+{
+  writerPool.waitForDone();
+  QMutexLocker locker(&dataMutex);
+  cacheDir.removeRecursively();
+  cacheDir.mkpath(".");
+  currentCacheSize = 0;
+}
@@ -0,0 +1,95 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VIDEODISKCACHE_H
+#define VIDEODISKCACHE_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QDir>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+
+/* The disk cache is an optional second tier behind the frame cache in memory (videoHandler::imageCache).
+ * Items that are expensive to load (like decoded compressed video) put the raw source data of the frames (the
+ * YUV/RGB planes as they come from the decoder) in here. The raw data is smaller than the converted image and it does
+ * not depend on the conversion settings, so changing e.g. the color conversion does not invalidate the disk cache.
+ * The frames are written compressed in the background. When the same frame is needed again (after a restart
+ * or after the item was removed and added again) it is read from disk, which is much faster than decoding it again.
+ * Frames are identified by a key which must contain the identity of the file (path, size, modification time) and
+ * the format of the raw data. The size of the cache is limited. If the limit is exceeded, the oldest frames are removed.
+ */
+class videoDiskCache
+{
+public:
+  // Don't create your own disk cache. Use the global one.
+  videoDiskCache();
+  static videoDiskCache &instance();
+
+  // Read the enabled state and the size limit from the settings
+  void updateSettings();
+  bool isEnabled() const { return enabledFlag.load() != 0; }
+
+  // Put the raw data of the frame into the disk cache. The data is written in the background. If the writer can not
+  // keep up, the frame is not written.
+  void storeFrame(const QString &key, int frameIdx, const QByteArray &rawData);
+  // Read the raw data of the frame from the disk cache. Returns an empty array if the frame is not in the cache.
+  QByteArray loadFrame(const QString &key, int frameIdx) const;
+
+  // The memory (in bytes) that is held by the frames that are waiting to be written
+  int64_t getMemoryUsage() const;
+
+  // Remove all frames from the disk
+  void clear();
+
+private:
+  QString getFilePath(const QString &key, int frameIdx) const;
+  // Compress and write the frame. This is called from the writer thread.
+  void writeFrame(const QString &filePath, const QByteArray &rawData);
+  // Remove the oldest files until the cache is below the size limit. This is called from the writer thread.
+  void enforceSizeLimit();
+
+  QAtomicInt enabledFlag;
+  QDir cacheDir;
+  // Only one thread writes the frames so that writing does not compete with decoding
+  QThreadPool writerPool;
+
+  mutable QMutex dataMutex;
+  QSet<QString> pendingWrites;
+  int64_t pendingWriteBytes {0};
+  int64_t maxCacheSize {0};
+  int64_t currentCacheSize {-1};  //< The number of bytes on disk (-1 if unknown)
+};
+
+#endif // VIDEODISKCACHE_H
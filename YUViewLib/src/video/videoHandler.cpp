@@ -35,6 +35,7 @@
 #include <QPainter>
 
 #include "common/functions.h"
+#include "video/videoDiskCache.h"
 
 // Activate this if you want to know when which buffer is loaded/converted to image and so on.
 #define VIDEOHANDLER_DEBUG_LOADING 0
@@ -221,21 +222,35 @@ QImage videoHandler::calculateDifference(frameHandler *item2, const int frameIdx
   if (videoItem2 == nullptr)
   {
     // The item2 is not a videoItem but this one is.
-    if (currentImageIdx != frameIdxItem0)
+    if (currentImageIdx != frameIdxItem0 && !setCurrentImageFromCache(frameIdxItem0))
       loadFrame(frameIdxItem0);
     // Call the frameHandler implementation to calculate the difference
     return frameHandler::calculateDifference(item2, frameIdxItem0, frameIdxItem1, differenceInfoList, amplificationFactor, markDifference);
   }
 
-  // Load the right images, if not already loaded)
-  if (currentImageIdx != frameIdxItem0)
+  // Load the right images, if not already loaded). Frames that are cached don't have to be loaded again.
+  if (currentImageIdx != frameIdxItem0 && !setCurrentImageFromCache(frameIdxItem0))
     loadFrame(frameIdxItem0);
-  if (videoItem2->currentImageIdx != frameIdxItem1)
+  if (videoItem2->currentImageIdx != frameIdxItem1 && !videoItem2->setCurrentImageFromCache(frameIdxItem1))
     videoItem2->loadFrame(frameIdxItem1);
 
   return frameHandler::calculateDifference(item2, frameIdxItem0, frameIdxItem1, differenceInfoList, amplificationFactor, markDifference);
 }
 
+bool videoHandler::setCurrentImageFromCache(int frameIndex)
+{
+  QMutexLocker lock(&imageCacheAccess);
+  if (!cacheValid || !imageCache.contains(frameIndex))
+    return false;
+
+  DEBUG_VIDEO("videoHandler::setCurrentImageFromCache %d", frameIndex);
+  currentImageSetMutex.lock();
+  currentImage = imageCache[frameIndex];
+  currentImageIdx = frameIndex;
+  currentImageSetMutex.unlock();
+  return true;
+}
+
 QRgb videoHandler::getPixelVal(int x, int y)
 {
   return currentImage.pixel(x, y);
@@ -275,12 +290,84 @@ void videoHandler::cacheFrame(int frameIdx, bool testMode)
     DEBUG_VIDEO("videoHandler::cacheFrame loading frame %i for caching failed", frameIdx);
 }
 
+void videoHandler::setDiskCacheSourceKey(const QString &key)
+{
+  QMutexLocker lock(&imageCacheAccess);
+  diskCacheSourceKey = key;
+}
+
+QString videoHandler::getRawDataFormatKey() const
+{
+  return QString("%1x%2").arg(frameSize.width()).arg(frameSize.height());
+}
+
+QString videoHandler::getDiskCacheKey() const
+{
+  if (!videoDiskCache::instance().isEnabled())
+    return QString();
+  QMutexLocker lock(&imageCacheAccess);
+  if (diskCacheSourceKey.isEmpty())
+    return QString();
+  return diskCacheSourceKey + "|" + getRawDataFormatKey();
+}
+
+void videoHandler::requestRawDataForCaching(int frameIndex)
+{
+  // Try the disk cache first. Reading from there is much faster than loading (decoding) the frame again.
+  const QString diskCacheKey = getDiskCacheKey();
+  if (!diskCacheKey.isEmpty())
+  {
+    const QByteArray diskData = videoDiskCache::instance().loadFrame(diskCacheKey, frameIndex);
+    const int64_t bytesPerFrame = getBytesPerFrame();
+    if (!diskData.isEmpty() && (bytesPerFrame < 0 || diskData.size() == bytesPerFrame))
+    {
+      DEBUG_VIDEO("videoHandler::requestRawDataForCaching frame %d from the disk cache", frameIndex);
+      rawData = diskData;
+      rawData_frameIdx = frameIndex;
+      return;
+    }
+  }
+
+  emit signalRequestRawData(frameIndex, true);
+
+  // Also write it to disk (unless the format changed while the frame was loaded)
+  if (!diskCacheKey.isEmpty() && rawData_frameIdx == frameIndex && diskCacheKey == getDiskCacheKey())
+    videoDiskCache::instance().storeFrame(diskCacheKey, frameIndex, rawData);
+}
+
+void videoHandler::addFrameToCache(int frameIdx, const QImage &frame, bool testMode)
+{
+  DEBUG_VIDEO("videoHandler::addFrameToCache %d %s", frameIdx, testMode ? "testMode" : "");
+
+  if (frame.isNull())
+    return;
+
+  QMutexLocker imageCacheLock(&imageCacheAccess);
+  if (cacheValid && !testMode)
+    imageCache.insert(frameIdx, frame);
+}
+
+QImage::Format videoHandler::getOutputImageFormat() const
+{
+  return functions::platformImageFormat();
+}
+
 unsigned int videoHandler::getCachingFrameSize() const
 {
-  auto bytes = functions::bytesPerPixel(functions::platformImageFormat());
+  auto bytes = functions::bytesPerPixel(getOutputImageFormat());
   return frameSize.width() * frameSize.height() * bytes;
 }
 
+int64_t videoHandler::getMemoryUsage() const
+{
+  // The current image, the double buffer and the requested frame
+  int64_t size = 3 * int64_t(getCachingFrameSize());
+  // The current raw data and the raw data buffer of the raw format handlers
+  if (getBytesPerFrame() > 0)
+    size += 2 * getBytesPerFrame();
+  return size;
+}
+
 QList<int> videoHandler::getCachedFrames() const
 {
   QMutexLocker lock(&imageCacheAccess);
@@ -364,6 +451,18 @@ void videoHandler::loadFrameForCaching(int frameIndex, QImage &frameToCache)
   frameToCache = requestedFrame;
 }
 
+QImage videoHandler::getFrameForCaching(int frameIdx)
+{
+  QMutexLocker imageCacheLock(&imageCacheAccess);
+  if (cacheValid && imageCache.contains(frameIdx))
+    return imageCache[frameIdx];
+  imageCacheLock.unlock();
+
+  QImage frame;
+  loadFrameForCaching(frameIdx, frame);
+  return frame;
+}
+
 void videoHandler::invalidateAllBuffers()
 {
   currentFrameRawData_frameIdx = -1;
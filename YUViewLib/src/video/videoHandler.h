@@ -59,13 +59,28 @@ public:
   // These methods are all thread-safe and can be invoked from any thread.
   int getNrFramesCached() const;
   void cacheFrame(int frameIdx, bool testMode);
+  // Put a frame that was loaded by the item itself into the cache. Items that can load frames without going through the
+  // shared requestedFrame buffer can use this so that multiple caching threads can work on the same item in parallel.
+  void addFrameToCache(int frameIdx, const QImage &frame, bool testMode);
+  // Get the given frame from the cache or load it (using loadFrameForCaching). The current image is not changed.
+  QImage getFrameForCaching(int frameIdx);
   unsigned int getCachingFrameSize() const; // How much bytes will be used when caching one frame?
+  // How much memory (in bytes) is used outside of the cache (current image, double buffer, requested frame and the raw
+  // data buffers)? This is estimated from the format so it does not need to lock any of the buffers.
+  int64_t getMemoryUsage() const;
   QList<int> getCachedFrames() const;
   int getNumberCachedFrames() const;
   bool isInCache(int idx) const;
   virtual void removeFrameFromCache(int frameIdx);
   virtual void removeAllFrameFromCache();
 
+  // Use the disk cache (videoDiskCache) as a second tier for the frames of this handler. The source key must identify the
+  // source of the frames (e.g. the file and the decoder settings). Set an empty key to not use the disk cache.
+  void setDiskCacheSourceKey(const QString &key);
+
+  // The format of the images that are drawn and cached. The default is the platform image format.
+  virtual QImage::Format getOutputImageFormat() const;
+
   // Get the number of bytes for one frame (RGB or YUV) with the current format (if this video handler uses raw data)
   virtual int64_t getBytesPerFrame() const { return -1; }
 
@@ -180,9 +195,22 @@ protected:
   // Set the cache to be invalid until a call to removefromCache(-1) clears it.
   void setCacheInvalid() { cacheValid = false; }
 
+  // If the given frame is in the cache, make it the current image and return true.
+  bool setCurrentImageFromCache(int frameIndex);
+
   // --- Caching
   QMutex mutable     imageCacheAccess;
   QMap<int, QImage>  imageCache;
+
+  // Get a key that identifies the format of the raw data (rawData). Overload this if the video handler has a raw format.
+  // The default implementation only uses the frame size.
+  virtual QString getRawDataFormatKey() const;
+  // The key for the disk cache (an empty string if the disk cache is not used)
+  QString getDiskCacheKey() const;
+  QString diskCacheSourceKey;
+  // Request the raw data of the given frame for a caching thread (signalRequestRawData). Lock the requestDataMutex first.
+  // If the disk cache is used, the raw data is read from the disk cache or written to it after it was loaded.
+  void requestRawDataForCaching(int frameIndex);
   // Is the cache valid? The cache can be ivalid in the following scenario:
   // Somethign about how an item is shown changes (e.g. the resolution) but caching of the item is currently performed.
   // If we just cleared the cache, the wrong (currently being cached) frames would still end up in the cache. So we emit
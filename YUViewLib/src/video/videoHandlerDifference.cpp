@@ -35,6 +35,7 @@
 #include <algorithm>
 #include <QPainter>
 
+#include "videoHandlerRGB.h"
 #include "videoHandlerYUV.h"
 
 // Activate this if you want to know when which buffer is loaded/converted to image and so on.
@@ -76,6 +77,8 @@ void videoHandlerDifference::drawDifferenceFrame(QPainter *painter, int frameIdx
       {
         currentImage = imageCache[frameIdx];
         currentImageIdx = frameIdx;
+        differenceInfoList = differenceInfoCache[frameIdx].differenceInfo;
+        firstDifferenceInfoList = differenceInfoCache[frameIdx].firstDifference;
         DEBUG_VIDEO("videoHandler::drawFrame %d loaded from cache", frameIdx);
       }
     }
@@ -106,9 +109,48 @@ void videoHandlerDifference::loadFrameDifference(int frameIndex, int frameIndex0
   // Calculate the difference between the inputVideos
   if (!inputsValid())
     return;
-  
-  differenceInfoList.clear();
 
+  QMutexLocker lock(&differenceMutex);
+  QList<infoItem> infoList, firstDifferenceList;
+  QImage newFrame = calculateDifferenceFrame(frameIndex0, frameIndex1, infoList, firstDifferenceList);
+  differenceInfoList = infoList;
+  firstDifferenceInfoList = firstDifferenceList;
+
+  if (!newFrame.isNull())
+  {
+    // The new difference frame is ready
+    currentImageIdx = frameIndex;
+    currentImageSetMutex.lock();
+    currentImage = newFrame;
+    currentImageSetMutex.unlock();
+  }
+}
+
+void videoHandlerDifference::cacheFrameDifference(int frameIndex, int frameIndex0, int frameIndex1, bool testMode)
+{
+  DEBUG_VIDEO("videoHandlerDifference::cacheFrameDifference %d %s", frameIndex, testMode ? "testMode" : "");
+
+  if (!inputsValid())
+    return;
+  if (cacheValid && isInCache(frameIndex) && !testMode)
+    return;
+
+  cachedDifferenceInfo info;
+  QImage newFrame = calculateDifferenceFrameForCaching(frameIndex0, frameIndex1, info.differenceInfo, info.firstDifference);
+
+  if (newFrame.isNull())
+    return;
+
+  QMutexLocker imageCacheLock(&imageCacheAccess);
+  if (cacheValid && !testMode)
+  {
+    imageCache.insert(frameIndex, newFrame);
+    differenceInfoCache.insert(frameIndex, info);
+  }
+}
+
+QImage videoHandlerDifference::calculateDifferenceFrame(int frameIndex0, int frameIndex1, QList<infoItem> &infoList, QList<infoItem> &firstDifferenceList)
+{
   // Check if the second item is a video and the first one is not. In that case,
   // make sure that the right frame is loaded for the video item.
   videoHandler* video0 = dynamic_cast<videoHandler*>(inputVideo[0].data());
@@ -117,16 +159,77 @@ void videoHandlerDifference::loadFrameDifference(int frameIndex, int frameIndex0
     video1->loadFrame(frameIndex1);
   
   // Calculate the difference  
-  QImage newFrame = inputVideo[0]->calculateDifference(inputVideo[1], frameIndex0, frameIndex1, differenceInfoList, amplificationFactor, markDifference);
+  QImage newFrame = inputVideo[0]->calculateDifference(inputVideo[1], frameIndex0, frameIndex1, infoList, amplificationFactor, markDifference);
 
+  // The YUV difference buffer of the first input is only valid until the next difference is calculated.
+  // So the position of the first difference must be found now.
   if (!newFrame.isNull())
   {
-    // The new difference frame is ready
-    currentImageIdx = frameIndex;
-    currentImageSetMutex.lock();
-    currentImage = newFrame;
-    currentImageSetMutex.unlock();
+    videoHandlerYUV *yuv0 = dynamic_cast<videoHandlerYUV*>(inputVideo[0].data());
+    if (yuv0 != nullptr && yuv0->getIs_YUV_diff())
+      calculateFirstDifferencePosition(newFrame, yuv0->getDiffYUV(), yuv0->getDiffYUVFormat(), firstDifferenceList);
+    else
+      calculateFirstDifferencePosition(newFrame, QByteArray(), YUV_Internals::yuvPixelFormat(), firstDifferenceList);
+  }
+
+  return newFrame;
+}
+
+QImage videoHandlerDifference::calculateDifferenceFrameForCaching(int frameIndex0, int frameIndex1, QList<infoItem> &infoList, QList<infoItem> &firstDifferenceList)
+{
+  // Only the caching paths of the inputs are used here. The current frame buffers of the inputs (and the
+  // YUV difference buffer) belong to the main thread.
+  QImage newFrame;
+  QByteArray diffYUV;
+  YUV_Internals::yuvPixelFormat diffYUVFormat;
+
+  videoHandlerYUV *yuv0 = dynamic_cast<videoHandlerYUV*>(inputVideo[0].data());
+  videoHandlerYUV *yuv1 = dynamic_cast<videoHandlerYUV*>(inputVideo[1].data());
+  videoHandlerRGB *rgb0 = dynamic_cast<videoHandlerRGB*>(inputVideo[0].data());
+  videoHandlerRGB *rgb1 = dynamic_cast<videoHandlerRGB*>(inputVideo[1].data());
+  if (yuv0 != nullptr && yuv1 != nullptr)
+    newFrame = yuv0->calculateDifferenceForCaching(yuv1, frameIndex0, frameIndex1, infoList, amplificationFactor, markDifference, diffYUV, diffYUVFormat);
+  else if (rgb0 != nullptr && rgb1 != nullptr)
+    newFrame = rgb0->calculateDifferenceForCaching(rgb1, frameIndex0, frameIndex1, infoList, amplificationFactor, markDifference);
+  else
+  {
+    // Compare the RGB values. Get the frames from the cache of the inputs or load them for caching.
+    // An input that is not a video (a single image) only has the one image.
+    videoHandler *video0 = dynamic_cast<videoHandler*>(inputVideo[0].data());
+    videoHandler *video1 = dynamic_cast<videoHandler*>(inputVideo[1].data());
+    QImage image0 = (video0 != nullptr) ? video0->getFrameForCaching(frameIndex0) : inputVideo[0]->getCurrentFrameAsImage();
+    QImage image1 = (video1 != nullptr) ? video1->getFrameForCaching(frameIndex1) : inputVideo[1]->getCurrentFrameAsImage();
+    newFrame = calculateImageDifference(image0, image1, infoList, amplificationFactor, markDifference);
   }
+
+  if (!newFrame.isNull())
+    calculateFirstDifferencePosition(newFrame, diffYUV, diffYUVFormat, firstDifferenceList);
+
+  return newFrame;
+}
+
+void videoHandlerDifference::removeFrameFromCache(int frameIdx)
+{
+  videoHandler::removeFrameFromCache(frameIdx);
+  QMutexLocker lock(&imageCacheAccess);
+  differenceInfoCache.remove(frameIdx);
+}
+
+void videoHandlerDifference::removeAllFrameFromCache()
+{
+  videoHandler::removeAllFrameFromCache();
+  QMutexLocker lock(&imageCacheAccess);
+  differenceInfoCache.clear();
+}
+
+void videoHandlerDifference::invalidateDifference()
+{
+  // Frames that are currently being cached are calculated from the old inputs. Don't add these.
+  QMutexLocker lock(&imageCacheAccess);
+  setCacheInvalid();
+  lock.unlock();
+
+  currentImageIdx = -1;
 }
 
 bool videoHandlerDifference::inputsValid() const
@@ -159,8 +262,9 @@ void videoHandlerDifference::setInputVideos(frameHandler *childVideo0, frameHand
       setFrameSize(diffSize);
     }
 
-    // If something changed, we might need a redraw
-    emit signalHandlerChanged(true, RECACHE_NONE);
+    // If something changed, we might need a redraw. The cached difference frames are invalid.
+    invalidateDifference();
+    emit signalHandlerChanged(true, RECACHE_CLEAR);
   }
 }
 
@@ -204,33 +308,37 @@ void videoHandlerDifference::slotDifferenceControlChanged()
   {
     markDifference = ui.markDifferenceCheckBox->isChecked();
 
-    // Set the current frame in the buffer to be invalid and emit the signal that something has changed
-    currentImageIdx = -1;
-    emit signalHandlerChanged(true, RECACHE_NONE);
+    // Set the current frame in the buffer to be invalid and emit the signal that something has changed.
+    // All cached difference frames are invalid now.
+    invalidateDifference();
+    emit signalHandlerChanged(true, RECACHE_CLEAR);
   }
   else if (sender == ui.codingOrderComboBox)
   {
     codingOrder = (CodingOrder)ui.codingOrderComboBox->currentIndex();
 
-     // The calculation of the first difference in coding order changed but no redraw is necessary
-    emit signalHandlerChanged(false, RECACHE_NONE);
+    // The calculation of the first difference in coding order changed. The position is calculated
+    // together with the difference, so the current and all cached frames have to be calculated again.
+    invalidateDifference();
+    emit signalHandlerChanged(true, RECACHE_CLEAR);
   }
   else if (sender == ui.amplificationFactorSpinBox)
   {
     amplificationFactor = ui.amplificationFactorSpinBox->value();
 
-    // Set the current frame in the buffer to be invalid and emit the signal that something has changed
-    currentImageIdx = -1;
-    emit signalHandlerChanged(true, RECACHE_NONE);
+    // Set the current frame in the buffer to be invalid and emit the signal that something has changed.
+    // All cached difference frames are invalid now.
+    invalidateDifference();
+    emit signalHandlerChanged(true, RECACHE_CLEAR);
   }
 }
 
-void videoHandlerDifference::reportFirstDifferencePosition(QList<infoItem> &infoList) const
+void videoHandlerDifference::calculateFirstDifferencePosition(const QImage &diffImg, const QByteArray &diffYUV, const YUV_Internals::yuvPixelFormat &diffYUVFormat, QList<infoItem> &infoList) const
 {
   if (!inputsValid())
     return;
 
-  if (currentImage.width() != frameSize.width() || currentImage.height() != frameSize.height())
+  if (diffImg.width() != frameSize.width() || diffImg.height() != frameSize.height())
     return;
 
   if (codingOrder == CodingOrder_HEVC)
@@ -251,12 +359,11 @@ void videoHandlerDifference::reportFirstDifferencePosition(QList<infoItem> &info
         int firstX, firstY, partIndex = 0;
 
 
-        videoHandlerYUV* video0 = dynamic_cast<videoHandlerYUV*>(inputVideo[0].data());
-        if(video0 != NULL && video0->getIs_YUV_diff())
+        if (!diffYUV.isEmpty())
         {
 
             // find first difference using YUV instead of QImage. The latter does not work for 10bit videos and very small differences, since it only supports 8bit
-            if (hierarchicalPositionYUV(x*64, y*64, 64, firstX, firstY, partIndex, video0->getDiffYUV(), video0->getDiffYUVFormat()))
+            if (hierarchicalPositionYUV(x*64, y*64, 64, firstX, firstY, partIndex, diffYUV, diffYUVFormat))
             {
               // We found a difference in this block
               infoList.append(infoItem("First Difference LCU", QString::number(y * widthLCU + x)));
@@ -269,7 +376,7 @@ void videoHandlerDifference::reportFirstDifferencePosition(QList<infoItem> &info
         }
         else
         {
-            if (hierarchicalPosition(x*64, y*64, 64, firstX, firstY, partIndex, currentImage))
+            if (hierarchicalPosition(x*64, y*64, 64, firstX, firstY, partIndex, diffImg))
             {
               // We found a difference in this block
               infoList.append(infoItem("First Difference LCU", QString::number(y * widthLCU + x)));
@@ -33,6 +33,8 @@
 #ifndef VIDEOHANDLERDIFFERENCE_H
 #define VIDEOHANDLERDIFFERENCE_H
 
+#include <QMap>
+#include <QMutex>
 #include <QPointer>
 
 #include "common/fileInfo.h"
@@ -54,6 +56,13 @@ public:
   explicit videoHandlerDifference();
 
   void loadFrameDifference(int frameIndex, int frameIndex0, int frameIndex1, bool loadToDoubleBuffer=false);
+  // Calculate the difference and put it into the cache (together with the difference info). This is called from a caching thread.
+  void cacheFrameDifference(int frameIndex, int frameIndex0, int frameIndex1, bool testMode);
+  // Overloaded from videoHandler. Also remove the difference info of the frame(s).
+  virtual void removeFrameFromCache(int frameIdx) Q_DECL_OVERRIDE;
+  virtual void removeAllFrameFromCache() Q_DECL_OVERRIDE;
+  // One of the inputs changed. The cache is invalid until the video cache cleared it.
+  void invalidateDifference();
   
   // Are both inputs valid and can be used?
   bool inputsValid() const;
@@ -70,8 +79,8 @@ public:
   // The difference overloads this and returns the difference values (A-B)
   virtual QStringPairList getPixelValues(const QPoint &pixelPos, int frameIdx, frameHandler *item2=nullptr, const int frameIdx1 = 0) Q_DECL_OVERRIDE;
 
-  // Calculate the position of the first difference and add the info to the list
-  void reportFirstDifferencePosition(QList<infoItem> &infoList) const;
+  // Add the position of the first difference (of the current frame) to the list
+  void reportFirstDifferencePosition(QList<infoItem> &infoList) const { infoList.append(firstDifferenceInfoList); }
     
 private slots:
   void slotDifferenceControlChanged();
@@ -91,6 +100,28 @@ private:
   // The two videos that the difference will be calculated from
   QPointer<frameHandler> inputVideo[2];  
 
+  // The difference is calculated from the current buffers of the inputs. Only one difference can be calculated at a time.
+  QMutex differenceMutex;
+  // Calculate the difference of the two inputs and the position of the first difference. Lock the differenceMutex first.
+  QImage calculateDifferenceFrame(int frameIndex0, int frameIndex1, QList<infoItem> &infoList, QList<infoItem> &firstDifferenceList);
+  // Same as calculateDifferenceFrame but only from local buffers (requested through the caching path of the inputs).
+  // This does not change any buffers of the inputs so it can run in multiple caching threads in parallel.
+  QImage calculateDifferenceFrameForCaching(int frameIndex0, int frameIndex1, QList<infoItem> &infoList, QList<infoItem> &firstDifferenceList);
+
+  // The position of the first difference in the current frame
+  QList<infoItem> firstDifferenceInfoList;
+  // The difference info of all cached frames (protected by the imageCacheAccess mutex)
+  struct cachedDifferenceInfo
+  {
+    QList<infoItem> differenceInfo;
+    QList<infoItem> firstDifference;
+  };
+  QMap<int, cachedDifferenceInfo> differenceInfoCache;
+
+  // Calculate the position of the first difference in the given difference image and add the info to the list
+  // If a YUV difference buffer is given, the position is searched in the YUV difference.
+  void calculateFirstDifferencePosition(const QImage &diffImg, const QByteArray &diffYUV, const YUV_Internals::yuvPixelFormat &diffYUVFormat, QList<infoItem> &infoList) const;
+
   // Recursively scan the LCU
   bool hierarchicalPosition(int x, int y, int blockSize, int &firstX, int &firstY, int &partIndex, const QImage &diffImg) const;
   bool hierarchicalPositionYUV(int x, int y, int blockSize, int &firstX, int &firstY, int &partIndex, const QByteArray &diffYUV, const YUV_Internals::yuvPixelFormat &diffYUVFormat) const;
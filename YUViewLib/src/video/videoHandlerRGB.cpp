@@ -36,6 +36,7 @@
 
 #include "common/functions.h"
 #include "common/fileInfo.h"
+#include "common/performanceProfiler.h"
 
 using namespace RGB_Internals;
 
@@ -330,6 +331,11 @@ QStringPairList videoHandlerRGB::getPixelValues(const QPoint &pixelPos, int fram
   return values;
 }
 
+QString videoHandlerRGB::getRawDataFormatKey() const
+{
+  return videoHandler::getRawDataFormatKey() + "|" + srcPixelFormat.getName();
+}
+
 QLayout *videoHandlerRGB::createVideoHandlerControls(bool isSizeFixed)
 {
   // Absolutely always only call this function once!
@@ -522,11 +528,12 @@ void videoHandlerRGB::loadFrameForCaching(int frameIndex, QImage &frameToCache)
   rgbFormatMutex.lock();
 
   requestDataMutex.lock();
-  emit signalRequestRawData(frameIndex, true);
+  requestRawDataForCaching(frameIndex);
   tmpBufferRawRGBDataCaching = rawData;
+  const int loadedFrameIdx = rawData_frameIdx;
   requestDataMutex.unlock();
 
-  if (frameIndex != rawData_frameIdx)
+  if (frameIndex != loadedFrameIdx)
   {
     // Loading failed
     currentImageIdx = -1;
@@ -579,11 +586,31 @@ bool videoHandlerRGB::loadRawRGBData(int frameIndex)
   return (currentFrameRawData_frameIdx == frameIndex);
 }
 
+bool videoHandlerRGB::loadRawRGBDataForCaching(int frameIndex, QByteArray &data, rgbPixelFormat &format, QSize &size)
+{
+  QMutexLocker formatLock(&rgbFormatMutex);
+  format = srcPixelFormat;
+  size = frameSize;
+
+  QMutexLocker lock(&requestDataMutex);
+  requestRawDataForCaching(frameIndex);
+  if (frameIndex != rawData_frameIdx || rawData.isEmpty())
+  {
+    // Loading failed
+    DEBUG_RGB("videoHandlerRGB::loadRawRGBDataForCaching %d Loading failed", frameIndex);
+    return false;
+  }
+
+  data = rawData;
+  return true;
+}
+
 // Convert the given raw RGB data in sourceBuffer (using srcPixelFormat) to image (RGB-888), using the
 // buffer tmpRGBBuffer for intermediate RGB values.
 void videoHandlerRGB::convertRGBToImage(const QByteArray &sourceBuffer, QImage &outputImage)
 {
   DEBUG_RGB("videoHandlerRGB::convertRGBToImage");
+  performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageConvertToRGB);
   QSize curFrameSize = frameSize;
 
   // Create the output image in the right format.
@@ -627,221 +654,200 @@ void videoHandlerRGB::setSrcPixelFormat(const RGB_Internals::rgbPixelFormat &new
   rgbFormatMutex.unlock();
 }
 
-// Convert the data in "sourceBuffer" from the format "srcPixelFormat" to RGB 888. While doing so, apply the
-// scaling factors, inversions and only convert the selected color components.
-void videoHandlerRGB::convertSourceToRGBA32Bit(const QByteArray &sourceBuffer, unsigned char *targetBuffer)
+namespace
 {
-  // Check if the source buffer is of the correct size
-  Q_ASSERT_X(sourceBuffer.size() >= getBytesPerFrame(), "videoHandlerRGB::convertSourceToRGB888", "The source buffer does not hold enough data.");
-
-  // Get the raw data pointer to the output array
-  unsigned char * restrict dst = targetBuffer;
-
-  // How many values do we have to skip in src to get to the next input value?
-  // In case of 8 or less bits this is 1 byte per value, for 9 to 16 bits it is 2 bytes per value.
-  int offsetToNextValue = srcPixelFormat.nrChannels();
-  if (srcPixelFormat.planar)
-    offsetToNextValue = 1;
-
-  if (componentDisplayMode != DisplayAll)
+  // A conversion kernel converts nrPixels values of the three given source channels to 8 bit BGRA. T is the
+  // type of one source value and srcStride the distance between two values of one channel (1 for planar
+  // formats, the number of channels for packed formats). With both known at compile time, the inner loops have
+  // no branches and no variable strides left so that the compiler can vectorize them.
+  typedef void (*rgbConversionKernel)(const unsigned char *srcR, const unsigned char *srcG, const unsigned char *srcB, unsigned char *dst, const int nrPixels, const int rightShift, const unsigned char * const lut[3]);
+
+  // No scaling, inversion or range conversion. Just shift the values down to 8 bit.
+  template<typename T, int srcStride>
+  void convertRGBToRGBA32ShiftKernel(const unsigned char *srcR, const unsigned char *srcG, const unsigned char *srcB, unsigned char *dst, const int nrPixels, const int rightShift, const unsigned char * const lut[3])
   {
-    // Only convert one of the components to a gray-scale image.
-    // Consider inversion and scale of that component
-
-    // Which component of the source do we need?
-    int displayComponentOffset = srcPixelFormat.posR;
-    if (componentDisplayMode == DisplayG)
-      displayComponentOffset = srcPixelFormat.posG;
-    else if (componentDisplayMode == DisplayG)
-      displayComponentOffset = srcPixelFormat.posB;
-
-    // Get the scale/inversion for the displayed component
-    const int displayIndex = (componentDisplayMode == DisplayR) ? 0 : (componentDisplayMode == DisplayG) ? 1 : 2;
-    const int scale = componentScale[displayIndex];
-    const bool invert = componentInvert[displayIndex];
-
-    if (srcPixelFormat.bitsPerValue > 8 && srcPixelFormat.bitsPerValue <= 16)
+    Q_UNUSED(lut);
+    const T * restrict r = (const T*)srcR;
+    const T * restrict g = (const T*)srcG;
+    const T * restrict b = (const T*)srcB;
+    unsigned char * restrict d = dst;
+    for (int i = 0; i < nrPixels; i++)
     {
-      // 9 to 16 bits per component. We assume two bytes per value.
-
-      // The source values have to be shifted left by this many bits to get 8 bit output
-      const int rightShift = srcPixelFormat.bitsPerValue - 8;
-
-      // First get the pointer to the first value that we will need.
-      unsigned short* src = (unsigned short*)sourceBuffer.data();
-      if (srcPixelFormat.planar)
-        src += displayComponentOffset * frameSize.width() * frameSize.height();
-      else
-        src += displayComponentOffset;
-
-      // Now we just have to iterate over all values and always skip "offsetToNextValue" values in src and write 3 values in dst.
-      for (int i = 0; i < frameSize.width() * frameSize.height(); i++)
-      {
-        int val = (((int)src[0]) * scale) >> rightShift;
-        val = clip(val, 0, 255);
-        if (invert)
-          val = 255 - val;
-        if (limitedRange)
-          val = videoHandler::convScaleLimitedRange(val);
-        dst[0] = val;
-        dst[1] = val;
-        dst[2] = val;
-        dst[3] = 255;
-
-        src += offsetToNextValue;
-        dst += 4;
-      }
+      const unsigned int valR = r[i * srcStride] >> rightShift;
+      const unsigned int valG = g[i * srcStride] >> rightShift;
+      const unsigned int valB = b[i * srcStride] >> rightShift;
+      d[i * 4    ] = (valB > 255) ? 255 : valB;
+      d[i * 4 + 1] = (valG > 255) ? 255 : valG;
+      d[i * 4 + 2] = (valR > 255) ? 255 : valR;
+      d[i * 4 + 3] = 255;
     }
-    else if (srcPixelFormat.bitsPerValue == 8)
-    {
-      // First get the pointer to the first value that we will need.
-      unsigned char* src = (unsigned char*)sourceBuffer.data();
-      if (srcPixelFormat.planar)
-        src += displayComponentOffset * frameSize.width() * frameSize.height();
-      else
-        src += displayComponentOffset;
+  }
 
-      // Now we just have to iterate over all values and always skip "offsetToNextValue" values in src and write 3 values in dst.
-      for (int i = 0; i < frameSize.width() * frameSize.height(); i++)
-      {
-        int val = ((int)src[0]) * scale;
-        val = clip(val, 0, 255);
-        if (invert)
-          val = 255 - val;
-        if (limitedRange)
-          val = videoHandler::convScaleLimitedRange(val);
-        dst[0] = val;
-        dst[1] = val;
-        dst[2] = val;
-        dst[3] = 255;
-
-        src += offsetToNextValue;
-        dst += 4;
-      }
+  // Scaling, inversion and range conversion were folded into one lookup table per component.
+  template<typename T, int srcStride>
+  void convertRGBToRGBA32LUTKernel(const unsigned char *srcR, const unsigned char *srcG, const unsigned char *srcB, unsigned char *dst, const int nrPixels, const int rightShift, const unsigned char * const lut[3])
+  {
+    Q_UNUSED(rightShift);
+    const T * restrict r = (const T*)srcR;
+    const T * restrict g = (const T*)srcG;
+    const T * restrict b = (const T*)srcB;
+    const unsigned char * restrict lutR = lut[0];
+    const unsigned char * restrict lutG = lut[1];
+    const unsigned char * restrict lutB = lut[2];
+    unsigned char * restrict d = dst;
+    for (int i = 0; i < nrPixels; i++)
+    {
+      d[i * 4    ] = lutB[b[i * srcStride]];
+      d[i * 4 + 1] = lutG[g[i * srcStride]];
+      d[i * 4 + 2] = lutR[r[i * srcStride]];
+      d[i * 4 + 3] = 255;
     }
-    else
-      Q_ASSERT_X(false, "videoHandlerRGB::convertSourceToRGB888", "No RGB format with less than 8 or more than 16 bits supported yet.");
   }
-  else if (componentDisplayMode == DisplayAll)
-  {
-    // Convert all components from the source RGB format to an RGB 888 array
 
-    if (srcPixelFormat.bitsPerValue > 8 && srcPixelFormat.bitsPerValue <= 16)
+  // Dispatch table indexed by [two bytes per value][source stride 1, 3 or 4][use lookup table]
+  const rgbConversionKernel rgbConversionKernels[2][3][2] =
+  {
     {
-      // 9 to 16 bits per component. We assume two bytes per value.
+      {convertRGBToRGBA32ShiftKernel<unsigned char, 1>, convertRGBToRGBA32LUTKernel<unsigned char, 1>},
+      {convertRGBToRGBA32ShiftKernel<unsigned char, 3>, convertRGBToRGBA32LUTKernel<unsigned char, 3>},
+      {convertRGBToRGBA32ShiftKernel<unsigned char, 4>, convertRGBToRGBA32LUTKernel<unsigned char, 4>}
+    },
+    {
+      {convertRGBToRGBA32ShiftKernel<unsigned short, 1>, convertRGBToRGBA32LUTKernel<unsigned short, 1>},
+      {convertRGBToRGBA32ShiftKernel<unsigned short, 3>, convertRGBToRGBA32LUTKernel<unsigned short, 3>},
+      {convertRGBToRGBA32ShiftKernel<unsigned short, 4>, convertRGBToRGBA32LUTKernel<unsigned short, 4>}
+    }
+  };
 
-      // The source values have to be shifted left by this many bits to get 8 bit output
-      const int rightShift = srcPixelFormat.bitsPerValue - 8;
+  // Fill the lookup table for one component. The table covers every value the source type can hold so that
+  // out of range values (e.g. set bits above the bit depth) are clipped like all other values.
+  void fillRGBConversionLUT(unsigned char *lut, const int lutSize, const int rightShift, const int scale, const bool invert, const bool limitedRange)
+  {
+    for (int i = 0; i < lutSize; i++)
+    {
+      int val = clip((i * scale) >> rightShift, 0, 255);
+      if (invert)
+        val = 255 - val;
+      if (limitedRange)
+        val = videoHandler::convScaleLimitedRange(val);
+      lut[i] = (unsigned char)val;
+    }
+  }
 
-      // First get the pointer to the first value of each channel.
-      unsigned short *srcR, *srcG, *srcB;
-      if (srcPixelFormat.planar)
-      {
-        srcR = (unsigned short*)sourceBuffer.data() + (srcPixelFormat.posR * frameSize.width() * frameSize.height());
-        srcG = (unsigned short*)sourceBuffer.data() + (srcPixelFormat.posG * frameSize.width() * frameSize.height());
-        srcB = (unsigned short*)sourceBuffer.data() + (srcPixelFormat.posB * frameSize.width() * frameSize.height());
-      }
-      else
-      {
-        srcR = (unsigned short*)sourceBuffer.data() + srcPixelFormat.posR;
-        srcG = (unsigned short*)sourceBuffer.data() + srcPixelFormat.posG;
-        srcB = (unsigned short*)sourceBuffer.data() + srcPixelFormat.posB;
-      }
+  // Only a few combinations are used at the same time (one per component at most). Start over if the cache
+  // grows beyond this because the user tried many settings.
+  const int conversionLUTCacheMaxSize = 16;
+}
 
-      // Now we just have to iterate over all values and always skip "offsetToNextValue" values in the sources and write 3 values in dst.
-      for (int i = 0; i < frameSize.width() * frameSize.height(); i++)
-      {
-        int valR = (((int)srcR[0]) * componentScale[0]) >> rightShift;
-        valR = clip(valR, 0, 255);
-        if (componentInvert[0])
-          valR = 255 - valR;
-        
-        int valG = (((int)srcG[0]) * componentScale[1]) >> rightShift;
-        valG = clip(valG, 0, 255);
-        if (componentInvert[1])
-          valG = 255 - valG;
-
-        int valB = (((int)srcB[0]) * componentScale[2]) >> rightShift;
-        valB = clip(valB, 0, 255);
-        if (componentInvert[2])
-          valB = 255 - valB;
-
-        if (limitedRange)
-        {
-          valR = videoHandler::convScaleLimitedRange(valR);
-          valG = videoHandler::convScaleLimitedRange(valG);
-          valB = videoHandler::convScaleLimitedRange(valB);
-        }
+bool videoHandlerRGB::conversionLUTKey::operator<(const conversionLUTKey &other) const
+{
+  if (scale != other.scale)
+    return scale < other.scale;
+  if (invert != other.invert)
+    return invert < other.invert;
+  if (limitedRange != other.limitedRange)
+    return limitedRange < other.limitedRange;
+  return bitDepth < other.bitDepth;
+}
 
-        srcR += offsetToNextValue;
-        srcG += offsetToNextValue;
-        srcB += offsetToNextValue;
+// Get the lookup table for the given parameters. It is filled on the first request and reused for all
+// following frames. The returned copy is implicitly shared, so it stays valid even if the cache is cleared.
+QByteArray videoHandlerRGB::getConversionLUT(const conversionLUTKey &key)
+{
+  QMutexLocker lock(&conversionLUTCacheMutex);
+  auto it = conversionLUTCache.constFind(key);
+  if (it != conversionLUTCache.constEnd())
+    return it.value();
+
+  const int lutSize = (key.bitDepth > 8) ? 65536 : 256;
+  QByteArray lut(lutSize, 0);
+  fillRGBConversionLUT((unsigned char*)lut.data(), lutSize, key.bitDepth - 8, key.scale, key.invert, key.limitedRange);
+
+  if (conversionLUTCache.size() >= conversionLUTCacheMaxSize)
+    conversionLUTCache.clear();
+  conversionLUTCache.insert(key, lut);
+  DEBUG_RGB("videoHandlerRGB::getConversionLUT new table scale %d invert %d limitedRange %d bitDepth %d", key.scale, key.invert, key.limitedRange, key.bitDepth);
+  return lut;
+}
 
-        dst[0] = valB;
-        dst[1] = valG;
-        dst[2] = valR;
-        dst[3] = 255;
-        dst += 4;
-      }
-    }
-    else if (srcPixelFormat.bitsPerValue == 8)
-    {
-      // First get the pointer to the first value of each channel.
-      unsigned char *srcR, *srcG, *srcB;
-      if (srcPixelFormat.planar)
-      {
-        srcR = (unsigned char*)sourceBuffer.data() + (srcPixelFormat.posR * frameSize.width() * frameSize.height());
-        srcG = (unsigned char*)sourceBuffer.data() + (srcPixelFormat.posG * frameSize.width() * frameSize.height());
-        srcB = (unsigned char*)sourceBuffer.data() + (srcPixelFormat.posB * frameSize.width() * frameSize.height());
-      }
-      else
-      {
-        srcR = (unsigned char*)sourceBuffer.data() + srcPixelFormat.posR;
-        srcG = (unsigned char*)sourceBuffer.data() + srcPixelFormat.posG;
-        srcB = (unsigned char*)sourceBuffer.data() + srcPixelFormat.posB;
-      }
+// Convert the data in "sourceBuffer" from the format "srcPixelFormat" to RGB 888. While doing so, apply the
+// scaling factors, inversions and only convert the selected color components.
+void videoHandlerRGB::convertSourceToRGBA32Bit(const QByteArray &sourceBuffer, unsigned char *targetBuffer)
+{
+  // Check if the source buffer is of the correct size
+  Q_ASSERT_X(sourceBuffer.size() >= getBytesPerFrame(), "videoHandlerRGB::convertSourceToRGB888", "The source buffer does not hold enough data.");
 
-      // Now we just have to iterate over all values and always skip "offsetToNextValue" values in the sources and write 3 values in dst.
-      for (int i = 0; i < frameSize.width() * frameSize.height(); i++)
-      {
-        int valR = ((int)srcR[0]) * componentScale[0];
-        valR = clip(valR, 0, 255);
-        if (componentInvert[0])
-          valR = 255 - valR;
-
-        int valG = ((int)srcG[0]) * componentScale[1];
-        valG = clip(valG, 0, 255);
-        if (componentInvert[1])
-          valG = 255 - valG;
-
-        int valB = ((int)srcB[0]) * componentScale[2];
-        valB = clip(valB, 0, 255);
-        if (componentInvert[2])
-          valB = 255 - valB;
-
-        if (limitedRange)
-        {
-          valR = videoHandler::convScaleLimitedRange(valR);
-          valG = videoHandler::convScaleLimitedRange(valG);
-          valB = videoHandler::convScaleLimitedRange(valB);
-        }
+  if (srcPixelFormat.bitsPerValue < 8 || srcPixelFormat.bitsPerValue > 16)
+  {
+    Q_ASSERT_X(false, "videoHandlerRGB::convertSourceToRGB888", "No RGB format with less than 8 or more than 16 bits supported yet.");
+    return;
+  }
 
-        srcR += offsetToNextValue;
-        srcG += offsetToNextValue;
-        srcB += offsetToNextValue;
+  // 9 to 16 bits per component. We assume two bytes per value.
+  const bool twoBytes = (srcPixelFormat.bitsPerValue > 8);
+  const int bytesPerValue = twoBytes ? 2 : 1;
+  // The source values have to be shifted right by this many bits to get 8 bit output
+  const int rightShift = srcPixelFormat.bitsPerValue - 8;
+  const int nrPixels = frameSize.width() * frameSize.height();
 
-        dst[0] = valB;
-        dst[1] = valG;
-        dst[2] = valR;
-        dst[3] = 255;
-        dst += 4;
-      }
+  // How many values do we have to skip in src to get to the next input value?
+  const int offsetToNextValue = srcPixelFormat.planar ? 1 : srcPixelFormat.nrChannels();
+  // Get the offset (in values) of the first value of a channel in the source.
+  auto channelOffset = [&](int channelPos) { return srcPixelFormat.planar ? channelPos * nrPixels : channelPos; };
+  const unsigned char *src = (const unsigned char*)sourceBuffer.data();
+
+  // Per displayed output channel (R, G, B): the source pointer, scale and inversion.
+  const unsigned char *srcChannel[3];
+  int scale[3];
+  bool invert[3];
+  if (componentDisplayMode == DisplayAll)
+  {
+    srcChannel[0] = src + channelOffset(srcPixelFormat.posR) * bytesPerValue;
+    srcChannel[1] = src + channelOffset(srcPixelFormat.posG) * bytesPerValue;
+    srcChannel[2] = src + channelOffset(srcPixelFormat.posB) * bytesPerValue;
+    for (int c = 0; c < 3; c++)
+    {
+      scale[c] = componentScale[c];
+      invert[c] = componentInvert[c];
     }
-    else
-      Q_ASSERT_X(false, "videoHandlerRGB::convertSourceToRGB888", "No RGB format with less than 8 or more than 16 bits supported yet.");
   }
   else
-    Q_ASSERT_X(false, "videoHandlerRGB::convertSourceToRGB888", "Unsupported display mode.");
+  {
+    // Only convert one of the components to a gray-scale image.
+    // Consider inversion and scale of that component
+    const int displayIndex = (componentDisplayMode == DisplayR) ? 0 : (componentDisplayMode == DisplayG) ? 1 : 2;
+    const int displayComponentPos = (displayIndex == 0) ? srcPixelFormat.posR : (displayIndex == 1) ? srcPixelFormat.posG : srcPixelFormat.posB;
+    for (int c = 0; c < 3; c++)
+    {
+      srcChannel[c] = src + channelOffset(displayComponentPos) * bytesPerValue;
+      scale[c] = componentScale[displayIndex];
+      invert[c] = componentInvert[displayIndex];
+    }
+  }
+
+  // Scaling, inversion and range conversion are only applied through the lookup tables. Without them, the
+  // values only have to be shifted.
+  bool useLUT = limitedRange;
+  for (int c = 0; c < 3; c++)
+    if (scale[c] != 1 || invert[c])
+      useLUT = true;
+
+  // Hold a reference to the tables while converting so that they can not be freed by another thread.
+  QByteArray lutBuffer[3];
+  const unsigned char *lut[3] = {nullptr, nullptr, nullptr};
+  if (useLUT)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      lutBuffer[c] = getConversionLUT({scale[c], invert[c], limitedRange, srcPixelFormat.bitsPerValue});
+      lut[c] = (const unsigned char*)lutBuffer[c].constData();
+    }
+  }
+
+  const int strideIdx = (offsetToNextValue == 1) ? 0 : (offsetToNextValue == 3) ? 1 : 2;
+  Q_ASSERT_X(offsetToNextValue == 1 || offsetToNextValue == 3 || offsetToNextValue == 4, "videoHandlerRGB::convertSourceToRGB888", "Unsupported number of channels.");
+  rgbConversionKernel kernel = rgbConversionKernels[twoBytes ? 1 : 0][strideIdx][useLUT ? 1 : 0];
+  kernel(srcChannel[0], srcChannel[1], srcChannel[2], targetBuffer, nrPixels, rightShift, lut);
 }
 
 videoHandlerRGB::rgba_t videoHandlerRGB::getPixelValue(const QPoint &pixelPos) const
@@ -1088,9 +1094,6 @@ QImage videoHandlerRGB::calculateDifference(frameHandler *item2, const int frame
     // The two items have different bit depths. Compare RGB 888 values instead.
     return videoHandler::calculateDifference(item2, frameIdxItem0, frameIdxItem1, differenceInfoList, amplificationFactor, markDifference);
 
-  const int width  = qMin(frameSize.width(), rgbItem2->frameSize.width());
-  const int height = qMin(frameSize.height(), rgbItem2->frameSize.height());
-
   // Load the right raw RGB data (if not already loaded).
   // This will just update the raw RGB data. No conversion to image (RGB) is performed. This is either
   // done on request if the frame is actually shown or has already been done by the caching process.
@@ -1099,6 +1102,36 @@ QImage videoHandlerRGB::calculateDifference(frameHandler *item2, const int frame
   if (!rgbItem2->loadRawRGBData(frameIdxItem1))
     return QImage();  // Loading failed
 
+  return calculateDifferenceRGB(currentFrameRawData, frameSize, rgbItem2->currentFrameRawData, rgbItem2->frameSize, srcPixelFormat, differenceInfoList, amplificationFactor, markDifference);
+}
+
+QImage videoHandlerRGB::calculateDifferenceForCaching(videoHandlerRGB *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference)
+{
+  // Get the raw data of both items through the caching path. The current buffers of the items are not touched.
+  QByteArray data[2];
+  rgbPixelFormat format[2];
+  QSize size[2];
+  if (!loadRawRGBDataForCaching(frameIdxItem0, data[0], format[0], size[0]))
+    return QImage();  // Loading failed
+  if (!item2->loadRawRGBDataForCaching(frameIdxItem1, data[1], format[1], size[1]))
+    return QImage();  // Loading failed
+
+  if (format[0].bitsPerValue != format[1].bitsPerValue)
+  {
+    // The two items have different bit depths. Compare RGB 888 values instead.
+    QImage image0 = getFrameForCaching(frameIdxItem0);
+    QImage image1 = item2->getFrameForCaching(frameIdxItem1);
+    return calculateImageDifference(image0, image1, differenceInfoList, amplificationFactor, markDifference);
+  }
+
+  return calculateDifferenceRGB(data[0], size[0], data[1], size[1], format[0], differenceInfoList, amplificationFactor, markDifference);
+}
+
+QImage videoHandlerRGB::calculateDifferenceRGB(const QByteArray &data0, const QSize &size0, const QByteArray &data1, const QSize &size1, const rgbPixelFormat &format, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference) const
+{
+  const int width  = qMin(size0.width(), size1.width());
+  const int height = qMin(size0.height(), size1.height());
+
   // Also calculate the MSE while we're at it (R,G,B)
   int64_t mseAdd[3] = {0, 0, 0};
 
@@ -1106,69 +1139,69 @@ QImage videoHandlerRGB::calculateDifference(frameHandler *item2, const int frame
   // In both cases, we will set the alpha channel to 255. The format of the raw buffer is: BGRA (each 8 bit).
   QImage outputImage;
   if (is_Q_OS_WIN)
-    outputImage = QImage(frameSize, QImage::Format_ARGB32_Premultiplied);
+    outputImage = QImage(size0, QImage::Format_ARGB32_Premultiplied);
   else if (is_Q_OS_MAC)
-    outputImage = QImage(frameSize, QImage::Format_RGB32);
+    outputImage = QImage(size0, QImage::Format_RGB32);
   else if (is_Q_OS_LINUX)
   {
     QImage::Format f = functions::platformImageFormat();
     if (f == QImage::Format_ARGB32_Premultiplied)
-      outputImage = QImage(frameSize, QImage::Format_ARGB32_Premultiplied);
+      outputImage = QImage(size0, QImage::Format_ARGB32_Premultiplied);
     if (f == QImage::Format_ARGB32)
-      outputImage = QImage(frameSize, QImage::Format_ARGB32);
+      outputImage = QImage(size0, QImage::Format_ARGB32);
     else
-      outputImage = QImage(frameSize, QImage::Format_RGB32);
+      outputImage = QImage(size0, QImage::Format_RGB32);
   }
 
   // We directly write the difference values into the QImage buffer in the right format (ABGR).
   unsigned char * restrict dst = outputImage.bits();
 
-  if (srcPixelFormat.bitsPerValue >= 8 && srcPixelFormat.bitsPerValue <= 16)
+  if (format.bitsPerValue >= 8 && format.bitsPerValue <= 16)
   {
     // How many values do we have to skip in src to get to the next input value?
     // In case of 8 or less bits this is 1 byte per value, for 9 to 16 bits it is 2 bytes per value.
-    int offsetToNextValue = srcPixelFormat.nrChannels();
-    if (srcPixelFormat.planar)
+    int offsetToNextValue = format.nrChannels();
+    if (format.planar)
       offsetToNextValue = 1;
 
-    if (srcPixelFormat.bitsPerValue > 8 && srcPixelFormat.bitsPerValue <= 16)
+    if (format.bitsPerValue > 8 && format.bitsPerValue <= 16)
     {
       // 9 to 16 bits per component. We assume two bytes per value.
       // First get the pointer to the first value of each channel. (this item)
       unsigned short *srcR0, *srcG0, *srcB0;
-      if (srcPixelFormat.planar)
+      if (format.planar)
       {
-        srcR0 = (unsigned short*)currentFrameRawData.data() + (srcPixelFormat.posR * frameSize.width() * frameSize.height());
-        srcG0 = (unsigned short*)currentFrameRawData.data() + (srcPixelFormat.posG * frameSize.width() * frameSize.height());
-        srcB0 = (unsigned short*)currentFrameRawData.data() + (srcPixelFormat.posB * frameSize.width() * frameSize.height());
+        srcR0 = (unsigned short*)data0.data() + (format.posR * size0.width() * size0.height());
+        srcG0 = (unsigned short*)data0.data() + (format.posG * size0.width() * size0.height());
+        srcB0 = (unsigned short*)data0.data() + (format.posB * size0.width() * size0.height());
       }
       else
       {
-        srcR0 = (unsigned short*)currentFrameRawData.data() + srcPixelFormat.posR;
-        srcG0 = (unsigned short*)currentFrameRawData.data() + srcPixelFormat.posG;
-        srcB0 = (unsigned short*)currentFrameRawData.data() + srcPixelFormat.posB;
+        srcR0 = (unsigned short*)data0.data() + format.posR;
+        srcG0 = (unsigned short*)data0.data() + format.posG;
+        srcB0 = (unsigned short*)data0.data() + format.posB;
       }
 
       // Next get the pointer to the first value of each channel. (the other item)
       unsigned short *srcR1, *srcG1, *srcB1;
-      if (srcPixelFormat.planar)
+      if (format.planar)
       {
-        srcR1 = (unsigned short*)rgbItem2->currentFrameRawData.data() + (srcPixelFormat.posR * frameSize.width() * frameSize.height());
-        srcG1 = (unsigned short*)rgbItem2->currentFrameRawData.data() + (srcPixelFormat.posG * frameSize.width() * frameSize.height());
-        srcB1 = (unsigned short*)rgbItem2->currentFrameRawData.data() + (srcPixelFormat.posB * frameSize.width() * frameSize.height());
+        srcR1 = (unsigned short*)data1.data() + (format.posR * size0.width() * size0.height());
+        srcG1 = (unsigned short*)data1.data() + (format.posG * size0.width() * size0.height());
+        srcB1 = (unsigned short*)data1.data() + (format.posB * size0.width() * size0.height());
       }
       else
       {
-        srcR1 = (unsigned short*)rgbItem2->currentFrameRawData.data() + srcPixelFormat.posR;
-        srcG1 = (unsigned short*)rgbItem2->currentFrameRawData.data() + srcPixelFormat.posG;
-        srcB1 = (unsigned short*)rgbItem2->currentFrameRawData.data() + srcPixelFormat.posB;
+        srcR1 = (unsigned short*)data1.data() + format.posR;
+        srcG1 = (unsigned short*)data1.data() + format.posG;
+        srcB1 = (unsigned short*)data1.data() + format.posB;
       }
 
       for (int y = 0; y < height; y++)
       {
         for (int x = 0; x < width; x++)
         {
-          unsigned int offsetCoordinate = frameSize.width() * y + x;
+          unsigned int offsetCoordinate = size0.width() * y + x;
 
           unsigned int R0 = (unsigned int)(*(srcR0 + offsetToNextValue * offsetCoordinate));
           unsigned int G0 = (unsigned int)(*(srcG0 + offsetToNextValue * offsetCoordinate));
@@ -1205,43 +1238,43 @@ QImage videoHandlerRGB::calculateDifference(frameHandler *item2, const int frame
         }
       }
     }
-    else if (srcPixelFormat.bitsPerValue == 8)
+    else if (format.bitsPerValue == 8)
     {
       // First get the pointer to the first value of each channel. (this item)
       unsigned char *srcR0, *srcG0, *srcB0;
-      if (srcPixelFormat.planar)
+      if (format.planar)
       {
-        srcR0 = (unsigned char*)currentFrameRawData.data() + (srcPixelFormat.posR * frameSize.width() * frameSize.height());
-        srcG0 = (unsigned char*)currentFrameRawData.data() + (srcPixelFormat.posG * frameSize.width() * frameSize.height());
-        srcB0 = (unsigned char*)currentFrameRawData.data() + (srcPixelFormat.posB * frameSize.width() * frameSize.height());
+        srcR0 = (unsigned char*)data0.data() + (format.posR * size0.width() * size0.height());
+        srcG0 = (unsigned char*)data0.data() + (format.posG * size0.width() * size0.height());
+        srcB0 = (unsigned char*)data0.data() + (format.posB * size0.width() * size0.height());
       }
       else
       {
-        srcR0 = (unsigned char*)currentFrameRawData.data() + srcPixelFormat.posR;
-        srcG0 = (unsigned char*)currentFrameRawData.data() + srcPixelFormat.posG;
-        srcB0 = (unsigned char*)currentFrameRawData.data() + srcPixelFormat.posB;
+        srcR0 = (unsigned char*)data0.data() + format.posR;
+        srcG0 = (unsigned char*)data0.data() + format.posG;
+        srcB0 = (unsigned char*)data0.data() + format.posB;
       }
 
       // First get the pointer to the first value of each channel. (other item)
       unsigned char *srcR1, *srcG1, *srcB1;
-      if (srcPixelFormat.planar)
+      if (format.planar)
       {
-        srcR1 = (unsigned char*)rgbItem2->currentFrameRawData.data() + (srcPixelFormat.posR * frameSize.width() * frameSize.height());
-        srcG1 = (unsigned char*)rgbItem2->currentFrameRawData.data() + (srcPixelFormat.posG * frameSize.width() * frameSize.height());
-        srcB1 = (unsigned char*)rgbItem2->currentFrameRawData.data() + (srcPixelFormat.posB * frameSize.width() * frameSize.height());
+        srcR1 = (unsigned char*)data1.data() + (format.posR * size0.width() * size0.height());
+        srcG1 = (unsigned char*)data1.data() + (format.posG * size0.width() * size0.height());
+        srcB1 = (unsigned char*)data1.data() + (format.posB * size0.width() * size0.height());
       }
       else
       {
-        srcR1 = (unsigned char*)rgbItem2->currentFrameRawData.data() + srcPixelFormat.posR;
-        srcG1 = (unsigned char*)rgbItem2->currentFrameRawData.data() + srcPixelFormat.posG;
-        srcB1 = (unsigned char*)rgbItem2->currentFrameRawData.data() + srcPixelFormat.posB;
+        srcR1 = (unsigned char*)data1.data() + format.posR;
+        srcG1 = (unsigned char*)data1.data() + format.posG;
+        srcB1 = (unsigned char*)data1.data() + format.posB;
       }
 
       for (int y = 0; y < height; y++)
       {
         for (int x = 0; x < width; x++)
         {
-          unsigned int offsetCoordinate = frameSize.width() * y + x;
+          unsigned int offsetCoordinate = size0.width() * y + x;
 
           unsigned int R0 = (unsigned int)(*(srcR0 + offsetToNextValue * offsetCoordinate));
           unsigned int G0 = (unsigned int)(*(srcG0 + offsetToNextValue * offsetCoordinate));
@@ -1283,7 +1316,7 @@ QImage videoHandlerRGB::calculateDifference(frameHandler *item2, const int frame
   }
 
   // Append the conversion information that will be returned
-  differenceInfoList.append(infoItem("Difference Type", QString("RGB %1bit").arg(srcPixelFormat.bitsPerValue)));
+  differenceInfoList.append(infoItem("Difference Type", QString("RGB %1bit").arg(format.bitsPerValue)));
   double mse[4];
   mse[0] = double(mseAdd[0]) / (width * height);
   mse[1] = double(mseAdd[1]) / (width * height);
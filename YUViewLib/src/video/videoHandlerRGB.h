@@ -133,6 +133,9 @@ public:
   // we will use the videoHandler::calculateDifference function to calculate the difference
   // using the 8bit RGB values.
   virtual QImage calculateDifference(frameHandler *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference) Q_DECL_OVERRIDE;
+  // Calculate the difference to the other RGB item from a caching thread. The raw data of both items is requested
+  // through the caching path. The current buffers (currentFrameRawData and currentImage) are not used or changed.
+  QImage calculateDifferenceForCaching(videoHandlerRGB *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference);
   
   // Load the given frame and convert it to image. After this, currentFrameRawRGBData and currentFrame will
   // contain the frame with the given frame index.
@@ -174,6 +177,9 @@ protected:
   bool componentInvert[3] {false, false, false};
   bool limitedRange {false};
 
+  // The disk cache key must change if the format of the raw RGB data changes
+  virtual QString getRawDataFormatKey() const Q_DECL_OVERRIDE;
+
   // Get the RGB values for the given pixel.
   struct rgba_t
   {
@@ -190,6 +196,11 @@ private:
   // Load the raw RGB data for the given frame index into currentFrameRawRGBData.
   // Return false is loading failed.
   bool loadRawRGBData(int frameIndex);
+  // Get a copy of the raw RGB data (and the format/size of it) for a caching thread. The current buffers are not changed.
+  bool loadRawRGBDataForCaching(int frameIndex, QByteArray &data, RGB_Internals::rgbPixelFormat &format, QSize &size);
+
+  // Calculate the difference of the two given raw buffers (which must have the same bit depth)
+  QImage calculateDifferenceRGB(const QByteArray &data0, const QSize &size0, const QByteArray &data1, const QSize &size1, const RGB_Internals::rgbPixelFormat &format, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference) const;
 
   // Convert from RGB (which ever format is selected) to a QImage in the platform QImage format (platformImageFormat)
   void convertRGBToImage(const QByteArray &sourceBuffer, QImage &outputImage);
@@ -201,6 +212,20 @@ private:
   void convertSourceToRGBA32Bit(const QByteArray &sourceBuffer, unsigned char *targetBuffer);
   QByteArray tmpBufferRawRGBDataCaching;
 
+  // The lookup tables for the conversion to 8 bit are only filled again if one of their parameters changes.
+  // The tables are shared between the main thread and the caching threads.
+  struct conversionLUTKey
+  {
+    int scale;
+    bool invert;
+    bool limitedRange;
+    int bitDepth;
+    bool operator<(const conversionLUTKey &other) const;
+  };
+  QByteArray getConversionLUT(const conversionLUTKey &key);
+  QMap<conversionLUTKey, QByteArray> conversionLUTCache;
+  QMutex conversionLUTCacheMutex;
+
   // When a caching job is running in the background it will lock this mutex, so that
   // the main thread does not change the RGB format while this is happening.
   QMutex rgbFormatMutex;
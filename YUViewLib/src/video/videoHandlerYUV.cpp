@@ -33,13 +33,23 @@
 #include "videoHandlerYUV.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <xmmintrin.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SSE2_UNPACKING 1
+#else
+#define SSE2_UNPACKING 0
+#endif
 #include <QDir>
 #include <QPainter>
+#include <QtConcurrent>
+#include <QVector>
 
 #include "common/fileInfo.h"
 #include "common/functions.h"
+#include "common/performanceProfiler.h"
 
 using namespace YUV_Internals;
 
@@ -85,7 +95,7 @@ const QStringList detectionSubsamplingNameList = QStringList() << "444" << "422"
 QList<YUVPackingOrder> getSupportedPackingFormats(YUVSubsamplingType subsampling)
 {
   if (subsampling == YUV_422)
-    return QList<YUVPackingOrder>() << Packing_UYVY << Packing_VYUY << Packing_YUYV << Packing_YVYU;
+    return QList<YUVPackingOrder>() << Packing_UYVY << Packing_VYUY << Packing_YUYV << Packing_YVYU << Packing_V210;
   if (subsampling == YUV_444)
     return QList<YUVPackingOrder>() << Packing_YUV << Packing_YVU << Packing_AYUV << Packing_YUVA;
 
@@ -154,6 +164,8 @@ QString getPackingFormatString(YUVPackingOrder packing)
     return "YUYV";
   if (packing == Packing_YVYU)
     return "YVYU";
+  if (packing == Packing_V210)
+    return "V210";
   return "";
 }
 
@@ -203,6 +215,45 @@ double computeMSE(T ptr, T ptr2, int numPixels)
   return (double)sad / numPixels;
 }
 
+#if SSE2_UNPACKING
+// SSE2 version for 8 bit samples. 16 samples are processed per iteration. The squared differences are summed
+// in 32 bit lanes which are flushed to the 64 bit sum before they can overflow.
+double computeMSE(const unsigned char *ptr, const unsigned char *ptr2, int numPixels)
+{
+  if (numPixels <= 0)
+    return 0.0;
+
+  const __m128i zero = _mm_setzero_si128();
+  uint64_t sad = 0;
+  int i = 0;
+  while (i + 16 <= numPixels)
+  {
+    // Every 32 bit lane gets at most 4*255^2 per iteration
+    const int blockEnd = std::min(numPixels - 15, i + 16 * 4096);
+    __m128i sum = _mm_setzero_si128();
+    for (; i < blockEnd; i += 16)
+    {
+      const __m128i a = _mm_loadu_si128((const __m128i*)(ptr + i));
+      const __m128i b = _mm_loadu_si128((const __m128i*)(ptr2 + i));
+      const __m128i diffLow  = _mm_sub_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+      const __m128i diffHigh = _mm_sub_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(diffLow, diffLow));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(diffHigh, diffHigh));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, sum);
+    sad += uint64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+  }
+  for (; i < numPixels; i++)
+  {
+    int diff = (int)ptr[i] - (int)ptr2[i];
+    sad += diff*diff;
+  }
+
+  return (double)sad / numPixels;
+}
+#endif
+
 namespace YUV_Internals
 {
   yuvPixelFormat::yuvPixelFormat()
@@ -220,7 +271,7 @@ namespace YUV_Internals
 
   yuvPixelFormat::yuvPixelFormat(const QString &name)
   {
-    QRegExp rxYUVFormat("([YUVA]{3,6}(?:\\(IL\\))?) (4:[420]{1}:[420]{1}) ([0-9]{1,2})-bit[ ]?([BL]{1}E)?[ ]?(packed|packed-B)?[ ]?(Cx[0-9]+)?[ ]?(Cy[0-9]+)?");
+    QRegExp rxYUVFormat("([YUVA]{3,6}(?:\\(IL\\))?|V210) (4:[420]{1}:[420]{1}) ([0-9]{1,2})-bit[ ]?([BL]{1}E)?[ ]?(packed|packed-B)?[ ]?(Cx[0-9]+)?[ ]?(Cy[0-9]+)?");
 
     if (rxYUVFormat.exactMatch(name))
     {
@@ -251,7 +302,7 @@ namespace YUV_Internals
       else
       {
         //static const QStringList orderNames = QStringList() << "YUV" << "YVU" << "AYUV" << "YUVA" << "UYVU" << "VYUY" << "YUYV" << "YVYU" << "YYYYUV" << "YYUYYV" << "UYYVYY" << "VYYUYY";
-        static const QStringList orderNames = QStringList() << "YUV" << "YVU" << "AYUV" << "YUVA" << "UYVU" << "VYUY" << "YUYV" << "YVYU";
+        static const QStringList orderNames = QStringList() << "YUV" << "YVU" << "AYUV" << "YUVA" << "UYVY" << "VYUY" << "YUYV" << "YVYU" << "V210";
         int idx = orderNames.indexOf(rxYUVFormat.cap(1));
         if (idx == -1)
           return;
@@ -313,6 +364,9 @@ namespace YUV_Internals
         return false;
       if ((packingOrder == Packing_UYVY || packingOrder == Packing_VYUY || packingOrder == Packing_YUYV || packingOrder == Packing_YVYU) && subsampling != YUV_422)
         return false;
+      if (packingOrder == Packing_V210 && (subsampling != YUV_422 || bitsPerSample != 10 || bigEndian))
+        // V210 is always 10 bit little endian 4:2:2
+        return false;
       if (packingOrder >= Packing_NUM)
         return false;
       /*if ((packingOrder == Packing_YYYYUV || packingOrder == Packing_YYUYYV || packingOrder == Packing_UYYVYY || packingOrder == Packing_VYYUYY) && subsampling == YUV_420)
@@ -386,7 +440,7 @@ namespace YUV_Internals
       name += (bigEndian) ? " BE" : " LE";
 
     if (!planar && subsampling != YUV_400)
-      name += bytePacking ? " packed-B" : " packed";
+      name += (bytePacking && packingOrder != Packing_V210) ? " packed-B" : " packed";
 
     // Add the Chroma offsets (if it is not the default offset)
     if (!isDefaultChromaFormat(chromaOffset[0], true, subsampling))
@@ -400,6 +454,12 @@ namespace YUV_Internals
   int64_t yuvPixelFormat::bytesPerFrame(const QSize &frameSize) const
   {
     int64_t bytes = 0;
+    if (!planar && packingOrder == Packing_V210)
+    {
+      // Groups of 6 pixels are packed into 16 bytes. Each line is padded to a multiple of 48 pixels (128 bytes).
+      const int64_t bytesPerLine = (frameSize.width() + 47) / 48 * 128;
+      return bytesPerLine * frameSize.height();
+    }
     if (planar || !bytePacking)
     {
       // Add the bytes of the 3 (or 4) planes.
@@ -910,6 +970,13 @@ QLayout *videoHandlerYUV::createVideoHandlerControls(bool isSizeFixed)
   ui.chromaInterpolationComboBox->setEnabled(srcPixelFormat.subsampled());
   ui.colorConversionComboBox->addItems(QStringList() << "ITU-R.BT709" << "ITU-R.BT709 Full Range" << "ITU-R.BT601" << "ITU-R.BT601 Full Range" << "ITU-R.BT2020" << "ITU-R.BT2020 Full Range" );
   ui.colorConversionComboBox->setCurrentIndex((int)yuvColorConversionType);
+  ui.outputModeComboBox->addItem("8 bit RGB");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+  ui.outputModeComboBox->addItems(QStringList() << "16 bit RGB" << "16 bit RGB, PQ to SDR" << "16 bit RGB, HLG to SDR");
+#else
+  ui.outputModeComboBox->setEnabled(false);
+#endif
+  ui.outputModeComboBox->setCurrentIndex((int)outputMode);
   ui.lumaScaleSpinBox->setValue(mathParameters[Luma].scale);
   ui.lumaOffsetSpinBox->setMaximum(1000);
   ui.lumaOffsetSpinBox->setValue(mathParameters[Luma].offset);
@@ -924,6 +991,7 @@ QLayout *videoHandlerYUV::createVideoHandlerControls(bool isSizeFixed)
   connect(ui.colorComponentsComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &videoHandlerYUV::slotYUVControlChanged);
   connect(ui.chromaInterpolationComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &videoHandlerYUV::slotYUVControlChanged);
   connect(ui.colorConversionComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &videoHandlerYUV::slotYUVControlChanged);
+  connect(ui.outputModeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &videoHandlerYUV::slotYUVControlChanged);
   connect(ui.lumaScaleSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &videoHandlerYUV::slotYUVControlChanged);
   connect(ui.lumaOffsetSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &videoHandlerYUV::slotYUVControlChanged);
   connect(ui.lumaInvertCheckBox, &QCheckBox::stateChanged, this, &videoHandlerYUV::slotYUVControlChanged);
@@ -1039,6 +1107,7 @@ void videoHandlerYUV::slotYUVControlChanged()
   if (sender == ui.colorComponentsComboBox ||
            sender == ui.chromaInterpolationComboBox ||
            sender == ui.colorConversionComboBox ||
+           sender == ui.outputModeComboBox ||
            sender == ui.lumaScaleSpinBox ||
            sender == ui.lumaOffsetSpinBox ||
            sender == ui.lumaInvertCheckBox ||
@@ -1049,6 +1118,7 @@ void videoHandlerYUV::slotYUVControlChanged()
     componentDisplayMode = (ComponentDisplayMode)ui.colorComponentsComboBox->currentIndex();
     interpolationMode = (InterpolationMode)ui.chromaInterpolationComboBox->currentIndex();
     yuvColorConversionType = (ColorConversion)ui.colorConversionComboBox->currentIndex();
+    outputMode = (OutputMode)ui.outputModeComboBox->currentIndex();
     mathParameters[Luma].scale = ui.lumaScaleSpinBox->value();
     mathParameters[Luma].offset = ui.lumaOffsetSpinBox->value();
     mathParameters[Luma].invert = ui.lumaInvertCheckBox->isChecked();
@@ -1156,13 +1226,30 @@ QStringPairList videoHandlerYUV::getPixelValues(const QPoint &pixelPos, int fram
     int width = frameSize.width();
     int height = frameSize.height();
 
-    // Do not get the pixel values if the buffer for the raw YUV values is out of date.
-    if (currentFrameRawData_frameIdx != frameIdx)
-      return QStringPairList();
-
     if (pixelPos.x() < 0 || pixelPos.x() >= width || pixelPos.y() < 0 || pixelPos.y() >= height)
       return QStringPairList();
 
+    if (currentFrameRawData_frameIdx != frameIdx)
+    {
+      // The buffer for the raw YUV values is out of date. If the frame was converted to 16 bit RGB,
+      // we can show the RGB values from the converted frame without loading the raw data again.
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+      currentImageSetMutex.lock();
+      const QImage image = currentImage;
+      const bool imageValid = (currentImageIdx == frameIdx);
+      currentImageSetMutex.unlock();
+
+      if (imageValid && image.format() == QImage::Format_RGBA64 && image.rect().contains(pixelPos))
+      {
+        const QRgba64 value = reinterpret_cast<const QRgba64*>(image.constScanLine(pixelPos.y()))[pixelPos.x()];
+        values.append(QStringPair("R", QString::number(value.red(), formatBase)));
+        values.append(QStringPair("G", QString::number(value.green(), formatBase)));
+        values.append(QStringPair("B", QString::number(value.blue(), formatBase)));
+      }
+#endif
+      return values;
+    }
+
     const yuv_t value = getPixelValue(pixelPos);
 
     if (showPixelValuesAsDiff)
@@ -1464,14 +1551,17 @@ bool videoHandlerYUV::setFormatFromSizeAndNamePacked(QString name, const QSize s
         {
           auto createFormatAndCheck = [packing, subsampling, bitDepth, endianess, name, size, fileSize, this](QString formatName)
           {
-            if (bitDepth > 8)
+            if (bitDepth > 8 && packing != Packing_V210)
               formatName += QString::number(bitDepth) + endianess;
             auto fmt = yuvPixelFormat(subsampling, bitDepth, packing, false, endianess=="be");
             // Check if this format is in the file name
             return name.contains(formatName) && checkAndSetFormat(fmt, size, fileSize);
           };
 
-          QString formatName = getPackingFormatString(packing).toLower() + yuvSubsamplingTypeToString(subsampling);
+          // The subsampling and bit depth of V210 are implicit
+          QString formatName = getPackingFormatString(packing).toLower();
+          if (packing != Packing_V210)
+            formatName += yuvSubsamplingTypeToString(subsampling);
           if (createFormatAndCheck(formatName))
             return true;
 
@@ -1641,20 +1731,14 @@ void videoHandlerYUV::setFormatFromSizeAndName(const QSize size, int bitDepth, b
   * If a file size is given, we test if the candidates frame size is a multiple of the fileSize. If fileSize is -1, this test
   * is skipped.
   */
-void videoHandlerYUV::setFormatFromCorrelation(const QByteArray &rawYUVData, int64_t fileSize)
-{
-  if(rawYUVData.size() < 1)
-    return;
+// Format candidates with an MSE between the first two frames at or above this are not used
+static const double correlationMSEThreshold = 400.0;
 
-  class testFormatAndSize
-  {
-  public:
-    testFormatAndSize(const QSize &size, yuvPixelFormat format) : size(size), format(format) { interesting = false; mse = 0; }
-    QSize size;
-    yuvPixelFormat format;
-    bool interesting;
-    double mse;
-  };
+QList<videoHandlerYUV::formatCandidate> videoHandlerYUV::getFormatCandidatesFromCorrelation(const QByteArray &rawYUVData, int64_t fileSize)
+{
+  QList<formatCandidate> candidates;
+  if (rawYUVData.size() < 1 || fileSize <= 0)
+    return candidates;
 
   // The candidates for the size
   const QList<QSize> testSizes = QList<QSize>()
@@ -1673,91 +1757,111 @@ void videoHandlerYUV::setFormatFromCorrelation(const QByteArray &rawYUVData, int
     << QSize(1920, 1072)
     << QSize(1920, 1080);
 
-  // Test bit depths 8, 10 and 16
-  QList<testFormatAndSize> formatList;
+  // Test bit depths 8, 10 and 16 with all subsampling modes. Only keep the candidates that fit the file size:
+  // At least two pictures for the correlation analysis and the file size must be a multiple of the picture size.
   for (int b = 0; b < 3; b++)
   {
     int bits = (b==0) ? 8 : (b==1) ? 10 : 16;
-    // Test all subsampling modes
     for (int i = 0; i < YUV_NUM_SUBSAMPLINGS; i++)
     {
       YUVSubsamplingType subsampling = static_cast<YUVSubsamplingType>(i);
       for (const QSize &size : testSizes)
       {
-        formatList.append(testFormatAndSize(size, yuvPixelFormat(subsampling, bits, Order_YUV)));
+        formatCandidate candidate;
+        candidate.size = size;
+        candidate.format = yuvPixelFormat(subsampling, bits, Order_YUV);
+        candidate.mse = std::numeric_limits<double>::max();
+        candidate.confidence = 0.0;
+
+        const int64_t picSize = candidate.format.bytesPerFrame(size);
+        const int64_t lumaBytes = int64_t(size.width()) * size.height() * ((bits > 8) ? 2 : 1);
+        if (picSize <= 0 || fileSize < picSize * 2 || (fileSize % picSize) != 0)
+          continue;
+        // Both luma planes must be inside of the sample window
+        if (picSize + lumaBytes > rawYUVData.size())
+          continue;
+        candidates.append(candidate);
       }
     }
   }
 
-  if (fileSize > 0)
+  // The MSE only depends on the picture size, the number of luma samples and the bytes per sample. Many
+  // candidates (e.g. 10 and 16 bit) share these so each combination only has to be calculated once.
+  struct correlationTest
   {
-    // if any candidate exceeds file size for two frames, discard
-    // if any candidate does not represent a multiple of file size, discard
-    bool found = false;
-
-    for (testFormatAndSize &testFormat : formatList)
-    {
-      int64_t picSize = testFormat.format.bytesPerFrame(testFormat.size);
-
-      if(fileSize >= (picSize*2))       // at least 2 pictures for correlation analysis
-      {
-        if((fileSize % picSize) == 0)   // important: file size must be multiple of the picture size
-        {
-          testFormat.interesting = true;  // test passed
-          found = true;
-        }
-      }
-    }
-
-    if(!found)
-      // No candidate matches the file size
-      return;
+    int64_t picSize;
+    int lumaSamples;
+    bool twoBytes;
+    double mse;
+  };
+  QVector<correlationTest> tests;
+  QVector<int> testIndex;
+  for (const formatCandidate &candidate : candidates)
+  {
+    correlationTest t;
+    t.picSize = candidate.format.bytesPerFrame(candidate.size);
+    t.lumaSamples = candidate.size.width() * candidate.size.height();
+    t.twoBytes = (candidate.format.bitsPerSample > 8);
+    t.mse = 0;
+    int idx = 0;
+    while (idx < tests.size() && !(tests[idx].picSize == t.picSize && tests[idx].lumaSamples == t.lumaSamples && tests[idx].twoBytes == t.twoBytes))
+      idx++;
+    if (idx == tests.size())
+      tests.append(t);
+    testIndex.append(idx);
   }
 
-  // calculate max. correlation for first two frames, use max. candidate frame size
-  for (testFormatAndSize &testFormat : formatList)
+  // Calculate the MSE between the luma planes of the first two frames for all tests in parallel
+  const char *data = rawYUVData.constData();
+  QtConcurrent::blockingMap(tests, [data](correlationTest &t)
   {
-    if (testFormat.interesting)
+    if (t.twoBytes)
     {
-      int64_t picSize = testFormat.format.bytesPerFrame(testFormat.size);
-      int lumaSamples = testFormat.size.width() * testFormat.size.height();
-
-      // Calculate the MSE for 2 frames
-      if (testFormat.format.bitsPerSample == 8)
-      {
-        unsigned char *ptr = (unsigned char*) rawYUVData.data();
-        testFormat.mse = computeMSE(ptr, ptr + picSize, lumaSamples);
-      }
-      else if (testFormat.format.bitsPerSample > 8 && testFormat.format.bitsPerSample <= 16)
-      {
-        unsigned short *ptr = (unsigned short*) rawYUVData.data();
-        testFormat.mse = computeMSE(ptr, ptr + picSize/2, lumaSamples);
-      }
-      else
-        // Not handled here
-        continue;
+      const unsigned short *ptr = (const unsigned short*)data;
+      t.mse = computeMSE(ptr, ptr + t.picSize/2, t.lumaSamples);
     }
-  }
-
-  // step3: select best candidate
-  double leastMSE = std::numeric_limits<double>::max(); // large error...
-  yuvPixelFormat bestFormat;
-  QSize bestSize;
-  for (const testFormatAndSize &testFormat : formatList)
-  {
-    if (testFormat.interesting && testFormat.mse < leastMSE)
+    else
     {
-      bestFormat = testFormat.format;
-      bestSize = testFormat.size;
-      leastMSE = testFormat.mse;
+      const unsigned char *ptr = (const unsigned char*)data;
+      t.mse = computeMSE(ptr, ptr + t.picSize, t.lumaSamples);
     }
+  });
+
+  // Rank the candidates. The confidence falls linearly from 1 (identical frames) to 0 at the MSE threshold.
+  for (int i = 0; i < candidates.size(); i++)
+  {
+    candidates[i].mse = tests[testIndex[i]].mse;
+    candidates[i].confidence = clip(1.0 - candidates[i].mse / correlationMSEThreshold, 0.0, 1.0);
   }
+  std::stable_sort(candidates.begin(), candidates.end(), [](const formatCandidate &c1, const formatCandidate &c2) { return c1.mse < c2.mse; });
+
+  return candidates;
+}
+
+bool videoHandlerYUV::getFormatFromCorrelation(const QByteArray &rawYUVData, int64_t fileSize, QSize &size, yuvPixelFormat &format)
+{
+  const QList<formatCandidate> candidates = getFormatCandidatesFromCorrelation(rawYUVData, fileSize);
+  if (candidates.isEmpty())
+    // No candidate matches the file size
+    return false;
 
-  if(leastMSE < 400)
+  if (candidates.first().mse >= correlationMSEThreshold)
+    return false;
+
+  // MSE is below threshold. Choose the candidate.
+  size = candidates.first().size;
+  format = candidates.first().format;
+  return true;
+}
+
+void videoHandlerYUV::setFormatFromCorrelation(const QByteArray &rawYUVData, int64_t fileSize)
+{
+  QSize size;
+  yuvPixelFormat format;
+  if (getFormatFromCorrelation(rawYUVData, fileSize, size, format))
   {
-    // MSE is below threshold. Choose the candidate.
-    setSrcPixelFormat(bestFormat, false);
-    setFrameSize(bestSize);
+    setSrcPixelFormat(format, false);
+    setFrameSize(size);
   }
 }
 
@@ -1797,16 +1901,12 @@ void videoHandlerYUV::loadFrameForCaching(int frameIndex, QImage &frameToCache)
 {
   DEBUG_YUV("videoHandlerYUV::loadFrameForCaching %d", frameIndex);
 
-  // Get the YUV format and the size here, so that the caching process does not crash if this changes.
-  yuvPixelFormat yuvFormat = srcPixelFormat;
-  const QSize curFrameSize = frameSize;
-
-  requestDataMutex.lock();
-  emit signalRequestRawData(frameIndex, true);
-  QByteArray tmpBufferRawYUVDataCaching = rawData;
-  requestDataMutex.unlock();
-
-  if (frameIndex != rawData_frameIdx)
+  // The frame index of the raw data is checked while the requestDataMutex is still locked. Another caching
+  // thread may request the next frame as soon as it is unlocked.
+  QByteArray tmpBufferRawYUVDataCaching;
+  yuvPixelFormat yuvFormat;
+  QSize curFrameSize;
+  if (!loadRawYUVDataForCaching(frameIndex, tmpBufferRawYUVDataCaching, yuvFormat, curFrameSize))
   {
     // Loading failed
     DEBUG_YUV("videoHandlerYUV::loadFrameForCaching Loading failed");
@@ -1847,6 +1947,25 @@ bool videoHandlerYUV::loadRawYUVData(int frameIndex)
   return true;
 }
 
+bool videoHandlerYUV::loadRawYUVDataForCaching(int frameIndex, QByteArray &data, yuvPixelFormat &format, QSize &size)
+{
+  // Get the YUV format and the size here, so that the caching process does not crash if this changes.
+  format = srcPixelFormat;
+  size = frameSize;
+
+  QMutexLocker lock(&requestDataMutex);
+  requestRawDataForCaching(frameIndex);
+  if (frameIndex != rawData_frameIdx || rawData.isEmpty())
+  {
+    // Loading failed
+    DEBUG_YUV("videoHandlerYUV::loadRawYUVDataForCaching %d Loading failed", frameIndex);
+    return false;
+  }
+
+  data = rawData;
+  return true;
+}
+
 inline int clip8Bit(int val)
 {
   if (val < 0)
@@ -2963,18 +3082,143 @@ inline void YUVPlaneToRGB_411(const int w, const int h, const yuvMathParameters
   }
 }
 
+// Unpack V210 (10 bit 4:2:2) to planar 16 bit samples. Each group of four 32 bit little endian words holds
+// 6 pixels with 3 samples per word: U0 Y0 V0 | Y1 U2 Y2 | V2 Y3 U4 | Y4 V4 Y5
+void unpackV210ToPlanar(const unsigned char *src, unsigned short *dstY, unsigned short *dstU, unsigned short *dstV, const int w, const int h)
+{
+  const int bytesPerLine = (w + 47) / 48 * 128;
+  for (int y = 0; y < h; y++)
+  {
+    const unsigned char * restrict srcLine = src + y * bytesPerLine;
+    unsigned short * restrict lineY = dstY + y * w;
+    unsigned short * restrict lineU = dstU + y * (w / 2);
+    unsigned short * restrict lineV = dstV + y * (w / 2);
+
+    for (int x = 0; x < w; x += 6)
+    {
+      unsigned short samples[12];
+      for (int i = 0; i < 4; i++)
+      {
+        const uint32_t word = uint32_t(srcLine[0]) | (uint32_t(srcLine[1]) << 8) | (uint32_t(srcLine[2]) << 16) | (uint32_t(srcLine[3]) << 24);
+        samples[i*3]   = word & 0x3ff;
+        samples[i*3+1] = (word >> 10) & 0x3ff;
+        samples[i*3+2] = (word >> 20) & 0x3ff;
+        srcLine += 4;
+      }
+
+      // The last group in a line may be incomplete
+      const int nrPixels = std::min(6, w - x);
+      for (int i = 0; i < nrPixels; i++)
+        lineY[x + i] = samples[i*2+1];
+      for (int i = 0; i < nrPixels / 2; i++)
+      {
+        lineU[x/2 + i] = samples[i*4];
+        lineV[x/2 + i] = samples[i*4+2];
+      }
+    }
+  }
+}
+
+// Get the sample with the given index from a block of samples that are bit packed (MSB first).
+inline unsigned int getBitPackedSample(const unsigned char *block, const int sampleIdx, const int bitsPerSample)
+{
+  const int bitPos = sampleIdx * bitsPerSample;
+  const unsigned char *src = block + bitPos / 8;
+  const int bitOffset = bitPos % 8;
+  const int nrBytes = (bitOffset + bitsPerSample + 7) / 8;
+  uint32_t window = 0;
+  for (int i = 0; i < nrBytes; i++)
+    window = (window << 8) | src[i];
+  return (window >> (nrBytes * 8 - bitOffset - bitsPerSample)) & ((1u << bitsPerSample) - 1);
+}
+
+// Unpack bit packed samples to planar. Each block of samples (4 for 4:2:2, 3 or 4 for 4:4:4) starts at a byte boundary.
+// T is the type of the output samples (unsigned char for up to 8 bit, unsigned short above).
+template<typename T>
+void unpackBitPackedToPlanar(const unsigned char *src, T *dstY, T *dstU, T *dstV, const int nrBlocks, const int samplesPerBlock, const int bitsPerSample, const int oY, const int oU, const int oV, const bool twoLumaSamples)
+{
+  const int bytesPerBlock = (samplesPerBlock * bitsPerSample + 7) / 8;
+  for (int i = 0; i < nrBlocks; i++)
+  {
+    *dstY++ = T(getBitPackedSample(src, oY, bitsPerSample));
+    if (twoLumaSamples)
+      *dstY++ = T(getBitPackedSample(src, oY + 2, bitsPerSample));
+    *dstU++ = T(getBitPackedSample(src, oU, bitsPerSample));
+    *dstV++ = T(getBitPackedSample(src, oV, bitsPerSample));
+    src += bytesPerBlock;
+  }
+}
+
 bool videoHandlerYUV::convertYUVPackedToPlanar(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &curFrameSize, yuvPixelFormat &sourceBufferFormat)
 {
   const yuvPixelFormat format = sourceBufferFormat;
   const YUVPackingOrder packing = format.packingOrder;
 
+  const int w = curFrameSize.width();
+  const int h = curFrameSize.height();
+
+  if (sourceBuffer.size() < format.bytesPerFrame(curFrameSize))
+    return false;
+
+  if (packing == Packing_V210 || (format.bytePacking && format.bitsPerSample % 8 != 0))
+  {
+    // The samples are not aligned to bytes. Unpack them to a planar format with one sample per byte (up to 8 bit)
+    // or two bytes per sample (little endian).
+    yuvPixelFormat planarFormat(format.subsampling, format.bitsPerSample, Order_YUV);
+    planarFormat.chromaOffset[0] = format.chromaOffset[0];
+    planarFormat.chromaOffset[1] = format.chromaOffset[1];
+    targetBuffer.resize(planarFormat.bytesPerFrame(curFrameSize));
+
+    const int chromaSize = (format.subsampling == YUV_422) ? w/2*h : w*h;
+    const unsigned char *src = (const unsigned char*)sourceBuffer.data();
+    if (packing == Packing_V210)
+    {
+      unsigned short *dstY = (unsigned short*)targetBuffer.data();
+      unpackV210ToPlanar(src, dstY, dstY + w*h, dstY + w*h + chromaSize, w, h);
+    }
+    else
+    {
+      int samplesPerBlock, oY, oU, oV, nrBlocks;
+      if (format.subsampling == YUV_422)
+      {
+        samplesPerBlock = 4;
+        nrBlocks = w*h/2;
+        oY = (packing == Packing_YUYV || packing == Packing_YVYU) ? 0 : 1;
+        oU = (packing == Packing_UYVY) ? 0 : (packing == Packing_YUYV) ? 1 : (packing == Packing_VYUY) ? 2 : 3;
+        oV = (packing == Packing_VYUY) ? 0 : (packing == Packing_YVYU) ? 1 : (packing == Packing_UYVY) ? 2 : 3;
+      }
+      else if (format.subsampling == YUV_444)
+      {
+        samplesPerBlock = (packing == Packing_YUV || packing == Packing_YVU) ? 3 : 4;
+        nrBlocks = w*h;
+        oY = (packing == Packing_AYUV) ? 1 : 0;
+        oU = (packing == Packing_YUV || packing == Packing_YUVA) ? 1 : 2;
+        oV = (packing == Packing_YVU) ? 1 : (packing == Packing_AYUV) ? 3 : 2;
+      }
+      else
+        return false;
+
+      const bool twoLumaSamples = (format.subsampling == YUV_422);
+      if (format.bitsPerSample > 8)
+      {
+        unsigned short *dstY = (unsigned short*)targetBuffer.data();
+        unpackBitPackedToPlanar(src, dstY, dstY + w*h, dstY + w*h + chromaSize, nrBlocks, samplesPerBlock, format.bitsPerSample, oY, oU, oV, twoLumaSamples);
+      }
+      else
+      {
+        unsigned char *dstY = (unsigned char*)targetBuffer.data();
+        unpackBitPackedToPlanar(src, dstY, dstY + w*h, dstY + w*h + chromaSize, nrBlocks, samplesPerBlock, format.bitsPerSample, oY, oU, oV, twoLumaSamples);
+      }
+    }
+
+    sourceBufferFormat = planarFormat;
+    return true;
+  }
+
   // Make sure that the target buffer is big enough. It should be as big as the input buffer.
   if (targetBuffer.size() != sourceBuffer.size())
     targetBuffer.resize(sourceBuffer.size());
 
-  const int w = curFrameSize.width();
-  const int h = curFrameSize.height();
-
   // Bytes per sample
   const int bps = (format.bitsPerSample > 8) ? 2 : 1;
 
@@ -2996,7 +3240,34 @@ bool videoHandlerYUV::convertYUVPackedToPlanar(const QByteArray &sourceBuffer, Q
       unsigned char * restrict dstU = dstY + w*h;
       unsigned char * restrict dstV = dstU + w/2*h;
 
-      for (int i = 0; i < nr4Samples; i++)
+      int i = 0;
+#if SSE2_UNPACKING
+      // Unpack 8 blocks (16 pixels) at a time. The luma samples are either the odd or the even bytes, the
+      // chroma samples are the other ones. These are split again in the first and second chroma component.
+      const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+      const bool lumaOdd = (oY == 1);
+      const bool uFirst = (oU < oV);
+      for (; i + 8 <= nr4Samples; i += 8)
+      {
+        const __m128i in0 = _mm_loadu_si128((const __m128i*)src);
+        const __m128i in1 = _mm_loadu_si128((const __m128i*)(src + 16));
+        const __m128i odd  = _mm_packus_epi16(_mm_srli_epi16(in0, 8), _mm_srli_epi16(in1, 8));
+        const __m128i even = _mm_packus_epi16(_mm_and_si128(in0, lowBytes), _mm_and_si128(in1, lowBytes));
+        const __m128i luma   = lumaOdd ? odd : even;
+        const __m128i chroma = lumaOdd ? even : odd;
+        const __m128i chroma0 = _mm_packus_epi16(_mm_and_si128(chroma, lowBytes), _mm_setzero_si128());
+        const __m128i chroma1 = _mm_packus_epi16(_mm_srli_epi16(chroma, 8), _mm_setzero_si128());
+
+        _mm_storeu_si128((__m128i*)dstY, luma);
+        _mm_storel_epi64((__m128i*)dstU, uFirst ? chroma0 : chroma1);
+        _mm_storel_epi64((__m128i*)dstV, uFirst ? chroma1 : chroma0);
+        src += 32;
+        dstY += 16;
+        dstU += 8;
+        dstV += 8;
+      }
+#endif
+      for (; i < nr4Samples; i++)
       {
         *dstY++ = src[oY];
         *dstY++ = src[oY+2];
@@ -3239,6 +3510,216 @@ bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, ucha
   return true;
 }
 
+// Get the display light (in cd/m2) for the given PQ (SMPTE ST 2084) coded value (0...1)
+inline double pqToDisplayLight(const double value)
+{
+  const double m1 = 2610.0 / 16384;
+  const double m2 = 2523.0 / 4096 * 128;
+  const double c1 = 3424.0 / 4096;
+  const double c2 = 2413.0 / 4096 * 32;
+  const double c3 = 2392.0 / 4096 * 32;
+
+  const double vp = std::pow(value, 1.0 / m2);
+  const double l = std::pow(std::max(vp - c1, 0.0) / (c2 - c3 * vp), 1.0 / m1);
+  return l * 10000;
+}
+
+// Get the normalized scene light (0...1) for the given HLG (ARIB STD-B67) coded value (0...1). This is the inverse OETF.
+inline double hlgToSceneLight(const double value)
+{
+  const double a = 0.17883277;
+  const double b = 1 - 4 * a;
+  const double c = 0.5 - a * std::log(4 * a);
+
+  return (value <= 0.5) ? value * value / 3 : (std::exp((value - c) / a) + b) / 12;
+}
+
+// Map the display light (in cd/m2) to an SDR code value (0...1). The HDR reference white (203 cd/m2, ITU-R BT.2408)
+// is mapped to SDR white. Highlights up to 1000 cd/m2 are compressed (extended Reinhard) instead of clipped.
+inline double displayLightToSDR(const double nits)
+{
+  const double referenceWhite = 203.0;
+  const double maxWhite = 1000.0 / referenceWhite;
+
+  const double l = nits / referenceWhite;
+  const double mapped = std::min(l * (1 + l / (maxWhite * maxWhite)) / (1 + l), 1.0);
+  // Apply the inverse of the BT.1886 EOTF (gamma 2.4)
+  return std::pow(mapped, 1 / 2.4);
+}
+
+// Create a lookup table that maps 16 bit PQ code values to 16 bit SDR code values
+QVector<quint16> createPQToneMappingLUT()
+{
+  QVector<quint16> lut(65536);
+  for (int i = 0; i < 65536; i++)
+  {
+    const double nits = pqToDisplayLight(double(i) / 65535);
+    lut[i] = quint16(clip(int(displayLightToSDR(nits) * 65535 + 0.5), 0, 65535));
+  }
+  return lut;
+}
+
+// Get the tone mapping lookup table for the given output mode (nullptr if no per component tone mapping is performed).
+// The table is only created once (the first time it is needed). This is thread-safe.
+const quint16 *getToneMappingLUT(const OutputMode mode)
+{
+  if (mode == Output16BitPQ)
+  {
+    static const QVector<quint16> lutPQ = createPQToneMappingLUT();
+    return lutPQ.constData();
+  }
+  return nullptr;
+}
+
+// The HLG OOTF (ITU-R BT.2100) is not a per component function. The display light of each component is
+// Fd = Lw * Ys^(gamma-1) * Es where Ys is the scene luminance. We assume a nominal peak luminance Lw of
+// 1000 cd/m2 (system gamma 1.2). The nonlinear parts are split into lookup tables.
+struct HLGToneMappingTables
+{
+  // The normalized scene light Es (0...1) for each 16 bit HLG code value (inverse OETF)
+  QVector<float> sceneLight;
+  // The OOTF gain Ys^(gamma-1) for the scene luminance Ys quantized to 16 bit
+  QVector<float> ootfGain;
+  // The 16 bit SDR code value for the normalized display light Fd/Lw quantized to 20 bit.
+  // More bits than for the input are used because the gamma of the SDR output is steep for dark values.
+  QVector<quint16> displayLightToSDR;
+};
+
+HLGToneMappingTables createHLGToneMappingTables()
+{
+  const double peakLuminance = 1000.0;
+  const double systemGamma = 1.2;
+  const int displayLightMax = (1 << 20) - 1;
+
+  HLGToneMappingTables tables;
+  tables.sceneLight.resize(65536);
+  tables.ootfGain.resize(65536);
+  for (int i = 0; i < 65536; i++)
+  {
+    tables.sceneLight[i] = float(hlgToSceneLight(double(i) / 65535));
+    tables.ootfGain[i] = float(std::pow(double(i) / 65535, systemGamma - 1));
+  }
+  tables.displayLightToSDR.resize(displayLightMax + 1);
+  for (int i = 0; i <= displayLightMax; i++)
+  {
+    const double nits = double(i) / displayLightMax * peakLuminance;
+    tables.displayLightToSDR[i] = quint16(clip(int(displayLightToSDR(nits) * 65535 + 0.5), 0, 65535));
+  }
+  return tables;
+}
+
+// Get the HLG tone mapping tables. They are only created once (the first time they are needed). This is thread-safe.
+const HLGToneMappingTables &getHLGToneMappingTables()
+{
+  static const HLGToneMappingTables tables = createHLGToneMappingTables();
+  return tables;
+}
+
+// Apply the HLG OOTF on the scene luminance and map the resulting display light to SDR
+inline void convertHLGToSDR(quint16 &r, quint16 &g, quint16 &b, const HLGToneMappingTables &tables)
+{
+  const float * restrict sceneLight = tables.sceneLight.constData();
+  const quint16 * restrict toSDR = tables.displayLightToSDR.constData();
+  const int displayLightMax = tables.displayLightToSDR.size() - 1;
+
+  const float sceneR = sceneLight[r];
+  const float sceneG = sceneLight[g];
+  const float sceneB = sceneLight[b];
+  // The luma weights of ITU-R BT.2100
+  const float sceneY = 0.2627f * sceneR + 0.6780f * sceneG + 0.0593f * sceneB;
+  const float gain = tables.ootfGain[clip(int(sceneY * 65535 + 0.5f), 0, 65535)] * displayLightMax;
+
+  r = toSDR[clip(int(sceneR * gain + 0.5f), 0, displayLightMax)];
+  g = toSDR[clip(int(sceneG * gain + 0.5f), 0, displayLightMax)];
+  b = toSDR[clip(int(sceneB * gain + 0.5f), 0, displayLightMax)];
+}
+
+// Scale the fixed point result of the YUV -> RGB conversion (see convertYUVToRGB8Bit) to 16 bit, clip it and apply
+// the tone mapping (if any). The 8 bit result would be (value >> shift). Multiplying by 257 maps 0...255 to 0...65535.
+inline quint16 convertToRGB16(const int64_t value, const int shift, const quint16 *toneMappingLUT)
+{
+  const int v = int(clip<int64_t>((value * 257) >> shift, 0, 65535));
+  return toneMappingLUT ? toneMappingLUT[v] : quint16(v);
+}
+
+bool videoHandlerYUV::convertYUVPlanarToRGB64(const QByteArray &sourceBuffer, QImage &outputImage, const QSize &curFrameSize, const yuvPixelFormat &sourceBufferFormat) const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+  const yuvPixelFormat format = sourceBufferFormat;
+  const ColorConversion conversion = yuvColorConversionType;
+  const int w = curFrameSize.width();
+  const int h = curFrameSize.height();
+
+  if (outputImage.format() != QImage::Format_RGBA64 || outputImage.size() != curFrameSize)
+    return false;
+
+  const int bps = format.bitsPerSample;
+  const bool fullRange = (conversion == BT709_FullRange || conversion == BT601_FullRange || conversion == BT2020_FullRange);
+
+  // The luma component has full resolution. The size of each chroma components depends on the subsampling.
+  const int subH = format.getSubsamplingHor();
+  const int subV = format.getSubsamplingVer();
+  const int widthChroma = w / subH;
+  const int componentSizeLuma = (w * h);
+  const int componentSizeChroma = widthChroma * (h / subV);
+  const int nrBytesLumaPlane = (bps > 8) ? componentSizeLuma * 2 : componentSizeLuma;
+  const int nrBytesChromaPlane = (bps > 8) ? componentSizeChroma * 2 : componentSizeChroma;
+
+  // If the U and V (and A if present) components are interlevaed, we have to skip every nth value in the input when reading U and V
+  const int inputValSkip = format.uvInterleaved ? ((format.planeOrder == Order_YUV || format.planeOrder == Order_YVU) ? 2 : 3) : 1;
+  const int nrBytesToNextChromaPlane = format.uvInterleaved ? ((bps > 8) ? 2 : 1) : nrBytesChromaPlane;
+  const bool uPlaneFirst = (format.planeOrder == Order_YUV || format.planeOrder == Order_YUVA);
+
+  const unsigned char * restrict srcY = (unsigned char*)sourceBuffer.data();
+  const unsigned char * restrict srcU = uPlaneFirst ? srcY + nrBytesLumaPlane : srcY + nrBytesLumaPlane + nrBytesToNextChromaPlane;
+  const unsigned char * restrict srcV = uPlaneFirst ? srcY + nrBytesLumaPlane + nrBytesToNextChromaPlane : srcY + nrBytesLumaPlane;
+
+  // Use the same fixed point coefficients as the 8 bit conversion. The intermediate values are kept in 64 bit
+  // so that no precision of the source has to be dropped (the 8 bit conversion drops 2 bits for more than 14 bits).
+  const int * const RGBConv = yuvRgbConvCoeffs[conversion];
+  const int yOffset = fullRange ? 0 : 16 << (bps - 8);
+  const int cZero = 128 << (bps - 8);
+  const int shift = 16 + bps - 8;
+
+  const quint16 *toneMappingLUT = getToneMappingLUT(outputMode);
+  const HLGToneMappingTables *hlgTables = (outputMode == Output16BitHLG) ? &getHLGToneMappingTables() : nullptr;
+
+  for (int y = 0; y < h; y++)
+  {
+    QRgba64 * restrict dst = reinterpret_cast<QRgba64*>(outputImage.scanLine(y));
+    const int lineOffsetLuma = y * w;
+    const int lineOffsetChroma = (y / subV) * widthChroma;
+    for (int x = 0; x < w; x++)
+    {
+      const int64_t Y_tmp = int64_t(getValueFromSource(srcY, lineOffsetLuma + x, bps, format.bigEndian) - yOffset) * RGBConv[0];
+      int64_t U_tmp = 0;
+      int64_t V_tmp = 0;
+      if (format.subsampling != YUV_400)
+      {
+        const int idxChroma = (lineOffsetChroma + x / subH) * inputValSkip;
+        U_tmp = getValueFromSource(srcU, idxChroma, bps, format.bigEndian) - cZero;
+        V_tmp = getValueFromSource(srcV, idxChroma, bps, format.bigEndian) - cZero;
+      }
+
+      quint16 r = convertToRGB16(Y_tmp                      + V_tmp * RGBConv[1], shift, toneMappingLUT);
+      quint16 g = convertToRGB16(Y_tmp + U_tmp * RGBConv[2] + V_tmp * RGBConv[3], shift, toneMappingLUT);
+      quint16 b = convertToRGB16(Y_tmp + U_tmp * RGBConv[4]                     , shift, toneMappingLUT);
+      if (hlgTables)
+        convertHLGToSDR(r, g, b, *hlgTables);
+      dst[x] = QRgba64::fromRgba64(r, g, b, 0xffff);
+    }
+  }
+
+  return true;
+#else
+  Q_UNUSED(sourceBuffer);
+  Q_UNUSED(outputImage);
+  Q_UNUSED(curFrameSize);
+  Q_UNUSED(sourceBufferFormat);
+  return false;
+#endif
+}
+
 // Convert the given raw YUV data in sourceBuffer (using srcPixelFormat) to image (RGB-888), using the
 // buffer tmpRGBBuffer for intermediate RGB values.
 void videoHandlerYUV::convertYUVToImage(const QByteArray &sourceBuffer, QImage &outputImage, const yuvPixelFormat &yuvFormat, const QSize &curFrameSize)
@@ -3250,6 +3731,31 @@ void videoHandlerYUV::convertYUVToImage(const QByteArray &sourceBuffer, QImage &
   }
 
   DEBUG_YUV("videoHandlerYUV::convertYUVToImage");
+  performanceProfiler::scopedTimer profilerTimer(performanceProfiler::stageConvertToRGB);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+  if (useHighBitDepthOutput())
+  {
+    // Keep the full precision of the source in a 16 bit per channel image
+    outputImage = QImage(curFrameSize, QImage::Format_RGBA64);
+    bool convOK = true;
+    if (yuvFormat.planar)
+      convOK = convertYUVPlanarToRGB64(sourceBuffer, outputImage, curFrameSize, yuvFormat);
+    else
+    {
+      QByteArray tmpPlanarYUVSource;
+      yuvPixelFormat bufferPixelFormat = yuvFormat;
+      convOK = convertYUVPackedToPlanar(sourceBuffer, tmpPlanarYUVSource, curFrameSize, bufferPixelFormat);
+      if (convOK)
+        convOK = convertYUVPlanarToRGB64(tmpPlanarYUVSource, outputImage, curFrameSize, bufferPixelFormat);
+    }
+    assert(convOK);
+    Q_UNUSED(convOK);
+
+    DEBUG_YUV("videoHandlerYUV::convertYUVToImage Done (16 bit)");
+    return;
+  }
+#endif
 
   // Create the output image in the right format.
   // In both cases, we will set the alpha channel to 255. The format of the raw buffer is: BGRA (each 8 bit).
@@ -3283,6 +3789,12 @@ void videoHandlerYUV::convertYUVToImage(const QByteArray &sourceBuffer, QImage &
     else
       convOK = convertYUVPlanarToRGB(sourceBuffer, outputImage.bits(), curFrameSize, yuvFormat);
   }
+  else if (yuvFormat.bitsPerSample == 8 && yuvFormat.subsampling == YUV_422 && yuvFormat.packingOrder != Packing_V210 &&
+           interpolationMode == NearestNeighborInterpolation && yuvFormat.chromaOffset[0] == 0 && yuvFormat.chromaOffset[1] == 0 && componentDisplayMode == DisplayAll &&
+           !mathParameters[Luma].yuvMathRequired() && !mathParameters[Chroma].yuvMathRequired())
+    // 8 bit packed 4:2:2 (UYVY, YUYV, ...), nearest neighbor, default chroma offset, all components displayed and no yuv math.
+    // Convert directly from the packed source without unpacking to a planar buffer first.
+    convOK = convertYUV422PackedToRGB(sourceBuffer, outputImage.bits(), curFrameSize, yuvFormat);
   else
   {
     // Convert to a planar format first
@@ -3363,7 +3875,23 @@ videoHandlerYUV::yuv_t videoHandlerYUV::getPixelValue(const QPoint &pixelPos) co
   else
   {
     const YUVPackingOrder packing = format.packingOrder;
-    if (format.subsampling == YUV_422)
+    if (packing == Packing_V210)
+    {
+      // Get the group of 6 pixels (four 32 bit words) that contains the pixel: U0 Y0 V0 | Y1 U2 Y2 | V2 Y3 U4 | Y4 V4 Y5
+      const int bytesPerLine = (w + 47) / 48 * 128;
+      const unsigned char * restrict src = (unsigned char*)currentFrameRawData.data() + bytesPerLine * pixelPos.y() + pixelPos.x() / 6 * 16;
+      auto getV210Sample = [src](int idx)
+      {
+        const unsigned char *word = src + idx / 3 * 4;
+        const uint32_t val = uint32_t(word[0]) | (uint32_t(word[1]) << 8) | (uint32_t(word[2]) << 16) | (uint32_t(word[3]) << 24);
+        return (val >> (idx % 3 * 10)) & 0x3ff;
+      };
+      const int xInGroup = pixelPos.x() % 6;
+      value.Y = getV210Sample(xInGroup * 2 + 1);
+      value.U = getV210Sample(xInGroup / 2 * 4);
+      value.V = getV210Sample(xInGroup / 2 * 4 + 2);
+    }
+    else if (format.subsampling == YUV_422)
     {
       // The data is arranged in blocks of 4 samples. How many of these are there?
       // What are the offsets withing the 4 samples for the components?
@@ -3401,6 +3929,61 @@ videoHandlerYUV::yuv_t videoHandlerYUV::getPixelValue(const QPoint &pixelPos) co
   return value;
 }
 
+// This is a specialized function that can convert 8-bit packed YUV 4:2:2 (UYVY, VYUY, YUYV, YVYU) to RGB888 using
+// NearestNeighborInterpolation. The chroma offset must be 0 in x direction. No yuvMath is supported.
+bool videoHandlerYUV::convertYUV422PackedToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const yuvPixelFormat &format) const
+{
+  const int frameWidth = size.width();
+  const int frameHeight = size.height();
+  const int nr4Samples = frameWidth * frameHeight / 2;
+  if (sourceBuffer.size() < nr4Samples * 4)
+    return false;
+
+  // Get/set the parameters used for YUV -> RGB conversion
+  const bool fullRange = (yuvColorConversionType == BT709_FullRange || yuvColorConversionType == BT601_FullRange || yuvColorConversionType == BT2020_FullRange);
+  const int yOffset = (fullRange ? 0 : 16);
+  const int cZero = 128;
+  const int RGBConv[5] = {
+    yuvRgbConvCoeffs[yuvColorConversionType][0],
+    yuvRgbConvCoeffs[yuvColorConversionType][1],
+    yuvRgbConvCoeffs[yuvColorConversionType][2],
+    yuvRgbConvCoeffs[yuvColorConversionType][3],
+    yuvRgbConvCoeffs[yuvColorConversionType][4]
+  };
+
+  // What are the offsets withing the 4 samples for the components?
+  const YUVPackingOrder packing = format.packingOrder;
+  const int oY = (packing == Packing_YUYV || packing == Packing_YVYU) ? 0 : 1;
+  const int oU = (packing == Packing_UYVY) ? 0 : (packing == Packing_YUYV) ? 1 : (packing == Packing_VYUY) ? 2 : 3;
+  const int oV = (packing == Packing_VYUY) ? 0 : (packing == Packing_YVYU) ? 1 : (packing == Packing_UYVY) ? 2 : 3;
+
+  const unsigned char * restrict src = (unsigned char*)sourceBuffer.data();
+  unsigned char * restrict dst = targetBuffer;
+
+  for (int i = 0; i < nr4Samples; i++)
+  {
+    // Process two pixels (they have the same U/V components)
+    const int U_tmp_G = ((int)src[oU] - cZero) * RGBConv[2];
+    const int U_tmp_B = ((int)src[oU] - cZero) * RGBConv[4];
+    const int V_tmp_R = ((int)src[oV] - cZero) * RGBConv[1];
+    const int V_tmp_G = ((int)src[oV] - cZero) * RGBConv[3];
+
+    for (int p = 0; p < 2; p++)
+    {
+      const int Y_tmp = ((int)src[oY + p*2] - yOffset) * RGBConv[0];
+
+      dst[0] = clip8Bit((Y_tmp + U_tmp_B          ) >> 16);
+      dst[1] = clip8Bit((Y_tmp + U_tmp_G + V_tmp_G) >> 16);
+      dst[2] = clip8Bit((Y_tmp           + V_tmp_R) >> 16);
+      dst[3] = 255;
+      dst += 4;
+    }
+    src += 4; // Goto the next 4 samples
+  }
+
+  return true;
+}
+
 // This is a specialized function that can convert 8-bit YUV 4:2:0 to RGB888 using NearestNeighborInterpolation.
 // The chroma must be 0 in x direction and 1 in y direction. No yuvMath is supported.
 // TODO: Correct the chroma subsampling offset.
@@ -3738,9 +4321,54 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
     // The two items have different subsampling modes. Compare RGB values instead.
     return videoHandler::calculateDifference(item2, frameIdxItem0, frameIdxItem1, differenceInfoList, amplificationFactor, markDifference);
 
+  // Load the right raw YUV data (if not already loaded).
+  // This will just update the raw YUV data. No conversion to image (RGB) is performed. This is either
+  // done on request if the frame is actually shown or has already been done by the caching process.
+  if (!loadRawYUVData(frameIdxItem0))
+    return QImage();  // Loading failed
+  if (!yuvItem2->loadRawYUVData(frameIdxItem1))
+    return QImage();  // Loading failed
+
+  // Both YUV buffers are up to date. Really calculate the difference.
+  DEBUG_YUV("videoHandlerYUV::calculateDifference frame idx item 0 %d - item 1 %d", frameIdxItem0, frameIdxItem1);
+
+  QImage outputImage = calculateDifferenceYUV(currentFrameRawData, srcPixelFormat, frameSize, yuvItem2->currentFrameRawData, yuvItem2->srcPixelFormat, yuvItem2->frameSize, differenceInfoList, amplificationFactor, markDifference, diffYUV, diffYUVFormat);
+
+  // we have a yuv differance available
+  is_YUV_diff = !outputImage.isNull();
+  return outputImage;
+}
+
+QImage videoHandlerYUV::calculateDifferenceForCaching(videoHandlerYUV *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference, QByteArray &diffBuffer, yuvPixelFormat &diffFormat)
+{
+  // Get the raw data of both items through the caching path. The current buffers of the items are not touched.
+  QByteArray data[2];
+  yuvPixelFormat format[2];
+  QSize size[2];
+  if (!loadRawYUVDataForCaching(frameIdxItem0, data[0], format[0], size[0]))
+    return QImage();  // Loading failed
+  if (!item2->loadRawYUVDataForCaching(frameIdxItem1, data[1], format[1], size[1]))
+    return QImage();  // Loading failed
+
+  DEBUG_YUV("videoHandlerYUV::calculateDifferenceForCaching frame idx item 0 %d - item 1 %d", frameIdxItem0, frameIdxItem1);
+
+  if (format[0].subsampling != format[1].subsampling)
+  {
+    // The two items have different subsampling modes. Compare RGB values instead.
+    QImage image[2];
+    convertYUVToImage(data[0], image[0], format[0], size[0]);
+    item2->convertYUVToImage(data[1], image[1], format[1], size[1]);
+    return calculateImageDifference(image[0], image[1], differenceInfoList, amplificationFactor, markDifference);
+  }
+
+  return calculateDifferenceYUV(data[0], format[0], size[0], data[1], format[1], size[1], differenceInfoList, amplificationFactor, markDifference, diffBuffer, diffFormat);
+}
+
+QImage videoHandlerYUV::calculateDifferenceYUV(const QByteArray &data0, const yuvPixelFormat &format0, const QSize &size0, const QByteArray &data1, const yuvPixelFormat &format1, const QSize &size1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference, QByteArray &diffBuffer, yuvPixelFormat &diffFormat) const
+{
   // Get/Set the bit depth of the input and output
   // If the bit depth if the two items is different, we will scale the item with the lower bit depth up.
-  const int bps_in[2] = {srcPixelFormat.bitsPerSample, yuvItem2->srcPixelFormat.bitsPerSample};
+  const int bps_in[2] = {format0.bitsPerSample, format1.bitsPerSample};
   const int bps_out = std::max(bps_in[0], bps_in[1]);
   // Which of the two input values has to be scaled up? Only one of these (or neither) can be set.
   const bool bitDepthScaling[2] = {bps_in[0] != bps_out, bps_in[1] != bps_out};
@@ -3756,39 +4384,28 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
   // Do we amplify the values?
   const bool amplification = (amplificationFactor != 1 && !markDifference);
 
-  // Load the right raw YUV data (if not already loaded).
-  // This will just update the raw YUV data. No conversion to image (RGB) is performed. This is either
-  // done on request if the frame is actually shown or has already been done by the caching process.
-  if (!loadRawYUVData(frameIdxItem0))
-    return QImage();  // Loading failed
-  if (!yuvItem2->loadRawYUVData(frameIdxItem1))
-    return QImage();  // Loading failed
-
-  // Both YUV buffers are up to date. Really calculate the difference.
-  DEBUG_YUV("videoHandlerYUV::calculateDifference frame idx item 0 %d - item 1 %d", frameIdxItem0, frameIdxItem1);
-
   // The items can be of different size (we then calculate the difference of the top left aligned part)
-  const int w_in[2] = {frameSize.width(), yuvItem2->frameSize.width()};
-  const int h_in[2] = {frameSize.height(), yuvItem2->frameSize.height()};
+  const int w_in[2] = {size0.width(), size1.width()};
+  const int h_in[2] = {size0.height(), size1.height()};
   const int w_out = qMin(w_in[0], w_in[1]);
   const int h_out = qMin(h_in[0], h_in[1]);
   // Append a warning if the frame sizes are different
-  if (frameSize != yuvItem2->frameSize)
+  if (size0 != size1)
     differenceInfoList.append(infoItem("Warning", "The size of the two items differs.", "The size of the two input items is different. The difference of the top left aligned part that overlaps will be calculated."));
 
-  yuvPixelFormat tmpDiffYUVFormat(srcPixelFormat.subsampling, bps_out, Order_YUV, true);
-  diffYUVFormat = tmpDiffYUVFormat;
+  yuvPixelFormat tmpDiffYUVFormat(format0.subsampling, bps_out, Order_YUV, true);
+  diffFormat = tmpDiffYUVFormat;
 
   if (!canConvertToRGB(tmpDiffYUVFormat, QSize(w_out, h_out)))
     return QImage();
 
 
   // Get subsampling modes (they are identical for both inputs and the output)
-  const int subH = srcPixelFormat.getSubsamplingHor();
-  const int subV = srcPixelFormat.getSubsamplingVer();
+  const int subH = format0.getSubsamplingHor();
+  const int subV = format0.getSubsamplingVer();
 
   // Get the endianess of the inputs
-  const bool bigEndian[2] = {srcPixelFormat.bigEndian, yuvItem2->srcPixelFormat.bigEndian};
+  const bool bigEndian[2] = {format0.bigEndian, format1.bigEndian};
 
   // Get pointers to the inputs
   const int componentSizeLuma_In[2] = {w_in[0]*h_in[0], w_in[1]*h_in[1]};
@@ -3796,20 +4413,20 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
   const int nrBytesLumaPlane_In[2] = {bps_in[0] > 8 ? 2 * componentSizeLuma_In[0] : componentSizeLuma_In[0], bps_in[1] > 8 ? 2 * componentSizeLuma_In[1] : componentSizeLuma_In[1]};
   const int nrBytesChromaPlane_In[2] = {bps_in[0] > 8 ? 2 * componentSizeChroma_In[0] : componentSizeChroma_In[0], bps_in[1] > 8 ? 2 * componentSizeChroma_In[1] : componentSizeChroma_In[1]};
   // Current item
-  const unsigned char * restrict srcY1 = (unsigned char*)currentFrameRawData.data();
-  const unsigned char * restrict srcU1 = (srcPixelFormat.planeOrder == Order_YUV || srcPixelFormat.planeOrder == Order_YUVA) ? srcY1 + nrBytesLumaPlane_In[0] : srcY1 + nrBytesLumaPlane_In[0] + nrBytesChromaPlane_In[0];
-  const unsigned char * restrict srcV1 = (srcPixelFormat.planeOrder == Order_YUV || srcPixelFormat.planeOrder == Order_YUVA) ? srcY1 + nrBytesLumaPlane_In[0] + nrBytesChromaPlane_In[0]: srcY1 + nrBytesLumaPlane_In[0];
+  const unsigned char * restrict srcY1 = (unsigned char*)data0.data();
+  const unsigned char * restrict srcU1 = (format0.planeOrder == Order_YUV || format0.planeOrder == Order_YUVA) ? srcY1 + nrBytesLumaPlane_In[0] : srcY1 + nrBytesLumaPlane_In[0] + nrBytesChromaPlane_In[0];
+  const unsigned char * restrict srcV1 = (format0.planeOrder == Order_YUV || format0.planeOrder == Order_YUVA) ? srcY1 + nrBytesLumaPlane_In[0] + nrBytesChromaPlane_In[0]: srcY1 + nrBytesLumaPlane_In[0];
   // The other item
-  const unsigned char * restrict srcY2 = (unsigned char*)yuvItem2->currentFrameRawData.data();
-  const unsigned char * restrict srcU2 = (yuvItem2->srcPixelFormat.planeOrder == Order_YUV || yuvItem2->srcPixelFormat.planeOrder == Order_YUVA) ? srcY2 + nrBytesLumaPlane_In[1] : srcY2 + nrBytesLumaPlane_In[1] + nrBytesChromaPlane_In[1];
-  const unsigned char * restrict srcV2 = (yuvItem2->srcPixelFormat.planeOrder == Order_YUV || yuvItem2->srcPixelFormat.planeOrder == Order_YUVA) ? srcY2 + nrBytesLumaPlane_In[1] + nrBytesChromaPlane_In[1]: srcY2 + nrBytesLumaPlane_In[1];
+  const unsigned char * restrict srcY2 = (unsigned char*)data1.data();
+  const unsigned char * restrict srcU2 = (format1.planeOrder == Order_YUV || format1.planeOrder == Order_YUVA) ? srcY2 + nrBytesLumaPlane_In[1] : srcY2 + nrBytesLumaPlane_In[1] + nrBytesChromaPlane_In[1];
+  const unsigned char * restrict srcV2 = (format1.planeOrder == Order_YUV || format1.planeOrder == Order_YUVA) ? srcY2 + nrBytesLumaPlane_In[1] + nrBytesChromaPlane_In[1]: srcY2 + nrBytesLumaPlane_In[1];
 
   // Get pointers to the output
   const int componentSizeLuma_out = w_out*h_out * (bps_out > 8 ? 2 : 1); // Size in bytes
   const int componentSizeChroma_out = (w_out/subH) * (h_out/subV) * (bps_out > 8 ? 2 : 1);
   // Resize the output buffer to the right size
-  diffYUV.resize(componentSizeLuma_out + 2*componentSizeChroma_out);
-  unsigned char * restrict dstY = (unsigned char*)diffYUV.data();
+  diffBuffer.resize(componentSizeLuma_out + 2*componentSizeChroma_out);
+  unsigned char * restrict dstY = (unsigned char*)diffBuffer.data();
   unsigned char * restrict dstU = dstY + componentSizeLuma_out;
   unsigned char * restrict dstV = dstU + componentSizeChroma_out;
 
@@ -3920,14 +4537,14 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
 
   if (markDifference)
     // We don't want to see the actual difference but just where differences are.
-    markDifferencesYUVPlanarToRGB(diffYUV, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
+    markDifferencesYUVPlanarToRGB(diffBuffer, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
   else
     // Get the format of the tmpDiffYUV buffer and convert it to RGB
-    convertYUVPlanarToRGB(diffYUV, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
+    convertYUVPlanarToRGB(diffBuffer, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
 
   // Append the conversion information that will be returned
   QStringList yuvSubsamplings = QStringList() << "4:4:4" << "4:2:2" << "4:2:0" << "4:4:0" << "4:1:0" << "4:1:1" << "4:0:0";
-  differenceInfoList.append(infoItem("Difference Type",QString("YUV %1").arg(yuvSubsamplings[srcPixelFormat.subsampling])));
+  differenceInfoList.append(infoItem("Difference Type",QString("YUV %1").arg(yuvSubsamplings[format0.subsampling])));
   double mse[4];
   mse[0] = double(mseAdd[0]) / (w_out * h_out);
   mse[1] = double(mseAdd[1]) / (w_out * h_out);
@@ -3947,8 +4564,6 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
       return outputImage.convertToFormat(f);
   }
 
-  // we have a yuv differance available
-  is_YUV_diff = true;
   return outputImage;
 }
 
@@ -4003,6 +4618,47 @@ void videoHandlerYUV::setYUVColorConversion(ColorConversion conversion)
   }
 }
 
+void videoHandlerYUV::setOutputMode(OutputMode mode)
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 12, 0)
+  // There is no 16 bit image format that we could convert to
+  mode = Output8Bit;
+#endif
+  if (mode != outputMode)
+  {
+    outputMode = mode;
+
+    if (ui.created())
+      ui.outputModeComboBox->setCurrentIndex(int(outputMode));
+  }
+}
+
+bool videoHandlerYUV::useHighBitDepthOutput() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+  // The 16 bit conversion always shows all components and does not apply YUV math. For
+  // everything else, the 8 bit conversion is used.
+  return outputMode != Output8Bit && componentDisplayMode == DisplayAll &&
+         !mathParameters[Luma].yuvMathRequired() && !mathParameters[Chroma].yuvMathRequired();
+#else
+  return false;
+#endif
+}
+
+QImage::Format videoHandlerYUV::getOutputImageFormat() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+  if (useHighBitDepthOutput())
+    return QImage::Format_RGBA64;
+#endif
+  return videoHandler::getOutputImageFormat();
+}
+
+QString videoHandlerYUV::getRawDataFormatKey() const
+{
+  return videoHandler::getRawDataFormatKey() + "|" + srcPixelFormat.getName();
+}
+
 bool videoHandlerYUV::canConvertToRGB(yuvPixelFormat format, QSize imageSize, QString *whyNot) const
 {
   if (!format.isValid())
@@ -59,6 +59,15 @@ namespace YUV_Internals
     BT2020_FullRange,
   } ColorConversion;
 
+  // How are the converted RGB frames stored (and displayed)?
+  typedef enum
+  {
+    Output8Bit,       // 8 bit per channel in the platform image format
+    Output16Bit,      // 16 bit per channel (RGBA64). Requires Qt 5.12.
+    Output16BitPQ,    // 16 bit per channel with tone mapping of PQ (SMPTE ST 2084) content to SDR
+    Output16BitHLG    // 16 bit per channel with tone mapping of HLG (ARIB STD-B67) content to SDR
+  } OutputMode;
+
   // How to perform up-sampling (chroma subsampling)
   typedef enum
   {
@@ -110,6 +119,7 @@ namespace YUV_Internals
     Packing_VYUY,     // 422
     Packing_YUYV,     // 422
     Packing_YVYU,     // 422
+    Packing_V210,     // 422 (10 bit, 6 pixels in four 32 bit words. Lines are padded to 48 pixels)
     //Packing_YYYYUV,   // 420
     //Packing_YYUYYV,   // 420
     //Packing_UYYVYY,   // 420
@@ -211,6 +221,11 @@ public:
   // we will use the playlistItemVideo::calculateDifference function to calculate the difference
   // using the RGB values.
   virtual QImage calculateDifference(frameHandler *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference) Q_DECL_OVERRIDE;
+  // Calculate the difference to the other YUV item from a caching thread. The raw data of both items is requested
+  // through the caching path and the YUV difference is written to diffBuffer/diffFormat. The current buffers
+  // (currentFrameRawData, currentImage and diffYUV) of both items are not used or changed. If the difference has to be
+  // calculated in the RGB domain, diffBuffer is not set.
+  QImage calculateDifferenceForCaching(videoHandlerYUV *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference, QByteArray &diffBuffer, YUV_Internals::yuvPixelFormat &diffFormat);
 
   // Get the number of bytes for one YUV frame with the current format
   virtual int64_t getBytesPerFrame() const Q_DECL_OVERRIDE { return srcPixelFormat.bytesPerFrame(frameSize); }
@@ -224,6 +239,22 @@ public:
   // If a file size is given, it is tested if the YUV format and the file size match.
   virtual void setFormatFromCorrelation(const QByteArray &rawYUVData, int64_t fileSize=-1) Q_DECL_OVERRIDE;
 
+  // A frame size and format guess of the correlation based format detection
+  struct formatCandidate
+  {
+    QSize size;
+    YUV_Internals::yuvPixelFormat format;
+    double mse;
+    // 1 if the first two frames are identical, 0 at (or above) the MSE threshold of setFormatFromCorrelation
+    double confidence;
+  };
+  // Evaluate all candidate sizes, bit depths and subsamplings that match the file size on the given sample
+  // of the file (in parallel). The candidates are returned ranked by their MSE (best first).
+  static QList<formatCandidate> getFormatCandidatesFromCorrelation(const QByteArray &rawYUVData, int64_t fileSize);
+  // Get the best candidate if it is below the MSE threshold. This does not change the handler and
+  // can be called from a background thread. The result can then be set in the main thread.
+  static bool getFormatFromCorrelation(const QByteArray &rawYUVData, int64_t fileSize, QSize &size, YUV_Internals::yuvPixelFormat &format);
+
   // Create the YUV controls and return a pointer to the layout.
   // yuvFormatFixed: For example a YUV file does not have a fixed format (the user can change this),
   // other sources might provide a fixed format which the user cannot change (HEVC file, ...)
@@ -236,6 +267,11 @@ public:
   virtual void setYUVPixelFormatByName(const QString &name, bool emitSignal=false) { setYUVPixelFormat(YUV_Internals::yuvPixelFormat(name), emitSignal); }
   virtual void setYUVPixelFormat(const YUV_Internals::yuvPixelFormat &fmt, bool emitSignal=false);
   virtual void setYUVColorConversion(YUV_Internals::ColorConversion conversion);
+  void setOutputMode(YUV_Internals::OutputMode mode);
+  YUV_Internals::OutputMode getOutputMode() const { return outputMode; }
+
+  // Override from videoHandler. In the 16 bit output modes, the converted frames are RGBA64 images.
+  virtual QImage::Format getOutputImageFormat() const Q_DECL_OVERRIDE;
 
   // When loading a videoHandlerYUV from playlist file, this can be used to set all the parameters at once
   void loadValues(const QSize &frameSize, const QString &sourcePixelFormat);
@@ -285,12 +321,20 @@ protected:
   */
   YUV_Internals::ColorConversion yuvColorConversionType;
 
+  // Convert to 8 bit RGB (default) or keep 16 bit per channel (with optional tone mapping)?
+  YUV_Internals::OutputMode outputMode {YUV_Internals::Output8Bit};
+  // Is the 16 bit output path used for the current settings? Not all display modes are supported.
+  bool useHighBitDepthOutput() const;
+
   // Parameters for the YUV transformation (like scaling, invert, offset). For Luma ([0]) and chroma([1]).
   YUV_Internals::yuvMathParameters mathParameters[2];
 
   // The currently selected YUV format
   YUV_Internals::yuvPixelFormat srcPixelFormat;
 
+  // The disk cache key must change if the format of the raw YUV data changes
+  virtual QString getRawDataFormatKey() const Q_DECL_OVERRIDE;
+
   // A static list of preset YUV formats. These are the formats that are shown in the YUV format selection comboBox.
   YUV_Internals::YUVFormatList yuvPresetsList;
 
@@ -309,6 +353,12 @@ private:
   // Load the raw YUV data for the given frame index into currentFrameRawYUVData.
   // Return false is loading failed.
   bool loadRawYUVData(int frameIndex);
+  // Get a copy of the raw YUV data (and the format/size of it) for a caching thread. The current buffers are not changed.
+  bool loadRawYUVDataForCaching(int frameIndex, QByteArray &data, YUV_Internals::yuvPixelFormat &format, QSize &size);
+
+  // Calculate the YUV difference of the two given raw buffers (which must have the same subsampling) into diffBuffer
+  // and convert it to RGB.
+  QImage calculateDifferenceYUV(const QByteArray &data0, const YUV_Internals::yuvPixelFormat &format0, const QSize &size0, const QByteArray &data1, const YUV_Internals::yuvPixelFormat &format1, const QSize &size1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference, QByteArray &diffBuffer, YUV_Internals::yuvPixelFormat &diffFormat) const;
 
   // Convert from YUV (which ever format is selected) to image (RGB-888)
   void convertYUVToImage(const QByteArray &sourceBuffer, QImage &outputImage, const YUV_Internals::yuvPixelFormat &yuvFormat, const QSize &curFrameSize);
@@ -329,8 +379,12 @@ private:
   bool convertYUV420ToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const YUV_Internals::yuvPixelFormat format);
 #endif
 
+  // Convert 8 bit packed 4:2:2 directly to RGB (without unpacking to planar first)
+  bool convertYUV422PackedToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const YUV_Internals::yuvPixelFormat &format) const;
   bool convertYUVPackedToPlanar(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &frameSize, YUV_Internals::yuvPixelFormat &sourceBufferFormat);
   bool convertYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
+  // Convert to 16 bit per channel RGBA64 without truncation to 8 bit. The output image must be allocated (Format_RGBA64).
+  bool convertYUVPlanarToRGB64(const QByteArray &sourceBuffer, QImage &outputImage, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
   bool markDifferencesYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
 
 #if SSE_CONVERSION_420_ALT
@@ -2,4 +2,4 @@ TEMPLATE = subdirs
 
 requires(qtHaveModule(testlib))
 
-SUBDIRS = filesource
+SUBDIRS = filesource parser
@@ -6,10 +6,11 @@ CONFIG -= app_bundled
 
 TARGET = tst_filesource
 
-QT += testlib
-QT -= gui
+QT += testlib gui widgets
 
 INCLUDEPATH += $$top_srcdir/YUViewLib/src
+# The annexB reader pulls in the video handler headers, whose generated ui headers live in the library build directory
+INCLUDEPATH += $$top_builddir/YUViewLib
 LIBS += -L$$top_builddir/YUViewLib -lYUViewLib
 
 SOURCES += tst_filesource.cpp
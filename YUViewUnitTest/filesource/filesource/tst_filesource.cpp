@@ -1,6 +1,7 @@
 #include <QtTest>
 
 #include <filesource/fileSource.h>
+#include <filesource/fileSourceAnnexBFile.h>
 
 class fileSourceTest : public QObject
 {
@@ -14,8 +15,37 @@ private slots:
     void testFormatFromFilename_data();
     void testFormatFromFilename();
 
+    void testAnnexBStartCodeAtBufferBoundary_data();
+    void testAnnexBStartCodeAtBufferBoundary();
+    void testAnnexBLastFrame();
+
 };
 
+namespace
+{
+
+// A NAL unit with a start code of the given length (3 or 4 bytes), the header byte and a payload without zero bytes
+QByteArray createNALUnit(int startCodeLength, char header, int size)
+{
+    QByteArray nal(startCodeLength - 1, (char)0);
+    nal.append((char)1);
+    nal.append(header);
+    for (int i = nal.size(); i < size; i++)
+        nal.append(char('a' + i % 26));
+    return nal;
+}
+
+bool writeFile(QTemporaryFile &file, const QByteArray &data)
+{
+    if (!file.open())
+        return false;
+    const bool ok = (file.write(data) == data.size());
+    file.close();
+    return ok;
+}
+
+}
+
 fileSourceTest::fileSourceTest()
 {
 }
@@ -115,6 +145,86 @@ void fileSourceTest::testFormatFromFilename()
     QCOMPARE(fileFormat.packed, packed);
 }
 
+void fileSourceTest::testAnnexBStartCodeAtBufferBoundary_data()
+{
+    QTest::addColumn<int>("startCodeLength");
+    QTest::addColumn<int>("bytesBeforeBoundary");
+
+    // The start code of the second NAL unit begins this many bytes before the end of the first buffer
+    for (int startCodeLength = 3; startCodeLength <= 4; startCodeLength++)
+        for (int bytesBeforeBoundary = 0; bytesBeforeBoundary <= startCodeLength; bytesBeforeBoundary++)
+            QTest::newRow(QString("startCode%1_split%2").arg(startCodeLength).arg(bytesBeforeBoundary).toLatin1().constData()) << startCodeLength << bytesBeforeBoundary;
+}
+
+void fileSourceTest::testAnnexBStartCodeAtBufferBoundary()
+{
+    QFETCH(int, startCodeLength);
+    QFETCH(int, bytesBeforeBoundary);
+
+    QList<QByteArray> nalUnits;
+    nalUnits.append(createNALUnit(4, 0x40, BUFFER_SIZE - bytesBeforeBoundary));
+    nalUnits.append(createNALUnit(startCodeLength, 0x42, 100));
+    nalUnits.append(createNALUnit(4, 0x44, 50));
+
+    QByteArray data;
+    for (const QByteArray &nal : nalUnits)
+        data.append(nal);
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, data));
+
+    // Read the NAL units with the copying and with the non copying interface
+    fileSourceAnnexBFile annexBFile(file.fileName());
+    fileSourceAnnexBFile annexBFileView(file.fileName());
+    uint64_t nalStart = 0;
+    for (const QByteArray &nal : nalUnits)
+    {
+        QUint64Pair startEndPosInFile;
+        QCOMPARE(annexBFile.getNextNALUnit(false, &startEndPosInFile), nal);
+        QCOMPARE(startEndPosInFile.first, nalStart);
+        QCOMPARE(annexBFileView.getNextNALUnitView(), nal);
+        nalStart += nal.size();
+    }
+    QVERIFY(annexBFile.atEnd());
+    QVERIFY(annexBFileView.atEnd());
+}
+
+void fileSourceTest::testAnnexBLastFrame()
+{
+    // The second buffer is only partly filled. The unused part still holds the data of the first buffer
+    // which has a start code at exactly the position where the valid data of the second buffer ends.
+    const int secondBufferSize = 1000;
+    QList<QByteArray> nalUnits;
+    nalUnits.append(createNALUnit(4, 0x40, secondBufferSize - 1));
+    nalUnits.append(createNALUnit(4, 0x42, BUFFER_SIZE + secondBufferSize / 2 - (secondBufferSize - 1)));
+    nalUnits.append(createNALUnit(4, 0x44, secondBufferSize / 2));
+
+    QByteArray data;
+    for (const QByteArray &nal : nalUnits)
+        data.append(nal);
+    QCOMPARE(data.size(), BUFFER_SIZE + secondBufferSize);
+    QTemporaryFile file;
+    QVERIFY(writeFile(file, data));
+
+    fileSourceAnnexBFile annexBFile(file.fileName());
+    QList<QUint64Pair> nalPositions;
+    for (const QByteArray &nal : nalUnits)
+    {
+        QUint64Pair startEndPosInFile;
+        QCOMPARE(annexBFile.getNextNALUnit(false, &startEndPosInFile), nal);
+        nalPositions.append(startEndPosInFile);
+    }
+    QVERIFY(annexBFile.atEnd());
+
+    // The last NAL unit ends with the last byte of the file
+    const uint64_t fileSize = uint64_t(data.size());
+    QCOMPARE(nalPositions.last().first, fileSize - nalUnits.last().size());
+    QCOMPARE(nalPositions.last().second, fileSize - 1);
+
+    // The frame data of the last frame must contain everything up to the end of the file
+    QCOMPARE(annexBFile.getFrameData(nalPositions.last()), nalUnits.last());
+    QCOMPARE(annexBFile.getFrameData(QUint64Pair(nalPositions[1].first, nalPositions.last().second)), nalUnits[1] + nalUnits.last());
+}
+
 QTEST_MAIN(fileSourceTest)
 
 #include "tst_filesource.moc"
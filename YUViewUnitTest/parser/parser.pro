@@ -0,0 +1,3 @@
+TEMPLATE = subdirs
+
+SUBDIRS = parser
\ No newline at end of file
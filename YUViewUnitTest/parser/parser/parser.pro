@@ -0,0 +1,17 @@
+TEMPLATE = app
+
+CONFIG += qt console warn_on no_testcase_installs depend_includepath testcase
+CONFIG -= debug_and_release
+CONFIG -= app_bundled
+
+TARGET = tst_parser
+
+# The parser headers use QtGui and QtWidgets types (e.g. QBrush) but the tests do not need a gui application
+QT += testlib gui widgets
+
+INCLUDEPATH += $$top_srcdir/YUViewLib/src
+# The transport stream parser pulls in the video handler headers, whose generated ui headers live in the library build directory
+INCLUDEPATH += $$top_builddir/YUViewLib
+LIBS += -L$$top_builddir/YUViewLib -lYUViewLib
+
+SOURCES += tst_parser.cpp
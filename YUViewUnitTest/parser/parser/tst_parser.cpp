@@ -0,0 +1,389 @@
+#include <QtTest>
+
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#include <parser/parserCommon.h>
+#include <parser/parserTransportStream.h>
+
+using namespace parserCommon;
+
+namespace
+{
+
+// Count the live allocations of the whole test so that the tests can check that all items, their blocks and
+// the string table of a tree are freed again.
+std::atomic<int64_t> nrLiveAllocations {0};
+
+}
+
+void *operator new(size_t size)
+{
+    void *p = std::malloc(size ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    nrLiveAllocations++;
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p == nullptr)
+        return;
+    nrLiveAllocations--;
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+class parserTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    parserTest();
+    ~parserTest();
+
+private slots:
+    void testTreeItemValues();
+    void testTreeItemCodes_data();
+    void testTreeItemCodes();
+    void testTreeItemsAcrossBlocks();
+    void testTreeItemFreeTreeOnRootDelete();
+
+    void testTransportStreamPIDList();
+    void testTransportStreamPIDFilter_data();
+    void testTransportStreamPIDFilter();
+
+};
+
+namespace
+{
+
+// The items are allocated from blocks of 1024 items. Use enough items to fill several blocks.
+const int nrItemsSeveralBlocks = 3 * 1024 + 100;
+
+QString itemName(int i)
+{
+    return QString("item_%1").arg(i % 100);
+}
+
+// Create a tree with nrItems children (and some grandchildren) below the root
+TreeItem *createTree(int nrItems)
+{
+    auto root = new TreeItem(nullptr);
+    for (int i = 0; i < nrItems; i++)
+    {
+        auto item = new TreeItem(itemName(i), i, "u(v) -> u(8)", "00000001", root);
+        if (i % 10 == 0)
+            new TreeItem("child", QString("value %1").arg(i), "", "", "meaning", item);
+    }
+    return root;
+}
+
+// The CRC_32 of the PSI sections (ISO/IEC 13818-1 Annex A)
+void appendCRC32(QByteArray &section)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (char c : section)
+    {
+        crc ^= uint32_t((unsigned char)c) << 24;
+        for (int k = 0; k < 8; k++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+    }
+    for (int shift = 24; shift >= 0; shift -= 8)
+        section.append(char((crc >> shift) & 0xFF));
+}
+
+// A TS packet with only payload. The payload is filled up with stuffing bytes (0xFF).
+QByteArray createTSPacket(int pid, bool payloadUnitStart, int continuityCounter, const QByteArray &payload)
+{
+    QByteArray packet;
+    packet.append(char(0x47));
+    packet.append(char((payloadUnitStart ? 0x40 : 0x00) | (pid >> 8)));
+    packet.append(char(pid & 0xFF));
+    packet.append(char(0x10 | (continuityCounter & 0x0F)));
+    packet.append(payload.left(184));
+    packet.append(QByteArray(188 - packet.size(), char(0xFF)));
+    return packet;
+}
+
+QByteArray createPSIPacket(int pid, QByteArray section)
+{
+    appendCRC32(section);
+    // The pointer_field is 0 (the section starts right after it)
+    return createTSPacket(pid, true, 0, QByteArray(1, 0) + section);
+}
+
+// A PES packet (stream_id 0xC0, no PTS) that fills the whole TS packet
+QByteArray createPESPacket(int pid, int continuityCounter)
+{
+    // The PES_packet_length is 0 (the packet ends with the next one) and there is no optional header data
+    QByteArray pes = QByteArray::fromHex("000001C00000800000");
+    pes.append(QByteArray(184 - pes.size(), char(0x55)));
+    return createTSPacket(pid, true, continuityCounter, pes);
+}
+
+// A transport stream with one program (PMT PID 0x1000) with two audio streams (PIDs 0x101 and 0x102)
+QByteArray createTransportStream()
+{
+    const int pmtPID = 0x1000;
+    QByteArray pat = QByteArray::fromHex("00B00D0001C10000");
+    pat.append(char(0x00));
+    pat.append(char(0x01));
+    pat.append(char(0xE0 | (pmtPID >> 8)));
+    pat.append(char(pmtPID & 0xFF));
+
+    // No PCR PID (0x1FFF), no program info, stream_type 0x03 (MPEG-1 audio) and 0x0F (AAC) without descriptors
+    QByteArray pmt = QByteArray::fromHex("02B0170001C10000FFFFF000");
+    pmt.append(QByteArray::fromHex("03E101F000"));
+    pmt.append(QByteArray::fromHex("0FE102F000"));
+
+    QByteArray ts;
+    ts.append(createPSIPacket(0, pat));
+    ts.append(createPSIPacket(pmtPID, pmt));
+    for (int i = 0; i < 3; i++)
+    {
+        ts.append(createPESPacket(0x101, i));
+        ts.append(createPESPacket(0x102, i));
+    }
+    return ts;
+}
+
+}
+
+parserTest::parserTest()
+{
+}
+
+parserTest::~parserTest()
+{
+}
+
+void parserTest::testTreeItemValues()
+{
+    TreeItem root(nullptr);
+
+    auto intItem = new TreeItem("int", -42, "se(v)", "00111", &root);
+    QCOMPARE(intItem->getData(0), QString("int"));
+    QCOMPARE(intItem->getData(1), QString("-42"));
+    QCOMPARE(intItem->getData(2), QString("se(v)"));
+    QCOMPARE(intItem->getData(3), QString("00111"));
+    QCOMPARE(intItem->getData(4), QString());
+    QCOMPARE(intItem->getData(5), QString());
+
+    auto uintItem = new TreeItem("uint", 4000000000u, "u(32)", "1", &root);
+    QCOMPARE(uintItem->getData(1), QString("4000000000"));
+
+    auto uint64Item = new TreeItem("uint64", std::numeric_limits<uint64_t>::max(), "u(64)", "", &root);
+    QCOMPARE(uint64Item->getData(1), QString("18446744073709551615"));
+
+    auto int64Item = new TreeItem("int64", std::numeric_limits<int64_t>::min(), "i(64)", "", &root);
+    QCOMPARE(int64Item->getData(1), QString("-9223372036854775808"));
+
+    auto boolTrue = new TreeItem("flagTrue", true, "u(1)", "1", &root);
+    auto boolFalse = new TreeItem("flagFalse", false, "u(1)", "0", &root);
+    QCOMPARE(boolTrue->getData(1), QString("1"));
+    QCOMPARE(boolTrue->getData(3), QString("1"));
+    QCOMPARE(boolFalse->getData(1), QString("0"));
+    QCOMPARE(boolFalse->getData(3), QString("0"));
+
+    auto doubleItem = new TreeItem("double", 0.25, "f(v)", "", &root);
+    QCOMPARE(doubleItem->getData(1), QString("0.25"));
+
+    auto stringItem = new TreeItem("string", QString("some text"), "", "", &root);
+    QCOMPARE(stringItem->getData(1), QString("some text"));
+
+    auto meaningItem = new TreeItem("withMeaning", 3, "u(2)", "11", "The meaning of 3", &root);
+    QCOMPARE(meaningItem->getData(1), QString("3"));
+    QCOMPARE(meaningItem->getData(4), QString("The meaning of 3"));
+
+    auto errorItem = new TreeItem("error", QString("bad"), "", "", "", &root, true);
+    QVERIFY(errorItem->isError());
+    QVERIFY(!meaningItem->isError());
+
+    auto listItem = new TreeItem(QList<QString>() << "listName" << "listValue" << "listCoding" << "0101" << "listMeaning", &root);
+    QCOMPARE(listItem->getData(0), QString("listName"));
+    QCOMPARE(listItem->getData(1), QString("listValue"));
+    QCOMPARE(listItem->getData(2), QString("listCoding"));
+    QCOMPARE(listItem->getData(3), QString("0101"));
+    QCOMPARE(listItem->getData(4), QString("listMeaning"));
+
+    // Items without a value have an empty value column
+    auto nameOnly = new TreeItem("nameOnly", &root);
+    QCOMPARE(nameOnly->getData(1), QString());
+
+    // Renaming and the stream index
+    nameOnly->setName("renamed");
+    QCOMPARE(nameOnly->getData(0), QString("renamed"));
+    nameOnly->setStreamIndex(2);
+    QCOMPARE(nameOnly->getName(true), QString("Stream 2 - renamed"));
+    QCOMPARE(nameOnly->getName(false), QString("renamed"));
+
+    // The same strings are shared between items but each item keeps its own value
+    auto intItem2 = new TreeItem("int", 7, "se(v)", "00111", &root);
+    QCOMPARE(intItem2->getData(1), QString("7"));
+    QCOMPARE(intItem->getData(1), QString("-42"));
+
+    QCOMPARE(root.getNumberItemsInTree(), int64_t(root.childItems.size() + 1));
+}
+
+void parserTest::testTreeItemCodes_data()
+{
+    QTest::addColumn<QString>("code");
+
+    QTest::newRow("empty") << QString();
+    QTest::newRow("leadingZeros") << QString("0001");
+    QTest::newRow("onlyZeros") << QString("00000000");
+    QTest::newRow("63bit") << QString(63, '1');
+    QTest::newRow("64bitOnes") << QString(64, '1');
+    QTest::newRow("64bitZeros") << QString(64, '0');
+    QTest::newRow("64bitMixed") << QString("10").repeated(32);
+    QTest::newRow("65bit") << QString("1") + QString(64, '0');
+    QTest::newRow("100bit") << QString("0110").repeated(25);
+    QTest::newRow("notBinary") << QString("0x1F");
+    QTest::newRow("text") << QString("some code");
+}
+
+void parserTest::testTreeItemCodes()
+{
+    QFETCH(QString, code);
+
+    TreeItem root(nullptr);
+    auto item = new TreeItem("name", 1, "coding", code, &root);
+    QCOMPARE(item->getData(3), code);
+
+    // The code must not change the other columns
+    QCOMPARE(item->getData(0), QString("name"));
+    QCOMPARE(item->getData(1), QString("1"));
+    QCOMPARE(item->getData(2), QString("coding"));
+}
+
+void parserTest::testTreeItemsAcrossBlocks()
+{
+    TreeItem *root = createTree(nrItemsSeveralBlocks);
+    const int nrGrandChildren = (nrItemsSeveralBlocks + 9) / 10;
+    QCOMPARE(root->childItems.size(), nrItemsSeveralBlocks);
+    QCOMPARE(root->getNumberItemsInTree(), int64_t(1 + nrItemsSeveralBlocks + nrGrandChildren));
+
+    // Delete every other item. This frees slots in all blocks without freeing any block completely.
+    int nrDeletedGrandChildren = 0;
+    for (int i = nrItemsSeveralBlocks - 1; i >= 0; i -= 2)
+    {
+        auto item = root->childItems.takeAt(i);
+        nrDeletedGrandChildren += item->childItems.size();
+        delete item;
+    }
+    const int nrRemaining = nrItemsSeveralBlocks / 2;
+    QCOMPARE(root->childItems.size(), nrRemaining);
+    QCOMPARE(root->getNumberItemsInTree(), int64_t(1 + nrRemaining + nrGrandChildren - nrDeletedGrandChildren));
+
+    // The remaining items are not affected by the deletes
+    for (int i = 0; i < nrRemaining; i++)
+    {
+        auto item = root->childItems[i];
+        QCOMPARE(item->getData(0), itemName(i * 2));
+        QCOMPARE(item->getData(1), QString::number(i * 2));
+        QCOMPARE(item->getData(3), QString("00000001"));
+        QCOMPARE(item->parentItem, root);
+        if ((i * 2) % 10 == 0)
+        {
+            QCOMPARE(item->childItems.size(), 1);
+            QCOMPARE(item->childItems[0]->getData(1), QString("value %1").arg(i * 2));
+            QCOMPARE(item->childItems[0]->getData(4), QString("meaning"));
+        }
+    }
+
+    // New items reuse the free slots
+    for (int i = 0; i < nrItemsSeveralBlocks; i++)
+        new TreeItem("new", uint64_t(i) << 32, "u(64)", "", root);
+    for (int i = 0; i < nrItemsSeveralBlocks; i++)
+    {
+        auto item = root->childItems[nrRemaining + i];
+        QCOMPARE(item->getData(0), QString("new"));
+        QCOMPARE(item->getData(1), QString::number(uint64_t(i) << 32));
+    }
+    for (int i = 0; i < nrRemaining; i++)
+        QCOMPARE(root->childItems[i]->getData(1), QString::number(i * 2));
+
+    delete root;
+}
+
+void parserTest::testTreeItemFreeTreeOnRootDelete()
+{
+    // Create and delete one tree first so that all lazily created data (e.g. in Qt) exists already
+    delete createTree(nrItemsSeveralBlocks);
+
+    const int64_t nrAllocationsBefore = nrLiveAllocations.load();
+    TreeItem *root = createTree(nrItemsSeveralBlocks);
+    const int64_t nrAllocationsWithTree = nrLiveAllocations.load();
+    delete root;
+    const int64_t nrAllocationsAfter = nrLiveAllocations.load();
+
+    QVERIFY(nrAllocationsWithTree > nrAllocationsBefore);
+    QCOMPARE(nrAllocationsAfter, nrAllocationsBefore);
+
+    // Deleting a subtree does not free the string table that the rest of the tree is still using
+    root = createTree(10);
+    auto subtree = root->childItems.takeFirst();
+    delete subtree;
+    QCOMPARE(root->getNumberItemsInTree(), int64_t(1 + 9));
+    QCOMPARE(root->childItems[0]->getData(0), itemName(1));
+    QCOMPARE(root->childItems[0]->getData(2), QString("u(v) -> u(8)"));
+    delete root;
+    QCOMPARE(nrLiveAllocations.load(), nrAllocationsBefore);
+}
+
+void parserTest::testTransportStreamPIDList()
+{
+    QCOMPARE(parserTransportStream::parsePIDList(""), QList<int>());
+    QCOMPARE(parserTransportStream::parsePIDList("256"), QList<int>() << 256);
+    QCOMPARE(parserTransportStream::parsePIDList("256, 0x101;258 259"), QList<int>() << 256 << 257 << 258 << 259);
+    // Invalid entries, the null PID, values that are too large and duplicates are dropped
+    QCOMPARE(parserTransportStream::parsePIDList("abc, 8191, 9000, -1, 256, 0x100"), QList<int>() << 256);
+}
+
+void parserTest::testTransportStreamPIDFilter_data()
+{
+    QTest::addColumn<QList<int>>("pidFilter");
+    QTest::addColumn<QStringList>("expectedStreams");
+
+    // The stream index 0 is reserved for the video stream. There is no video stream in the test stream.
+    QTest::newRow("noFilter") << QList<int>() << (QStringList() << "No video stream" << "PID 257 - MPEG-1 Audio" << "PID 258 - AAC Audio (ADTS)");
+    QTest::newRow("first") << (QList<int>() << 0x101) << (QStringList() << "No video stream" << "PID 257 - MPEG-1 Audio");
+    QTest::newRow("second") << (QList<int>() << 0x102) << (QStringList() << "No video stream" << "PID 258 - AAC Audio (ADTS)");
+    QTest::newRow("both") << (QList<int>() << 0x102 << 0x101) << (QStringList() << "No video stream" << "PID 257 - MPEG-1 Audio" << "PID 258 - AAC Audio (ADTS)");
+    QTest::newRow("none") << (QList<int>() << 0x200) << QStringList();
+}
+
+void parserTest::testTransportStreamPIDFilter()
+{
+    QFETCH(QList<int>, pidFilter);
+    QFETCH(QStringList, expectedStreams);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const QByteArray ts = createTransportStream();
+    QCOMPARE(file.write(ts), qint64(ts.size()));
+    file.close();
+    QVERIFY(parserTransportStream::isTransportStreamFile(file.fileName()));
+
+    parserTransportStream parser;
+    parser.enableModel();
+    parser.setPIDFilter(pidFilter);
+    QVERIFY(parser.runParsingOfFile(file.fileName()));
+
+    // The filtered PIDs are skipped. Only the other streams are demultiplexed.
+    QCOMPARE(int(parser.getNrStreams()), expectedStreams.count());
+    for (int i = 0; i < expectedStreams.count(); i++)
+        QCOMPARE(parser.getShortStreamDescription(i), expectedStreams[i]);
+}
+
+QTEST_GUILESS_MAIN(parserTest)
+
+#include "tst_parser.moc"